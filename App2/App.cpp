@@ -12,6 +12,7 @@ using namespace Windows::ApplicationModel::Activation;
 using namespace Windows::UI::Core;
 using namespace Windows::UI::Input;
 using namespace Windows::System;
+using namespace Windows::System::Threading;
 using namespace Windows::Foundation;
 using namespace Windows::Graphics::Display;
 
@@ -49,9 +50,14 @@ void App::Initialize(CoreApplicationView^ applicationView)
 	CoreApplication::Resuming +=
 		ref new EventHandler<Platform::Object^>(this, &App::OnResuming);
 
+	// La línea de tiempo del arranque empieza aquí; App2Main la completa hasta el primer fotograma.
+	m_startupTimeline = std::unique_ptr<DX::StartupTimeline>(new DX::StartupTimeline());
+
 	// En este punto tenemos acceso al dispositivo. 
 	// Podemos crear los recursos dependientes del dispositivo.
+	double start = m_startupTimeline->GetElapsedMilliseconds();
 	m_deviceResources = std::make_shared<DX::DeviceResources>();
+	m_startupTimeline->AddInterval("DeviceResources", 0, start, m_startupTimeline->GetElapsedMilliseconds(), true);
 }
 
 // Se llama cuando se crea o se vuelve a crear el objeto CoreWindow.
@@ -66,6 +72,9 @@ void App::SetWindow(CoreWindow^ window)
 	window->Closed += 
 		ref new TypedEventHandler<CoreWindow^, CoreWindowEventArgs^>(this, &App::OnWindowClosed);
 
+	window->KeyDown +=
+		ref new TypedEventHandler<CoreWindow^, KeyEventArgs^>(this, &App::OnKeyDown);
+
 	DisplayInformation^ currentDisplayInformation = DisplayInformation::GetForCurrentView();
 
 	currentDisplayInformation->DpiChanged +=
@@ -77,7 +86,9 @@ void App::SetWindow(CoreWindow^ window)
 	DisplayInformation::DisplayContentsInvalidated +=
 		ref new TypedEventHandler<DisplayInformation^, Object^>(this, &App::OnDisplayContentsInvalidated);
 
+	double start = m_startupTimeline->GetElapsedMilliseconds();
 	m_deviceResources->SetWindow(window);
+	m_startupTimeline->AddInterval("DeviceResources::SetWindow", 0, start, m_startupTimeline->GetElapsedMilliseconds(), true);
 }
 
 // Inicializa los recursos de la escena o carga un estado de aplicación previamente guardado.
@@ -85,18 +96,39 @@ void App::Load(Platform::String^ entryPoint)
 {
 	if (m_main == nullptr)
 	{
-		m_main = std::unique_ptr<App2Main>(new App2Main(m_deviceResources));
+		m_main = std::unique_ptr<App2Main>(new App2Main(m_deviceResources, m_startupTimeline.get()));
 	}
 }
 
-// Se llama a este método una vez que se activa la ventana.
+// Se llama a este método una vez que se activa la ventana. Solo se actualiza y se dibuja cuando algo ha
+// marcado el fotograma (la animación, la entrada, la ventana, la carga); si no, el bucle se bloquea en la
+// cola de eventos hasta el siguiente cambio o el siguiente refresco periódico.
 void App::Run()
 {
+	CoreDispatcher^ dispatcher = CoreWindow::GetForCurrentThread()->Dispatcher;
+
+	// Un cambio desde otro subproceso (el temporizador, una carga) despierta la cola con un evento vacío.
+	m_main->GetFrameInvalidation().SetWakeCallback([dispatcher]()
+	{
+		dispatcher->RunAsync(CoreDispatcherPriority::Normal, ref new DispatchedHandler([]() {}));
+	});
+
 	while (!m_windowClosed)
 	{
 		if (m_windowVisible)
 		{
-			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+			dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+
+			if (m_main->GetFrameInvalidation().BeginFrame() == 0)
+			{
+				WaitForInvalidation(dispatcher);
+				continue;
+			}
+
+			// Se espera al momento que marca el ritmo de fotogramas y se vuelve a leer la entrada, de modo que
+			// el fotograma la muestre lo más tarde posible sin perder el vsync.
+			m_deviceResources->WaitForNextFrame();
+			dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
 
 			m_main->Update();
 
@@ -107,9 +139,42 @@ void App::Run()
 		}
 		else
 		{
-			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
+			dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
 		}
 	}
+
+	m_main->GetFrameInvalidation().SetWakeCallback(nullptr);
+}
+
+// Espera eventos de la ventana sin gastar CPU. Si hay refresco periódico, un temporizador del grupo de
+// subprocesos marca el fotograma cuando toca.
+void App::WaitForInvalidation(CoreDispatcher^ dispatcher)
+{
+	DX::FrameInvalidation& invalidation = m_main->GetFrameInvalidation();
+	double idleSeconds = invalidation.GetIdleWaitSeconds();
+	if (!invalidation.BeginWait())
+	{
+		return;
+	}
+
+	if (idleSeconds >= 0.0)
+	{
+		TimeSpan delay;
+		delay.Duration = static_cast<long long>(idleSeconds * 10000000.0);
+		m_idleTimer = ThreadPoolTimer::CreateTimer(ref new TimerElapsedHandler([this](ThreadPoolTimer^)
+		{
+			m_main->GetFrameInvalidation().Invalidate(DX::FrameInvalidationReason::Idle);
+		}), delay);
+	}
+
+	dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
+	invalidation.EndWait();
+
+	if (m_idleTimer != nullptr)
+	{
+		m_idleTimer->Cancel();
+		m_idleTimer = nullptr;
+	}
 }
 
 // Necesario para IFrameworkView.
@@ -165,6 +230,10 @@ void App::OnWindowSizeChanged(CoreWindow^ sender, WindowSizeChangedEventArgs^ ar
 void App::OnVisibilityChanged(CoreWindow^ sender, VisibilityChangedEventArgs^ args)
 {
 	m_windowVisible = args->Visible;
+	if (m_windowVisible && m_main != nullptr)
+	{
+		m_main->GetFrameInvalidation().Invalidate(DX::FrameInvalidationReason::Window);
+	}
 }
 
 void App::OnWindowClosed(CoreWindow^ sender, CoreWindowEventArgs^ args)
@@ -172,6 +241,16 @@ void App::OnWindowClosed(CoreWindow^ sender, CoreWindowEventArgs^ args)
 	m_windowClosed = true;
 }
 
+// Controladores de eventos de entrada. La barra espaciadora pausa la animación.
+
+void App::OnKeyDown(CoreWindow^ sender, KeyEventArgs^ args)
+{
+	if (args->VirtualKey == VirtualKey::Space)
+	{
+		m_main->SetAnimationPaused(!m_main->IsAnimationPaused());
+	}
+}
+
 // Controladores de eventos DisplayInformation.
 
 void App::OnDpiChanged(DisplayInformation^ sender, Object^ args)
@@ -193,4 +272,5 @@ void App::OnOrientationChanged(DisplayInformation^ sender, Object^ args)
 void App::OnDisplayContentsInvalidated(DisplayInformation^ sender, Object^ args)
 {
 	m_deviceResources->ValidateDevice();
+	m_main->GetFrameInvalidation().Invalidate(DX::FrameInvalidationReason::Window);
 }
\ No newline at end of file
@@ -30,16 +30,25 @@ namespace App2
 		void OnVisibilityChanged(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::VisibilityChangedEventArgs^ args);
 		void OnWindowClosed(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::CoreWindowEventArgs^ args);
 
+		// Controladores de eventos de entrada.
+		void OnKeyDown(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::KeyEventArgs^ args);
+
 		// Controladores de eventos DisplayInformation.
 		void OnDpiChanged(Windows::Graphics::Display::DisplayInformation^ sender, Platform::Object^ args);
 		void OnOrientationChanged(Windows::Graphics::Display::DisplayInformation^ sender, Platform::Object^ args);
 		void OnDisplayContentsInvalidated(Windows::Graphics::Display::DisplayInformation^ sender, Platform::Object^ args);
 
 	private:
+		void WaitForInvalidation(Windows::UI::Core::CoreDispatcher^ dispatcher);
+
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 		std::unique_ptr<App2Main> m_main;
+		std::unique_ptr<DX::StartupTimeline> m_startupTimeline;
 		bool m_windowClosed;
 		bool m_windowVisible;
+
+		// Despierta al bucle para el refresco periódico mientras espera eventos.
+		Windows::System::Threading::ThreadPoolTimer^ m_idleTimer;
 	};
 }
 
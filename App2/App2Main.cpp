@@ -8,24 +8,84 @@ using namespace Windows::Foundation;
 using namespace Windows::System::Threading;
 using namespace Concurrency;
 
-// Carga e inicializa los activos de la aplicación cuando se carga la aplicación.
-App2Main::App2Main(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
-	m_deviceResources(deviceResources)
+// Carga e inicializa los activos de la aplicación cuando se carga la aplicación. La inicialización es un
+// grafo de tareas que se ejecuta en paralelo; las estimaciones (en ms) solo ordenan la cola, de modo que
+// el representador de la escena y la fuente del texto, que están en el camino al primer fotograma
+// completo, empiezan antes que lo que puede esperar.
+App2Main::App2Main(const std::shared_ptr<DX::DeviceResources>& deviceResources, DX::StartupTimeline* startupTimeline) :
+	m_deviceResources(deviceResources),
+	m_animationPaused(false),
+	m_startupTimeline(startupTimeline),
+	m_placeholderFrameMilliseconds(-1.0),
+	m_firstFrameMilliseconds(-1.0)
 {
 	// Registrarse para recibir notificación si el dispositivo se pierde o se vuelve a crear
 	m_deviceResources->RegisterDeviceNotify(this);
 
+	// El sistema de tareas ejecuta el propio grafo, así que va antes.
+	m_jobSystem = std::unique_ptr<DX::JobSystem>(new DX::JobSystem());
+	m_scene = std::unique_ptr<SceneSimulation>(new SceneSimulation(m_jobSystem.get()));
+
 	// TODO: Reemplácelo por la inicialización del contenido de su aplicación.
-	m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources));
+	DX::StartupGraph startup;
+	DX::StartupTask sceneRenderer = startup.AddTask("Sample3DSceneRenderer", 4.0, [this]()
+	{
+		m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources));
+	});
+
+	// Es la única tarea que usa Direct2D, cuya fábrica es de un solo subproceso.
+	startup.AddTask("SampleFpsTextRenderer", 2.0, [this]()
+	{
+		m_fpsTextRenderer = std::unique_ptr<SampleFpsTextRenderer>(new SampleFpsTextRenderer(m_deviceResources));
+	});
+
+	startup.AddTask("OverlayTextRenderer", 6.0, [this]()
+	{
+		m_overlayTextRenderer = std::unique_ptr<OverlayTextRenderer>(new OverlayTextRenderer(m_deviceResources));
+	});
+
+	DX::StartupTask frameArena = startup.AddTask("FrameArena", 0.5, [this]()
+	{
+		m_frameArena = std::unique_ptr<DX::FrameArena>(new DX::FrameArena(m_jobSystem->GetThreadCount(), 256 * 1024));
+	});
+
+	DX::StartupTask physics = startup.AddTask("RigidBodyWorld", 1.0, [this]() { m_scene->CreateRigidBodies(); });
 
-	m_fpsTextRenderer = std::unique_ptr<SampleFpsTextRenderer>(new SampleFpsTextRenderer(m_deviceResources));
+	// La tela reserva las poses de los huesos en la arena del fotograma.
+	DX::StartupTask cloth = startup.AddTask("ClothSimulation", 2.0, [this]() { m_scene->CreateCloth(*m_frameArena); });
+	startup.DependsOn(cloth, frameArena);
 
-	// TODO: Cambie la configuración del temporizador si desea usar un modo distinto al modo de timestep variable predeterminado.
-	// p. ej. para una lógica de actualización de timestep fijo de 60 FPS, llame a:
-	/*
+	DX::StartupTask terrain = startup.AddTask("TerrainStreamer", 0.5, [this]() { m_scene->CreateTerrain(); });
+	DX::StartupTask voxels = startup.AddTask("VoxelVolume", 3.0, [this]() { m_scene->CreateVoxels(); });
+
+	DX::StartupTask connect = startup.AddTask("Conectar la escena", 1.0, [this]()
+	{
+		m_sceneRenderer->SetRigidBodyWorld(m_scene->GetRigidBodyWorld());
+		m_sceneRenderer->SetCloth(m_scene->GetCloth());
+		m_sceneRenderer->SetTerrain(m_scene->GetTerrain());
+		m_sceneRenderer->SetVoxelVolume(m_scene->GetVoxelVolume());
+		m_sceneRenderer->SetJobSystem(m_jobSystem.get());
+	});
+	startup.DependsOn(connect, sceneRenderer);
+	startup.DependsOn(connect, physics);
+	startup.DependsOn(connect, cloth);
+	startup.DependsOn(connect, terrain);
+	startup.DependsOn(connect, voxels);
+
+	startup.Run(m_jobSystem.get(), m_startupTimeline);
+
+	// Presupuestos de memoria de la CPU; la superposición avisa de los que se superan.
+	DX::MemoryTracker& memory = DX::MemoryTracker::Get();
+	memory.SetBudget(DX::MemoryTag::FrameArena, 8 * 1024 * 1024);
+	memory.SetBudget(DX::MemoryTag::RenderCommands, 16 * 1024 * 1024);
+	memory.SetBudget(DX::MemoryTag::Text, 4 * 1024 * 1024);
+
+	// La física avanza con timestep fijo de 60 FPS para que la simulación sea estable y reproducible.
 	m_timer.SetFixedTimeStep(true);
 	m_timer.SetTargetElapsedSeconds(1.0 / 60);
-	*/
+
+	// Sin cambios, la superposición se refresca una vez por segundo.
+	m_frameInvalidation.SetIdleFramesPerSecond(1.0);
 }
 
 App2Main::~App2Main()
@@ -39,30 +99,129 @@ void App2Main::CreateWindowSizeDependentResources()
 {
 	// TODO: Reemplácelo por la inicialización dependiente del tamaño del contenido de su aplicación.
 	m_sceneRenderer->CreateWindowSizeDependentResources();
+	m_overlayTextRenderer->CreateWindowSizeDependentResources();
+	BuildFrameGraph();
+	m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Window);
+}
+
+// Al reanudar, el reloj no cuenta el tiempo en pausa.
+void App2Main::SetAnimationPaused(bool paused)
+{
+	if (paused == m_animationPaused)
+	{
+		return;
+	}
+
+	m_animationPaused = paused;
+	if (!paused)
+	{
+		m_timer.ResetElapsedTime();
+	}
+	m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Animation);
+}
+
+// Construye el grafo de pases del fotograma. El búfer de reserva y la profundidad son de DeviceResources
+// y se importan; los pases que dibujan sobre lo anterior los declaran como leídos y escritos.
+void App2Main::BuildFrameGraph()
+{
+	Windows::Foundation::Size outputSize = m_deviceResources->GetOutputSize();
+	uint32 width = static_cast<uint32>(outputSize.Width);
+	uint32 height = static_cast<uint32>(outputSize.Height);
+	DX::FrameGraphTextureDesc colorDesc = { width, height, DXGI_FORMAT_B8G8R8A8_UNORM, 4 };
+	DX::FrameGraphTextureDesc depthDesc = { width, height, DXGI_FORMAT_D24_UNORM_S8_UINT, 4 };
+
+	m_frameGraph.Reset();
+	DX::FrameGraphResource backBuffer = m_frameGraph.ImportTexture("BackBuffer", colorDesc);
+	DX::FrameGraphResource depthStencil = m_frameGraph.ImportTexture("DepthStencil", depthDesc);
+
+	DX::FrameGraphPass scene = m_frameGraph.AddPass("Escena", [this](const DX::FrameGraph&) { RenderScenePass(); });
+	m_frameGraph.Write(scene, backBuffer);
+	m_frameGraph.Write(scene, depthStencil);
+
+	DX::FrameGraphPass overlay = m_frameGraph.AddPass("Texto superpuesto", [this](const DX::FrameGraph&)
+	{
+		DrawStatistics();
+		DX_PROFILE_SCOPE("OverlayTextRenderer::Render");
+		m_overlayTextRenderer->Render();
+	});
+	m_frameGraph.Read(overlay, backBuffer);
+	m_frameGraph.Write(overlay, backBuffer);
+
+	DX::FrameGraphPass fpsText = m_frameGraph.AddPass("Texto FPS", [this](const DX::FrameGraph&)
+	{
+		DX_PROFILE_SCOPE("SampleFpsTextRenderer::Render");
+		m_fpsTextRenderer->Render();
+	});
+	m_frameGraph.Read(fpsText, backBuffer);
+	m_frameGraph.Write(fpsText, backBuffer);
+
+	if (!m_frameGraph.Compile())
+	{
+		throw ref new Platform::FailureException(L"El grafo de fotograma no es válido.");
+	}
 }
 
 // Actualiza el estado de la aplicación una vez por marco.
 void App2Main::Update() 
 {
-	// Actualizar los objetos de la escena.
-	m_timer.Tick([&]()
+	// El fotograma del perfilador va de un Update al siguiente, de modo que incluye Render y Present.
+	DX::Profiler::Get().EndFrame();
+	DX::MemoryTracker::Get().EndFrame();
+	UpdateProfileCapture();
+
+	DX_PROFILE_SCOPE("App2Main::Update");
+	m_frameArena->BeginFrame();
+
+	// Actualizar los objetos de la escena. En pausa el reloj no avanza y la escena no cambia.
+	if (!m_animationPaused)
 	{
-		// TODO: Reemplácelo por las funciones de actualización de contenido de su aplicación.
-		m_sceneRenderer->Update(m_timer);
-		m_fpsTextRenderer->Update(m_timer);
-	});
+		m_timer.Tick([&]()
+		{
+			// TODO: Reemplácelo por las funciones de actualización de contenido de su aplicación.
+			m_scene->Step(m_timer, *m_frameArena);
+			m_sceneRenderer->Update(m_timer);
+			m_fpsTextRenderer->Update(m_timer);
+		});
+		m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Animation);
+	}
+
+	m_scene->UpdateStreaming();
+
+	// Lo que aún no ha terminado pide el fotograma siguiente: los trozos de terreno que no cupieron en este
+	// y los sombreadores y mallas que se cargan en segundo plano.
+	if (m_scene->GetTerrain()->GetStats().pendingChunks > 0)
+	{
+		m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Streaming);
+	}
+	if (!m_sceneRenderer->IsLoadingComplete())
+	{
+		m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Loading);
+	}
 }
 
 // Presenta el marco actual de acuerdo con el estado actual de la aplicación.
 // Devuelve true si se ha presentado el marco y está listo para ser mostrado.
 bool App2Main::Render() 
 {
-	// No intente presentar nada antes de la primera actualización.
+	// Antes de la primera actualización se presenta un fotograma provisional con solo el fondo, para que
+	// la ventana no espere a la simulación ni a que terminen de cargarse los sombreadores.
 	if (m_timer.GetFrameCount() == 0)
 	{
-		return false;
+		ClearBackBuffer();
+		UpdateStartupReport();
+		return true;
 	}
 
+	DX_PROFILE_SCOPE("App2Main::Render");
+	m_frameGraph.Execute();
+	UpdateStartupReport();
+
+	return true;
+}
+
+// Fija la ventanilla y los destinos de presentación y borra el búfer de reserva y la profundidad.
+void App2Main::ClearBackBuffer()
+{
 	auto context = m_deviceResources->GetD3DDeviceContext();
 
 	// Restablecer la ventanilla para que afecte a toda la pantalla.
@@ -76,13 +235,168 @@ bool App2Main::Render()
 	// Borrar el búfer de reserva y la vista de galería de símbolos de profundidad.
 	context->ClearRenderTargetView(m_deviceResources->GetBackBufferRenderTargetView(), DirectX::Colors::CornflowerBlue);
 	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+}
+
+// Pase de la escena: limpia el búfer de reserva y la profundidad y dibuja los objetos 3D.
+void App2Main::RenderScenePass()
+{
+	ClearBackBuffer();
 
 	// Presentar los objetos de la escena.
 	// TODO: Reemplácelo por las funciones de representación de contenido de su aplicación.
+	DX_PROFILE_SCOPE("Sample3DSceneRenderer::Render");
 	m_sceneRenderer->Render();
-	m_fpsTextRenderer->Render();
+}
 
-	return true;
+// Escribe las estadísticas de la simulación en la esquina superior izquierda.
+void App2Main::DrawStatistics()
+{
+	const RigidBodyWorldStats& physics = m_scene->GetRigidBodyWorld()->GetStats();
+	const ClothStats& cloth = m_scene->GetCloth()->GetStats();
+	DX::TextFormat format(16, 0.0f, DX::TextAlignment::Leading);
+	char text[128];
+
+	snprintf(text, sizeof(text), "Cuerpos despiertos: %u  Contactos: %u", physics.awakeBodies, physics.contactPoints);
+	m_overlayTextRenderer->AddText(text, 8.0f, 8.0f, 0xffffffff, format);
+
+	const TerrainStats& terrain = m_scene->GetTerrain()->GetStats();
+	snprintf(text, sizeof(text), "Fisica: %.2f ms  Tela: %.2f ms  Terreno: %.2f ms (%u trozos, %u pendientes)  Voxeles: %.2f ms",
+		physics.broadphaseMilliseconds + physics.narrowphaseMilliseconds + physics.solverMilliseconds,
+		cloth.solverMilliseconds,
+		terrain.updateMilliseconds,
+		terrain.loadedChunks,
+		terrain.pendingChunks,
+		m_scene->GetVoxelVolume()->GetStats().remeshMilliseconds);
+	m_overlayTextRenderer->AddText(text, 8.0f, 26.0f, 0xffffffff, format);
+
+	const DX::FrameArenaStats& arena = m_frameArena->GetLastFrameStats();
+	snprintf(text, sizeof(text), "Arena: %u reservas, %.1f KB, %u desbordamientos", arena.allocations, arena.bytes / 1024.0, arena.overflowAllocations);
+	m_overlayTextRenderer->AddText(text, 8.0f, 44.0f, 0xffffffff, format);
+
+	const DX::RenderStateStats& state = m_sceneRenderer->GetRenderStateStats();
+	DX::OcclusionStats occlusion = m_sceneRenderer->GetOcclusionStats();
+	snprintf(text, sizeof(text), "Estado: %llu llamadas, %llu filtradas  Oclusion: %u de %u ocultos, %.2f ms",
+		static_cast<unsigned long long>(state.GetIssued()),
+		static_cast<unsigned long long>(state.GetFiltered()),
+		occlusion.occluded,
+		occlusion.tested,
+		occlusion.rasterizeMilliseconds + occlusion.pyramidMilliseconds);
+	m_overlayTextRenderer->AddText(text, 8.0f, 62.0f, 0xffffffff, format);
+
+	DX::FrameInvalidationStats onDemand = m_frameInvalidation.GetStats();
+	snprintf(text, sizeof(text), "Arranque: provisional %.0f ms, primer fotograma %.0f ms  Bajo demanda: %llu esperas, %llu refrescos",
+		m_placeholderFrameMilliseconds,
+		m_firstFrameMilliseconds,
+		static_cast<unsigned long long>(onDemand.waits),
+		static_cast<unsigned long long>(onDemand.idleFrames));
+	m_overlayTextRenderer->AddText(text, 8.0f, 80.0f, 0xffffffff, format);
+
+	// Memoria del fotograma anterior y la etiqueta que más ocupa.
+	const DX::MemorySnapshot& memory = DX::MemoryTracker::Get().GetLastFrame();
+	DX::MemoryTag largest = DX::MemoryTag::General;
+	for (uint32 i = 0; i < static_cast<uint32>(DX::MemoryTag::Count); i++)
+	{
+		if (memory.tags[i].liveBytes > memory.Get(largest).liveBytes)
+		{
+			largest = static_cast<DX::MemoryTag>(i);
+		}
+	}
+	snprintf(text, sizeof(text), "Memoria: %.1f MB (%s %.1f MB), %llu reservas, %u sobre presupuesto",
+		memory.GetLiveBytes() / (1024.0 * 1024.0),
+		DX::GetMemoryTagName(largest),
+		memory.Get(largest).liveBytes / (1024.0 * 1024.0),
+		static_cast<unsigned long long>(memory.GetFrameAllocations()),
+		memory.GetOverBudgetCount());
+	m_overlayTextRenderer->AddText(text, 8.0f, 98.0f, 0xffffffff, format);
+
+	const DX::FramePacerStats& pacing = m_deviceResources->GetFramePacer().GetStats();
+	snprintf(text, sizeof(text), "Ritmo: previsto %.2f ms, espera %.2f ms, latencia %.1f ms, %llu vsync perdidos",
+		pacing.predictedSeconds * 1000.0,
+		pacing.averageDelay * 1000.0,
+		pacing.lastLatency * 1000.0,
+		static_cast<unsigned long long>(pacing.missedDeadlines));
+	m_overlayTextRenderer->AddText(text, 8.0f, 116.0f, 0xffffffff, format);
+
+	// Árbol del perfilador del fotograma anterior: los dos primeros niveles del subproceso del bucle.
+	const DX::ProfileFrame& profile = DX::Profiler::Get().GetLastFrame();
+	uint32 mainThread = DX::Profiler::Get().GetCurrentThread();
+	float y = 134.0f;
+	for (const DX::ProfileNode& node : profile.nodes)
+	{
+		if (node.thread != mainThread || node.depth > 1 || y > 134.0f + 18.0f * 8)
+		{
+			continue;
+		}
+		snprintf(text, sizeof(text), "%*s%s: %.2f ms (%u)", static_cast<int>(node.depth * 2), "", node.name, node.inclusiveMilliseconds, node.calls);
+		m_overlayTextRenderer->AddText(text, 8.0f, y, 0xffffffff, format);
+		y += 18.0f;
+	}
+}
+
+// Anota en la línea de tiempo el fotograma provisional y el primero con la escena cargada. Con este último
+// se cierra el arranque: en las compilaciones de depuración la línea de tiempo se guarda como informe
+// (startup.txt) y como traza de Chrome (startup.json) en la carpeta local de la aplicación.
+void App2Main::UpdateStartupReport()
+{
+	if (m_startupTimeline == nullptr || m_firstFrameMilliseconds >= 0.0)
+	{
+		return;
+	}
+
+	if (m_placeholderFrameMilliseconds < 0.0)
+	{
+		m_startupTimeline->MarkEvent("Fotograma provisional");
+		m_placeholderFrameMilliseconds = m_startupTimeline->GetEventMilliseconds("Fotograma provisional");
+	}
+
+	if (m_timer.GetFrameCount() == 0 || !m_sceneRenderer->IsLoadingComplete())
+	{
+		return;
+	}
+
+	m_startupTimeline->MarkEvent("Primer fotograma completo");
+	m_firstFrameMilliseconds = m_startupTimeline->GetEventMilliseconds("Primer fotograma completo");
+
+#if defined(_DEBUG)
+	Platform::String^ folder = Windows::Storage::ApplicationData::Current->LocalFolder->Path;
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, (folder + L"\\startup.txt")->Data(), L"wb") == 0 && file != nullptr)
+	{
+		m_startupTimeline->WriteReport(file);
+		fclose(file);
+	}
+	if (_wfopen_s(&file, (folder + L"\\startup.json")->Data(), L"wb") == 0 && file != nullptr)
+	{
+		m_startupTimeline->WriteChromeTrace(file);
+		fclose(file);
+	}
+#endif
+}
+
+// En las compilaciones de depuración se capturan los fotogramas 120 a 240 y se guardan como traza de
+// Chrome (profile.json en la carpeta local de la aplicación) para abrirla en chrome://tracing o Perfetto.
+void App2Main::UpdateProfileCapture()
+{
+#if defined(_DEBUG) && !defined(DX_PROFILER_DISABLED)
+	DX::Profiler& profiler = DX::Profiler::Get();
+	uint64 frame = profiler.GetLastFrame().frame;
+	if (frame == 120)
+	{
+		profiler.BeginCapture();
+	}
+	else if (frame == 240 && profiler.IsCapturing())
+	{
+		profiler.EndCapture();
+
+		Platform::String^ path = Windows::Storage::ApplicationData::Current->LocalFolder->Path + L"\\profile.json";
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, path->Data(), L"wb") == 0 && file != nullptr)
+		{
+			profiler.WriteChromeTrace(file);
+			fclose(file);
+		}
+	}
+#endif
 }
 
 // Notifica a los representadores que deben liberarse recursos del dispositivo.
@@ -90,6 +404,7 @@ void App2Main::OnDeviceLost()
 {
 	m_sceneRenderer->ReleaseDeviceDependentResources();
 	m_fpsTextRenderer->ReleaseDeviceDependentResources();
+	m_overlayTextRenderer->ReleaseDeviceDependentResources();
 }
 
 // Notifica a los representadores que los recursos del dispositivo pueden volver a crearse.
@@ -97,7 +412,9 @@ void App2Main::OnDeviceRestored()
 {
 	m_sceneRenderer->CreateDeviceDependentResources();
 	m_fpsTextRenderer->CreateDeviceDependentResources();
+	m_overlayTextRenderer->CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
+	m_frameInvalidation.Invalidate(DX::FrameInvalidationReason::Device);
 }
 
 
@@ -4,6 +4,15 @@
 #include "Common\DeviceResources.h"
 #include "Content\Sample3DSceneRenderer.h"
 #include "Content\SampleFpsTextRenderer.h"
+#include "Content\OverlayTextRenderer.h"
+#include "Content\SceneSimulation.h"
+#include "Common\JobSystem.h"
+#include "Common\FrameArena.h"
+#include "Common\Profiler.h"
+#include "Common\MemoryTracker.h"
+#include "Common\FrameGraph.h"
+#include "Common\FrameInvalidation.h"
+#include "Common\StartupGraph.h"
 
 // Presenta contenido Direct2D y 3D en la pantalla.
 namespace App2
@@ -11,26 +20,62 @@ namespace App2
 	class App2Main : public DX::IDeviceNotify
 	{
 	public:
-		App2Main(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		App2Main(const std::shared_ptr<DX::DeviceResources>& deviceResources, DX::StartupTimeline* startupTimeline);
 		~App2Main();
 		void CreateWindowSizeDependentResources();
 		void Update();
 		bool Render();
 		void Nose();
 
+		// App consulta aquí si hay que dibujar; los cambios de la escena y de la ventana lo marcan.
+		DX::FrameInvalidation& GetFrameInvalidation()		{ return m_frameInvalidation; }
+
+		// Con la animación en pausa, la escena solo se vuelve a dibujar cuando algo cambia.
+		void SetAnimationPaused(bool paused);
+		bool IsAnimationPaused() const						{ return m_animationPaused; }
+
 		// IDeviceNotify
 		virtual void OnDeviceLost();
 		virtual void OnDeviceRestored();
 
 	private:
+		void DrawStatistics();
+		void BuildFrameGraph();
+		void ClearBackBuffer();
+		void RenderScenePass();
+		void UpdateStartupReport();
+		void UpdateProfileCapture();
+
 		// Puntero almacenado en caché para los recursos del dispositivo.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
 		// TODO: Sustituir con sus propios representadores de contenido.
 		std::unique_ptr<Sample3DSceneRenderer> m_sceneRenderer;
 		std::unique_ptr<SampleFpsTextRenderer> m_fpsTextRenderer;
+		std::unique_ptr<OverlayTextRenderer> m_overlayTextRenderer;
+
+		// Simulación física de la escena, repartida entre los subprocesos de trabajo.
+		std::unique_ptr<DX::JobSystem> m_jobSystem;
+
+		// Memoria temporal de cada fotograma; el bucle Update/Render no debe usar el montón general.
+		std::unique_ptr<DX::FrameArena> m_frameArena;
+
+		// Cubos, tela, terreno y vóxeles; lo mismo que avanza AnimationExporter sin ventana.
+		std::unique_ptr<SceneSimulation> m_scene;
+
+		// Pases del fotograma; se reconstruye al cambiar el tamaño de la ventana.
+		DX::FrameGraph m_frameGraph;
 
 		// Temporizador de bucle de representación.
 		DX::StepTimer m_timer;
+
+		// Dibujo bajo demanda: qué ha cambiado desde el último fotograma.
+		DX::FrameInvalidation m_frameInvalidation;
+		bool m_animationPaused;
+
+		// Línea de tiempo del arranque (de App); se cierra con el primer fotograma completo.
+		DX::StartupTimeline* m_startupTimeline;
+		double m_placeholderFrameMilliseconds;
+		double m_firstFrameMilliseconds;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+﻿#include "AnimationTrack.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+// Índice k de la clave con keys[k].time <= time < keys[k + 1].time.
+uint32_t DX::AnimationTrack::FindKey(float time, uint32_t cursor) const
+{
+	uint32_t last = static_cast<uint32_t>(m_keys.size()) - 1;
+	if (cursor < last && m_keys[cursor].time <= time)
+	{
+		// Caso habitual: misma clave o unas pocas más adelante.
+		for (uint32_t step = 0; step < 4 && cursor < last; step++)
+		{
+			if (time < m_keys[cursor + 1].time)
+			{
+				return cursor;
+			}
+			cursor++;
+		}
+	}
+
+	auto next = std::upper_bound(m_keys.begin(), m_keys.end(), time, [](float t, const TransformKey& key) { return t < key.time; });
+	uint32_t index = static_cast<uint32_t>(next - m_keys.begin());
+	return (index > 0) ? std::min(index - 1, last) : 0;
+}
+
+void DX::AnimationTrack::Sample(float time, uint32_t& cursor, Vector3& position, Quaternion& rotation) const
+{
+	if (m_keys.empty())
+	{
+		position = Vector3();
+		rotation = Quaternion();
+		return;
+	}
+
+	float duration = GetDuration();
+	if (m_looping && duration > 0.0f)
+	{
+		time = fmodf(time, duration);
+		if (time < 0.0f)
+		{
+			time += duration;
+		}
+	}
+
+	cursor = FindKey(time, cursor);
+	const TransformKey& a = m_keys[cursor];
+	if (cursor + 1 >= m_keys.size() || time <= a.time)
+	{
+		position = a.position;
+		rotation = a.rotation;
+		return;
+	}
+
+	const TransformKey& b = m_keys[cursor + 1];
+	float t = (time - a.time) / (b.time - a.time);
+	position = a.position + (b.position - a.position) * t;
+	rotation = Nlerp(a.rotation, b.rotation, t);
+}
@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "VectorMath.h"
+
+namespace DX
+{
+	struct TransformKey
+	{
+		float		time;
+		Vector3		position;
+		Quaternion	rotation;
+	};
+
+	// Pista de animación de una transformación con claves ordenadas por tiempo. Entre claves se interpola
+	// linealmente la posición y con nlerp la rotación. Al muestrear en orden creciente de tiempo, el cursor
+	// que guarda quien llama evita la búsqueda binaria: normalmente la clave sigue siendo la misma o la siguiente.
+	class AnimationTrack
+	{
+	public:
+		AnimationTrack() : m_looping(true) {}
+
+		// Las claves deben llegar ordenadas por tiempo.
+		void AddKey(const TransformKey& key)		{ m_keys.push_back(key); }
+		void SetLooping(bool looping)				{ m_looping = looping; }
+
+		float GetDuration() const					{ return m_keys.empty() ? 0.0f : m_keys.back().time; }
+		uint32_t GetKeyCount() const				{ return static_cast<uint32_t>(m_keys.size()); }
+
+		void Sample(float time, uint32_t& cursor, Vector3& position, Quaternion& rotation) const;
+
+	private:
+		uint32_t FindKey(float time, uint32_t cursor) const;
+
+		std::vector<TransformKey>	m_keys;
+		bool						m_looping;
+	};
+}
@@ -0,0 +1,105 @@
+﻿#include "AsyncFileWriter.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+using namespace DX;
+
+AsyncFileWriter::AsyncFileWriter() :
+	m_writing(false),
+	m_stopping(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_thread = std::thread(&AsyncFileWriter::WriterMain, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeCondition.notify_one();
+	m_thread.join();
+}
+
+void AsyncFileWriter::Enqueue(const std::string& path, std::vector<uint8_t>&& bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(PendingFile());
+		m_queue.back().path = path;
+		m_queue.back().bytes.swap(bytes);
+		uint32_t pending = static_cast<uint32_t>(m_queue.size());
+		if (pending > m_stats.maxPendingFiles)
+		{
+			m_stats.maxPendingFiles = pending;
+		}
+	}
+	m_wakeCondition.notify_one();
+}
+
+void AsyncFileWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this]() { return m_queue.empty() && !m_writing; });
+}
+
+AsyncFileWriterStats AsyncFileWriter::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// Al detenerse, vacía la cola antes de salir.
+void AsyncFileWriter::WriterMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_wakeCondition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+		if (m_queue.empty())
+		{
+			return;
+		}
+
+		PendingFile file;
+		file.path.swap(m_queue.front().path);
+		file.bytes.swap(m_queue.front().bytes);
+		m_queue.pop_front();
+		m_writing = true;
+		lock.unlock();
+
+		auto start = std::chrono::steady_clock::now();
+		bool succeeded = false;
+		{
+			DX_PROFILE_SCOPE("AsyncFileWriter::Write");
+			FILE* handle = fopen(file.path.c_str(), "wb");
+			if (handle != nullptr)
+			{
+				size_t written = fwrite(file.bytes.data(), 1, file.bytes.size(), handle);
+				succeeded = fclose(handle) == 0 && written == file.bytes.size();
+			}
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		lock.lock();
+		m_writing = false;
+		m_stats.writeMilliseconds += milliseconds;
+		if (succeeded)
+		{
+			m_stats.filesWritten++;
+			m_stats.bytesWritten += file.bytes.size();
+		}
+		else
+		{
+			m_stats.failures++;
+		}
+		if (m_queue.empty())
+		{
+			m_idleCondition.notify_all();
+		}
+	}
+}
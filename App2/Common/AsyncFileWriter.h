@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	struct AsyncFileWriterStats
+	{
+		uint32_t	filesWritten;
+		uint32_t	failures;			// Archivos que no se pudieron abrir o escribir por completo.
+		uint64_t	bytesWritten;
+		uint32_t	maxPendingFiles;	// Mayor cola vista: cuánto se adelantó el productor al disco.
+		double		writeMilliseconds;	// Tiempo del subproceso de escritura en fopen/fwrite/fclose.
+	};
+
+	// Escribe archivos completos en un subproceso propio, en el orden en que se encolan. Enqueue solo toma
+	// el contenido y vuelve, así que quien produce los datos (p. ej., el trazador) nunca espera al disco; la
+	// cola no tiene límite, de modo que la memoria que ocupa es la de los archivos aún pendientes.
+	class AsyncFileWriter
+	{
+	public:
+		AsyncFileWriter();
+
+		// Espera a que se escriba todo lo encolado.
+		~AsyncFileWriter();
+
+		AsyncFileWriter(const AsyncFileWriter&) = delete;
+		AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+		void Enqueue(const std::string& path, std::vector<uint8_t>&& bytes);
+
+		// Bloquea hasta que la cola está vacía y el último archivo, cerrado.
+		void Flush();
+
+		AsyncFileWriterStats GetStats() const;
+
+	private:
+		struct PendingFile
+		{
+			std::string				path;
+			std::vector<uint8_t>	bytes;
+		};
+
+		void WriterMain();
+
+		mutable std::mutex			m_mutex;
+		std::condition_variable		m_wakeCondition;
+		std::condition_variable		m_idleCondition;
+		std::deque<PendingFile>		m_queue;
+		bool						m_writing;
+		bool						m_stopping;
+		AsyncFileWriterStats		m_stats;
+
+		// Va la última para que el resto ya esté construido cuando arranca.
+		std::thread					m_thread;
+	};
+}
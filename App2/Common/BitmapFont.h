@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include "GlyphAtlas.h"
+
+namespace DX
+{
+	// Rasterizador portátil con una fuente de mapa de bits de 5x7 píxeles para ASCII imprimible.
+	// No depende de DirectWrite, así que el texto superpuesto funciona igual en todas las plataformas.
+	// El tamaño se redondea a un múltiplo entero de la celda de 8 píxeles para que los píxeles sigan nítidos.
+	class BitmapFontRasterizer : public IGlyphRasterizer
+	{
+	public:
+		virtual FontMetrics GetFontMetrics(uint32_t pixelSize) const;
+		virtual bool HasGlyph(uint32_t codepoint) const;
+		virtual void RasterizeGlyph(uint32_t codepoint, uint32_t pixelSize, GlyphMetrics& metrics, std::vector<uint8_t>& pixels) const;
+	};
+}
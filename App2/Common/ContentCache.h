@@ -0,0 +1,134 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "ContentHash.h"
+
+namespace DX
+{
+	struct ContentCacheStats
+	{
+		uint64_t	lookups;
+		uint64_t	hits;
+		uint64_t	collisions;		// Búsquedas con el hash de otra descripción guardada.
+
+		double GetHitRate() const	{ return (lookups > 0) ? static_cast<double>(hits) / lookups : 0.0; }
+	};
+
+	// Bytes de una descripción que no se puede añadir entera (tiene relleno o punteros a texto), para
+	// usarla como clave de ContentCache. Se construye campo a campo como ContentHasher.
+	class ContentKey
+	{
+	public:
+		void Add(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+		}
+
+		// Con el terminador, como en ContentHasher.
+		void AddString(const char* text)
+		{
+			Add(text, (text != nullptr) ? strlen(text) + 1 : 0);
+		}
+
+		template<typename T>
+		void AddValue(const T& value)
+		{
+			Add(&value, sizeof(value));
+		}
+
+		const uint8_t* GetData() const	{ return m_bytes.data(); }
+		size_t GetSize() const			{ return m_bytes.size(); }
+
+	private:
+		std::vector<uint8_t>	m_bytes;
+	};
+
+	// Objetos compartidos indexados por el contenido de su descripción: pedir dos veces lo mismo devuelve
+	// el mismo objeto y solo se crea una vez. Se busca por el hash, pero cada entrada guarda también los
+	// bytes de la descripción y se comparan, de modo que dos descripciones con el mismo hash no comparten
+	// objeto. Se puede usar desde varios subprocesos (las tareas de carga de los representadores terminan
+	// en subprocesos distintos); la creación ocurre con el bloqueo tomado.
+	template<typename T>
+	class ContentCache
+	{
+	public:
+		ContentCache()
+		{
+			m_stats.lookups = 0;
+			m_stats.hits = 0;
+			m_stats.collisions = 0;
+		}
+
+		// Devuelve el objeto de la descripción key o llama a create() para crearlo y guardarlo.
+		template<typename TCreate>
+		T GetOrCreate(const void* key, size_t keySize, const TCreate& create)
+		{
+			uint64_t hash = HashContent(key, keySize);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stats.lookups++;
+			auto range = m_entries.equal_range(hash);
+			for (auto found = range.first; found != range.second; ++found)
+			{
+				const std::vector<uint8_t>& stored = found->second.key;
+				if (stored.size() == keySize && (keySize == 0 || memcmp(stored.data(), key, keySize) == 0))
+				{
+					m_stats.hits++;
+					return found->second.value;
+				}
+			}
+			if (range.first != range.second)
+			{
+				m_stats.collisions++;
+			}
+
+			Entry entry;
+			entry.key.assign(static_cast<const uint8_t*>(key), static_cast<const uint8_t*>(key) + keySize);
+			entry.value = create();
+			T value = entry.value;
+			m_entries.emplace(hash, std::move(entry));
+			return value;
+		}
+
+		template<typename TCreate>
+		T GetOrCreate(const ContentKey& key, const TCreate& create)
+		{
+			return GetOrCreate(key.GetData(), key.GetSize(), create);
+		}
+
+		// Suelta todos los objetos, por ejemplo al perder el dispositivo. Los contadores se conservan.
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_entries.clear();
+		}
+
+		size_t GetCount() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_entries.size();
+		}
+
+		ContentCacheStats GetStats() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_stats;
+		}
+
+	private:
+		struct Entry
+		{
+			std::vector<uint8_t>	key;
+			T						value;
+		};
+
+		mutable std::mutex							m_mutex;
+		std::unordered_multimap<uint64_t, Entry>	m_entries;
+		ContentCacheStats							m_stats;
+	};
+}
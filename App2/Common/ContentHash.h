@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace DX
+{
+	// Hash de 64 bits de contenido (código de sombreadores, descripciones de estado) para usarlo como clave
+	// de caché. Procesa ocho bytes por paso; no está pensado para resistir colisiones provocadas.
+	class ContentHasher
+	{
+	public:
+		ContentHasher() : m_hash(0x243f6a8885a308d3ull), m_length(0) {}
+
+		void Add(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			size_t words = size / 8;
+			for (size_t i = 0; i < words; i++)
+			{
+				uint64_t word;
+				memcpy(&word, bytes + i * 8, sizeof(word));
+				Mix(word);
+			}
+
+			uint64_t tail = 0;
+			size_t remaining = size - words * 8;
+			if (remaining > 0)
+			{
+				memcpy(&tail, bytes + words * 8, remaining);
+				Mix(tail ^ (static_cast<uint64_t>(remaining) << 56));
+			}
+			m_length += size;
+		}
+
+		// Las cadenas se añaden con su terminador para que "ab" + "c" no coincida con "a" + "bc".
+		void AddString(const char* text)
+		{
+			Add(text, (text != nullptr) ? strlen(text) + 1 : 0);
+		}
+
+		// Solo para tipos sin relleno entre campos; los demás se añaden campo a campo.
+		template<typename T>
+		void AddValue(const T& value)
+		{
+			Add(&value, sizeof(value));
+		}
+
+		uint64_t GetHash() const
+		{
+			uint64_t hash = m_hash ^ m_length;
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+	private:
+		void Mix(uint64_t word)
+		{
+			word *= 0x9e3779b97f4a7c15ull;
+			word ^= word >> 32;
+			m_hash = (m_hash ^ word) * 0x100000001b3ull;
+			m_hash = (m_hash << 27) | (m_hash >> 37);
+		}
+
+		uint64_t	m_hash;
+		uint64_t	m_length;
+	};
+
+	inline uint64_t HashContent(const void* data, size_t size)
+	{
+		ContentHasher hasher;
+		hasher.Add(data, size);
+		return hasher.GetHash();
+	}
+}
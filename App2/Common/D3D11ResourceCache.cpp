@@ -0,0 +1,219 @@
+﻿#include "pch.h"
+#include "D3D11ResourceCache.h"
+#include "DirectXHelper.h"
+
+#include <stdexcept>
+
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	void AddStencilOp(ContentKey& key, const D3D11_DEPTH_STENCILOP_DESC& op)
+	{
+		key.AddValue(op.StencilFailOp);
+		key.AddValue(op.StencilDepthFailOp);
+		key.AddValue(op.StencilPassOp);
+		key.AddValue(op.StencilFunc);
+	}
+
+	const char* GetSemanticName(VertexSemantic semantic)
+	{
+		switch (semantic)
+		{
+		case VertexSemantic::Position:	return "POSITION";
+		case VertexSemantic::Normal:	return "NORMAL";
+		case VertexSemantic::Color:		return "COLOR";
+		default:						return "TEXCOORD";
+		}
+	}
+
+	DXGI_FORMAT GetElementFormat(VertexElementFormat format)
+	{
+		switch (format)
+		{
+		case VertexElementFormat::Float1:	return DXGI_FORMAT_R32_FLOAT;
+		case VertexElementFormat::Float2:	return DXGI_FORMAT_R32G32_FLOAT;
+		case VertexElementFormat::Float3:	return DXGI_FORMAT_R32G32B32_FLOAT;
+		case VertexElementFormat::Float4:	return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		default:							return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+}
+
+DX::D3D11ResourceCache::D3D11ResourceCache()
+{
+}
+
+void DX::D3D11ResourceCache::SetDevice(ID3D11Device3* device)
+{
+	if (m_device.Get() != device)
+	{
+		Clear();
+		m_device = device;
+	}
+}
+
+void DX::D3D11ResourceCache::Clear()
+{
+	m_vertexShaders.Clear();
+	m_pixelShaders.Clear();
+	m_inputLayouts.Clear();
+	m_rasterizerStates.Clear();
+	m_blendStates.Clear();
+	m_depthStencilStates.Clear();
+	m_samplerStates.Clear();
+}
+
+ComPtr<ID3D11VertexShader> DX::D3D11ResourceCache::GetVertexShader(const void* bytecode, size_t size)
+{
+	return m_vertexShaders.GetOrCreate(bytecode, size, [&]()
+	{
+		ComPtr<ID3D11VertexShader> shader;
+		DX::ThrowIfFailed(m_device->CreateVertexShader(bytecode, size, nullptr, &shader));
+		return shader;
+	});
+}
+
+ComPtr<ID3D11PixelShader> DX::D3D11ResourceCache::GetPixelShader(const void* bytecode, size_t size)
+{
+	return m_pixelShaders.GetOrCreate(bytecode, size, [&]()
+	{
+		ComPtr<ID3D11PixelShader> shader;
+		DX::ThrowIfFailed(m_device->CreatePixelShader(bytecode, size, nullptr, &shader));
+		return shader;
+	});
+}
+
+// Los nombres de semántica son punteros, así que la clave lleva el texto y no la dirección.
+ComPtr<ID3D11InputLayout> DX::D3D11ResourceCache::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32 elementCount, const void* vertexShaderBytecode, size_t size)
+{
+	ContentKey key;
+	for (uint32 i = 0; i < elementCount; i++)
+	{
+		const D3D11_INPUT_ELEMENT_DESC& element = elements[i];
+		key.AddString(element.SemanticName);
+		key.AddValue(element.SemanticIndex);
+		key.AddValue(element.Format);
+		key.AddValue(element.InputSlot);
+		key.AddValue(element.AlignedByteOffset);
+		key.AddValue(element.InputSlotClass);
+		key.AddValue(element.InstanceDataStepRate);
+	}
+	key.Add(vertexShaderBytecode, size);
+
+	return m_inputLayouts.GetOrCreate(key, [&]()
+	{
+		ComPtr<ID3D11InputLayout> inputLayout;
+		DX::ThrowIfFailed(m_device->CreateInputLayout(elements, elementCount, vertexShaderBytecode, size, &inputLayout));
+		return inputLayout;
+	});
+}
+
+// Traduce los elementos de un formato de vértice a la descripción de Direct3D; la caché es la misma.
+ComPtr<ID3D11InputLayout> DX::D3D11ResourceCache::GetInputLayout(const VertexElement* elements, uint32 elementCount, const void* vertexShaderBytecode, size_t size)
+{
+	D3D11_INPUT_ELEMENT_DESC descs[D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT];
+	if (elementCount > ARRAYSIZE(descs))
+	{
+		throw std::invalid_argument("Un formato de vértice no puede tener más elementos que entradas tiene el ensamblador");
+	}
+
+	for (uint32 i = 0; i < elementCount; i++)
+	{
+		D3D11_INPUT_ELEMENT_DESC& desc = descs[i];
+		desc.SemanticName = GetSemanticName(elements[i].semantic);
+		desc.SemanticIndex = elements[i].semanticIndex;
+		desc.Format = GetElementFormat(elements[i].format);
+		desc.InputSlot = 0;
+		desc.AlignedByteOffset = elements[i].offset;
+		desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		desc.InstanceDataStepRate = 0;
+	}
+	return GetInputLayout(descs, elementCount, vertexShaderBytecode, size);
+}
+
+// D3D11_RASTERIZER_DESC y D3D11_SAMPLER_DESC no tienen relleno y sirven enteras de clave.
+ComPtr<ID3D11RasterizerState> DX::D3D11ResourceCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	return m_rasterizerStates.GetOrCreate(&desc, sizeof(desc), [&]()
+	{
+		ComPtr<ID3D11RasterizerState> state;
+		DX::ThrowIfFailed(m_device->CreateRasterizerState(&desc, &state));
+		return state;
+	});
+}
+
+ComPtr<ID3D11BlendState> DX::D3D11ResourceCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	// RenderTargetWriteMask deja relleno tras cada destino: la clave se forma campo a campo.
+	ContentKey key;
+	key.AddValue(desc.AlphaToCoverageEnable);
+	key.AddValue(desc.IndependentBlendEnable);
+	for (const D3D11_RENDER_TARGET_BLEND_DESC& target : desc.RenderTarget)
+	{
+		key.AddValue(target.BlendEnable);
+		key.AddValue(target.SrcBlend);
+		key.AddValue(target.DestBlend);
+		key.AddValue(target.BlendOp);
+		key.AddValue(target.SrcBlendAlpha);
+		key.AddValue(target.DestBlendAlpha);
+		key.AddValue(target.BlendOpAlpha);
+		key.AddValue(target.RenderTargetWriteMask);
+	}
+
+	return m_blendStates.GetOrCreate(key, [&]()
+	{
+		ComPtr<ID3D11BlendState> state;
+		DX::ThrowIfFailed(m_device->CreateBlendState(&desc, &state));
+		return state;
+	});
+}
+
+ComPtr<ID3D11DepthStencilState> DX::D3D11ResourceCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	ContentKey key;
+	key.AddValue(desc.DepthEnable);
+	key.AddValue(desc.DepthWriteMask);
+	key.AddValue(desc.DepthFunc);
+	key.AddValue(desc.StencilEnable);
+	key.AddValue(desc.StencilReadMask);
+	key.AddValue(desc.StencilWriteMask);
+	AddStencilOp(key, desc.FrontFace);
+	AddStencilOp(key, desc.BackFace);
+
+	return m_depthStencilStates.GetOrCreate(key, [&]()
+	{
+		ComPtr<ID3D11DepthStencilState> state;
+		DX::ThrowIfFailed(m_device->CreateDepthStencilState(&desc, &state));
+		return state;
+	});
+}
+
+ComPtr<ID3D11SamplerState> DX::D3D11ResourceCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+	return m_samplerStates.GetOrCreate(&desc, sizeof(desc), [&]()
+	{
+		ComPtr<ID3D11SamplerState> state;
+		DX::ThrowIfFailed(m_device->CreateSamplerState(&desc, &state));
+		return state;
+	});
+}
+
+ContentCacheStats DX::D3D11ResourceCache::GetStats() const
+{
+	ContentCacheStats total = { 0, 0, 0 };
+	ContentCacheStats parts[7] =
+	{
+		m_vertexShaders.GetStats(), m_pixelShaders.GetStats(), m_inputLayouts.GetStats(), m_rasterizerStates.GetStats(),
+		m_blendStates.GetStats(), m_depthStencilStates.GetStats(), m_samplerStates.GetStats(),
+	};
+	for (const ContentCacheStats& part : parts)
+	{
+		total.lookups += part.lookups;
+		total.hits += part.hits;
+		total.collisions += part.collisions;
+	}
+	return total;
+}
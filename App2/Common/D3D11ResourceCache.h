@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "ContentCache.h"
+#include "VertexFormat.h"
+
+namespace DX
+{
+	// Caché de objetos de Direct3D 11 que dependen solo de su descripción: sombreadores (por su código),
+	// diseños de entrada (por sus elementos y la firma del sombreador) y estados de rasterizador, mezcla,
+	// profundidad y muestreo. Los representadores piden los objetos aquí en lugar de crearlos, así que dos
+	// representadores con los mismos sombreadores o estados comparten los mismos objetos.
+	class D3D11ResourceCache
+	{
+	public:
+		D3D11ResourceCache();
+
+		// Dispositivo con el que se crean los objetos nuevos. Cambiar de dispositivo vacía la caché.
+		void SetDevice(ID3D11Device3* device);
+		void Clear();
+
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> GetVertexShader(const void* bytecode, size_t size);
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> GetPixelShader(const void* bytecode, size_t size);
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, uint32 elementCount, const void* vertexShaderBytecode, size_t size);
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout(const VertexElement* elements, uint32 elementCount, const void* vertexShaderBytecode, size_t size);
+
+		// Diseño de entrada de un tipo de vértice con VertexLayoutOf, en la ranura 0.
+		template<typename TVertex>
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout(const void* vertexShaderBytecode, size_t size)
+		{
+			typedef VertexLayoutOf<TVertex> Layout;
+			return GetInputLayout(Layout::GetElements(), Layout::ElementCount, vertexShaderBytecode, size);
+		}
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState> GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+		Microsoft::WRL::ComPtr<ID3D11BlendState> GetBlendState(const D3D11_BLEND_DESC& desc);
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState> GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+		Microsoft::WRL::ComPtr<ID3D11SamplerState> GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+
+		// Búsquedas y aciertos sumando todos los tipos de objeto.
+		ContentCacheStats GetStats() const;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11Device3>	m_device;
+
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11VertexShader>>		m_vertexShaders;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11PixelShader>>			m_pixelShaders;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11InputLayout>>			m_inputLayouts;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11RasterizerState>>		m_rasterizerStates;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11BlendState>>			m_blendStates;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11DepthStencilState>>	m_depthStencilStates;
+		ContentCache<Microsoft::WRL::ComPtr<ID3D11SamplerState>>		m_samplerStates;
+	};
+}
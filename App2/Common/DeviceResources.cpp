@@ -1,6 +1,9 @@
 ﻿#include "pch.h"
 #include "DeviceResources.h"
 #include "DirectXHelper.h"
+#include "Profiler.h"
+
+#include <thread>
 
 using namespace D2D1;
 using namespace DirectX;
@@ -66,6 +69,8 @@ namespace ScreenRotation
 
 // Constructor para DeviceResources.
 DX::DeviceResources::DeviceResources() :
+	m_frameLatencyWaitableObject(nullptr),
+	m_frameLatencySlotFree(false),
 	m_screenViewport(),
 	m_d3dFeatureLevel(D3D_FEATURE_LEVEL_9_1),
 	m_d3dRenderTargetSize(),
@@ -77,6 +82,7 @@ DX::DeviceResources::DeviceResources() :
 	m_effectiveDpi(-1.0f),
 	m_deviceNotify(nullptr)
 {
+	QueryPerformanceFrequency(&m_pacerFrequency);
 	CreateDeviceIndependentResources();
 	CreateDeviceResources();
 }
@@ -202,6 +208,9 @@ void DX::DeviceResources::CreateDeviceResources()
 		context.As(&m_d3dContext)
 		);
 
+	// Los objetos de la caché pertenecen al dispositivo anterior.
+	m_resourceCache.SetDevice(m_d3dDevice.Get());
+
 	// Cree el objeto de dispositivo de Direct2D y un contexto correspondiente.
 	ComPtr<IDXGIDevice3> dxgiDevice;
 	DX::ThrowIfFailed(
@@ -251,7 +260,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 			lround(m_d3dRenderTargetSize.Width),
 			lround(m_d3dRenderTargetSize.Height),
 			DXGI_FORMAT_B8G8R8A8_UNORM,
-			0
+			DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT
 			);
 
 		if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
@@ -283,7 +292,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 		swapChainDesc.BufferCount = 2;									// Use el almacenamiento de doble búfer para minimizar la latencia.
 		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;	// Todas las aplicaciones de Microsoft Store deben usar este SwapEffect.
-		swapChainDesc.Flags = 0;
+		swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;	// WaitForNextFrame espera en ella.
 		swapChainDesc.Scaling = scaling;
 		swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
 
@@ -319,9 +328,14 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 
 		// Asegúrese de que DXGI no ponga en cola más de un fotograma cada vez. Esto reduce la latencia y
 		// garantiza que la aplicación solo se presente tras cada VSync, lo que minimiza el consumo eléctrico.
+		// Con la espera de la cadena de intercambio el límite se pone en ella y no en el dispositivo.
 		DX::ThrowIfFailed(
-			dxgiDevice->SetMaximumFrameLatency(1)
+			m_swapChain->SetMaximumFrameLatency(1)
 			);
+
+		ReleaseFrameLatencyWaitableObject();
+		m_frameLatencyWaitableObject = m_swapChain->GetFrameLatencyWaitableObject();
+		m_frameLatencySlotFree = false;
 	}
 
 	// Establezca la orientación correcta para la cadena de intercambio y genere transformaciones de matriz en 2D y
@@ -584,6 +598,7 @@ void DX::DeviceResources::ValidateDevice()
 // Vuelva a crear todos los recursos de dispositivo y vuélvalos a establecer en el estado actual.
 void DX::DeviceResources::HandleDeviceLost()
 {
+	ReleaseFrameLatencyWaitableObject();
 	m_swapChain = nullptr;
 
 	if (m_deviceNotify != nullptr)
@@ -595,6 +610,10 @@ void DX::DeviceResources::HandleDeviceLost()
 	m_d2dContext->SetDpi(m_dpi, m_dpi);
 	CreateWindowSizeDependentResources();
 
+	// Reconstruya desde memoria, empezando por lo visible, los recursos que tienen copia en el registro;
+	// los representadores solo tienen que crear el resto.
+	m_resourceRegistry.RecreateAll();
+
 	if (m_deviceNotify != nullptr)
 	{
 		m_deviceNotify->OnDeviceRestored();
@@ -617,14 +636,62 @@ void DX::DeviceResources::Trim()
 	dxgiDevice->Trim();
 }
 
+// Espera a que la cadena de intercambio admita otro fotograma y, después, hasta el momento que indica
+// FramePacer: el siguiente vsync menos el coste previsto del fotograma. Quien llama debe leer la entrada
+// después, para que el fotograma muestre la más reciente. Si el fotograma anterior no se presentó, la
+// cadena de intercambio ya tiene el hueco libre y no se vuelve a esperar en ella.
+void DX::DeviceResources::WaitForNextFrame()
+{
+	DX_PROFILE_SCOPE("DeviceResources::WaitForNextFrame");
+
+	if (m_frameLatencyWaitableObject != nullptr && !m_frameLatencySlotFree)
+	{
+		WaitForSingleObjectEx(m_frameLatencyWaitableObject, 1000, TRUE);
+		m_frameLatencySlotFree = true;
+	}
+
+	// El último vsync en el que se mostró un fotograma. Falla hasta la primera presentación.
+	DXGI_FRAME_STATISTICS statistics = {};
+	if (SUCCEEDED(m_swapChain->GetFrameStatistics(&statistics)) && statistics.SyncQPCTime.QuadPart != 0)
+	{
+		m_framePacer.OnVsync(
+			static_cast<double>(statistics.SyncQPCTime.QuadPart) / static_cast<double>(m_pacerFrequency.QuadPart),
+			statistics.SyncRefreshCount
+			);
+	}
+
+	// Se duerme hasta un milisegundo antes (la precisión del planificador) y el resto se espera activamente.
+	double now = GetPacerSeconds();
+	double start = m_framePacer.GetFrameStart(now);
+	if (start > now)
+	{
+		if (start - now > 0.001)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(start - now - 0.001));
+		}
+		while (GetPacerSeconds() < start)
+		{
+			std::this_thread::yield();
+		}
+
+		now = GetPacerSeconds();
+		m_framePacer.RecordWakeup(start, now);
+	}
+	m_framePacer.BeginFrame(now);
+}
+
 // Presente el contenido de la cadena de intercambio en la pantalla.
 void DX::DeviceResources::Present() 
 {
+	DX_PROFILE_SCOPE("DeviceResources::Present");
+
 	// El primer argumento indica a DXGI que se bloquee hasta VSync, lo que pone a la aplicación
 	// en suspensión hasta el siguiente VSync. Esto asegura que no se desperdician ciclos presentando
 	// fotogramas que no se mostrarán nunca en la pantalla.
 	DXGI_PRESENT_PARAMETERS parameters = { 0 };
 	HRESULT hr = m_swapChain->Present1(1, 0, &parameters);
+	m_framePacer.EndFrame(GetPacerSeconds());
+	m_frameLatencySlotFree = false;
 
 	// Descartar el contenido del destino de presentación.
 	// Esta es solo una operación válida cuando el contenido existente se va a sobrescribir
@@ -646,6 +713,23 @@ void DX::DeviceResources::Present()
 	}
 }
 
+void DX::DeviceResources::ReleaseFrameLatencyWaitableObject()
+{
+	if (m_frameLatencyWaitableObject != nullptr)
+	{
+		CloseHandle(m_frameLatencyWaitableObject);
+		m_frameLatencyWaitableObject = nullptr;
+	}
+}
+
+// Segundos del contador de rendimiento, el mismo reloj que SyncQPCTime de las estadísticas de DXGI.
+double DX::DeviceResources::GetPacerSeconds() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return static_cast<double>(counter.QuadPart) / static_cast<double>(m_pacerFrequency.QuadPart);
+}
+
 // Este método determina la rotación entre la orientación nativa del dispositivo de pantalla y
 // la orientación de pantalla actual.
 DXGI_MODE_ROTATION DX::DeviceResources::ComputeDisplayRotation()
@@ -1,5 +1,9 @@
 ﻿#pragma once
 
+#include "D3D11ResourceCache.h"
+#include "FramePacer.h"
+#include "ResourceRegistry.h"
+
 namespace DX
 {
 	// Proporciona una interfaz para que se notifique a una aplicación propietaria de DeviceResources cuando se pierde o se crea el dispositivo.
@@ -22,6 +26,7 @@ namespace DX
 		void HandleDeviceLost();
 		void RegisterDeviceNotify(IDeviceNotify* deviceNotify);
 		void Trim();
+		void WaitForNextFrame();
 		void Present();
 
 		// Tamaño del destino de representación en píxeles.
@@ -41,6 +46,15 @@ namespace DX
 		D3D11_VIEWPORT				GetScreenViewport() const				{ return m_screenViewport; }
 		DirectX::XMFLOAT4X4			GetOrientationTransform3D() const		{ return m_orientationTransform3D; }
 
+		// Sombreadores, diseños de entrada y estados compartidos entre representadores.
+		D3D11ResourceCache*			GetResourceCache()						{ return &m_resourceCache; }
+
+		// Copias en la CPU con las que se vuelven a crear los recursos al perder el dispositivo.
+		ResourceRegistry*			GetResourceRegistry()					{ return &m_resourceRegistry; }
+
+		// Ritmo de los fotogramas respecto al vsync de la cadena de intercambio.
+		const FramePacer&			GetFramePacer() const					{ return m_framePacer; }
+
 		// Descriptores de acceso D2D.
 		ID2D1Factory3*				GetD2DFactory() const					{ return m_d2dFactory.Get(); }
 		ID2D1Device2*				GetD2DDevice() const					{ return m_d2dDevice.Get(); }
@@ -56,11 +70,21 @@ namespace DX
 		void CreateWindowSizeDependentResources();
 		void UpdateRenderTargetSize();
 		DXGI_MODE_ROTATION ComputeDisplayRotation();
+		void ReleaseFrameLatencyWaitableObject();
+		double GetPacerSeconds() const;
 
 		// Objetos de Direct3D.
 		Microsoft::WRL::ComPtr<ID3D11Device3>			m_d3dDevice;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext3>	m_d3dContext;
 		Microsoft::WRL::ComPtr<IDXGISwapChain3>			m_swapChain;
+		D3D11ResourceCache								m_resourceCache;
+		ResourceRegistry								m_resourceRegistry;
+
+		// Espera de la cadena de intercambio hasta que admite otro fotograma y ritmo de los fotogramas.
+		HANDLE											m_frameLatencyWaitableObject;
+		bool											m_frameLatencySlotFree;
+		FramePacer										m_framePacer;
+		LARGE_INTEGER									m_pacerFrequency;
 
 		// Objetos de representación de Direct3D. Necesarios para 3D.
 		Microsoft::WRL::ComPtr<ID3D11RenderTargetView1>	m_d3dRenderTargetView;
@@ -0,0 +1,139 @@
+﻿#include "FrameArena.h"
+
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+using namespace DX;
+
+DX::LinearArena::LinearArena(size_t capacity) :
+	m_base(nullptr),
+	m_capacity(capacity),
+	m_offset(0),
+	m_overflowBytes(0),
+	m_allocationCount(0)
+{
+	if (capacity > 0)
+	{
+		m_base = static_cast<uint8_t*>(malloc(capacity));
+		if (m_base == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		TrackAllocation(MemoryTag::FrameArena, capacity);
+	}
+}
+
+DX::LinearArena::~LinearArena()
+{
+	Reset();
+	if (m_base != nullptr)
+	{
+		TrackFree(MemoryTag::FrameArena, m_capacity);
+		free(m_base);
+	}
+}
+
+void* DX::LinearArena::Allocate(size_t size, size_t alignment)
+{
+	m_allocationCount++;
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(m_base) + m_offset;
+	uintptr_t aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	size_t end = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(m_base)) + size;
+	if (m_base != nullptr && end <= m_capacity)
+	{
+		m_offset = end;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	// No cabe: bloque aparte con espacio para alinear. Se libera en Reset.
+	void* block = malloc(size + alignment);
+	if (block == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	m_overflowBlocks.push_back(block);
+	m_overflowBytes += size + alignment;
+	TrackAllocation(MemoryTag::FrameArena, size + alignment);
+	uintptr_t blockAddress = reinterpret_cast<uintptr_t>(block);
+	return reinterpret_cast<void*>((blockAddress + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
+
+void DX::LinearArena::Reset()
+{
+	for (void* block : m_overflowBlocks)
+	{
+		free(block);
+	}
+	m_overflowBlocks.clear();
+	TrackFree(MemoryTag::FrameArena, m_overflowBytes);
+
+	// Si hubo desbordamiento, el bloque principal crece para que el mismo volumen quepa la próxima vez.
+	if (m_overflowBytes > 0)
+	{
+		size_t capacity = (m_offset + m_overflowBytes) * 3 / 2;
+		uint8_t* base = static_cast<uint8_t*>(malloc(capacity));
+		if (base != nullptr)
+		{
+			if (m_base != nullptr)
+			{
+				TrackFree(MemoryTag::FrameArena, m_capacity);
+			}
+			TrackAllocation(MemoryTag::FrameArena, capacity);
+			free(m_base);
+			m_base = base;
+			m_capacity = capacity;
+		}
+	}
+
+	m_offset = 0;
+	m_overflowBytes = 0;
+	m_allocationCount = 0;
+}
+
+DX::FrameArena::FrameArena(uint32_t threadCount, size_t bytesPerThread) :
+	m_threadCount(threadCount > 0 ? threadCount : 1),
+	m_current(0),
+	m_frame(0)
+{
+	for (uint32_t i = 0; i < 2 * m_threadCount; i++)
+	{
+		m_arenas.push_back(std::unique_ptr<LinearArena>(new LinearArena(bytesPerThread)));
+	}
+	m_lastFrameStats = FrameArenaStats();
+}
+
+void DX::FrameArena::BeginFrame()
+{
+	FrameArenaStats stats = FrameArenaStats();
+	stats.frame = m_frame;
+	for (uint32_t t = 0; t < m_threadCount; t++)
+	{
+		const LinearArena& arena = *m_arenas[m_current * m_threadCount + t];
+		stats.bytes += arena.GetUsedBytes();
+		stats.allocations += arena.GetAllocationCount();
+		stats.overflowAllocations += arena.GetOverflowCount();
+	}
+	m_lastFrameStats = stats;
+
+	// El otro búfer contiene lo reservado hace dos fotogramas; ya nadie lo usa.
+	m_current ^= 1;
+	m_frame++;
+	for (uint32_t t = 0; t < m_threadCount; t++)
+	{
+		m_arenas[m_current * m_threadCount + t]->Reset();
+	}
+}
+
+LinearArena& DX::FrameArena::GetArena()
+{
+	uint32_t thread = JobSystem::GetCurrentThreadIndex();
+	if (thread >= m_threadCount)
+	{
+		throw std::out_of_range("El subproceso no tiene subarena: el JobSystem tiene más subprocesos que la FrameArena");
+	}
+	return *m_arenas[m_current * m_threadCount + thread];
+}
@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// Asignador lineal: cada reserva avanza un desplazamiento y la memoria se libera toda a la vez con Reset.
+	// Si el bloque se queda corto, las reservas que no caben se sirven desde bloques de desbordamiento y, en
+	// el siguiente Reset, el bloque principal crece para que en régimen estable no se toque el montón general.
+	class LinearArena
+	{
+	public:
+		explicit LinearArena(size_t capacity = 0);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		void Reset();
+
+		size_t GetCapacity() const					{ return m_capacity; }
+		size_t GetUsedBytes() const					{ return m_offset + m_overflowBytes; }
+		uint32_t GetAllocationCount() const			{ return m_allocationCount; }
+		uint32_t GetOverflowCount() const			{ return static_cast<uint32_t>(m_overflowBlocks.size()); }
+
+	private:
+		uint8_t*			m_base;
+		size_t				m_capacity;
+		size_t				m_offset;
+		std::vector<void*>	m_overflowBlocks;
+		size_t				m_overflowBytes;
+		uint32_t			m_allocationCount;
+	};
+
+	// Resumen de las reservas de un fotograma completo, sumando las subarenas de todos los subprocesos.
+	struct FrameArenaStats
+	{
+		uint64_t	frame;
+		size_t		bytes;
+		uint32_t	allocations;
+		uint32_t	overflowAllocations;
+	};
+
+	// Arena por fotograma con doble búfer: la memoria reservada en el fotograma N sigue siendo válida durante
+	// el fotograma N + 1 (por ejemplo, para datos que la GPU o un trabajo asincrónico leen con retraso) y se
+	// recicla al empezar el N + 2. Cada subproceso de DX::JobSystem tiene su propia subarena, así que reservar
+	// desde un trabajo no necesita sincronización. Solo deben usarla el subproceso del bucle y los trabajadores.
+	class FrameArena
+	{
+	public:
+		FrameArena(uint32_t threadCount, size_t bytesPerThread);
+
+		// Cierra el fotograma actual (sus estadísticas pasan a GetLastFrameStats) y empieza el siguiente.
+		void BeginFrame();
+
+		// Subarena del subproceso actual en el fotograma actual, según JobSystem::GetCurrentThreadIndex. Solo
+		// pueden llamarla el subproceso del bucle y los trabajadores de un JobSystem con como mucho
+		// threadCount subprocesos: cualquier otro subproceso tiene el índice 0 y compartiría la subarena del
+		// bucle sin sincronización. Un índice fuera de rango (un grupo mayor que la arena) lanza out_of_range.
+		LinearArena& GetArena();
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))	{ return GetArena().Allocate(size, alignment); }
+
+		const FrameArenaStats& GetLastFrameStats() const	{ return m_lastFrameStats; }
+
+	private:
+		uint32_t									m_threadCount;
+		uint32_t									m_current;
+		uint64_t									m_frame;
+		std::vector<std::unique_ptr<LinearArena>>	m_arenas;		// [búfer][subproceso]
+		FrameArenaStats								m_lastFrameStats;
+	};
+
+	// Adaptador de asignador de la STL sobre una LinearArena. deallocate no hace nada: la memoria se
+	// recupera al reiniciar la arena, así que el contenedor no debe sobrevivir a su fotograma.
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		explicit ArenaAllocator(LinearArena& arena) noexcept : m_arena(&arena) {}
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.GetArena()) {}
+
+		T* allocate(size_t count)					{ return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) noexcept		{}
+
+		LinearArena* GetArena() const noexcept		{ return m_arena; }
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const noexcept	{ return m_arena == other.GetArena(); }
+		template<typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const noexcept	{ return m_arena != other.GetArena(); }
+
+	private:
+		LinearArena*	m_arena;
+	};
+
+	template<typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+	typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
+	typedef std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>> ArenaWString;
+}
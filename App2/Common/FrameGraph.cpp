@@ -0,0 +1,315 @@
+﻿#include "FrameGraph.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+
+DX::FrameGraph::FrameGraph()
+{
+	Reset();
+}
+
+void DX::FrameGraph::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_order.clear();
+	m_physical.clear();
+	m_errors.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_compiled = false;
+}
+
+FrameGraphResource DX::FrameGraph::CreateTexture(const char* name, const FrameGraphTextureDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resource.imported = false;
+	resource.firstUse = FrameGraphInvalid;
+	resource.lastUse = 0;
+	resource.physical = FrameGraphInvalid;
+	m_resources.push_back(resource);
+	m_compiled = false;
+	return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+FrameGraphResource DX::FrameGraph::ImportTexture(const char* name, const FrameGraphTextureDesc& desc)
+{
+	FrameGraphResource resource = CreateTexture(name, desc);
+	m_resources[resource].imported = true;
+	return resource;
+}
+
+FrameGraphPass DX::FrameGraph::AddPass(const char* name, const ExecuteFunction& execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.sideEffect = false;
+	pass.live = false;
+	m_passes.push_back(pass);
+	m_compiled = false;
+	return static_cast<FrameGraphPass>(m_passes.size() - 1);
+}
+
+bool DX::FrameGraph::IsValidPass(FrameGraphPass pass, const char* operation)
+{
+	if (pass >= m_passes.size())
+	{
+		AddError(std::string(operation) + ": pase no válido");
+		return false;
+	}
+	return true;
+}
+
+bool DX::FrameGraph::IsValidResource(FrameGraphResource resource, const char* operation)
+{
+	if (resource >= m_resources.size())
+	{
+		AddError(std::string(operation) + ": textura no válida");
+		return false;
+	}
+	return true;
+}
+
+void DX::FrameGraph::Read(FrameGraphPass pass, FrameGraphResource resource)
+{
+	if (IsValidPass(pass, "Read") && IsValidResource(resource, "Read"))
+	{
+		std::vector<FrameGraphResource>& reads = m_passes[pass].reads;
+		if (std::find(reads.begin(), reads.end(), resource) == reads.end())
+		{
+			reads.push_back(resource);
+		}
+		m_compiled = false;
+	}
+}
+
+void DX::FrameGraph::Write(FrameGraphPass pass, FrameGraphResource resource)
+{
+	if (IsValidPass(pass, "Write") && IsValidResource(resource, "Write"))
+	{
+		std::vector<FrameGraphResource>& writes = m_passes[pass].writes;
+		if (std::find(writes.begin(), writes.end(), resource) == writes.end())
+		{
+			writes.push_back(resource);
+		}
+		m_compiled = false;
+	}
+}
+
+void DX::FrameGraph::SetSideEffect(FrameGraphPass pass)
+{
+	if (IsValidPass(pass, "SetSideEffect"))
+	{
+		m_passes[pass].sideEffect = true;
+		m_compiled = false;
+	}
+}
+
+bool DX::FrameGraph::Compile()
+{
+	// Los errores de declaración se conservan; los de una compilación anterior, no.
+	m_errors.erase(
+		std::remove_if(m_errors.begin(), m_errors.end(), [](const std::string& error) { return error.compare(0, 8, "Compile:") == 0; }),
+		m_errors.end());
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_compiled = false;
+
+	Validate();
+	if (!m_errors.empty())
+	{
+		return false;
+	}
+
+	Cull();
+	ComputeLifetimes();
+	AssignPhysicalTextures();
+	m_compiled = true;
+	return true;
+}
+
+// Una textura transitoria no tiene contenido hasta que un pase anterior la escribe.
+void DX::FrameGraph::Validate()
+{
+	std::vector<bool> written(m_resources.size(), false);
+	for (const Pass& pass : m_passes)
+	{
+		for (FrameGraphResource resource : pass.reads)
+		{
+			if (!m_resources[resource].imported && !written[resource])
+			{
+				AddError("Compile: el pase '" + pass.name + "' lee '" + m_resources[resource].name + "' antes de que ningún pase la escriba");
+			}
+		}
+		for (FrameGraphResource resource : pass.writes)
+		{
+			written[resource] = true;
+		}
+	}
+}
+
+// Recorre los pases de atrás adelante: un pase vive si escribe algo que un pase vivo posterior lee, o una
+// textura importada cuyo contenido final no se sobrescribe después, o si tiene efectos secundarios.
+void DX::FrameGraph::Cull()
+{
+	std::vector<bool> needed(m_resources.size(), false);
+	for (size_t i = 0; i < m_resources.size(); i++)
+	{
+		needed[i] = m_resources[i].imported;
+	}
+
+	for (size_t p = m_passes.size(); p-- > 0;)
+	{
+		Pass& pass = m_passes[p];
+		pass.live = pass.sideEffect;
+		for (FrameGraphResource resource : pass.writes)
+		{
+			pass.live = pass.live || needed[resource];
+		}
+
+		if (!pass.live)
+		{
+			continue;
+		}
+
+		// Lo que escribe este pase ya no hace falta de pases anteriores, salvo que también lo lea.
+		for (FrameGraphResource resource : pass.writes)
+		{
+			needed[resource] = false;
+		}
+		for (FrameGraphResource resource : pass.reads)
+		{
+			needed[resource] = true;
+		}
+	}
+
+	m_order.clear();
+	for (size_t p = 0; p < m_passes.size(); p++)
+	{
+		if (m_passes[p].live)
+		{
+			m_order.push_back(static_cast<FrameGraphPass>(p));
+		}
+	}
+
+	m_stats.passes = static_cast<uint32_t>(m_passes.size());
+	m_stats.culledPasses = static_cast<uint32_t>(m_passes.size() - m_order.size());
+}
+
+void DX::FrameGraph::ComputeLifetimes()
+{
+	for (Resource& resource : m_resources)
+	{
+		resource.firstUse = FrameGraphInvalid;
+		resource.lastUse = 0;
+		resource.physical = FrameGraphInvalid;
+	}
+
+	for (uint32_t position = 0; position < m_order.size(); position++)
+	{
+		const Pass& pass = m_passes[m_order[position]];
+		auto touch = [&](FrameGraphResource index)
+		{
+			Resource& resource = m_resources[index];
+			if (resource.firstUse == FrameGraphInvalid)
+			{
+				resource.firstUse = position;
+			}
+			resource.lastUse = position;
+		};
+		for (FrameGraphResource resource : pass.reads)
+		{
+			touch(resource);
+		}
+		for (FrameGraphResource resource : pass.writes)
+		{
+			touch(resource);
+		}
+	}
+}
+
+// Reparto voraz por orden de primer uso: cada textura reutiliza una física compatible que ya esté libre
+// (su último usuario va antes que el primero de esta) o crea una nueva.
+void DX::FrameGraph::AssignPhysicalTextures()
+{
+	std::vector<FrameGraphResource> transients;
+	for (size_t i = 0; i < m_resources.size(); i++)
+	{
+		const Resource& resource = m_resources[i];
+		if (!resource.imported && resource.firstUse != FrameGraphInvalid)
+		{
+			transients.push_back(static_cast<FrameGraphResource>(i));
+		}
+	}
+	std::stable_sort(transients.begin(), transients.end(), [this](FrameGraphResource a, FrameGraphResource b)
+	{
+		return m_resources[a].firstUse < m_resources[b].firstUse;
+	});
+
+	m_physical.clear();
+	std::vector<uint32_t> physicalLastUse;
+	for (FrameGraphResource index : transients)
+	{
+		Resource& resource = m_resources[index];
+		uint32_t chosen = FrameGraphInvalid;
+		for (uint32_t physical = 0; physical < m_physical.size(); physical++)
+		{
+			if (physicalLastUse[physical] < resource.firstUse && m_physical[physical] == resource.desc)
+			{
+				chosen = physical;
+				break;
+			}
+		}
+
+		if (chosen == FrameGraphInvalid)
+		{
+			chosen = static_cast<uint32_t>(m_physical.size());
+			m_physical.push_back(resource.desc);
+			physicalLastUse.push_back(0);
+			m_stats.aliasedBytes += resource.desc.GetSize();
+		}
+
+		resource.physical = chosen;
+		physicalLastUse[chosen] = resource.lastUse;
+		m_stats.unaliasedBytes += resource.desc.GetSize();
+	}
+
+	// Bytes vivos en cada posición: se suman al primer uso y se restan tras el último.
+	std::vector<int64_t> delta(m_order.size() + 1, 0);
+	for (FrameGraphResource index : transients)
+	{
+		const Resource& resource = m_resources[index];
+		delta[resource.firstUse] += static_cast<int64_t>(resource.desc.GetSize());
+		delta[resource.lastUse + 1] -= static_cast<int64_t>(resource.desc.GetSize());
+	}
+	int64_t liveBytes = 0;
+	for (uint32_t position = 0; position < m_order.size(); position++)
+	{
+		liveBytes += delta[position];
+		m_stats.peakLiveBytes = std::max(m_stats.peakLiveBytes, static_cast<uint64_t>(liveBytes));
+	}
+
+	m_stats.transientTextures = static_cast<uint32_t>(transients.size());
+	m_stats.physicalTextures = static_cast<uint32_t>(m_physical.size());
+}
+
+void DX::FrameGraph::Execute() const
+{
+	if (!m_compiled)
+	{
+		return;
+	}
+
+	for (FrameGraphPass index : m_order)
+	{
+		const Pass& pass = m_passes[index];
+		if (pass.execute)
+		{
+			pass.execute(*this);
+		}
+	}
+}
@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// Descripción de una textura del grafo. format es el valor del API (DXGI_FORMAT en la aplicación); como
+	// el grafo no conoce los formatos, el tamaño de cada píxel se indica aparte.
+	struct FrameGraphTextureDesc
+	{
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	format;
+		uint32_t	bytesPerPixel;
+
+		uint64_t GetSize() const	{ return static_cast<uint64_t>(width) * height * bytesPerPixel; }
+		bool operator==(const FrameGraphTextureDesc& other) const
+		{
+			return width == other.width && height == other.height && format == other.format && bytesPerPixel == other.bytesPerPixel;
+		}
+	};
+
+	typedef uint32_t FrameGraphResource;
+	typedef uint32_t FrameGraphPass;
+	const uint32_t FrameGraphInvalid = 0xffffffff;
+
+	// Resultado de la última compilación. Los bytes son solo de las texturas transitorias.
+	struct FrameGraphStats
+	{
+		uint32_t	passes;
+		uint32_t	culledPasses;
+		uint32_t	transientTextures;
+		uint32_t	physicalTextures;
+		uint64_t	unaliasedBytes;		// Una textura por recurso transitorio.
+		uint64_t	aliasedBytes;		// Con las texturas físicas compartidas.
+		uint64_t	peakLiveBytes;		// Máximo de bytes vivos a la vez: el mínimo posible.
+	};
+
+	// Grafo de pases de un fotograma. Los pases declaran qué texturas leen y escriben; Compile descarta los
+	// que no contribuyen a ninguna textura importada (ni tienen efectos secundarios), fija el orden de
+	// ejecución y asigna a cada textura transitoria una textura física, compartida con otras cuyas vidas no
+	// se solapan y que tienen la misma descripción (Direct3D 11 no permite solapar memoria de otro modo).
+	//
+	// El orden de declaración define las versiones: un pase lee lo que escribió el último pase declarado
+	// antes que él. Un pase que dibuja sobre el contenido anterior debe declarar la textura como leída y
+	// escrita. El grafo se construye al cambiar la configuración y se ejecuta en cada fotograma.
+	class FrameGraph
+	{
+	public:
+		typedef std::function<void(const FrameGraph& graph)> ExecuteFunction;
+
+		FrameGraph();
+
+		// Vacía el grafo para volver a construirlo.
+		void Reset();
+
+		FrameGraphResource CreateTexture(const char* name, const FrameGraphTextureDesc& desc);
+		FrameGraphResource ImportTexture(const char* name, const FrameGraphTextureDesc& desc);
+
+		FrameGraphPass AddPass(const char* name, const ExecuteFunction& execute);
+		void Read(FrameGraphPass pass, FrameGraphResource resource);
+		void Write(FrameGraphPass pass, FrameGraphResource resource);
+
+		// El pase se ejecuta aunque no escriba nada que se use (por ejemplo, una lectura hacia la CPU).
+		void SetSideEffect(FrameGraphPass pass);
+
+		// Valida, descarta, ordena y asigna texturas. Devuelve false si hay errores (GetErrors).
+		bool Compile();
+		const std::vector<std::string>& GetErrors() const	{ return m_errors; }
+
+		// Ejecuta los pases vivos en orden. Requiere un Compile correcto.
+		void Execute() const;
+
+		const FrameGraphStats& GetStats() const				{ return m_stats; }
+		const std::vector<FrameGraphPass>& GetExecutionOrder() const	{ return m_order; }
+		bool IsPassCulled(FrameGraphPass pass) const		{ return !m_passes[pass].live; }
+		const char* GetPassName(FrameGraphPass pass) const	{ return m_passes[pass].name.c_str(); }
+
+		// Textura física de un recurso transitorio, o FrameGraphInvalid si es importado o no se usa.
+		uint32_t GetPhysicalTexture(FrameGraphResource resource) const	{ return m_resources[resource].physical; }
+		uint32_t GetPhysicalTextureCount() const			{ return static_cast<uint32_t>(m_physical.size()); }
+		const FrameGraphTextureDesc& GetPhysicalTextureDesc(uint32_t physical) const	{ return m_physical[physical]; }
+		const FrameGraphTextureDesc& GetTextureDesc(FrameGraphResource resource) const	{ return m_resources[resource].desc; }
+
+	private:
+		struct Resource
+		{
+			std::string				name;
+			FrameGraphTextureDesc	desc;
+			bool					imported;
+			uint32_t				firstUse;	// Posición en el orden de ejecución.
+			uint32_t				lastUse;
+			uint32_t				physical;
+		};
+
+		struct Pass
+		{
+			std::string						name;
+			ExecuteFunction					execute;
+			std::vector<FrameGraphResource>	reads;
+			std::vector<FrameGraphResource>	writes;
+			bool							sideEffect;
+			bool							live;
+		};
+
+		bool IsValidPass(FrameGraphPass pass, const char* operation);
+		bool IsValidResource(FrameGraphResource resource, const char* operation);
+		void AddError(const std::string& error)				{ m_errors.push_back(error); }
+
+		void Validate();
+		void Cull();
+		void ComputeLifetimes();
+		void AssignPhysicalTextures();
+
+		std::vector<Resource>				m_resources;
+		std::vector<Pass>					m_passes;
+		std::vector<FrameGraphPass>			m_order;
+		std::vector<FrameGraphTextureDesc>	m_physical;
+		std::vector<std::string>			m_errors;
+		FrameGraphStats						m_stats;
+		bool								m_compiled;
+	};
+}
@@ -0,0 +1,124 @@
+﻿#include "FrameInvalidation.h"
+
+using namespace DX;
+
+// El primer fotograma siempre se dibuja.
+FrameInvalidation::FrameInvalidation() :
+	m_reasons(ToMask(FrameInvalidationReason::Window)),
+	m_waiting(false),
+	m_onDemand(true),
+	m_idleInterval(Clock::duration::zero()),
+	m_lastFrame(Clock::now()),
+	m_stats()
+{
+}
+
+void FrameInvalidation::SetIdleFramesPerSecond(double framesPerSecond)
+{
+	m_idleInterval = (framesPerSecond > 0.0)
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond))
+		: Clock::duration::zero();
+}
+
+void FrameInvalidation::SetWakeCallback(const std::function<void()>& wake)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_wake = wake;
+}
+
+// El mutex evita que el aviso se pierda entre la comprobación de Wait y su bloqueo. Solo se despierta al
+// bucle si está esperando, de modo que marcar el fotograma mientras se dibuja no cuesta nada más.
+void FrameInvalidation::Invalidate(FrameInvalidationReason reason)
+{
+	m_reasons.fetch_or(ToMask(reason));
+	if (!m_waiting.exchange(false))
+	{
+		return;
+	}
+
+	std::function<void()> wake;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		wake = m_wake;
+	}
+	m_condition.notify_all();
+	if (wake)
+	{
+		wake();
+	}
+}
+
+uint32_t FrameInvalidation::BeginFrame()
+{
+	uint32_t reasons = m_reasons.exchange(0);
+	if (!m_onDemand)
+	{
+		reasons |= ToMask(FrameInvalidationReason::Animation);
+	}
+
+	Clock::time_point now = Clock::now();
+	if (reasons == 0 && m_idleInterval != Clock::duration::zero() && now - m_lastFrame >= m_idleInterval)
+	{
+		reasons = ToMask(FrameInvalidationReason::Idle);
+	}
+
+	if (reasons != 0)
+	{
+		m_lastFrame = now;
+		m_stats.frames++;
+		if (reasons == ToMask(FrameInvalidationReason::Idle))
+		{
+			m_stats.idleFrames++;
+		}
+	}
+	return reasons;
+}
+
+double FrameInvalidation::GetIdleWaitSeconds() const
+{
+	if (m_idleInterval == Clock::duration::zero())
+	{
+		return -1.0;
+	}
+
+	double seconds = std::chrono::duration<double>(m_lastFrame + m_idleInterval - Clock::now()).count();
+	return (seconds > 0.0) ? seconds : 0.0;
+}
+
+bool FrameInvalidation::BeginWait()
+{
+	m_waiting = true;
+	if (m_reasons.load() != 0 || !m_onDemand)
+	{
+		m_waiting = false;
+		return false;
+	}
+	m_stats.waits++;
+	return true;
+}
+
+void FrameInvalidation::EndWait()
+{
+	m_waiting = false;
+}
+
+void FrameInvalidation::Wait()
+{
+	if (!BeginWait())
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto invalidated = [this]() { return m_reasons.load() != 0; };
+	if (m_idleInterval != Clock::duration::zero())
+	{
+		m_condition.wait_until(lock, m_lastFrame + m_idleInterval, invalidated);
+	}
+	else
+	{
+		m_condition.wait(lock, invalidated);
+	}
+	lock.unlock();
+	EndWait();
+}
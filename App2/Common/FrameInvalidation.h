@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace DX
+{
+	// Motivos para dibujar un fotograma. BeginFrame devuelve una máscara con un bit por motivo.
+	enum class FrameInvalidationReason : uint32_t
+	{
+		Animation,		// La escena avanza con el reloj.
+		Input,			// Puntero o teclado.
+		Window,			// Tamaño, orientación, visibilidad o contenido de la pantalla.
+		Device,			// Dispositivo recreado.
+		Loading,		// Recursos que terminan de cargarse en segundo plano.
+		Streaming,		// Trozos de terreno pendientes.
+		Idle,			// Refresco periódico sin cambios.
+		Count,
+	};
+
+	struct FrameInvalidationStats
+	{
+		uint64_t	frames;			// Fotogramas dibujados.
+		uint64_t	idleFrames;		// De ellos, solo por el refresco periódico.
+		uint64_t	waits;			// Veces que el bucle se ha bloqueado esperando un cambio.
+	};
+
+	// Dibujo bajo demanda: los subsistemas marcan el fotograma como sucio con Invalidate y el bucle solo
+	// actualiza y dibuja si hay algo marcado; si no, se bloquea hasta el siguiente cambio o hasta que toque
+	// el refresco periódico (idleFramesPerSecond, 0 para ninguno). Invalidate se puede llamar desde
+	// cualquier subproceso y despierta al bucle si está esperando: con Wait, o con la función de
+	// SetWakeCallback si el bucle espera en otro sitio (la cola de eventos de la ventana).
+	class FrameInvalidation
+	{
+	public:
+		FrameInvalidation();
+
+		FrameInvalidation(const FrameInvalidation&) = delete;
+		FrameInvalidation& operator=(const FrameInvalidation&) = delete;
+
+		// Sin bajo demanda, todos los fotogramas se dibujan como antes.
+		void SetOnDemand(bool onDemand)					{ m_onDemand = onDemand; }
+		bool IsOnDemand() const							{ return m_onDemand; }
+		void SetIdleFramesPerSecond(double framesPerSecond);
+
+		void Invalidate(FrameInvalidationReason reason);
+		void SetWakeCallback(const std::function<void()>& wake);
+
+		static bool HasReason(uint32_t reasons, FrameInvalidationReason reason)	{ return (reasons & ToMask(reason)) != 0; }
+
+		// Al principio de cada vuelta del bucle: devuelve los motivos pendientes (y los borra), Idle si toca
+		// el refresco periódico, o 0 si no hay que dibujar.
+		uint32_t BeginFrame();
+
+		// Segundos hasta el siguiente refresco periódico, o un valor negativo si no hay.
+		double GetIdleWaitSeconds() const;
+
+		// Para bucles que esperan en otro sitio: BeginWait devuelve false si ya hay motivos pendientes (no
+		// hay que bloquearse); si devuelve true, Invalidate llamará a la función de despertar hasta EndWait.
+		bool BeginWait();
+		void EndWait();
+
+		// Bloquea el subproceso hasta el siguiente Invalidate o el siguiente refresco periódico.
+		void Wait();
+
+		FrameInvalidationStats GetStats() const			{ return m_stats; }
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		static uint32_t ToMask(FrameInvalidationReason reason)	{ return 1u << static_cast<uint32_t>(reason); }
+
+		std::atomic<uint32_t>		m_reasons;
+		std::atomic<bool>			m_waiting;
+		bool						m_onDemand;
+		Clock::duration				m_idleInterval;		// Cero si no hay refresco periódico.
+		Clock::time_point			m_lastFrame;
+
+		std::mutex					m_mutex;
+		std::condition_variable		m_condition;
+		std::function<void()>		m_wake;
+
+		FrameInvalidationStats		m_stats;
+	};
+}
@@ -0,0 +1,153 @@
+﻿#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+FramePacerDesc FramePacerDesc::CreateDefault()
+{
+	FramePacerDesc desc;
+	desc.refreshPeriod = 1.0 / 60.0;
+	desc.historyLength = 64;
+	desc.percentile = 0.99;
+	desc.safetyMargin = 0.0005;
+	return desc;
+}
+
+void FramePacer::History::Add(double value)
+{
+	m_values[m_next] = value;
+	m_next = (m_next + 1) % static_cast<uint32_t>(m_values.size());
+	m_count = std::min(m_count + 1, static_cast<uint32_t>(m_values.size()));
+}
+
+// Son pocos valores: se copian y se busca el percentil con nth_element.
+double FramePacer::History::GetPercentile(double percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0.0;
+	}
+
+	m_scratch.assign(m_values.begin(), m_values.begin() + m_count);
+	size_t index = std::min(static_cast<size_t>(percentile * m_count), static_cast<size_t>(m_count - 1));
+	std::nth_element(m_scratch.begin(), m_scratch.begin() + index, m_scratch.end());
+	return m_scratch[index];
+}
+
+FramePacer::FramePacer(const FramePacerDesc& desc) :
+	m_desc(desc),
+	m_frameCosts(std::max(desc.historyLength, 1u)),
+	m_wakeupDelays(std::max(desc.historyLength, 1u)),
+	m_hasVsync(false),
+	m_lastVsync(0.0),
+	m_lastRefreshCount(0),
+	m_refreshPeriod(desc.refreshPeriod),
+	m_margin(desc.safetyMargin),
+	m_inFrame(false),
+	m_frameStart(0.0),
+	m_frameDeadline(0.0),
+	m_totalDelay(0.0),
+	m_pendingDelay(0.0),
+	m_stats()
+{
+}
+
+// El periodo se suaviza y solo se acepta si es razonable (entre 20 y 500 Hz), de modo que un salto en
+// las estadísticas no lo estropee.
+void FramePacer::OnVsync(double seconds, uint64_t refreshCount)
+{
+	if (m_hasVsync && refreshCount > m_lastRefreshCount && seconds > m_lastVsync)
+	{
+		double period = (seconds - m_lastVsync) / static_cast<double>(refreshCount - m_lastRefreshCount);
+		if (period > 0.002 && period < 0.05)
+		{
+			m_refreshPeriod += (period - m_refreshPeriod) * 0.1;
+		}
+	}
+
+	m_hasVsync = true;
+	m_lastVsync = seconds;
+	m_lastRefreshCount = refreshCount;
+}
+
+double FramePacer::GetNextVsync(double time) const
+{
+	if (!m_hasVsync)
+	{
+		return time;
+	}
+
+	double periods = floor((time - m_lastVsync) / m_refreshPeriod) + 1.0;
+	return m_lastVsync + periods * m_refreshPeriod;
+}
+
+// Si el fotograma previsto no cabe antes del próximo vsync se empieza ya: esperar al siguiente bajaría
+// los fotogramas por segundo. Hasta tener fotogramas medidos no se retrasa nada.
+double FramePacer::GetFrameStart(double now) const
+{
+	if (!m_hasVsync || m_frameCosts.GetCount() == 0)
+	{
+		return now;
+	}
+
+	double start = GetNextVsync(now) - GetPredictedFrameSeconds();
+	return (start > now) ? start : now;
+}
+
+void FramePacer::RecordWakeup(double requested, double actual)
+{
+	m_wakeupDelays.Add(std::max(actual - requested, 0.0));
+}
+
+void FramePacer::BeginFrame(double start)
+{
+	double expectedEnd = start + m_frameCosts.GetPercentile(m_desc.percentile);
+	m_inFrame = true;
+	m_frameStart = start;
+	m_frameDeadline = GetNextVsync(expectedEnd);
+	m_pendingDelay = m_hasVsync ? std::max(start - m_lastVsync, 0.0) : 0.0;
+}
+
+FramePacingSample FramePacer::EndFrame(double end)
+{
+	FramePacingSample sample = {};
+	if (!m_inFrame)
+	{
+		return sample;
+	}
+	m_inFrame = false;
+
+	sample.start = m_frameStart;
+	sample.end = end;
+	sample.deadline = m_frameDeadline;
+	sample.displayed = m_hasVsync ? GetNextVsync(end) : end;
+	sample.missed = m_hasVsync && sample.displayed > m_frameDeadline + 0.5 * m_refreshPeriod;
+	sample.latency = sample.displayed - sample.start;
+
+	m_frameCosts.Add(end - m_frameStart);
+
+	// Un fallo sube la holgura en la mínima (hasta un cuarto de periodo); cada acierto la acerca a ella.
+	if (sample.missed)
+	{
+		m_margin = std::min(m_margin + m_desc.safetyMargin, 0.25 * m_refreshPeriod);
+		m_stats.missedDeadlines++;
+	}
+	else
+	{
+		m_margin = m_desc.safetyMargin + (m_margin - m_desc.safetyMargin) * 0.98;
+	}
+
+	m_stats.frames++;
+	m_totalDelay += m_pendingDelay;
+	m_stats.averageDelay = m_totalDelay / static_cast<double>(m_stats.frames);
+	m_stats.lastLatency = sample.latency;
+	m_stats.predictedSeconds = GetPredictedFrameSeconds();
+	return sample;
+}
+
+double FramePacer::GetPredictedFrameSeconds() const
+{
+	return m_frameCosts.GetPercentile(m_desc.percentile) + m_wakeupDelays.GetPercentile(m_desc.percentile) + m_margin;
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	struct FramePacerDesc
+	{
+		double		refreshPeriod;		// Segundos entre vsync hasta que se mide con OnVsync.
+		uint32_t	historyLength;		// Fotogramas recordados para predecir el coste.
+		double		percentile;			// Percentil del coste reciente que se toma como previsto (0..1).
+		double		safetyMargin;		// Segundos de holgura mínimos antes del vsync.
+
+		static FramePacerDesc CreateDefault();
+	};
+
+	// Un fotograma medido: empieza (y lee la entrada) en start, termina de enviarse en end y se muestra en
+	// el vsync displayed. latency es displayed - start.
+	struct FramePacingSample
+	{
+		double	start;
+		double	end;
+		double	deadline;		// Vsync al que apuntaba.
+		double	displayed;
+		double	latency;
+		bool	missed;			// Terminó después de deadline y se mostró un vsync más tarde.
+	};
+
+	struct FramePacerStats
+	{
+		uint64_t	frames;
+		uint64_t	missedDeadlines;
+		double		predictedSeconds;	// Coste previsto del siguiente fotograma, con los márgenes.
+		double		lastLatency;
+		double		averageDelay;		// Espera media antes de empezar los fotogramas.
+	};
+
+	// Ritmo de fotogramas predictivo. En lugar de empezar el fotograma en cuanto Present deja de bloquear
+	// (justo después de un vsync, con la entrada un fotograma entero atrasada hasta el siguiente), lo
+	// retrasa hasta el último momento en que aún llega a tiempo: el siguiente vsync menos el coste
+	// previsto (un percentil alto de los fotogramas recientes), la holgura y el retraso con el que suele
+	// despertar la espera. Cada fallo aumenta la holgura, que vuelve poco a poco a la mínima.
+	// Los tiempos son segundos de cualquier reloj monotónico, que pone quien llama: el de la plataforma en
+	// la aplicación o uno simulado en las pruebas.
+	class FramePacer
+	{
+	public:
+		explicit FramePacer(const FramePacerDesc& desc = FramePacerDesc::CreateDefault());
+
+		// Vsync observado (por ejemplo, de las estadísticas de la cadena de intercambio) con su número de
+		// refresco; de dos seguidos se mide el periodo.
+		void OnVsync(double seconds, uint64_t refreshCount);
+		bool HasVsync() const							{ return m_hasVsync; }
+		double GetRefreshPeriod() const					{ return m_refreshPeriod; }
+
+		// Primer vsync estrictamente posterior a time.
+		double GetNextVsync(double time) const;
+
+		// Momento en que conviene empezar el fotograma, no antes de now. Sin vsync conocido, now.
+		double GetFrameStart(double now) const;
+
+		// Retraso con el que despertó la espera hasta GetFrameStart.
+		void RecordWakeup(double requested, double actual);
+
+		void BeginFrame(double start);
+		FramePacingSample EndFrame(double end);
+
+		double GetPredictedFrameSeconds() const;
+		const FramePacerStats& GetStats() const			{ return m_stats; }
+
+	private:
+		// Últimos valores en un anillo, para tomar percentiles.
+		class History
+		{
+		public:
+			explicit History(uint32_t length) : m_values(length, 0.0), m_next(0), m_count(0) {}
+
+			void Add(double value);
+			uint32_t GetCount() const			{ return m_count; }
+			double GetPercentile(double percentile) const;
+
+		private:
+			std::vector<double>			m_values;
+			mutable std::vector<double>	m_scratch;
+			uint32_t					m_next;
+			uint32_t					m_count;
+		};
+
+		FramePacerDesc		m_desc;
+		History				m_frameCosts;
+		History				m_wakeupDelays;
+
+		bool				m_hasVsync;
+		double				m_lastVsync;
+		uint64_t			m_lastRefreshCount;
+		double				m_refreshPeriod;
+		double				m_margin;
+
+		bool				m_inFrame;
+		double				m_frameStart;
+		double				m_frameDeadline;
+		double				m_totalDelay;
+		double				m_pendingDelay;
+		FramePacerStats		m_stats;
+	};
+}
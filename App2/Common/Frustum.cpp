@@ -0,0 +1,102 @@
+﻿#include "Frustum.h"
+
+using namespace DX;
+
+namespace
+{
+	Plane MakePlane(float a, float b, float c, float d)
+	{
+		float length = sqrtf(a * a + b * b + c * c);
+		float inv = (length > 0.0f) ? 1.0f / length : 0.0f;
+		Plane plane;
+		plane.normal = Vector3(a * inv, b * inv, c * inv);
+		plane.d = d * inv;
+		return plane;
+	}
+}
+
+// Con vectores fila, la coordenada de recorte i es el producto por la columna i de la matriz. Los planos
+// son -w <= x <= w, -w <= y <= w y 0 <= z <= w.
+Frustum DX::Frustum::FromViewProjection(const Matrix4& viewProjection)
+{
+	const float (&m)[4][4] = viewProjection.m;
+	auto column = [&m](int j, int row) { return m[row][j]; };
+
+	Frustum frustum;
+	for (int i = 0; i < 2; i++)
+	{
+		frustum.m_planes[i * 2 + 0] = MakePlane(
+			column(3, 0) + column(i, 0), column(3, 1) + column(i, 1), column(3, 2) + column(i, 2), column(3, 3) + column(i, 3));
+		frustum.m_planes[i * 2 + 1] = MakePlane(
+			column(3, 0) - column(i, 0), column(3, 1) - column(i, 1), column(3, 2) - column(i, 2), column(3, 3) - column(i, 3));
+	}
+	frustum.m_planes[4] = MakePlane(column(2, 0), column(2, 1), column(2, 2), column(2, 3));
+	frustum.m_planes[5] = MakePlane(
+		column(3, 0) - column(2, 0), column(3, 1) - column(2, 1), column(3, 2) - column(2, 2), column(3, 3) - column(2, 3));
+	return frustum;
+}
+
+bool DX::Frustum::IntersectsSphere(const Vector3& center, float radius) const
+{
+	for (const Plane& plane : m_planes)
+	{
+		if (plane.Distance(center) < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DX::Frustum::IntersectsAabb(const Vector3& center, const Vector3& extents) const
+{
+	for (const Plane& plane : m_planes)
+	{
+		// Radio de la caja proyectado sobre la normal del plano.
+		float radius = extents.x * fabsf(plane.normal.x) + extents.y * fabsf(plane.normal.y) + extents.z * fabsf(plane.normal.z);
+		if (plane.Distance(center) < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t DX::Frustum::CullSpheres(const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible) const
+{
+	uint32_t visibleCount = 0;
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		SimdFloat4 cx = SimdFloat4::Load(x + i);
+		SimdFloat4 cy = SimdFloat4::Load(y + i);
+		SimdFloat4 cz = SimdFloat4::Load(z + i);
+		SimdFloat4 negativeRadius = SimdFloat4::Splat(0.0f) - SimdFloat4::Load(radius + i);
+
+		int mask = 0xf;
+		for (const Plane& plane : m_planes)
+		{
+			SimdFloat4 distance =
+				cx * SimdFloat4::Splat(plane.normal.x) +
+				cy * SimdFloat4::Splat(plane.normal.y) +
+				cz * SimdFloat4::Splat(plane.normal.z) +
+				SimdFloat4::Splat(plane.d);
+			mask &= LessEqualMask(negativeRadius, distance);
+		}
+
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint8_t inside = static_cast<uint8_t>((mask >> k) & 1);
+			visible[i + k] = inside;
+			visibleCount += inside;
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		uint8_t inside = IntersectsSphere(Vector3(x[i], y[i], z[i]), radius[i]) ? 1 : 0;
+		visible[i] = inside;
+		visibleCount += inside;
+	}
+	return visibleCount;
+}
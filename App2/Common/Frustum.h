@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <cstdint>
+#include "VectorMath.h"
+
+namespace DX
+{
+	// Plano n · p + d = 0 con la normal hacia el interior del volumen.
+	struct Plane
+	{
+		Vector3	normal;
+		float	d;
+
+		float Distance(const Vector3& p) const		{ return Dot(normal, p) + d; }
+	};
+
+	// Tronco de visión extraído de una matriz vista-proyección (convención de DirectXMath, profundidad
+	// de recorte en [0, 1]). Las pruebas son conservadoras: un volumen que toca el tronco se considera visible.
+	class Frustum
+	{
+	public:
+		static Frustum FromViewProjection(const Matrix4& viewProjection);
+
+		bool IntersectsSphere(const Vector3& center, float radius) const;
+		bool IntersectsAabb(const Vector3& center, const Vector3& extents) const;
+
+		// Prueba count esferas guardadas como estructura de arrays, cuatro a la vez. Escribe 1 o 0 por
+		// esfera en visible y devuelve cuántas son visibles.
+		uint32_t CullSpheres(const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible) const;
+
+		const Plane& GetPlane(int i) const			{ return m_planes[i]; }
+
+	private:
+		Plane	m_planes[6];
+	};
+}
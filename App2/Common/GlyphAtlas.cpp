@@ -0,0 +1,173 @@
+﻿#include "GlyphAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	// Separación entre glifos para que el filtrado no mezcle glifos vecinos.
+	const uint32_t GlyphPadding = 1;
+
+	uint64_t MakeGlyphKey(uint32_t codepoint, uint32_t pixelSize)
+	{
+		return (static_cast<uint64_t>(pixelSize) << 32) | codepoint;
+	}
+}
+
+DX::GlyphAtlas::GlyphAtlas(IGlyphRasterizer* rasterizer, uint32_t width, uint32_t height) :
+	m_rasterizer(rasterizer),
+	m_width(width),
+	m_height(height),
+	m_pixels(static_cast<size_t>(width) * height, 0),
+	m_generation(0),
+	m_hits(0),
+	m_misses(0)
+{
+	Clear();
+}
+
+void DX::GlyphAtlas::Clear()
+{
+	m_glyphs.clear();
+	m_fastPixelSize = 0;
+	std::fill(m_fastGlyphs, m_fastGlyphs + 128, nullptr);
+	std::fill(m_pixels.begin(), m_pixels.end(), static_cast<uint8_t>(0));
+	m_shelfX = GlyphPadding;
+	m_shelfY = GlyphPadding;
+	m_shelfHeight = 0;
+	m_generation++;
+
+	// Todo el atlas debe volver a subirse.
+	m_dirtyLeft = 0;
+	m_dirtyTop = 0;
+	m_dirtyRight = m_width;
+	m_dirtyBottom = m_height;
+}
+
+bool DX::GlyphAtlas::Pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+{
+	if (m_shelfX + width + GlyphPadding > m_width)
+	{
+		m_shelfY += m_shelfHeight + GlyphPadding;
+		m_shelfX = GlyphPadding;
+		m_shelfHeight = 0;
+	}
+
+	if (m_shelfX + width + GlyphPadding > m_width || m_shelfY + height + GlyphPadding > m_height)
+	{
+		return false;
+	}
+
+	x = m_shelfX;
+	y = m_shelfY;
+	m_shelfX += width + GlyphPadding;
+	m_shelfHeight = std::max(m_shelfHeight, height);
+	return true;
+}
+
+const AtlasGlyph& DX::GlyphAtlas::GetGlyph(uint32_t codepoint, uint32_t pixelSize)
+{
+	if (codepoint < 128 && pixelSize == m_fastPixelSize && m_fastGlyphs[codepoint] != nullptr)
+	{
+		m_hits++;
+		return *m_fastGlyphs[codepoint];
+	}
+
+	if (pixelSize != m_fastPixelSize)
+	{
+		m_fastPixelSize = pixelSize;
+		std::fill(m_fastGlyphs, m_fastGlyphs + 128, nullptr);
+	}
+
+	uint32_t requested = codepoint;
+	if (!m_rasterizer->HasGlyph(codepoint))
+	{
+		codepoint = '?';
+	}
+
+	uint64_t key = MakeGlyphKey(codepoint, pixelSize);
+	auto found = m_glyphs.find(key);
+	if (found != m_glyphs.end())
+	{
+		m_hits++;
+		if (requested < 128)
+		{
+			m_fastGlyphs[requested] = &found->second;
+		}
+		return found->second;
+	}
+
+	m_misses++;
+	GlyphMetrics metrics;
+	m_rasterizer->RasterizeGlyph(codepoint, pixelSize, metrics, m_scratch);
+
+	// Un glifo mayor que el atlas entero no cabría ni vacío: se guarda sin píxeles (solo avanza la pluma)
+	// y no se vacía el atlas por él.
+	if (metrics.width + 2 * GlyphPadding > m_width || metrics.height + 2 * GlyphPadding > m_height)
+	{
+		metrics.width = 0;
+		metrics.height = 0;
+	}
+
+	uint32_t x = 0, y = 0;
+	if (metrics.width > 0 && metrics.height > 0 && !Pack(metrics.width, metrics.height, x, y))
+	{
+		// Atlas lleno: se empieza de nuevo. Las maquetaciones guardadas detectan el cambio de generación.
+		Clear();
+		Pack(metrics.width, metrics.height, x, y);
+	}
+
+	for (uint32_t row = 0; row < metrics.height; row++)
+	{
+		memcpy(&m_pixels[static_cast<size_t>(y + row) * m_width + x], &m_scratch[static_cast<size_t>(row) * metrics.width], metrics.width);
+	}
+
+	if (metrics.width > 0 && metrics.height > 0)
+	{
+		m_dirtyLeft = std::min(m_dirtyLeft, x);
+		m_dirtyTop = std::min(m_dirtyTop, y);
+		m_dirtyRight = std::max(m_dirtyRight, x + metrics.width);
+		m_dirtyBottom = std::max(m_dirtyBottom, y + metrics.height);
+	}
+
+	AtlasGlyph glyph;
+	glyph.u0 = static_cast<float>(x) / m_width;
+	glyph.v0 = static_cast<float>(y) / m_height;
+	glyph.u1 = static_cast<float>(x + metrics.width) / m_width;
+	glyph.v1 = static_cast<float>(y + metrics.height) / m_height;
+	glyph.width = static_cast<float>(metrics.width);
+	glyph.height = static_cast<float>(metrics.height);
+	glyph.offsetX = metrics.offsetX;
+	glyph.offsetY = metrics.offsetY;
+	glyph.advance = metrics.advance;
+	const AtlasGlyph& inserted = m_glyphs.insert(std::make_pair(key, glyph)).first->second;
+	if (requested < 128)
+	{
+		m_fastGlyphs[requested] = &inserted;
+	}
+	return inserted;
+}
+
+bool DX::GlyphAtlas::GetDirtyRect(uint32_t& left, uint32_t& top, uint32_t& right, uint32_t& bottom) const
+{
+	if (m_dirtyRight <= m_dirtyLeft || m_dirtyBottom <= m_dirtyTop)
+	{
+		return false;
+	}
+
+	left = m_dirtyLeft;
+	top = m_dirtyTop;
+	right = m_dirtyRight;
+	bottom = m_dirtyBottom;
+	return true;
+}
+
+void DX::GlyphAtlas::ClearDirtyRect()
+{
+	m_dirtyLeft = m_width;
+	m_dirtyTop = m_height;
+	m_dirtyRight = 0;
+	m_dirtyBottom = 0;
+}
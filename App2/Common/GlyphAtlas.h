@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "MemoryTracker.h"
+
+namespace DX
+{
+	// Métricas de una fuente para un tamaño dado, en píxeles.
+	struct FontMetrics
+	{
+		float	lineHeight;
+	};
+
+	// Métricas de un glifo rasterizado. El desplazamiento es relativo a la posición del lápiz y al borde superior de la línea.
+	struct GlyphMetrics
+	{
+		uint32_t	width;
+		uint32_t	height;
+		float		offsetX;
+		float		offsetY;
+		float		advance;
+	};
+
+	// Origen de los mapas de bits de los glifos. Permite cambiar de rasterizador (fuente de mapa de bits
+	// portátil, DirectWrite, etc.) sin tocar el atlas ni la maquetación.
+	class IGlyphRasterizer
+	{
+	public:
+		virtual ~IGlyphRasterizer() {}
+
+		virtual FontMetrics GetFontMetrics(uint32_t pixelSize) const = 0;
+		virtual bool HasGlyph(uint32_t codepoint) const = 0;
+
+		// Escribe width * height bytes de cobertura (0-255) en pixels.
+		virtual void RasterizeGlyph(uint32_t codepoint, uint32_t pixelSize, GlyphMetrics& metrics, std::vector<uint8_t>& pixels) const = 0;
+	};
+
+	// Glifo almacenado en el atlas: métricas y coordenadas de textura.
+	struct AtlasGlyph
+	{
+		float	u0, v0, u1, v1;
+		float	width;
+		float	height;
+		float	offsetX;
+		float	offsetY;
+		float	advance;
+	};
+
+	// Atlas de glifos de un canal. Los glifos se rasterizan la primera vez que se piden y se empaquetan
+	// por estantes; las siguientes peticiones son una búsqueda en una tabla. Cuando el atlas se llena se
+	// vacía y se incrementa la generación, de modo que las maquetaciones guardadas saben que deben rehacerse.
+	class GlyphAtlas
+	{
+	public:
+		GlyphAtlas(IGlyphRasterizer* rasterizer, uint32_t width, uint32_t height);
+
+		const AtlasGlyph& GetGlyph(uint32_t codepoint, uint32_t pixelSize);
+		FontMetrics GetFontMetrics(uint32_t pixelSize) const	{ return m_rasterizer->GetFontMetrics(pixelSize); }
+
+		uint32_t GetWidth() const								{ return m_width; }
+		uint32_t GetHeight() const								{ return m_height; }
+		const uint8_t* GetPixels() const						{ return m_pixels.data(); }
+		uint32_t GetGeneration() const							{ return m_generation; }
+
+		// Rectángulo modificado desde la última llamada a ClearDirtyRect, para subir solo esa parte a la GPU.
+		bool GetDirtyRect(uint32_t& left, uint32_t& top, uint32_t& right, uint32_t& bottom) const;
+		void ClearDirtyRect();
+
+		uint64_t GetHitCount() const							{ return m_hits; }
+		uint64_t GetMissCount() const							{ return m_misses; }
+
+	private:
+		void Clear();
+		bool Pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+		IGlyphRasterizer*							m_rasterizer;
+		uint32_t									m_width;
+		uint32_t									m_height;
+		TaggedVector<uint8_t, MemoryTag::Textures>	m_pixels;
+		std::unordered_map<uint64_t, AtlasGlyph>	m_glyphs;
+		std::vector<uint8_t>						m_scratch;
+
+		// Acceso directo a los glifos ASCII del último tamaño usado, sin pasar por la tabla hash.
+		uint32_t									m_fastPixelSize;
+		const AtlasGlyph*							m_fastGlyphs[128];
+		uint32_t									m_generation;
+
+		// Empaquetado por estantes: fila actual y posición dentro de ella.
+		uint32_t									m_shelfX;
+		uint32_t									m_shelfY;
+		uint32_t									m_shelfHeight;
+
+		uint32_t									m_dirtyLeft;
+		uint32_t									m_dirtyTop;
+		uint32_t									m_dirtyRight;
+		uint32_t									m_dirtyBottom;
+
+		uint64_t									m_hits;
+		uint64_t									m_misses;
+	};
+}
@@ -0,0 +1,197 @@
+﻿#include "GradientNoise.h"
+#include "VectorMath.h"
+
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+	// Ocho gradientes unitarios; con ellos el ruido 2D queda en [-0.71, 0.71], de ahí la escala.
+	const float Diagonal = 0.70710678f;
+	const float GradientX[8] = { 1.0f, -1.0f, 0.0f, 0.0f, Diagonal, -Diagonal, Diagonal, -Diagonal };
+	const float GradientY[8] = { 0.0f, 0.0f, 1.0f, -1.0f, Diagonal, Diagonal, -Diagonal, -Diagonal };
+	const float OutputScale = 1.41421356f;
+
+	inline float Fade(float t)
+	{
+		return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+	}
+
+	inline SimdFloat4 Fade(SimdFloat4 t)
+	{
+		return t * t * t * (t * (t * SimdFloat4::Splat(6.0f) - SimdFloat4::Splat(15.0f)) + SimdFloat4::Splat(10.0f));
+	}
+
+	inline void GetLatticeLanes(int32_t first, float spacing, float* x)
+	{
+		for (int32_t lane = 0; lane < 4; lane++)
+		{
+			x[lane] = static_cast<float>(first + lane) * spacing;
+		}
+	}
+
+	// Inversa de la suma de amplitudes, para que el ruido fractal siga en [-1, 1].
+	float GetFractalNormalization(const NoiseDesc& desc)
+	{
+		float amplitude = 1.0f;
+		float sum = 0.0f;
+		for (uint32_t octave = 0; octave < desc.octaves; octave++)
+		{
+			sum += amplitude;
+			amplitude *= desc.gain;
+		}
+		return (sum > 0.0f) ? 1.0f / sum : 0.0f;
+	}
+}
+
+// Mezcla de Fisher-Yates con un generador congruencial lineal.
+GradientNoise::GradientNoise(uint32_t seed)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		m_permutation[i] = static_cast<uint8_t>(i);
+	}
+
+	uint32_t state = seed * 2654435761u + 1;
+	for (uint32_t i = 255; i > 0; i--)
+	{
+		state = state * 1664525u + 1013904223u;
+		uint32_t j = (state >> 8) % (i + 1);
+		uint8_t swap = m_permutation[i];
+		m_permutation[i] = m_permutation[j];
+		m_permutation[j] = swap;
+	}
+}
+
+float GradientNoise::Sample(float x, float y) const
+{
+	float xFloor = floorf(x);
+	float yFloor = floorf(y);
+	int32_t xi = static_cast<int32_t>(xFloor);
+	int32_t yi = static_cast<int32_t>(yFloor);
+	float fx = x - xFloor;
+	float fy = y - yFloor;
+	float fx1 = fx - 1.0f;
+	float fy1 = fy - 1.0f;
+
+	uint32_t h00 = Hash(xi, yi);
+	uint32_t h10 = Hash(xi + 1, yi);
+	uint32_t h01 = Hash(xi, yi + 1);
+	uint32_t h11 = Hash(xi + 1, yi + 1);
+	float d00 = GradientX[h00] * fx + GradientY[h00] * fy;
+	float d10 = GradientX[h10] * fx1 + GradientY[h10] * fy;
+	float d01 = GradientX[h01] * fx + GradientY[h01] * fy1;
+	float d11 = GradientX[h11] * fx1 + GradientY[h11] * fy1;
+
+	float u = Fade(fx);
+	float v = Fade(fy);
+	float a = d00 + u * (d10 - d00);
+	float b = d01 + u * (d11 - d01);
+	return (a + v * (b - a)) * OutputScale;
+}
+
+float GradientNoise::Fractal(float x, float y, const NoiseDesc& desc) const
+{
+	float frequency = desc.frequency;
+	float amplitude = 1.0f;
+	float sum = 0.0f;
+	for (uint32_t octave = 0; octave < desc.octaves; octave++)
+	{
+		sum += amplitude * Sample(x * frequency, y * frequency);
+		frequency *= desc.lacunarity;
+		amplitude *= desc.gain;
+	}
+	return sum * GetFractalNormalization(desc);
+}
+
+// Cuatro muestras en las abscisas x[0..3] y la misma ordenada. La celda y los gradientes de cada carril
+// se leen de la tabla uno a uno; la interpolación se hace con las mismas operaciones que Sample.
+void GradientNoise::SampleLanes(const float* x, float y, float* out) const
+{
+	float yFloor = floorf(y);
+	int32_t yi = static_cast<int32_t>(yFloor);
+	float fy = y - yFloor;
+
+	alignas(16) float fx[4];
+	alignas(16) float g00x[4], g00y[4], g10x[4], g10y[4], g01x[4], g01y[4], g11x[4], g11y[4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		float xFloor = floorf(x[lane]);
+		int32_t xi = static_cast<int32_t>(xFloor);
+		fx[lane] = x[lane] - xFloor;
+
+		uint32_t h00 = Hash(xi, yi);
+		uint32_t h10 = Hash(xi + 1, yi);
+		uint32_t h01 = Hash(xi, yi + 1);
+		uint32_t h11 = Hash(xi + 1, yi + 1);
+		g00x[lane] = GradientX[h00];
+		g00y[lane] = GradientY[h00];
+		g10x[lane] = GradientX[h10];
+		g10y[lane] = GradientY[h10];
+		g01x[lane] = GradientX[h01];
+		g01y[lane] = GradientY[h01];
+		g11x[lane] = GradientX[h11];
+		g11y[lane] = GradientY[h11];
+	}
+
+	SimdFloat4 one = SimdFloat4::Splat(1.0f);
+	SimdFloat4 fx0 = SimdFloat4::Load(fx);
+	SimdFloat4 fx1 = fx0 - one;
+	SimdFloat4 fy0 = SimdFloat4::Splat(fy);
+	SimdFloat4 fy1 = SimdFloat4::Splat(fy - 1.0f);
+
+	SimdFloat4 d00 = SimdFloat4::Load(g00x) * fx0 + SimdFloat4::Load(g00y) * fy0;
+	SimdFloat4 d10 = SimdFloat4::Load(g10x) * fx1 + SimdFloat4::Load(g10y) * fy0;
+	SimdFloat4 d01 = SimdFloat4::Load(g01x) * fx0 + SimdFloat4::Load(g01y) * fy1;
+	SimdFloat4 d11 = SimdFloat4::Load(g11x) * fx1 + SimdFloat4::Load(g11y) * fy1;
+
+	SimdFloat4 u = Fade(fx0);
+	SimdFloat4 v = SimdFloat4::Splat(Fade(fy));
+	SimdFloat4 a = d00 + u * (d10 - d00);
+	SimdFloat4 b = d01 + u * (d11 - d01);
+	((a + v * (b - a)) * SimdFloat4::Splat(OutputScale)).Store(out);
+}
+
+void GradientNoise::SampleRow(int32_t first, float spacing, float y, uint32_t count, float* out) const
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		float x[4];
+		GetLatticeLanes(first + static_cast<int32_t>(i), spacing, x);
+		SampleLanes(x, y, out + i);
+	}
+	for (; i < count; i++)
+	{
+		out[i] = Sample(static_cast<float>(first + static_cast<int32_t>(i)) * spacing, y);
+	}
+}
+
+void GradientNoise::FractalRow(int32_t first, float spacing, float y, uint32_t count, const NoiseDesc& desc, float* out) const
+{
+	float normalization = GetFractalNormalization(desc);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		float x[4];
+		GetLatticeLanes(first + static_cast<int32_t>(i), spacing, x);
+		float frequency = desc.frequency;
+		float amplitude = 1.0f;
+		SimdFloat4 sum = SimdFloat4::Splat(0.0f);
+		for (uint32_t octave = 0; octave < desc.octaves; octave++)
+		{
+			float scaled[4] = { x[0] * frequency, x[1] * frequency, x[2] * frequency, x[3] * frequency };
+			float sample[4];
+			SampleLanes(scaled, y * frequency, sample);
+			sum = sum + SimdFloat4::Splat(amplitude) * SimdFloat4::Load(sample);
+			frequency *= desc.lacunarity;
+			amplitude *= desc.gain;
+		}
+		(sum * SimdFloat4::Splat(normalization)).Store(out + i);
+	}
+	for (; i < count; i++)
+	{
+		out[i] = Fractal(static_cast<float>(first + static_cast<int32_t>(i)) * spacing, y, desc);
+	}
+}
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	// Parámetros del ruido fractal: octaves capas de ruido, cada una con lacunarity veces la frecuencia y
+	// gain veces la amplitud de la anterior.
+	struct NoiseDesc
+	{
+		uint32_t	octaves;
+		float		frequency;
+		float		lacunarity;
+		float		gain;
+	};
+
+	// Ruido de gradiente 2D (Perlin) con una tabla de permutación generada a partir de una semilla. El
+	// resultado está aproximadamente en [-1, 1]. Las filas se evalúan de cuatro en cuatro con SimdFloat4;
+	// el acceso a la tabla es escalar (SSE2 no tiene lecturas dispersas) y el resto de la cuenta es
+	// vectorial. Sample y SampleRow dan exactamente el mismo valor en el mismo punto.
+	class GradientNoise
+	{
+	public:
+		explicit GradientNoise(uint32_t seed = 1);
+
+		float Sample(float x, float y) const;
+		float Fractal(float x, float y, const NoiseDesc& desc) const;
+
+		// Filas sobre una rejilla: out[i] = Sample((first + i) * spacing, y), para i en [0, count). Como la
+		// abscisa sale de un índice entero, dos filas que comparten puntos de la rejilla (trozos vecinos, o
+		// niveles de detalle cuyo espaciado es el doble) dan en ellos exactamente el mismo valor.
+		void SampleRow(int32_t first, float spacing, float y, uint32_t count, float* out) const;
+
+		// out[i] = Fractal((first + i) * spacing, y, desc).
+		void FractalRow(int32_t first, float spacing, float y, uint32_t count, const NoiseDesc& desc, float* out) const;
+
+	private:
+		void SampleLanes(const float* x, float y, float* out) const;
+		uint32_t Hash(int32_t x, int32_t y) const	{ return m_permutation[(m_permutation[y & 255] + x) & 255] & 7; }
+
+		uint8_t		m_permutation[256];
+	};
+}
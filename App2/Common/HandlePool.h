@@ -0,0 +1,174 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <utility>
+#include "MemoryTracker.h"
+
+namespace DX
+{
+	// Identificador estable de 32 bits: índice de ranura en los bits bajos y generación en los altos. La
+	// generación cambia cada vez que la ranura se libera, así que un identificador de un objeto destruido
+	// deja de ser válido aunque la ranura se reutilice. El 0 nunca es válido (la generación empieza en 1).
+	typedef uint32_t PoolHandle;
+	const PoolHandle InvalidPoolHandle = 0;
+
+	// Objetos densos con identificadores generacionales. Los valores viven contiguos (al destruir uno, el
+	// último ocupa su hueco), de modo que recorrer el conjunto es recorrer un vector; una tabla de ranuras
+	// traduce cada identificador a su posición actual. Crear, destruir y buscar son O(1) y no reservan
+	// memoria una vez alcanzado el tamaño máximo. IndexBits limita el número de objetos vivos a
+	// 2^IndexBits; con GenerationBits pequeños un identificador caduco puede volver a parecer válido tras
+	// 2^GenerationBits - 1 reutilizaciones de su ranura. No es seguro para varios subprocesos.
+	template<typename T, MemoryTag Tag = MemoryTag::General, uint32_t IndexBits = 20, uint32_t GenerationBits = 12>
+	class HandlePool
+	{
+		static_assert(IndexBits > 0 && GenerationBits > 0 && IndexBits + GenerationBits <= 32, "El identificador debe caber en 32 bits");
+
+	public:
+		static const uint32_t MaxCount = 1u << IndexBits;
+		static const uint32_t IndexMask = MaxCount - 1;
+		static const uint32_t GenerationMask = (1u << GenerationBits) - 1;
+
+		HandlePool() : m_freeHead(NoSlot) {}
+
+		static uint32_t GetIndex(PoolHandle handle)			{ return handle & IndexMask; }
+		static uint32_t GetGeneration(PoolHandle handle)	{ return (handle >> IndexBits) & GenerationMask; }
+
+		void Reserve(uint32_t count)
+		{
+			m_slots.reserve(count);
+			m_values.reserve(count);
+			m_owners.reserve(count);
+		}
+
+		// Devuelve InvalidPoolHandle si ya hay MaxCount objetos vivos.
+		template<typename... TArgs>
+		PoolHandle Create(TArgs&&... args)
+		{
+			uint32_t index;
+			if (m_freeHead != NoSlot)
+			{
+				index = m_freeHead;
+				m_freeHead = m_slots[index].dense;
+			}
+			else if (m_slots.size() < MaxCount)
+			{
+				index = static_cast<uint32_t>(m_slots.size());
+				Slot slot = { 0, 1 };
+				m_slots.push_back(slot);
+			}
+			else
+			{
+				return InvalidPoolHandle;
+			}
+
+			Slot& slot = m_slots[index];
+			slot.dense = static_cast<uint32_t>(m_values.size());
+			m_values.emplace_back(std::forward<TArgs>(args)...);
+			m_owners.push_back(index);
+			return (slot.generation << IndexBits) | index;
+		}
+
+		// Devuelve false si handle no es válido (ya destruido o de otro conjunto).
+		bool Destroy(PoolHandle handle)
+		{
+			if (!IsValid(handle))
+			{
+				return false;
+			}
+
+			uint32_t index = GetIndex(handle);
+			Slot& slot = m_slots[index];
+			uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+			if (slot.dense != last)
+			{
+				m_values[slot.dense] = std::move(m_values[last]);
+				m_owners[slot.dense] = m_owners[last];
+				m_slots[m_owners[last]].dense = slot.dense;
+			}
+			m_values.pop_back();
+			m_owners.pop_back();
+			Release(index);
+			return true;
+		}
+
+		// Destruye todos los objetos; los identificadores anteriores dejan de ser válidos.
+		void Clear()
+		{
+			for (uint32_t index : m_owners)
+			{
+				Release(index);
+			}
+			m_values.clear();
+			m_owners.clear();
+		}
+
+		bool IsValid(PoolHandle handle) const
+		{
+			uint32_t index = GetIndex(handle);
+			return index < m_slots.size() && m_slots[index].generation == GetGeneration(handle);
+		}
+
+		// nullptr si handle no es válido. El puntero deja de ser válido al crear o destruir otro objeto.
+		T* Get(PoolHandle handle)
+		{
+			return IsValid(handle) ? &m_values[m_slots[GetIndex(handle)].dense] : nullptr;
+		}
+
+		const T* Get(PoolHandle handle) const
+		{
+			return IsValid(handle) ? &m_values[m_slots[GetIndex(handle)].dense] : nullptr;
+		}
+
+		// Recorrido denso: los objetos vivos, en un orden que cambia al destruir.
+		uint32_t GetCount() const				{ return static_cast<uint32_t>(m_values.size()); }
+		bool IsEmpty() const					{ return m_values.empty(); }
+		T* GetData()							{ return m_values.data(); }
+		const T* GetData() const				{ return m_values.data(); }
+		T& operator[](uint32_t i)				{ return m_values[i]; }
+		const T& operator[](uint32_t i) const	{ return m_values[i]; }
+
+		// Identificador del objeto en la posición densa i.
+		PoolHandle GetHandle(uint32_t i) const
+		{
+			uint32_t index = m_owners[i];
+			return (m_slots[index].generation << IndexBits) | index;
+		}
+
+	private:
+		static const uint32_t NoSlot = 0xffffffffu;
+
+		// Mientras la ranura está libre, dense enlaza con la siguiente ranura libre.
+		struct Slot
+		{
+			uint32_t	dense;
+			uint32_t	generation;
+		};
+
+		// Avanza la generación (saltando el 0) y añade la ranura a la lista libre.
+		void Release(uint32_t index)
+		{
+			Slot& slot = m_slots[index];
+			slot.generation = (slot.generation + 1) & GenerationMask;
+			if (slot.generation == 0)
+			{
+				slot.generation = 1;
+			}
+			slot.dense = m_freeHead;
+			m_freeHead = index;
+		}
+
+		TaggedVector<Slot, Tag>		m_slots;
+		TaggedVector<T, Tag>		m_values;
+		TaggedVector<uint32_t, Tag>	m_owners;	// Ranura de cada valor denso.
+		uint32_t					m_freeHead;
+	};
+
+	template<typename T, MemoryTag Tag, uint32_t IndexBits, uint32_t GenerationBits>
+	const uint32_t HandlePool<T, Tag, IndexBits, GenerationBits>::MaxCount;
+
+	template<typename T, MemoryTag Tag, uint32_t IndexBits, uint32_t GenerationBits>
+	const uint32_t HandlePool<T, Tag, IndexBits, GenerationBits>::IndexMask;
+
+	template<typename T, MemoryTag Tag, uint32_t IndexBits, uint32_t GenerationBits>
+	const uint32_t HandlePool<T, Tag, IndexBits, GenerationBits>::GenerationMask;
+}
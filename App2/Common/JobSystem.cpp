@@ -0,0 +1,143 @@
+﻿#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Índice del subproceso actual dentro del grupo (0 = subproceso externo).
+	thread_local uint32_t t_threadIndex = 0;
+
+	// Se establece mientras el subproceso ejecuta un bloque; evita interbloqueos en llamadas anidadas.
+	thread_local bool t_insideJob = false;
+}
+
+DX::JobSystem::JobSystem(uint32_t threadCount) :
+	m_generation(0),
+	m_finishedWorkers(0),
+	m_stopping(false),
+	m_function(nullptr),
+	m_context(nullptr),
+	m_count(0),
+	m_grainSize(1),
+	m_nextIndex(0)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0)
+		{
+			threadCount = 1;
+		}
+	}
+
+	m_workers.reserve(threadCount - 1);
+	for (uint32_t i = 1; i < threadCount; i++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+DX::JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+uint32_t DX::JobSystem::GetCurrentThreadIndex()
+{
+	return t_threadIndex;
+}
+
+void DX::JobSystem::Dispatch(uint32_t count, uint32_t grainSize, RangeFunction function, const void* context)
+{
+	// Sin trabajadores, con un solo bloque o desde dentro de otro trabajo: ejecutar en línea.
+	if (m_workers.empty() || count <= grainSize || t_insideJob)
+	{
+		bool wasInside = t_insideJob;
+		t_insideJob = true;
+		for (uint32_t begin = 0; begin < count; begin += grainSize)
+		{
+			uint32_t end = (count - begin > grainSize) ? begin + grainSize : count;
+			function(context, begin, end);
+		}
+		t_insideJob = wasInside;
+		return;
+	}
+
+	std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_function = function;
+		m_context = context;
+		m_count = count;
+		m_grainSize = grainSize;
+		m_nextIndex.store(0, std::memory_order_relaxed);
+		m_finishedWorkers = 0;
+		m_generation++;
+	}
+	m_wakeCondition.notify_all();
+
+	t_insideJob = true;
+	RunChunks();
+	t_insideJob = false;
+
+	// Esperar a que todos los trabajadores hayan salido del lote antes de liberar el contexto.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return m_finishedWorkers == m_workers.size(); });
+}
+
+void DX::JobSystem::RunChunks()
+{
+	DX_PROFILE_SCOPE("JobSystem::RunChunks");
+	for (;;)
+	{
+		uint32_t begin = m_nextIndex.fetch_add(m_grainSize, std::memory_order_relaxed);
+		if (begin >= m_count)
+		{
+			break;
+		}
+
+		uint32_t end = (m_count - begin > m_grainSize) ? begin + m_grainSize : m_count;
+		m_function(m_context, begin, end);
+	}
+}
+
+void DX::JobSystem::WorkerMain(uint32_t threadIndex)
+{
+	t_threadIndex = threadIndex;
+	DX_PROFILE_THREAD("Trabajador");
+
+	uint64_t lastGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [&]() { return m_stopping || m_generation != lastGeneration; });
+
+			if (m_stopping)
+			{
+				return;
+			}
+
+			lastGeneration = m_generation;
+		}
+
+		t_insideJob = true;
+		RunChunks();
+		t_insideJob = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finishedWorkers++;
+		}
+		m_doneCondition.notify_one();
+	}
+}
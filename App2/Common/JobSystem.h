@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	// Grupo de subprocesos de trabajo portátil usado por los sistemas de CPU (física, simulación, etc.).
+	// El subproceso que llama a ParallelFor también participa en el trabajo, de modo que un grupo
+	// con un solo subproceso ejecuta todo de forma secuencial sin coste de sincronización.
+	class JobSystem
+	{
+	public:
+		// threadCount incluye el subproceso que llama. Un valor de 0 usa todos los núcleos disponibles.
+		explicit JobSystem(uint32_t threadCount = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Número total de subprocesos que ejecutan trabajo, incluido el que llama.
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()) + 1; }
+
+		// Índice del subproceso actual: 0 para el que llama a ParallelFor y 1..N para los trabajadores.
+		static uint32_t GetCurrentThreadIndex();
+
+		// Divide [0, count) en bloques de grainSize elementos y llama a func(begin, end) en paralelo.
+		// Devuelve cuando todos los bloques han terminado. Las llamadas anidadas se ejecutan en serie.
+		template<typename TFunc>
+		void ParallelFor(uint32_t count, uint32_t grainSize, const TFunc& func)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			if (grainSize == 0)
+			{
+				grainSize = 1;
+			}
+
+			Dispatch(count, grainSize, &InvokeRange<TFunc>, &func);
+		}
+
+	private:
+		typedef void (*RangeFunction)(const void* context, uint32_t begin, uint32_t end);
+
+		template<typename TFunc>
+		static void InvokeRange(const void* context, uint32_t begin, uint32_t end)
+		{
+			(*static_cast<const TFunc*>(context))(begin, end);
+		}
+
+		void Dispatch(uint32_t count, uint32_t grainSize, RangeFunction function, const void* context);
+		void RunChunks();
+		void WorkerMain(uint32_t threadIndex);
+
+		std::vector<std::thread>	m_workers;
+
+		// Serializa las llamadas a ParallelFor desde varios subprocesos externos.
+		std::mutex					m_dispatchMutex;
+
+		// Estado del lote actual.
+		std::mutex					m_mutex;
+		std::condition_variable		m_wakeCondition;
+		std::condition_variable		m_doneCondition;
+		uint64_t					m_generation;
+		uint32_t					m_finishedWorkers;
+		bool						m_stopping;
+
+		RangeFunction				m_function;
+		const void*					m_context;
+		uint32_t					m_count;
+		uint32_t					m_grainSize;
+		std::atomic<uint32_t>		m_nextIndex;
+	};
+}
@@ -0,0 +1,160 @@
+﻿#include "MemoryTracker.h"
+
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t TagCount = static_cast<uint32_t>(MemoryTag::Count);
+
+	const char* const TagNames[TagCount] =
+	{
+		"General",
+		"Sombreadores",
+		"Mallas",
+		"Texturas",
+		"Constantes",
+		"Texto",
+		"Comandos",
+		"Arena",
+		"Fisica",
+		"Tela",
+		"Voxeles",
+	};
+}
+
+const char* DX::GetMemoryTagName(MemoryTag tag)
+{
+	return (tag < MemoryTag::Count) ? TagNames[static_cast<uint32_t>(tag)] : "?";
+}
+
+uint64_t DX::MemorySnapshot::GetLiveBytes() const
+{
+	uint64_t bytes = 0;
+	for (const MemoryTagStats& stats : tags)
+	{
+		bytes += stats.liveBytes;
+	}
+	return bytes;
+}
+
+uint64_t DX::MemorySnapshot::GetFrameAllocations() const
+{
+	uint64_t allocations = 0;
+	for (const MemoryTagStats& stats : tags)
+	{
+		allocations += stats.frameAllocations;
+	}
+	return allocations;
+}
+
+uint32_t DX::MemorySnapshot::GetOverBudgetCount() const
+{
+	uint32_t count = 0;
+	for (const MemoryTagStats& stats : tags)
+	{
+		count += stats.IsOverBudget() ? 1 : 0;
+	}
+	return count;
+}
+
+MemoryTracker& DX::MemoryTracker::Get()
+{
+	static MemoryTracker tracker;
+	return tracker;
+}
+
+DX::MemoryTracker::MemoryTracker() :
+	m_frame(0)
+{
+	for (Counters& counters : m_counters)
+	{
+		counters.liveBytes.store(0, std::memory_order_relaxed);
+		counters.peakBytes.store(0, std::memory_order_relaxed);
+	}
+	memset(m_budgets, 0, sizeof(m_budgets));
+	memset(m_previousAllocations, 0, sizeof(m_previousAllocations));
+	memset(m_previousFrees, 0, sizeof(m_previousFrees));
+	memset(m_previousAllocatedBytes, 0, sizeof(m_previousAllocatedBytes));
+	memset(&m_lastFrame, 0, sizeof(m_lastFrame));
+}
+
+// Los contadores de un subproceso que termina se conservan, para que los totales no retrocedan.
+MemoryTracker::ThreadCounters* DX::MemoryTracker::RegisterThread()
+{
+	std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+	for (uint32_t i = 0; i < TagCount; i++)
+	{
+		counters->allocations[i].store(0, std::memory_order_relaxed);
+		counters->frees[i].store(0, std::memory_order_relaxed);
+		counters->allocatedBytes[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+	m_threads.push_back(std::move(counters));
+	return m_threads.back().get();
+}
+
+void DX::MemoryTracker::ResetPeaks()
+{
+	for (Counters& counters : m_counters)
+	{
+		counters.peakBytes.store(counters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+MemorySnapshot DX::MemoryTracker::TakeSnapshot()
+{
+	MemorySnapshot snapshot;
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.frame = m_frame;
+	for (uint32_t i = 0; i < TagCount; i++)
+	{
+		MemoryTagStats& stats = snapshot.tags[i];
+		stats.liveBytes = m_counters[i].liveBytes.load(std::memory_order_relaxed);
+		stats.peakBytes = m_counters[i].peakBytes.load(std::memory_order_relaxed);
+		stats.budgetBytes = m_budgets[i];
+	}
+
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+	for (const std::unique_ptr<ThreadCounters>& thread : m_threads)
+	{
+		for (uint32_t i = 0; i < TagCount; i++)
+		{
+			snapshot.tags[i].totalAllocations += thread->allocations[i].load(std::memory_order_relaxed);
+		}
+	}
+	return snapshot;
+}
+
+void DX::MemoryTracker::EndFrame()
+{
+	MemorySnapshot snapshot = TakeSnapshot();
+	uint64_t frees[TagCount] = {};
+	uint64_t allocatedBytes[TagCount] = {};
+	{
+		std::lock_guard<std::mutex> lock(m_threadMutex);
+		for (const std::unique_ptr<ThreadCounters>& thread : m_threads)
+		{
+			for (uint32_t i = 0; i < TagCount; i++)
+			{
+				frees[i] += thread->frees[i].load(std::memory_order_relaxed);
+				allocatedBytes[i] += thread->allocatedBytes[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < TagCount; i++)
+	{
+		MemoryTagStats& stats = snapshot.tags[i];
+		stats.frameAllocations = stats.totalAllocations - m_previousAllocations[i];
+		stats.frameFrees = frees[i] - m_previousFrees[i];
+		stats.frameAllocatedBytes = allocatedBytes[i] - m_previousAllocatedBytes[i];
+		m_previousAllocations[i] = stats.totalAllocations;
+		m_previousFrees[i] = frees[i];
+		m_previousAllocatedBytes[i] = allocatedBytes[i];
+	}
+	m_lastFrame = snapshot;
+	m_frame++;
+}
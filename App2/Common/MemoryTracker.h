@@ -0,0 +1,208 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Con DX_MEMORY_TRACKING_DISABLED definido, los contadores no se tocan: los asignadores con etiqueta
+// se comportan como std::allocator y TrackAllocation/TrackFree no generan código.
+
+namespace DX
+{
+	// Subsistema al que se cargan las reservas.
+	enum class MemoryTag : uint32_t
+	{
+		General,
+		Shaders,
+		Meshes,
+		Textures,
+		ConstantData,
+		Text,
+		RenderCommands,
+		FrameArena,
+		Physics,
+		Cloth,
+		Voxels,
+		Count
+	};
+
+	const char* GetMemoryTagName(MemoryTag tag);
+
+	// Estado de una etiqueta al cerrar un fotograma. Los contadores por fotograma son la diferencia con el
+	// fotograma anterior.
+	struct MemoryTagStats
+	{
+		uint64_t	liveBytes;
+		uint64_t	peakBytes;
+		uint64_t	budgetBytes;			// 0 = sin presupuesto.
+		uint64_t	totalAllocations;
+		uint64_t	frameAllocations;
+		uint64_t	frameFrees;
+		uint64_t	frameAllocatedBytes;
+
+		bool IsOverBudget() const	{ return budgetBytes > 0 && liveBytes > budgetBytes; }
+	};
+
+	struct MemorySnapshot
+	{
+		uint64_t		frame;
+		MemoryTagStats	tags[static_cast<uint32_t>(MemoryTag::Count)];
+
+		const MemoryTagStats& Get(MemoryTag tag) const	{ return tags[static_cast<uint32_t>(tag)]; }
+		uint64_t GetLiveBytes() const;
+		uint64_t GetFrameAllocations() const;
+		uint32_t GetOverBudgetCount() const;
+	};
+
+	// Contadores de memoria por subsistema: bytes vivos, pico, reservas y presupuestos. Los bytes vivos de
+	// cada etiqueta son una única suma atómica relajada en su línea de caché (para que el pico sea exacto);
+	// el número de reservas y de bytes reservados va en contadores propios de cada subproceso, sin
+	// instrucciones con bloqueo. EndFrame, llamado una vez por fotograma desde el bucle, suma los de todos
+	// los subprocesos y toma la instantánea.
+	class MemoryTracker
+	{
+	public:
+		static MemoryTracker& Get();
+
+		void OnAllocate(MemoryTag tag, size_t bytes)
+		{
+			uint32_t index = static_cast<uint32_t>(tag);
+			Counters& counters = m_counters[index];
+			uint64_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			{
+			}
+
+			ThreadCounters& thread = GetThreadCounters();
+			Increment(thread.allocations[index], 1);
+			Increment(thread.allocatedBytes[index], bytes);
+		}
+
+		void OnFree(MemoryTag tag, size_t bytes)
+		{
+			uint32_t index = static_cast<uint32_t>(tag);
+			m_counters[index].liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+			Increment(GetThreadCounters().frees[index], 1);
+		}
+
+		void SetBudget(MemoryTag tag, uint64_t bytes)	{ m_budgets[static_cast<uint32_t>(tag)] = bytes; }
+
+		// El pico vuelve a los bytes vivos, por ejemplo al cambiar de nivel.
+		void ResetPeaks();
+
+		// Cierra el fotograma: guarda la instantánea, que queda en GetLastFrame.
+		void EndFrame();
+		const MemorySnapshot& GetLastFrame() const		{ return m_lastFrame; }
+
+		// Estado actual sin cerrar el fotograma; los contadores por fotograma quedan a cero.
+		MemorySnapshot TakeSnapshot();
+
+	private:
+		static const uint32_t TagCount = static_cast<uint32_t>(MemoryTag::Count);
+
+		struct alignas(64) Counters
+		{
+			std::atomic<uint64_t>	liveBytes;
+			std::atomic<uint64_t>	peakBytes;
+		};
+
+		// Solo los escribe su subproceso; EndFrame los lee.
+		struct ThreadCounters
+		{
+			std::atomic<uint64_t>	allocations[TagCount];
+			std::atomic<uint64_t>	frees[TagCount];
+			std::atomic<uint64_t>	allocatedBytes[TagCount];
+		};
+
+		MemoryTracker();
+
+		static void Increment(std::atomic<uint64_t>& counter, uint64_t amount)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		ThreadCounters& GetThreadCounters()
+		{
+			static thread_local ThreadCounters* t_counters = nullptr;
+			if (t_counters == nullptr)
+			{
+				t_counters = RegisterThread();
+			}
+			return *t_counters;
+		}
+
+		ThreadCounters* RegisterThread();
+
+		Counters		m_counters[TagCount];
+		std::mutex		m_threadMutex;
+		std::vector<std::unique_ptr<ThreadCounters>>	m_threads;
+		uint64_t		m_budgets[TagCount];
+		uint64_t		m_previousAllocations[TagCount];
+		uint64_t		m_previousFrees[TagCount];
+		uint64_t		m_previousAllocatedBytes[TagCount];
+		uint64_t		m_frame;
+		MemorySnapshot	m_lastFrame;
+	};
+
+	inline void TrackAllocation(MemoryTag tag, size_t bytes)
+	{
+#if !defined(DX_MEMORY_TRACKING_DISABLED)
+		MemoryTracker::Get().OnAllocate(tag, bytes);
+#else
+		(void)tag;
+		(void)bytes;
+#endif
+	}
+
+	inline void TrackFree(MemoryTag tag, size_t bytes)
+	{
+#if !defined(DX_MEMORY_TRACKING_DISABLED)
+		MemoryTracker::Get().OnFree(tag, bytes);
+#else
+		(void)tag;
+		(void)bytes;
+#endif
+	}
+
+	// Asignador de la STL que carga sus reservas a Tag.
+	template<typename T, MemoryTag Tag>
+	class TaggedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		TaggedAllocator() {}
+		template<typename U>
+		TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+		template<typename U>
+		struct rebind { typedef TaggedAllocator<U, Tag> other; };
+
+		T* allocate(size_t count)
+		{
+			// Se anota después de reservar: si ::operator new lanza, la etiqueta no cuenta bytes que no existen.
+			T* pointer = static_cast<T*>(::operator new(count * sizeof(T)));
+			TrackAllocation(Tag, count * sizeof(T));
+			return pointer;
+		}
+
+		void deallocate(T* pointer, size_t count)
+		{
+			TrackFree(Tag, count * sizeof(T));
+			::operator delete(pointer);
+		}
+
+		template<typename U>
+		bool operator==(const TaggedAllocator<U, Tag>&) const	{ return true; }
+		template<typename U>
+		bool operator!=(const TaggedAllocator<U, Tag>&) const	{ return false; }
+	};
+
+	template<typename T, MemoryTag Tag>
+	using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+}
@@ -0,0 +1,105 @@
+﻿#include "MockRenderBackend.h"
+
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t Unbound = 0xffffffff;
+}
+
+void DX::MockRenderBackend::Reset()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_shader = Unbound;
+	m_material = Unbound;
+	m_mesh = Unbound;
+}
+
+void DX::MockRenderBackend::BindShader(uint32_t shader)
+{
+	m_stats.shaderBinds++;
+	if (shader != m_shader)
+	{
+		m_stats.shaderChanges++;
+		m_shader = shader;
+	}
+}
+
+void DX::MockRenderBackend::BindMaterial(uint32_t material)
+{
+	m_stats.materialBinds++;
+	if (material != m_material)
+	{
+		m_stats.materialChanges++;
+		m_material = material;
+	}
+}
+
+void DX::MockRenderBackend::BindMesh(uint32_t mesh)
+{
+	m_stats.meshBinds++;
+	if (mesh != m_mesh)
+	{
+		m_stats.meshChanges++;
+		m_mesh = mesh;
+	}
+}
+
+void DX::MockRenderBackend::UpdateConstants(const void*, uint32_t size)
+{
+	m_stats.constantUpdates++;
+	m_stats.constantBytes += size;
+}
+
+void DX::MockRenderBackend::DrawIndexed(uint32_t, uint32_t, int32_t)
+{
+	m_stats.draws++;
+}
+
+void DX::RecordingStateSink::Record(RenderStateSlot slot, uint32_t index, const void* object, uint32_t a, uint32_t b)
+{
+	RecordedStateCall call;
+	call.slot = slot;
+	call.index = index;
+	call.object = object;
+	call.a = a;
+	call.b = b;
+	m_calls.push_back(call);
+}
+
+void DX::RecordingStateSink::SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset)
+{
+	Record(RenderStateSlot::VertexBuffer, slot, buffer, stride, offset);
+}
+
+void DX::RecordingStateSink::SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset)
+{
+	Record(RenderStateSlot::IndexBuffer, 0, buffer, format, offset);
+}
+
+void DX::RecordingStateSink::SetTopology(uint32_t topology)
+{
+	Record(RenderStateSlot::Topology, 0, nullptr, topology, 0);
+}
+
+void DX::RecordingStateSink::SetInputLayout(const void* inputLayout)
+{
+	Record(RenderStateSlot::InputLayout, 0, inputLayout, 0, 0);
+}
+
+void DX::RecordingStateSink::SetVertexShader(const void* shader)
+{
+	Record(RenderStateSlot::VertexShader, 0, shader, 0, 0);
+}
+
+void DX::RecordingStateSink::SetVertexConstantBuffer(uint32_t slot, const void* buffer)
+{
+	Record(RenderStateSlot::ConstantBuffer, slot, buffer, 0, 0);
+}
+
+void DX::RecordingStateSink::SetPixelShader(const void* shader)
+{
+	Record(RenderStateSlot::PixelShader, 0, shader, 0, 0);
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "RenderCommandBuffer.h"
+#include "RenderStateCache.h"
+
+namespace DX
+{
+	// Contadores de la reproducción. Una llamada cuenta como cambio solo si el valor difiere del anterior.
+	struct RenderBackendStats
+	{
+		uint64_t	draws;
+		uint64_t	shaderBinds;
+		uint64_t	shaderChanges;
+		uint64_t	materialBinds;
+		uint64_t	materialChanges;
+		uint64_t	meshBinds;
+		uint64_t	meshChanges;
+		uint64_t	constantUpdates;
+		uint64_t	constantBytes;
+
+		uint64_t GetStateChanges() const		{ return shaderChanges + materialChanges + meshChanges; }
+	};
+
+	// Backend sin dispositivo: registra lo que una reproducción enviaría a la GPU, para medir el efecto
+	// de la ordenación y del filtrado de estado fuera de la aplicación.
+	class MockRenderBackend : public IRenderBackend
+	{
+	public:
+		MockRenderBackend()								{ Reset(); }
+
+		void Reset();
+		const RenderBackendStats& GetStats() const		{ return m_stats; }
+
+		virtual void BindShader(uint32_t shader) override;
+		virtual void BindMaterial(uint32_t material) override;
+		virtual void BindMesh(uint32_t mesh) override;
+		virtual void UpdateConstants(const void* data, uint32_t size) override;
+		virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+
+	private:
+		RenderBackendStats	m_stats;
+		uint32_t			m_shader;
+		uint32_t			m_material;
+		uint32_t			m_mesh;
+	};
+
+	// Asignación de estado grabada por RecordingStateSink. object es el búfer, sombreador o diseño; a y b
+	// son el resto de argumentos (paso y desplazamiento, formato y desplazamiento o topología).
+	struct RecordedStateCall
+	{
+		RenderStateSlot	slot;
+		uint32_t		index;
+		const void*		object;
+		uint32_t		a;
+		uint32_t		b;
+	};
+
+	// Destino de estado sin dispositivo que guarda cada llamada, para comprobar y medir RenderStateCache.
+	class RecordingStateSink : public IRenderStateSink
+	{
+	public:
+		void Clear()										{ m_calls.clear(); }
+		const std::vector<RecordedStateCall>& GetCalls() const	{ return m_calls; }
+
+		virtual void SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset) override;
+		virtual void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) override;
+		virtual void SetTopology(uint32_t topology) override;
+		virtual void SetInputLayout(const void* inputLayout) override;
+		virtual void SetVertexShader(const void* shader) override;
+		virtual void SetVertexConstantBuffer(uint32_t slot, const void* buffer) override;
+		virtual void SetPixelShader(const void* shader) override;
+
+	private:
+		void Record(RenderStateSlot slot, uint32_t index, const void* object, uint32_t a, uint32_t b);
+
+		std::vector<RecordedStateCall>	m_calls;
+	};
+}
@@ -0,0 +1,460 @@
+﻿#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	// Los bordes de la pirámide se prueban hasta este tamaño de rectángulo, en texels por lado.
+	const int32_t MaxTestTexels = 4;
+
+	// Con jobSystem reparte [0, count) en bloques; sin él lo recorre entero en este subproceso.
+	template<typename TFunc>
+	void ForEachRange(JobSystem* jobSystem, uint32_t count, uint32_t grainSize, const TFunc& func)
+	{
+		if (jobSystem != nullptr)
+		{
+			jobSystem->ParallelFor(count, grainSize, func);
+		}
+		else if (count > 0)
+		{
+			func(0, count);
+		}
+	}
+
+	double GetMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+OcclusionCullerDesc OcclusionCullerDesc::CreateDefault()
+{
+	OcclusionCullerDesc desc;
+	desc.width = 256;
+	desc.height = 144;
+	desc.tileWidth = 32;
+	desc.tileHeight = 16;
+	desc.nearW = 0.01f;
+	return desc;
+}
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullerDesc& desc) :
+	m_desc(desc),
+	m_viewProjection(Matrix4::Identity()),
+	m_tilesX(desc.width / desc.tileWidth),
+	m_tilesY(desc.height / desc.tileHeight),
+	m_tileTriangles(static_cast<size_t>(desc.width / desc.tileWidth) * (desc.height / desc.tileHeight)),
+	m_tested(0),
+	m_occluded(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	size_t offset = 0;
+	uint32_t width = desc.width;
+	uint32_t height = desc.height;
+	for (;;)
+	{
+		Level level = { width, height, offset };
+		m_levels.push_back(level);
+		offset += static_cast<size_t>(width) * height;
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+	m_pyramid.assign(offset, 0.0f);
+}
+
+void OcclusionCuller::BeginFrame(const Matrix4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+	m_indices.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_tested = 0;
+	m_occluded = 0;
+}
+
+template<typename TIndex>
+void OcclusionCuller::AddOccluderTriangles(const void* positions, uint32_t stride, uint32_t vertexCount, const TIndex* indices, uint32_t indexCount)
+{
+	uint32_t base = static_cast<uint32_t>(m_positionX.size());
+	const uint8_t* source = static_cast<const uint8_t*>(positions);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		const float* p = reinterpret_cast<const float*>(source + static_cast<size_t>(i) * stride);
+		m_positionX.push_back(p[0]);
+		m_positionY.push_back(p[1]);
+		m_positionZ.push_back(p[2]);
+	}
+
+	uint32_t triangleIndices = indexCount - indexCount % 3;
+	for (uint32_t i = 0; i < triangleIndices; i++)
+	{
+		m_indices.push_back(base + indices[i]);
+	}
+	m_stats.occluderTriangles += triangleIndices / 3;
+}
+
+void OcclusionCuller::AddOccluder(const void* positions, uint32_t stride, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount)
+{
+	AddOccluderTriangles(positions, stride, vertexCount, indices, indexCount);
+}
+
+void OcclusionCuller::AddOccluder(const void* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+	AddOccluderTriangles(positions, stride, vertexCount, indices, indexCount);
+}
+
+// Los vértices son índices en las coordenadas de recorte. Los triángulos que cruzan nearW se descartan en lugar de
+// recortarse: un oclusor de menos solo hace que se dibuje algo de más.
+bool OcclusionCuller::SetupTriangle(uint32_t a, uint32_t b, uint32_t c, TriangleSetup& setup) const
+{
+	if (m_clipW[a] < m_desc.nearW || m_clipW[b] < m_desc.nearW || m_clipW[c] < m_desc.nearW)
+	{
+		return false;
+	}
+
+	float halfWidth = 0.5f * m_desc.width;
+	float halfHeight = 0.5f * m_desc.height;
+	float x[3], y[3], depth[3];
+	const uint32_t vertices[3] = { a, b, c };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		depth[i] = 1.0f / m_clipW[vertices[i]];
+		x[i] = halfWidth + m_clipX[vertices[i]] * depth[i] * halfWidth;
+		y[i] = halfHeight - m_clipY[vertices[i]] * depth[i] * halfHeight;
+	}
+
+	// Píxeles cuyo centro puede caer dentro.
+	setup.minX = std::max(0, static_cast<int32_t>(ceilf(std::min(x[0], std::min(x[1], x[2])) - 0.5f)));
+	setup.minY = std::max(0, static_cast<int32_t>(ceilf(std::min(y[0], std::min(y[1], y[2])) - 0.5f)));
+	setup.maxX = std::min(static_cast<int32_t>(m_desc.width) - 1, static_cast<int32_t>(floorf(std::max(x[0], std::max(x[1], x[2])) - 0.5f)));
+	setup.maxY = std::min(static_cast<int32_t>(m_desc.height) - 1, static_cast<int32_t>(floorf(std::max(y[0], std::max(y[1], y[2])) - 0.5f)));
+	if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+	{
+		return false;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (fabsf(area) < 1e-6f)
+	{
+		return false;
+	}
+
+	// Se invierte el orden de los de área negativa para que el interior sea siempre positivo: las dos caras ocultan.
+	if (area < 0.0f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(depth[1], depth[2]);
+		area = -area;
+	}
+
+	// Arista k: la opuesta al vértice k, de modo que su valor dividido por el área es la coordenada baricéntrica k.
+	float inverseArea = 1.0f / area;
+	setup.depthX = 0.0f;
+	setup.depthY = 0.0f;
+	setup.depthC = 0.0f;
+	for (uint32_t k = 0; k < 3; k++)
+	{
+		uint32_t p = (k + 1) % 3;
+		uint32_t q = (k + 2) % 3;
+		setup.edgeX[k] = y[p] - y[q];
+		setup.edgeY[k] = x[q] - x[p];
+		setup.edgeC[k] = x[p] * y[q] - x[q] * y[p];
+		setup.depthX += setup.edgeX[k] * inverseArea * depth[k];
+		setup.depthY += setup.edgeY[k] * inverseArea * depth[k];
+		setup.depthC += setup.edgeC[k] * inverseArea * depth[k];
+	}
+	return true;
+}
+
+void OcclusionCuller::Rasterize(JobSystem* jobSystem)
+{
+	DX_PROFILE_SCOPE("OcclusionCuller::Rasterize");
+	auto start = std::chrono::steady_clock::now();
+
+	uint32_t vertexCount = static_cast<uint32_t>(m_positionX.size());
+	m_clipX.resize(vertexCount);
+	m_clipY.resize(vertexCount);
+	m_clipW.resize(vertexCount);
+	ForEachRange(jobSystem, vertexCount, 1024, [this](uint32_t begin, uint32_t end)
+	{
+		TransformPoints(m_viewProjection, &m_positionX[begin], &m_positionY[begin], &m_positionZ[begin], end - begin, &m_clipX[begin], &m_clipY[begin], nullptr, &m_clipW[begin]);
+	});
+
+	uint32_t triangleCount = static_cast<uint32_t>(m_indices.size() / 3);
+	m_setups.resize(triangleCount);
+	m_setupValid.resize(triangleCount);
+	ForEachRange(jobSystem, triangleCount, 512, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t t = begin; t < end; t++)
+		{
+			const uint32_t* index = &m_indices[static_cast<size_t>(t) * 3];
+			m_setupValid[t] = SetupTriangle(index[0], index[1], index[2], m_setups[t]) ? 1 : 0;
+		}
+	});
+
+	// Reparto por cuadros en orden, de modo que cada cuadro rasteriza sus triángulos en el orden en que se añadieron.
+	for (std::vector<uint32_t>& list : m_tileTriangles)
+	{
+		list.clear();
+	}
+	m_stats.rasterizedTriangles = 0;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		if (!m_setupValid[t])
+		{
+			continue;
+		}
+
+		const TriangleSetup& setup = m_setups[t];
+		m_stats.rasterizedTriangles++;
+		for (uint32_t ty = setup.minY / m_desc.tileHeight; ty <= setup.maxY / m_desc.tileHeight; ty++)
+		{
+			for (uint32_t tx = setup.minX / m_desc.tileWidth; tx <= setup.maxX / m_desc.tileWidth; tx++)
+			{
+				m_tileTriangles[ty * m_tilesX + tx].push_back(t);
+			}
+		}
+	}
+
+	ForEachRange(jobSystem, m_tilesX * m_tilesY, 1, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t tile = begin; tile < end; tile++)
+		{
+			RasterizeTile(tile);
+		}
+	});
+	m_stats.rasterizeMilliseconds = GetMilliseconds(start);
+
+	auto pyramidStart = std::chrono::steady_clock::now();
+	for (uint32_t level = 1; level < m_levels.size(); level++)
+	{
+		BuildLevel(jobSystem, level);
+	}
+	m_stats.pyramidMilliseconds = GetMilliseconds(pyramidStart);
+}
+
+// Cuatro píxeles por paso. Sin instrucción de selección, la cobertura entra en la profundidad: el mínimo de
+// las tres aristas, multiplicado por un número enorme, es negativo fuera del triángulo (y el máximo conserva
+// lo que había) y mayor que la profundidad dentro, salvo a una fracción ínfima de píxel de una arista, donde
+// el resultado queda más lejos y la prueba sigue siendo conservadora.
+void OcclusionCuller::RasterizeTile(uint32_t tile)
+{
+	int32_t x0 = static_cast<int32_t>((tile % m_tilesX) * m_desc.tileWidth);
+	int32_t y0 = static_cast<int32_t>((tile / m_tilesX) * m_desc.tileHeight);
+	int32_t x1 = x0 + static_cast<int32_t>(m_desc.tileWidth) - 1;
+	int32_t y1 = y0 + static_cast<int32_t>(m_desc.tileHeight) - 1;
+	float* depthBuffer = m_pyramid.data();
+	uint32_t rowPitch = m_desc.width;
+
+	for (int32_t y = y0; y <= y1; y++)
+	{
+		std::fill(depthBuffer + static_cast<size_t>(y) * rowPitch + x0, depthBuffer + static_cast<size_t>(y) * rowPitch + x1 + 1, 0.0f);
+	}
+
+	const SimdFloat4 laneOffsets = SimdFloat4::Set(0.5f, 1.5f, 2.5f, 3.5f);
+	const SimdFloat4 coverageScale = SimdFloat4::Splat(1e30f);
+	for (uint32_t t : m_tileTriangles[tile])
+	{
+		const TriangleSetup& setup = m_setups[t];
+		int32_t startX = std::max(setup.minX, x0) & ~3;
+		int32_t endX = std::min(setup.maxX, x1);
+		int32_t startY = std::max(setup.minY, y0);
+		int32_t endY = std::min(setup.maxY, y1);
+
+		SimdFloat4 edgeX0 = SimdFloat4::Splat(setup.edgeX[0]);
+		SimdFloat4 edgeX1 = SimdFloat4::Splat(setup.edgeX[1]);
+		SimdFloat4 edgeX2 = SimdFloat4::Splat(setup.edgeX[2]);
+		SimdFloat4 depthX = SimdFloat4::Splat(setup.depthX);
+		for (int32_t y = startY; y <= endY; y++)
+		{
+			float centerY = y + 0.5f;
+			SimdFloat4 row0 = SimdFloat4::Splat(setup.edgeY[0] * centerY + setup.edgeC[0]);
+			SimdFloat4 row1 = SimdFloat4::Splat(setup.edgeY[1] * centerY + setup.edgeC[1]);
+			SimdFloat4 row2 = SimdFloat4::Splat(setup.edgeY[2] * centerY + setup.edgeC[2]);
+			SimdFloat4 rowDepth = SimdFloat4::Splat(setup.depthY * centerY + setup.depthC);
+			float* target = depthBuffer + static_cast<size_t>(y) * rowPitch;
+			for (int32_t x = startX; x <= endX; x += 4)
+			{
+				SimdFloat4 centerX = SimdFloat4::Splat(static_cast<float>(x)) + laneOffsets;
+				SimdFloat4 coverage = Min(edgeX0 * centerX + row0, Min(edgeX1 * centerX + row1, edgeX2 * centerX + row2));
+				SimdFloat4 depth = Min(depthX * centerX + rowDepth, coverage * coverageScale);
+				Max(SimdFloat4::Load(target + x), depth).Store(target + x);
+			}
+		}
+	}
+}
+
+// Cada texel es el mínimo de los (hasta) cuatro de debajo; en un borde impar se repite el último.
+void OcclusionCuller::BuildLevel(JobSystem* jobSystem, uint32_t level)
+{
+	const Level& source = m_levels[level - 1];
+	const Level& target = m_levels[level];
+	const float* from = m_pyramid.data() + source.offset;
+	float* to = m_pyramid.data() + target.offset;
+	ForEachRange(jobSystem, target.height, 16, [&source, &target, from, to](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			const float* row0 = from + static_cast<size_t>(2 * y) * source.width;
+			const float* row1 = from + static_cast<size_t>(std::min(2 * y + 1, source.height - 1)) * source.width;
+			for (uint32_t x = 0; x < target.width; x++)
+			{
+				uint32_t left = 2 * x;
+				uint32_t right = std::min(2 * x + 1, source.width - 1);
+				to[static_cast<size_t>(y) * target.width + x] = std::min(std::min(row0[left], row0[right]), std::min(row1[left], row1[right]));
+			}
+		}
+	});
+}
+
+// Las ocho esquinas se proyectan de cuatro en cuatro. Un volumen que cruza nearW o queda fuera de la
+// pantalla se da por visible: de lo segundo se ocupa el tronco.
+bool OcclusionCuller::TestAabb(const Vector3& center, const Vector3& extents) const
+{
+	const Matrix4& m = m_viewProjection;
+	SimdFloat4 xs = SimdFloat4::Set(center.x - extents.x, center.x + extents.x, center.x - extents.x, center.x + extents.x);
+	SimdFloat4 ys = SimdFloat4::Set(center.y - extents.y, center.y - extents.y, center.y + extents.y, center.y + extents.y);
+	float nearZ = center.z - extents.z;
+	float farZ = center.z + extents.z;
+
+	SimdFloat4 clip[3][2];
+	const int columns[3] = { 0, 1, 3 };
+	for (int i = 0; i < 3; i++)
+	{
+		int j = columns[i];
+		SimdFloat4 base = xs * SimdFloat4::Splat(m.m[0][j]) + ys * SimdFloat4::Splat(m.m[1][j]) + SimdFloat4::Splat(m.m[3][j]);
+		clip[i][0] = base + SimdFloat4::Splat(nearZ * m.m[2][j]);
+		clip[i][1] = base + SimdFloat4::Splat(farZ * m.m[2][j]);
+	}
+
+	SimdFloat4 nearW = SimdFloat4::Splat(m_desc.nearW);
+	if ((LessEqualMask(clip[2][0], nearW) | LessEqualMask(clip[2][1], nearW)) != 0)
+	{
+		return true;
+	}
+
+	SimdFloat4 one = SimdFloat4::Splat(1.0f);
+	SimdFloat4 halfWidth = SimdFloat4::Splat(0.5f * m_desc.width);
+	SimdFloat4 halfHeight = SimdFloat4::Splat(0.5f * m_desc.height);
+	SimdFloat4 depth[2], screenX[2], screenY[2];
+	for (int k = 0; k < 2; k++)
+	{
+		depth[k] = one / clip[2][k];
+		screenX[k] = halfWidth + clip[0][k] * depth[k] * halfWidth;
+		screenY[k] = halfHeight - clip[1][k] * depth[k] * halfHeight;
+	}
+
+	float minX[4], maxX[4], minY[4], maxY[4], nearest[4];
+	Min(screenX[0], screenX[1]).Store(minX);
+	Max(screenX[0], screenX[1]).Store(maxX);
+	Min(screenY[0], screenY[1]).Store(minY);
+	Max(screenY[0], screenY[1]).Store(maxY);
+	Max(depth[0], depth[1]).Store(nearest);
+	for (int k = 1; k < 4; k++)
+	{
+		minX[0] = std::min(minX[0], minX[k]);
+		maxX[0] = std::max(maxX[0], maxX[k]);
+		minY[0] = std::min(minY[0], minY[k]);
+		maxY[0] = std::max(maxY[0], maxY[k]);
+		nearest[0] = std::max(nearest[0], nearest[k]);
+	}
+
+	// Todos los píxeles que toca el rectángulo, no solo aquellos cuyo centro cubre.
+	if (maxX[0] < 0.0f || maxY[0] < 0.0f || minX[0] >= m_desc.width || minY[0] >= m_desc.height)
+	{
+		return true;
+	}
+	int32_t x0 = std::max(0, static_cast<int32_t>(minX[0]));
+	int32_t y0 = std::max(0, static_cast<int32_t>(minY[0]));
+	int32_t x1 = std::min(static_cast<int32_t>(m_desc.width) - 1, static_cast<int32_t>(maxX[0]));
+	int32_t y1 = std::min(static_cast<int32_t>(m_desc.height) - 1, static_cast<int32_t>(maxY[0]));
+
+	uint32_t level = 0;
+	while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) >= MaxTestTexels || (y1 >> level) - (y0 >> level) >= MaxTestTexels))
+	{
+		level++;
+	}
+
+	const Level& info = m_levels[level];
+	const float* data = m_pyramid.data() + info.offset;
+	for (int32_t y = y0 >> level; y <= (y1 >> level); y++)
+	{
+		for (int32_t x = x0 >> level; x <= (x1 >> level); x++)
+		{
+			if (nearest[0] >= data[static_cast<size_t>(y) * info.width + x])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool OcclusionCuller::IsAabbVisible(const Vector3& center, const Vector3& extents) const
+{
+	bool visible = TestAabb(center, extents);
+	m_tested.fetch_add(1, std::memory_order_relaxed);
+	if (!visible)
+	{
+		m_occluded.fetch_add(1, std::memory_order_relaxed);
+	}
+	return visible;
+}
+
+uint32_t OcclusionCuller::CullSpheres(JobSystem* jobSystem, const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible)
+{
+	DX_PROFILE_SCOPE("OcclusionCuller::CullSpheres");
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<uint32_t> visibleCount(0);
+	ForEachRange(jobSystem, count, 1024, [&](uint32_t begin, uint32_t end)
+	{
+		uint32_t tested = 0;
+		uint32_t occluded = 0;
+		uint32_t stillVisible = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (!visible[i])
+			{
+				continue;
+			}
+
+			tested++;
+			if (TestAabb(Vector3(x[i], y[i], z[i]), Vector3(radius[i], radius[i], radius[i])))
+			{
+				stillVisible++;
+			}
+			else
+			{
+				visible[i] = 0;
+				occluded++;
+			}
+		}
+		m_tested.fetch_add(tested, std::memory_order_relaxed);
+		m_occluded.fetch_add(occluded, std::memory_order_relaxed);
+		visibleCount += stillVisible;
+	});
+	m_stats.testMilliseconds += GetMilliseconds(start);
+	return visibleCount;
+}
+
+OcclusionStats OcclusionCuller::GetStats() const
+{
+	OcclusionStats stats = m_stats;
+	stats.tested = m_tested;
+	stats.occluded = m_occluded;
+	return stats;
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "VectorMath.h"
+
+namespace DX
+{
+	struct OcclusionCullerDesc
+	{
+		uint32_t	width;			// Del búfer de profundidad, en píxeles: múltiplo de tileWidth.
+		uint32_t	height;			// Múltiplo de tileHeight.
+		uint32_t	tileWidth;		// Múltiplo de 4 (una fila de un cuadro se rasteriza de cuatro en cuatro píxeles).
+		uint32_t	tileHeight;
+		float		nearW;			// Profundidad de vista mínima: más cerca, los oclusores se ignoran y las cajas son visibles.
+
+		static OcclusionCullerDesc CreateDefault();
+	};
+
+	struct OcclusionStats
+	{
+		uint32_t	occluderTriangles;		// Añadidos desde BeginFrame.
+		uint32_t	rasterizedTriangles;	// Los que quedan tras descartar los degenerados, fuera de pantalla o cortados por nearW.
+		uint32_t	tested;					// Pruebas desde BeginFrame.
+		uint32_t	occluded;
+		double		rasterizeMilliseconds;	// Transformación, reparto por cuadros y rasterización.
+		double		pyramidMilliseconds;
+		double		testMilliseconds;		// Solo de CullSpheres; las pruebas sueltas no se cronometran.
+	};
+
+	// Descarte por oclusión en la CPU. Cada fotograma se rasterizan unos pocos oclusores elegidos (grandes y
+	// cercanos) en un búfer de profundidad pequeño, repartido en cuadros que se rasterizan en paralelo, con
+	// cuatro píxeles por instrucción. Se guarda 1/w, que es lineal en pantalla y no pierde precisión con la
+	// distancia como z/w; sin oclusor vale 0. Sobre él se construye una pirámide en la que cada texel guarda
+	// el mínimo de los cuatro de debajo (el oclusor más lejano), y un volumen está ocluido si su punto más
+	// cercano queda detrás en todos los texels que cubre su rectángulo en pantalla, en el nivel en que ese
+	// rectángulo mide como mucho 4 x 4 texels. Las pruebas son conservadoras salvo en el borde de los
+	// oclusores, donde un píxel cuenta como cubierto si lo está su centro.
+	class OcclusionCuller
+	{
+	public:
+		explicit OcclusionCuller(const OcclusionCullerDesc& desc);
+
+		// Vacía los oclusores y fija la matriz vista-proyección del fotograma (convención de Frustum).
+		void BeginFrame(const Matrix4& viewProjection);
+
+		// Copia los triángulos de una malla en espacio del mundo; las posiciones son tres flotantes cada
+		// stride bytes. Ambas caras ocultan.
+		void AddOccluder(const void* positions, uint32_t stride, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount);
+		void AddOccluder(const void* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+		// Rasteriza los oclusores y construye la pirámide. Sin jobSystem se hace en este subproceso.
+		void Rasterize(JobSystem* jobSystem);
+
+		// Se pueden llamar desde varios subprocesos a la vez después de Rasterize.
+		bool IsAabbVisible(const Vector3& center, const Vector3& extents) const;
+		bool IsSphereVisible(const Vector3& center, float radius) const	{ return IsAabbVisible(center, Vector3(radius, radius, radius)); }
+
+		// Como Frustum::CullSpheres, pero solo prueba (y puede poner a 0) las esferas con visible != 0, de modo
+		// que se encadena tras el descarte por tronco. Devuelve cuántas siguen visibles.
+		uint32_t CullSpheres(JobSystem* jobSystem, const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible);
+
+		const OcclusionCullerDesc& GetDesc() const	{ return m_desc; }
+		OcclusionStats GetStats() const;
+
+		// Nivel 0 (el búfer de profundidad) y siguientes: 1/w por texel, fila a fila.
+		uint32_t GetLevelCount() const							{ return static_cast<uint32_t>(m_levels.size()); }
+		uint32_t GetLevelWidth(uint32_t level) const			{ return m_levels[level].width; }
+		uint32_t GetLevelHeight(uint32_t level) const			{ return m_levels[level].height; }
+		const float* GetLevelData(uint32_t level) const			{ return m_pyramid.data() + m_levels[level].offset; }
+
+	private:
+		struct Level
+		{
+			uint32_t	width;
+			uint32_t	height;
+			size_t		offset;
+		};
+
+		// Funciones de arista y plano de 1/w, en píxeles, de un triángulo ya en pantalla.
+		struct TriangleSetup
+		{
+			float		edgeX[3];
+			float		edgeY[3];
+			float		edgeC[3];
+			float		depthX;
+			float		depthY;
+			float		depthC;
+			int32_t		minX;
+			int32_t		minY;
+			int32_t		maxX;
+			int32_t		maxY;
+		};
+
+		template<typename TIndex>
+		void AddOccluderTriangles(const void* positions, uint32_t stride, uint32_t vertexCount, const TIndex* indices, uint32_t indexCount);
+		bool SetupTriangle(uint32_t a, uint32_t b, uint32_t c, TriangleSetup& setup) const;
+		bool TestAabb(const Vector3& center, const Vector3& extents) const;
+		void RasterizeTile(uint32_t tile);
+		void BuildLevel(JobSystem* jobSystem, uint32_t level);
+
+		OcclusionCullerDesc			m_desc;
+		Matrix4						m_viewProjection;
+		uint32_t					m_tilesX;
+		uint32_t					m_tilesY;
+
+		// Posiciones y coordenadas de recorte como estructura de arrays, para transformarlas de cuatro en cuatro.
+		std::vector<float>			m_positionX;
+		std::vector<float>			m_positionY;
+		std::vector<float>			m_positionZ;
+		std::vector<uint32_t>		m_indices;
+		std::vector<float>			m_clipX;
+		std::vector<float>			m_clipY;
+		std::vector<float>			m_clipW;
+		std::vector<TriangleSetup>	m_setups;
+		std::vector<uint8_t>		m_setupValid;
+		std::vector<std::vector<uint32_t>>	m_tileTriangles;
+
+		std::vector<Level>			m_levels;
+		std::vector<float>			m_pyramid;
+
+		OcclusionStats				m_stats;
+		mutable std::atomic<uint32_t>	m_tested;
+		mutable std::atomic<uint32_t>	m_occluded;
+	};
+}
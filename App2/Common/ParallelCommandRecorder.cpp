@@ -0,0 +1,37 @@
+﻿#include "ParallelCommandRecorder.h"
+
+using namespace DX;
+
+DX::ParallelCommandRecorder::ParallelCommandRecorder(uint32_t objectsPerList) :
+	m_listCount(0),
+	m_objectsPerList((objectsPerList > 0) ? objectsPerList : 1)
+{
+}
+
+void DX::ParallelCommandRecorder::PrepareLists(uint32_t count)
+{
+	while (m_lists.size() < count)
+	{
+		// Cada lista se dimensiona para su tramo, con las constantes típicas de un dibujo.
+		m_lists.emplace_back(m_objectsPerList, m_objectsPerList * 256);
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_lists[i].Reset();
+	}
+	m_listCount = count;
+}
+
+void DX::ParallelCommandRecorder::Merge(JobSystem* jobSystem, RenderCommandBuffer& target) const
+{
+	target.Append(jobSystem, m_lists.data(), m_listCount);
+}
+
+void DX::ParallelCommandRecorder::Submit(IRenderBackend& backend) const
+{
+	for (uint32_t i = 0; i < m_listCount; i++)
+	{
+		m_lists[i].Submit(backend);
+	}
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "RenderCommandBuffer.h"
+
+namespace DX
+{
+	// Graba los dibujos de muchos objetos en paralelo, al estilo de los contextos diferidos: los objetos
+	// se reparten en tramos fijos de objectsPerList y cada tramo graba en su propia lista, sin compartir
+	// nada con los demás. Las listas se unen siempre en el orden de los tramos, de modo que el resultado
+	// es idéntico con cualquier número de subprocesos.
+	class ParallelCommandRecorder
+	{
+	public:
+		explicit ParallelCommandRecorder(uint32_t objectsPerList = 1024);
+
+		// Llama a record(list, begin, end) para cada tramo de [0, count) repartiendo los tramos entre los
+		// subprocesos de jobSystem (puede ser nullptr). record solo debe escribir en list.
+		template<typename TRecord>
+		void Record(JobSystem* jobSystem, uint32_t count, const TRecord& record)
+		{
+			uint32_t listCount = (count + m_objectsPerList - 1) / m_objectsPerList;
+			PrepareLists(listCount);
+
+			RenderCommandBuffer* lists = m_lists.data();
+			uint32_t objectsPerList = m_objectsPerList;
+			auto recordLists = [=, &record](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					uint32_t first = i * objectsPerList;
+					uint32_t last = (first + objectsPerList < count) ? first + objectsPerList : count;
+					record(lists[i], first, last);
+				}
+			};
+
+			if (jobSystem != nullptr && listCount > 1)
+			{
+				jobSystem->ParallelFor(listCount, 1, recordLists);
+			}
+			else
+			{
+				recordLists(0, listCount);
+			}
+		}
+
+		// Añade las listas grabadas, en orden, al final de target.
+		void Merge(JobSystem* jobSystem, RenderCommandBuffer& target) const;
+
+		// Reproduce las listas en orden sin unirlas (sin ordenar por clave entre listas).
+		void Submit(IRenderBackend& backend) const;
+
+		uint32_t GetListCount() const							{ return m_listCount; }
+		const RenderCommandBuffer& GetList(uint32_t i) const	{ return m_lists[i]; }
+
+	private:
+		// Vacía las primeras count listas, creando las que falten. Las listas conservan su memoria.
+		void PrepareLists(uint32_t count);
+
+		std::vector<RenderCommandBuffer>	m_lists;
+		uint32_t							m_listCount;
+		uint32_t							m_objectsPerList;
+	};
+}
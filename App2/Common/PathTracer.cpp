@@ -0,0 +1,285 @@
+﻿#include "PathTracer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	// Separación de los puntos de impacto, en unidades de la escena (un cubo mide 0.1).
+	const float SurfaceOffset = 1e-4f;
+
+	inline Vector3 Multiply(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(a.x * b.x, a.y * b.y, a.z * b.z);
+	}
+
+	// Hash PCG: a partir de él, cada píxel y muestra tiene su propia secuencia.
+	inline uint32_t Hash(uint32_t value)
+	{
+		uint32_t state = value * 747796405u + 2891336453u;
+		uint32_t word = ((state >> ((state >> 28) + 4)) ^ state) * 277803737u;
+		return (word >> 22) ^ word;
+	}
+
+	inline float NextFloat(uint32_t& state)
+	{
+		state = Hash(state);
+		return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Dirección con densidad proporcional al coseno alrededor de la normal.
+	Vector3 SampleCosine(const Vector3& normal, uint32_t& state)
+	{
+		float r1 = NextFloat(state);
+		float r2 = NextFloat(state);
+		float radius = sqrtf(r1);
+		float angle = 2.0f * Pi * r2;
+		float x = radius * cosf(angle);
+		float y = radius * sinf(angle);
+		float z = sqrtf(std::max(0.0f, 1.0f - r1));
+
+		Vector3 helper = (fabsf(normal.x) > 0.9f) ? Vector3(0.0f, 1.0f, 0.0f) : Vector3(1.0f, 0.0f, 0.0f);
+		Vector3 tangent = Normalize(Cross(helper, normal));
+		Vector3 bitangent = Cross(normal, tangent);
+		return tangent * x + bitangent * y + normal * z;
+	}
+
+	void StoreLittleEndian(uint8_t* target, uint32_t value, uint32_t bytes)
+	{
+		for (uint32_t i = 0; i < bytes; i++)
+		{
+			target[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xff);
+		}
+	}
+}
+
+PathTracerDesc PathTracerDesc::CreateDefault(uint32_t width, uint32_t height)
+{
+	PathTracerDesc desc;
+	desc.width = width;
+	desc.height = height;
+	desc.tileSize = 16;
+	desc.maxBounces = 3;
+	desc.sunDirection = Vector3(0.424f, 0.848f, 0.318f);
+	desc.sunColor = Vector3(0.9f, 0.85f, 0.75f);
+	desc.skyHorizon = Vector3(0.85f, 0.9f, 1.0f);
+	desc.skyZenith = Vector3(0.392f, 0.584f, 0.929f);
+	return desc;
+}
+
+PathTracer::PathTracer(JobSystem* jobSystem, const PathTracerDesc& desc) :
+	m_jobSystem(jobSystem),
+	m_desc(desc),
+	m_accumulation(static_cast<size_t>(desc.width) * desc.height * 3, 0.0f)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	SetCamera(Vector3(0.0f, 0.0f, 1.0f), Vector3(), Vector3(0.0f, 1.0f, 0.0f), 1.0f);
+}
+
+void PathTracer::SetScene(const TraceScene& scene)
+{
+	uint32_t triangleCount = scene.GetTriangleCount();
+	m_bvh.Build(m_jobSystem, scene.positions.data(), triangleCount);
+	m_albedo = scene.albedo;
+	m_normals.resize(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		const Vector3* v = &scene.positions[static_cast<size_t>(t) * 3];
+		Vector3 normal = Cross(v[1] - v[0], v[2] - v[0]);
+		float length = Length(normal);
+		m_normals[t] = (length > 0.0f) ? normal * (1.0f / length) : Vector3(0.0f, 1.0f, 0.0f);
+	}
+	ResetAccumulation();
+}
+
+// Misma convención que LookAtRH y PerspectiveFovRH: right y up van escalados al borde de la imagen.
+void PathTracer::SetCamera(const Vector3& eye, const Vector3& target, const Vector3& up, float fovAngleY)
+{
+	float halfHeight = tanf(fovAngleY * 0.5f);
+	float halfWidth = halfHeight * m_desc.width / m_desc.height;
+	m_eye = eye;
+	m_forward = Normalize(target - eye);
+	Vector3 right = Normalize(Cross(m_forward, up));
+	m_right = right * halfWidth;
+	m_up = Cross(right, m_forward) * halfHeight;
+	ResetAccumulation();
+}
+
+void PathTracer::ResetAccumulation()
+{
+	std::fill(m_accumulation.begin(), m_accumulation.end(), 0.0f);
+	m_stats.samplesPerPixel = 0;
+}
+
+Vector3 PathTracer::GetSkyColor(const Vector3& direction) const
+{
+	float t = std::max(0.0f, direction.y);
+	return m_desc.skyHorizon + (m_desc.skyZenith - m_desc.skyHorizon) * t;
+}
+
+// Muestreo por coseno: con un material difuso, el peso de cada rebote es su albedo. El sol se suma con un
+// rayo de sombra en cada impacto (estimación del siguiente evento).
+Vector3 PathTracer::TracePath(Ray ray, uint32_t& state, uint64_t& rays) const
+{
+	Vector3 radiance;
+	Vector3 throughput(1.0f, 1.0f, 1.0f);
+	for (uint32_t bounce = 0; bounce <= m_desc.maxBounces; bounce++)
+	{
+		RayHit hit;
+		rays++;
+		if (!m_bvh.Intersect(ray, hit))
+		{
+			radiance += Multiply(throughput, GetSkyColor(ray.direction));
+			break;
+		}
+
+		Vector3 normal = m_normals[hit.triangle];
+		if (Dot(normal, ray.direction) > 0.0f)
+		{
+			normal = -normal;
+		}
+		Vector3 albedo = m_albedo[hit.triangle];
+		Vector3 point = ray.origin + ray.direction * hit.distance + normal * SurfaceOffset;
+
+		float sunCosine = Dot(normal, m_desc.sunDirection);
+		if (sunCosine > 0.0f)
+		{
+			Ray shadow = { point, m_desc.sunDirection, 1e30f };
+			rays++;
+			if (!m_bvh.IsOccluded(shadow))
+			{
+				radiance += Multiply(Multiply(throughput, albedo), m_desc.sunColor) * sunCosine;
+			}
+		}
+
+		throughput = Multiply(throughput, albedo);
+		ray.origin = point;
+		ray.direction = SampleCosine(normal, state);
+		ray.maxDistance = 1e30f;
+	}
+	return radiance;
+}
+
+void PathTracer::RenderPass()
+{
+	DX_PROFILE_SCOPE("PathTracer::RenderPass");
+	auto start = std::chrono::steady_clock::now();
+	uint32_t tileSize = m_desc.tileSize;
+	uint32_t tilesX = (m_desc.width + tileSize - 1) / tileSize;
+	uint32_t tilesY = (m_desc.height + tileSize - 1) / tileSize;
+	uint32_t sample = m_stats.samplesPerPixel;
+	std::atomic<uint64_t> totalRays(0);
+
+	m_jobSystem->ParallelFor(tilesX * tilesY, 1, [&](uint32_t begin, uint32_t end)
+	{
+		uint64_t rays = 0;
+		for (uint32_t tile = begin; tile < end; tile++)
+		{
+			uint32_t x0 = (tile % tilesX) * tileSize;
+			uint32_t y0 = (tile / tilesX) * tileSize;
+			uint32_t x1 = std::min(m_desc.width, x0 + tileSize);
+			uint32_t y1 = std::min(m_desc.height, y0 + tileSize);
+			for (uint32_t y = y0; y < y1; y++)
+			{
+				for (uint32_t x = x0; x < x1; x++)
+				{
+					uint32_t pixel = y * m_desc.width + x;
+					uint32_t state = Hash(pixel ^ Hash(sample * 0x9e3779b9u + 1u));
+					float ndcX = 2.0f * (x + NextFloat(state)) / m_desc.width - 1.0f;
+					float ndcY = 1.0f - 2.0f * (y + NextFloat(state)) / m_desc.height;
+					Ray ray = { m_eye, Normalize(m_forward + m_right * ndcX + m_up * ndcY), 1e30f };
+
+					Vector3 color = TracePath(ray, state, rays);
+					float* target = &m_accumulation[static_cast<size_t>(pixel) * 3];
+					target[0] += color.x;
+					target[1] += color.y;
+					target[2] += color.z;
+				}
+			}
+		}
+		totalRays += rays;
+	});
+
+	m_stats.samplesPerPixel++;
+	m_stats.rays = totalRays;
+	m_stats.passMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_stats.threads = m_jobSystem->GetThreadCount();
+	m_stats.raysPerSecond = (m_stats.passMilliseconds > 0.0) ? m_stats.rays / (m_stats.passMilliseconds / 1000.0) : 0.0;
+	m_stats.raysPerSecondPerThread = m_stats.raysPerSecond / m_stats.threads;
+}
+
+void PathTracer::Resolve(std::vector<uint8_t>& rgb) const
+{
+	rgb.resize(static_cast<size_t>(m_desc.width) * m_desc.height * 3);
+	float scale = (m_stats.samplesPerPixel > 0) ? 1.0f / m_stats.samplesPerPixel : 0.0f;
+	for (size_t i = 0; i < rgb.size(); i++)
+	{
+		float value = std::min(1.0f, m_accumulation[i] * scale);
+		rgb[i] = static_cast<uint8_t>(powf(value, 1.0f / 2.2f) * 255.0f + 0.5f);
+	}
+}
+
+bool PathTracer::WriteBmp(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	WriteBmp(file);
+	bool succeeded = ferror(file) == 0;
+	return fclose(file) == 0 && succeeded;
+}
+
+void PathTracer::WriteBmp(FILE* file) const
+{
+	std::vector<uint8_t> bytes;
+	EncodeBmp(bytes);
+	fwrite(bytes.data(), 1, bytes.size(), file);
+}
+
+// Cabecera de archivo (14 bytes) y BITMAPINFOHEADER (40); las filas van de abajo arriba, en BGR y
+// alineadas a 4 bytes.
+void PathTracer::EncodeBmp(std::vector<uint8_t>& bytes) const
+{
+	std::vector<uint8_t> rgb;
+	Resolve(rgb);
+	uint32_t rowBytes = (m_desc.width * 3 + 3) & ~3u;
+	uint32_t imageBytes = rowBytes * m_desc.height;
+
+	bytes.assign(54 + static_cast<size_t>(imageBytes), 0);
+	uint8_t* header = bytes.data();
+	header[0] = 'B';
+	header[1] = 'M';
+	StoreLittleEndian(header + 2, 54 + imageBytes, 4);
+	StoreLittleEndian(header + 10, 54, 4);
+	StoreLittleEndian(header + 14, 40, 4);
+	StoreLittleEndian(header + 18, m_desc.width, 4);
+	StoreLittleEndian(header + 22, m_desc.height, 4);
+	StoreLittleEndian(header + 26, 1, 2);
+	StoreLittleEndian(header + 28, 24, 2);
+	StoreLittleEndian(header + 34, imageBytes, 4);
+	StoreLittleEndian(header + 38, 2835, 4);
+	StoreLittleEndian(header + 42, 2835, 4);
+
+	for (uint32_t y = 0; y < m_desc.height; y++)
+	{
+		const uint8_t* source = &rgb[static_cast<size_t>(y) * m_desc.width * 3];
+		uint8_t* row = &bytes[54 + static_cast<size_t>(m_desc.height - 1 - y) * rowBytes];
+		for (uint32_t x = 0; x < m_desc.width; x++)
+		{
+			row[x * 3 + 0] = source[x * 3 + 2];
+			row[x * 3 + 1] = source[x * 3 + 1];
+			row[x * 3 + 2] = source[x * 3 + 0];
+		}
+	}
+}
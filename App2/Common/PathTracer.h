@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "JobSystem.h"
+#include "TriangleBvh.h"
+#include "VectorMath.h"
+
+namespace DX
+{
+	// Geometría para el trazador: tres vértices y un color difuso (albedo) por triángulo.
+	struct TraceScene
+	{
+		std::vector<Vector3>	positions;
+		std::vector<Vector3>	albedo;
+
+		void AddTriangle(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& color)
+		{
+			positions.push_back(a);
+			positions.push_back(b);
+			positions.push_back(c);
+			albedo.push_back(color);
+		}
+
+		uint32_t GetTriangleCount() const	{ return static_cast<uint32_t>(albedo.size()); }
+	};
+
+	struct PathTracerDesc
+	{
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	tileSize;		// Lado de los cuadros que se reparten entre los subprocesos.
+		uint32_t	maxBounces;
+		Vector3		sunDirection;	// Hacia el sol, normalizada.
+		Vector3		sunColor;
+		Vector3		skyHorizon;
+		Vector3		skyZenith;
+
+		static PathTracerDesc CreateDefault(uint32_t width, uint32_t height);
+	};
+
+	struct PathTracerStats
+	{
+		uint32_t	samplesPerPixel;	// Acumuladas desde ResetAccumulation.
+		uint64_t	rays;				// De la última pasada: primarios, rebotes y sombras.
+		double		passMilliseconds;
+		double		raysPerSecond;
+		double		raysPerSecondPerThread;
+		uint32_t	threads;
+	};
+
+	// Trazador de caminos para fotogramas sin GPU: superficies difusas de dos caras, luz del cielo
+	// (degradado del horizonte al cénit) y un sol direccional muestreado con un rayo de sombra en cada
+	// rebote. Cada RenderPass añade una muestra por píxel al acumulador (render progresivo); la imagen se
+	// reparte en cuadros de tileSize píxeles que se trazan en paralelo. Los números aleatorios dependen solo
+	// del píxel y del número de muestra, así que el resultado no depende del número de subprocesos.
+	class PathTracer
+	{
+	public:
+		PathTracer(JobSystem* jobSystem, const PathTracerDesc& desc);
+
+		// Construye la jerarquía y vacía el acumulador.
+		void SetScene(const TraceScene& scene);
+		void SetCamera(const Vector3& eye, const Vector3& target, const Vector3& up, float fovAngleY);
+
+		void ResetAccumulation();
+		void RenderPass();
+
+		// Media de las muestras con corrección gamma, en RGB de 8 bits por fila de arriba abajo.
+		void Resolve(std::vector<uint8_t>& rgb) const;
+
+		// BMP de 24 bits sin comprimir; EncodeBmp lo deja en memoria para escribirlo en otro subproceso.
+		bool WriteBmp(const char* path) const;
+		void WriteBmp(FILE* file) const;
+		void EncodeBmp(std::vector<uint8_t>& bytes) const;
+
+		const PathTracerDesc& GetDesc() const		{ return m_desc; }
+		const PathTracerStats& GetStats() const		{ return m_stats; }
+		const BvhStats& GetBvhStats() const			{ return m_bvh.GetStats(); }
+
+	private:
+		Vector3 TracePath(Ray ray, uint32_t& state, uint64_t& rays) const;
+		Vector3 GetSkyColor(const Vector3& direction) const;
+
+		JobSystem*				m_jobSystem;
+		PathTracerDesc			m_desc;
+		TriangleBvh				m_bvh;
+		std::vector<Vector3>	m_albedo;
+		std::vector<Vector3>	m_normals;
+
+		Vector3		m_eye;
+		Vector3		m_forward;
+		Vector3		m_right;
+		Vector3		m_up;
+
+		std::vector<float>		m_accumulation;	// RGB por píxel.
+		PathTracerStats			m_stats;
+	};
+}
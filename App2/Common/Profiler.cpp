@@ -0,0 +1,351 @@
+﻿#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t NoParent = 0xffffffff;
+
+	int64_t SteadyNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Los nombres de los marcadores son literales, pero se escapan por si contienen comillas o barras.
+	void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				fprintf(file, "\\u%04x", static_cast<unsigned char>(*c));
+			}
+			else
+			{
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+}
+
+DX::Profiler& DX::Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+DX::Profiler::Profiler() :
+	m_calibrationTicks(Timestamp()),
+	m_calibrationNanoseconds(SteadyNanoseconds()),
+	m_frame(0),
+	m_capturing(false),
+	m_captureLimit(0)
+{
+#if defined(DX_PROFILER_RDTSC)
+	// Estimación inicial hasta la primera calibración: se mide el contador durante un milisegundo.
+	int64_t target = m_calibrationNanoseconds + 1000000;
+	int64_t now;
+	while ((now = SteadyNanoseconds()) < target)
+	{
+	}
+	m_millisecondsPerTick = (now - m_calibrationNanoseconds) * 1e-6 / static_cast<double>(Timestamp() - m_calibrationTicks);
+#else
+	m_millisecondsPerTick = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::duration(1)).count();
+#endif
+
+	m_originTicks = Timestamp();
+	m_frameStart = m_originTicks;
+	m_lastFrame.frame = 0;
+	m_lastFrame.milliseconds = 0.0;
+	m_lastFrame.droppedEvents = 0;
+}
+
+DX::Profiler::ThreadBuffer* DX::Profiler::RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint32_t index = static_cast<uint32_t>(m_threads.size());
+	m_threads.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer(index)));
+	return m_threads.back().get();
+}
+
+void DX::Profiler::SetCurrentThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	buffer.name = name;
+}
+
+// Con rdtsc, la frecuencia del contador se obtiene comparando con steady_clock desde el arranque;
+// cuanto más tiempo pasa, más precisa es la relación.
+void DX::Profiler::Calibrate()
+{
+#if defined(DX_PROFILER_RDTSC)
+	uint64_t ticks = Timestamp();
+	int64_t nanoseconds = SteadyNanoseconds();
+	if (nanoseconds - m_calibrationNanoseconds > 10000000 && ticks > m_calibrationTicks)
+	{
+		m_millisecondsPerTick = (nanoseconds - m_calibrationNanoseconds) * 1e-6 / static_cast<double>(ticks - m_calibrationTicks);
+	}
+#endif
+}
+
+void DX::Profiler::EndFrame()
+{
+	uint64_t frameEnd = Timestamp();
+	Calibrate();
+
+	m_lastFrame.frame = m_frame;
+	m_lastFrame.milliseconds = TicksToMilliseconds(frameEnd - m_frameStart);
+	m_lastFrame.droppedEvents = 0;
+	m_lastFrame.nodes.clear();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& thread : m_threads)
+	{
+		ThreadBuffer& buffer = *thread;
+		uint64_t write = buffer.writeIndex.load(std::memory_order_acquire);
+		uint64_t read = buffer.readIndex;
+		if (write - read > ThreadBufferSize)
+		{
+			m_lastFrame.droppedEvents += static_cast<uint32_t>(write - read - ThreadBufferSize);
+			read = write - ThreadBufferSize;
+		}
+
+		m_scratch.resize(static_cast<size_t>(write - read));
+		for (uint64_t i = read; i < write; i++)
+		{
+			m_scratch[static_cast<size_t>(i - read)] = buffer.events[i & (ThreadBufferSize - 1)];
+		}
+
+		// Si el subproceso ha dado la vuelta al búfer mientras se copiaba, los primeros eventos pueden estar mezclados.
+		uint64_t writeAfter = buffer.writeIndex.load(std::memory_order_acquire);
+		if (writeAfter - read > ThreadBufferSize)
+		{
+			uint64_t torn = std::min<uint64_t>(writeAfter - read - ThreadBufferSize, write - read);
+			m_scratch.erase(m_scratch.begin(), m_scratch.begin() + static_cast<size_t>(torn));
+			m_lastFrame.droppedEvents += static_cast<uint32_t>(torn);
+		}
+		buffer.readIndex = write;
+
+		if (m_scratch.empty())
+		{
+			continue;
+		}
+
+		if (m_capturing)
+		{
+			for (const ProfileEvent& event : m_scratch)
+			{
+				if (m_capture.size() >= m_captureLimit)
+				{
+					break;
+				}
+				CapturedEvent captured;
+				captured.event = event;
+				captured.thread = buffer.thread;
+				m_capture.push_back(captured);
+			}
+		}
+
+		AggregateThread(buffer.thread, m_scratch.data(), static_cast<uint32_t>(m_scratch.size()));
+	}
+
+	// Recolocar los nodos en orden de recorrido en profundidad para poder mostrarlos con sangría. Los hijos
+	// siempre se crean después de su padre, y un fotograma tiene pocas decenas de nodos.
+	std::vector<ProfileNode>& nodes = m_lastFrame.nodes;
+	m_orderedNodes.clear();
+	m_remap.assign(nodes.size(), NoParent);
+	m_stack.clear();
+	for (uint32_t i = static_cast<uint32_t>(nodes.size()); i-- > 0;)
+	{
+		if (nodes[i].parent == NoParent)
+		{
+			m_stack.push_back(i);
+		}
+	}
+	while (!m_stack.empty())
+	{
+		uint32_t index = m_stack.back();
+		m_stack.pop_back();
+		m_remap[index] = static_cast<uint32_t>(m_orderedNodes.size());
+		m_orderedNodes.push_back(nodes[index]);
+		for (uint32_t i = static_cast<uint32_t>(nodes.size()); i-- > index + 1;)
+		{
+			if (nodes[i].parent == index)
+			{
+				m_stack.push_back(i);
+			}
+		}
+	}
+	for (ProfileNode& node : m_orderedNodes)
+	{
+		if (node.parent != NoParent)
+		{
+			node.parent = m_remap[node.parent];
+		}
+	}
+	nodes.swap(m_orderedNodes);
+
+	if (m_capturing)
+	{
+		m_captureFrames.push_back(std::make_pair(m_frameStart, frameEnd));
+	}
+
+	m_frameStart = frameEnd;
+	m_frame++;
+}
+
+// Reconstruye el anidamiento a partir de la profundidad de cada evento y suma los tiempos por nodo.
+void DX::Profiler::AggregateThread(uint32_t thread, ProfileEvent* events, uint32_t count)
+{
+	std::sort(events, events + count, [](const ProfileEvent& a, const ProfileEvent& b)
+	{
+		return (a.start != b.start) ? a.start < b.start : a.depth < b.depth;
+	});
+
+	std::vector<ProfileNode>& nodes = m_lastFrame.nodes;
+	uint32_t firstNode = static_cast<uint32_t>(nodes.size());
+	m_stack.clear();
+
+	for (uint32_t e = 0; e < count; e++)
+	{
+		const ProfileEvent& event = events[e];
+
+		// Un padre que empezó en un fotograma anterior y aún no ha terminado no aparece aquí;
+		// sus hijos se cuelgan del antecesor más cercano que sí esté.
+		while (m_stack.size() > event.depth)
+		{
+			m_stack.pop_back();
+		}
+		uint32_t parent = m_stack.empty() ? NoParent : m_stack.back();
+
+		// El nombre es un literal, así que basta comparar punteros.
+		uint32_t node = NoParent;
+		for (uint32_t i = firstNode; i < nodes.size(); i++)
+		{
+			if (nodes[i].parent == parent && nodes[i].name == event.name)
+			{
+				node = i;
+				break;
+			}
+		}
+		if (node == NoParent)
+		{
+			ProfileNode created;
+			created.name = event.name;
+			created.thread = thread;
+			created.depth = (parent == NoParent) ? 0 : nodes[parent].depth + 1;
+			created.parent = parent;
+			created.calls = 0;
+			created.inclusiveMilliseconds = 0.0;
+			created.selfMilliseconds = 0.0;
+			node = static_cast<uint32_t>(nodes.size());
+			nodes.push_back(created);
+		}
+
+		double milliseconds = TicksToMilliseconds(event.end - event.start);
+		nodes[node].calls++;
+		nodes[node].inclusiveMilliseconds += milliseconds;
+		nodes[node].selfMilliseconds += milliseconds;
+		if (parent != NoParent)
+		{
+			nodes[parent].selfMilliseconds -= milliseconds;
+		}
+
+		// Si faltan niveles, se rellenan con el padre para que los hijos de este evento lo encuentren a su profundidad.
+		while (m_stack.size() < event.depth)
+		{
+			m_stack.push_back(parent);
+		}
+		m_stack.push_back(node);
+	}
+}
+
+void DX::Profiler::BeginCapture(uint32_t maxEvents)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_capture.clear();
+	m_captureFrames.clear();
+	m_capture.reserve(std::min<uint32_t>(maxEvents, 1 << 16));
+	m_captureLimit = maxEvents;
+	m_capturing = true;
+	m_originTicks = Timestamp();
+}
+
+void DX::Profiler::EndCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_capturing = false;
+}
+
+bool DX::Profiler::WriteChromeTrace(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	WriteChromeTrace(file);
+	bool succeeded = ferror(file) == 0;
+	return fclose(file) == 0 && succeeded;
+}
+
+// Eventos completos ("X") por marcador, un evento instantáneo por límite de fotograma y los nombres
+// de los subprocesos como metadatos. Las marcas de tiempo van en microsegundos desde BeginCapture.
+void DX::Profiler::WriteChromeTrace(FILE* file) const
+{
+	double microsecondsPerTick = m_millisecondsPerTick * 1000.0;
+	auto toMicroseconds = [this, microsecondsPerTick](uint64_t ticks)
+	{
+		return (ticks >= m_originTicks) ? (ticks - m_originTicks) * microsecondsPerTick : -((m_originTicks - ticks) * microsecondsPerTick);
+	};
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& thread : m_threads)
+	{
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", thread->thread);
+		if (thread->name.empty())
+		{
+			fprintf(file, "\"Subproceso %u\"", thread->thread);
+		}
+		else
+		{
+			WriteJsonString(file, thread->name.c_str());
+		}
+		fprintf(file, "}}");
+		first = false;
+	}
+
+	for (size_t i = 0; i < m_captureFrames.size(); i++)
+	{
+		fprintf(file, "%s{\"name\":\"Fotograma\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}", first ? "" : ",\n", toMicroseconds(m_captureFrames[i].second));
+		first = false;
+	}
+
+	for (const CapturedEvent& captured : m_capture)
+	{
+		fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+		WriteJsonString(file, captured.event.name);
+		fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			captured.thread,
+			toMicroseconds(captured.event.start),
+			(captured.event.end - captured.event.start) * microsecondsPerTick);
+		first = false;
+	}
+
+	fprintf(file, "\n]}\n");
+}
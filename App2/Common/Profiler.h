@@ -0,0 +1,201 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DX_PROFILER_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define DX_PROFILER_RDTSC 1
+#else
+#include <chrono>
+#endif
+
+// Con DX_PROFILER_DISABLED definido, las macros DX_PROFILE_* no generan código.
+#if !defined(DX_PROFILER_DISABLED)
+#define DX_PROFILE_CONCAT_INNER(a, b) a##b
+#define DX_PROFILE_CONCAT(a, b) DX_PROFILE_CONCAT_INNER(a, b)
+#define DX_PROFILE_SCOPE(name) DX::ProfileScope DX_PROFILE_CONCAT(dxProfileScope, __LINE__)(name)
+#define DX_PROFILE_THREAD(name) DX::Profiler::Get().SetCurrentThreadName(name)
+#else
+#define DX_PROFILE_SCOPE(name) ((void)0)
+#define DX_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace DX
+{
+	// Intervalo medido por un marcador. Los nombres deben ser cadenas estáticas: solo se guarda el puntero.
+	struct ProfileEvent
+	{
+		const char*	name;
+		uint64_t	start;
+		uint64_t	end;
+		uint32_t	depth;
+	};
+
+	// Nodo del árbol agregado de un fotograma: todas las llamadas con el mismo nombre y el mismo padre
+	// en un subproceso se suman en un nodo. Los nodos aparecen en orden de recorrido en profundidad.
+	struct ProfileNode
+	{
+		const char*	name;
+		uint32_t	thread;
+		uint32_t	depth;
+		uint32_t	parent;				// Índice del nodo padre o UINT32_MAX en la raíz.
+		uint32_t	calls;
+		double		inclusiveMilliseconds;
+		double		selfMilliseconds;
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t					frame;
+		double						milliseconds;
+		uint32_t					droppedEvents;
+		std::vector<ProfileNode>	nodes;
+	};
+
+	// Perfilador jerárquico de CPU. Cada subproceso escribe sus marcadores en un búfer circular propio sin
+	// bloqueos; EndFrame, llamado una vez por fotograma desde el bucle, recoge los eventos de todos los
+	// subprocesos, los agrega en un árbol por fotograma y, si hay una captura en curso, los copia para
+	// exportarlos como traza de Chrome (chrome://tracing o Perfetto).
+	class Profiler
+	{
+	public:
+		static Profiler& Get();
+
+		// Marca de tiempo en ticks: rdtsc en x86 y steady_clock en el resto de plataformas.
+		static uint64_t Timestamp()
+		{
+#if defined(DX_PROFILER_RDTSC)
+			return __rdtsc();
+#else
+			return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+		}
+
+		// Abre y cierra un marcador en el subproceso actual. Se usan a través de ProfileScope.
+		uint32_t BeginScope()						{ return GetThreadBuffer().depth++; }
+		void EndScope(const char* name, uint64_t start, uint32_t depth)
+		{
+			ThreadBuffer& buffer = GetThreadBuffer();
+			buffer.depth = depth;
+			uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+			ProfileEvent& event = buffer.events[index & (ThreadBufferSize - 1)];
+			event.name = name;
+			event.start = start;
+			event.end = Timestamp();
+			event.depth = depth;
+			buffer.writeIndex.store(index + 1, std::memory_order_release);
+		}
+
+		void SetCurrentThreadName(const char* name);
+		uint32_t GetCurrentThread()					{ return GetThreadBuffer().thread; }
+
+		// Cierra el fotograma: agrega los eventos terminados desde la llamada anterior.
+		void EndFrame();
+		const ProfileFrame& GetLastFrame() const	{ return m_lastFrame; }
+
+		// Guarda los eventos de los fotogramas siguientes hasta EndCapture (como mucho maxEvents).
+		void BeginCapture(uint32_t maxEvents = 1 << 20);
+		void EndCapture();
+		bool IsCapturing() const					{ return m_capturing; }
+		uint32_t GetCapturedEventCount() const		{ return static_cast<uint32_t>(m_capture.size()); }
+
+		// Escribe la captura en formato JSON de Chrome Trace Event.
+		bool WriteChromeTrace(const char* path) const;
+		void WriteChromeTrace(FILE* file) const;
+
+		double TicksToMilliseconds(uint64_t ticks) const	{ return ticks * m_millisecondsPerTick; }
+
+	private:
+		static const uint32_t ThreadBufferSize = 1 << 15;
+
+		struct ThreadBuffer
+		{
+			ThreadBuffer(uint32_t index) : thread(index), depth(0), writeIndex(0), readIndex(0) {}
+
+			uint32_t				thread;
+			std::string				name;
+			uint32_t				depth;
+			std::atomic<uint64_t>	writeIndex;		// Solo lo escribe el propio subproceso.
+			uint64_t				readIndex;		// Solo lo toca EndFrame.
+			ProfileEvent			events[ThreadBufferSize];
+		};
+
+		struct CapturedEvent
+		{
+			ProfileEvent	event;
+			uint32_t		thread;
+		};
+
+		Profiler();
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			static thread_local ThreadBuffer* t_buffer = nullptr;
+			if (t_buffer == nullptr)
+			{
+				t_buffer = RegisterThread();
+			}
+			return *t_buffer;
+		}
+
+		ThreadBuffer* RegisterThread();
+		void Calibrate();
+		void AggregateThread(uint32_t thread, ProfileEvent* events, uint32_t count);
+
+		mutable std::mutex							m_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>>	m_threads;
+
+		// Conversión de ticks a milisegundos, recalibrada contra steady_clock en cada fotograma.
+		uint64_t									m_calibrationTicks;
+		int64_t										m_calibrationNanoseconds;
+		double										m_millisecondsPerTick;
+		uint64_t									m_originTicks;
+
+		uint64_t									m_frame;
+		uint64_t									m_frameStart;
+		ProfileFrame								m_lastFrame;
+		std::vector<ProfileEvent>					m_scratch;
+		std::vector<uint32_t>						m_stack;
+		std::vector<ProfileNode>					m_orderedNodes;
+		std::vector<uint32_t>						m_remap;
+
+		bool										m_capturing;
+		uint32_t									m_captureLimit;
+		std::vector<CapturedEvent>					m_capture;
+		std::vector<std::pair<uint64_t, uint64_t>>	m_captureFrames;
+	};
+
+	// Marcador con ámbito: mide desde su construcción hasta su destrucción.
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name) :
+			m_name(name),
+			m_depth(Profiler::Get().BeginScope()),
+			m_start(Profiler::Timestamp())
+		{
+		}
+
+		~ProfileScope()
+		{
+			Profiler::Get().EndScope(m_name, m_start, m_depth);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char*	m_name;
+		uint32_t	m_depth;
+		uint64_t	m_start;
+	};
+}
@@ -0,0 +1,133 @@
+﻿#include "RadixSort.h"
+
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t DigitCount = 8;
+	const uint32_t BucketCount = 256;
+
+	// Por debajo de este tamaño, repartir entre subprocesos cuesta más que lo que se gana.
+	const uint32_t MinItemsPerBlock = 16384;
+
+	inline uint32_t Digit(uint64_t key, uint32_t digit)
+	{
+		return static_cast<uint32_t>(key >> (digit * 8)) & (BucketCount - 1);
+	}
+}
+
+void DX::RadixSorter::Sort(JobSystem* jobSystem, RadixSortItem* items, uint32_t count)
+{
+	if (count < 2)
+	{
+		return;
+	}
+
+	// Histograma global de todos los dígitos en una sola lectura: no cambia entre pasadas y dice cuáles se pueden omitir.
+	uint32_t globalHistogram[DigitCount][BucketCount];
+	memset(globalHistogram, 0, sizeof(globalHistogram));
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t key = items[i].key;
+		for (uint32_t d = 0; d < DigitCount; d++)
+		{
+			globalHistogram[d][Digit(key, d)]++;
+		}
+	}
+
+	uint32_t threadCount = (jobSystem != nullptr) ? jobSystem->GetThreadCount() : 1;
+	uint32_t blockCount = (count + MinItemsPerBlock - 1) / MinItemsPerBlock;
+	if (blockCount > threadCount)
+	{
+		blockCount = threadCount;
+	}
+	uint32_t blockSize = (count + blockCount - 1) / blockCount;
+
+	// Por bloque y dígito: primero el histograma del bloque y después su posición de escritura.
+	m_offsets.resize(static_cast<size_t>(blockCount) * BucketCount);
+	uint32_t* offsets = m_offsets.data();
+	if (m_scratch.size() < count)
+	{
+		m_scratch.resize(count);
+	}
+
+	RadixSortItem* source = items;
+	RadixSortItem* destination = m_scratch.data();
+
+	for (uint32_t d = 0; d < DigitCount; d++)
+	{
+		if (globalHistogram[d][Digit(source[0].key, d)] == count)
+		{
+			continue;
+		}
+
+		auto countBlocks = [=](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t block = begin; block < end; block++)
+			{
+				uint32_t* histogram = &offsets[static_cast<size_t>(block) * BucketCount];
+				memset(histogram, 0, BucketCount * sizeof(uint32_t));
+				uint32_t first = block * blockSize;
+				uint32_t last = (first + blockSize < count) ? first + blockSize : count;
+				for (uint32_t i = first; i < last; i++)
+				{
+					histogram[Digit(source[i].key, d)]++;
+				}
+			}
+		};
+
+		// Posición de escritura: todos los elementos con dígito menor, más los del mismo dígito en bloques anteriores.
+		auto computeOffsets = [&]()
+		{
+			uint32_t position = 0;
+			for (uint32_t bucket = 0; bucket < BucketCount; bucket++)
+			{
+				for (uint32_t block = 0; block < blockCount; block++)
+				{
+					uint32_t& entry = offsets[static_cast<size_t>(block) * BucketCount + bucket];
+					uint32_t blockItems = entry;
+					entry = position;
+					position += blockItems;
+				}
+			}
+		};
+
+		auto scatterBlocks = [=](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t block = begin; block < end; block++)
+			{
+				uint32_t* position = &offsets[static_cast<size_t>(block) * BucketCount];
+				uint32_t first = block * blockSize;
+				uint32_t last = (first + blockSize < count) ? first + blockSize : count;
+				for (uint32_t i = first; i < last; i++)
+				{
+					destination[position[Digit(source[i].key, d)]++] = source[i];
+				}
+			}
+		};
+
+		if (jobSystem != nullptr && blockCount > 1)
+		{
+			jobSystem->ParallelFor(blockCount, 1, countBlocks);
+			computeOffsets();
+			jobSystem->ParallelFor(blockCount, 1, scatterBlocks);
+		}
+		else
+		{
+			countBlocks(0, blockCount);
+			computeOffsets();
+			scatterBlocks(0, blockCount);
+		}
+
+		RadixSortItem* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	if (source != items)
+	{
+		memcpy(items, source, static_cast<size_t>(count) * sizeof(RadixSortItem));
+	}
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+
+namespace DX
+{
+	// Clave de 64 bits con un valor de 32 bits (normalmente el índice del elemento ordenado).
+	struct RadixSortItem
+	{
+		uint64_t	key;
+		uint32_t	value;
+		uint32_t	padding;
+	};
+
+	// Ordenación por base estable (LSD, dígitos de 8 bits) por clave ascendente. Cada pasada reparte los
+	// elementos en bloques entre los subprocesos de jobSystem (puede ser nullptr): cada bloque cuenta su
+	// histograma, se calculan los desplazamientos por dígito y bloque, y cada bloque dispersa sus elementos
+	// sin sincronización. Las pasadas en las que todas las claves comparten el dígito se omiten, así que las
+	// claves con bits altos constantes salen más baratas. La memoria auxiliar se conserva entre llamadas.
+	class RadixSorter
+	{
+	public:
+		void Sort(JobSystem* jobSystem, RadixSortItem* items, uint32_t count);
+
+	private:
+		std::vector<RadixSortItem>	m_scratch;
+		std::vector<uint32_t>		m_offsets;		// [bloque][dígito]
+	};
+}
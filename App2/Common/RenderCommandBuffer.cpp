@@ -0,0 +1,124 @@
+﻿#include "RenderCommandBuffer.h"
+
+#include <cstring>
+
+using namespace DX;
+
+DX::RenderCommandBuffer::RenderCommandBuffer(uint32_t capacity, uint32_t constantBytes) :
+	m_constantBytes(0)
+{
+	m_items.reserve(capacity);
+	m_packets.reserve(capacity);
+	m_constants.resize(constantBytes);
+}
+
+void DX::RenderCommandBuffer::Reset()
+{
+	m_items.clear();
+	m_packets.clear();
+	m_constantBytes = 0;
+}
+
+uint32_t DX::RenderCommandBuffer::AddConstants(const void* data, uint32_t size)
+{
+	uint32_t offset = (m_constantBytes + 15) & ~15u;
+	if (offset + size > m_constants.size())
+	{
+		// Crece en bloques grandes para que en régimen estable no haya más reservas.
+		m_constants.resize((offset + size) * 2);
+	}
+
+	memcpy(&m_constants[offset], data, size);
+	m_constantBytes = offset + size;
+	return offset;
+}
+
+void DX::RenderCommandBuffer::Add(uint64_t key, const DrawPacket& packet)
+{
+	RadixSortItem item;
+	item.key = key;
+	item.value = static_cast<uint32_t>(m_packets.size());
+	item.padding = 0;
+	m_items.push_back(item);
+	m_packets.push_back(packet);
+}
+
+void DX::RenderCommandBuffer::Append(JobSystem* jobSystem, const RenderCommandBuffer* sources, uint32_t sourceCount)
+{
+	// Primero se reparte el espacio: cada fuente sabe dónde escribir sin depender de las demás.
+	m_appendBases.resize(static_cast<size_t>(sourceCount) * 2);
+	uint32_t* packetBases = m_appendBases.data();
+	uint32_t* constantBases = packetBases + sourceCount;
+	uint32_t packetCount = static_cast<uint32_t>(m_packets.size());
+	uint32_t constantBytes = m_constantBytes;
+	for (uint32_t i = 0; i < sourceCount; i++)
+	{
+		constantBytes = (constantBytes + 15) & ~15u;
+		packetBases[i] = packetCount;
+		constantBases[i] = constantBytes;
+		packetCount += sources[i].GetCount();
+		constantBytes += sources[i].m_constantBytes;
+	}
+
+	m_items.resize(packetCount);
+	m_packets.resize(packetCount);
+	if (constantBytes > m_constants.size())
+	{
+		m_constants.resize(static_cast<size_t>(constantBytes) * 2);
+	}
+	m_constantBytes = constantBytes;
+
+	auto copySources = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const RenderCommandBuffer& source = sources[i];
+			uint32_t packetBase = packetBases[i];
+			uint32_t constantBase = constantBases[i];
+			for (uint32_t j = 0; j < source.GetCount(); j++)
+			{
+				RadixSortItem item = source.m_items[j];
+				item.value += packetBase;
+				m_items[packetBase + j] = item;
+
+				DrawPacket packet = source.m_packets[j];
+				packet.constantOffset += constantBase;
+				m_packets[packetBase + j] = packet;
+			}
+			if (source.m_constantBytes > 0)
+			{
+				memcpy(&m_constants[constantBase], source.m_constants.data(), source.m_constantBytes);
+			}
+		}
+	};
+
+	if (jobSystem != nullptr && sourceCount > 1)
+	{
+		jobSystem->ParallelFor(sourceCount, 1, copySources);
+	}
+	else
+	{
+		copySources(0, sourceCount);
+	}
+}
+
+void DX::RenderCommandBuffer::Sort(JobSystem* jobSystem)
+{
+	m_sorter.Sort(jobSystem, m_items.data(), static_cast<uint32_t>(m_items.size()));
+}
+
+void DX::RenderCommandBuffer::Submit(IRenderBackend& backend) const
+{
+	for (const RadixSortItem& item : m_items)
+	{
+		const DrawPacket& packet = m_packets[item.value];
+		backend.BindShader(packet.shader);
+		backend.BindMaterial(packet.material);
+		backend.BindMesh(packet.mesh);
+		if (packet.constantSize > 0)
+		{
+			backend.UpdateConstants(&m_constants[packet.constantOffset], packet.constantSize);
+		}
+		backend.DrawIndexed(packet.indexCount, packet.startIndex, packet.baseVertex);
+	}
+}
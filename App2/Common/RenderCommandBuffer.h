@@ -0,0 +1,112 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "RadixSort.h"
+
+namespace DX
+{
+	// Clave de ordenación de 64 bits, de más a menos significativo:
+	//   opaco:      pasada (4) | sombreador (12) | material (16) | profundidad (24) | libre (8)
+	//   translúcido: pasada (4) | profundidad invertida (24) | sombreador (12) | material (16) | libre (8)
+	// Los opacos se agrupan por estado y, dentro de cada grupo, se dibujan de delante a atrás; los
+	// translúcidos se dibujan de atrás a delante aunque eso obligue a cambiar de estado.
+	namespace RenderSortKey
+	{
+		const uint32_t MaxPass = 15;
+		const uint32_t MaxShader = 4095;
+		const uint32_t MaxMaterial = 65535;
+
+		// depth en [0, 1] (0 = plano cercano); se cuantiza a 24 bits.
+		inline uint64_t QuantizeDepth(float depth)
+		{
+			float clamped = (depth < 0.0f) ? 0.0f : (depth > 1.0f) ? 1.0f : depth;
+			return static_cast<uint64_t>(clamped * 16777215.0f);
+		}
+
+		inline uint64_t Opaque(uint32_t pass, uint32_t shader, uint32_t material, float depth)
+		{
+			return (static_cast<uint64_t>(pass & MaxPass) << 60) |
+				(static_cast<uint64_t>(shader & MaxShader) << 48) |
+				(static_cast<uint64_t>(material & MaxMaterial) << 32) |
+				(QuantizeDepth(depth) << 8);
+		}
+
+		inline uint64_t Translucent(uint32_t pass, uint32_t shader, uint32_t material, float depth)
+		{
+			return (static_cast<uint64_t>(pass & MaxPass) << 60) |
+				((16777215ull - QuantizeDepth(depth)) << 36) |
+				(static_cast<uint64_t>(shader & MaxShader) << 24) |
+				(static_cast<uint64_t>(material & MaxMaterial) << 8);
+		}
+	}
+
+	// Paquete de dibujo compacto. Los identificadores los asigna el backend al registrar los recursos; las
+	// constantes del dibujo viven en la memoria del propio búfer de comandos.
+	struct DrawPacket
+	{
+		uint16_t	shader;
+		uint16_t	material;
+		uint16_t	mesh;
+		uint16_t	constantSize;
+		uint32_t	constantOffset;
+		uint32_t	indexCount;
+		uint32_t	startIndex;
+		int32_t		baseVertex;
+	};
+
+	// Destino de la reproducción de un búfer de comandos: Direct3D 11 en la aplicación o un backend
+	// simulado que solo cuenta. Cada dibujo llega con todo su estado; es el backend quien decide qué
+	// llamadas son redundantes.
+	class IRenderBackend
+	{
+	public:
+		virtual ~IRenderBackend() {}
+
+		virtual void BindShader(uint32_t shader) = 0;
+		virtual void BindMaterial(uint32_t material) = 0;
+		virtual void BindMesh(uint32_t mesh) = 0;
+		virtual void UpdateConstants(const void* data, uint32_t size) = 0;
+		virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+	};
+
+	// Búfer de comandos de dibujo de un fotograma. Los representadores añaden paquetes en cualquier orden,
+	// Sort los ordena por clave con una ordenación por base paralela y Submit los reproduce en ese orden.
+	class RenderCommandBuffer
+	{
+	public:
+		explicit RenderCommandBuffer(uint32_t capacity = 1024, uint32_t constantBytes = 64 * 1024);
+
+		// Vacía el búfer conservando la memoria.
+		void Reset();
+
+		// Copia constantes para un paquete y devuelve su desplazamiento (alineado a 16 bytes).
+		uint32_t AddConstants(const void* data, uint32_t size);
+
+		void Add(uint64_t key, const DrawPacket& packet);
+
+		// Añade al final los paquetes de sourceCount búferes, en ese orden y cada uno en su orden actual,
+		// copiándolos en paralelo. Los desplazamientos de constantes se ajustan a este búfer.
+		void Append(JobSystem* jobSystem, const RenderCommandBuffer* sources, uint32_t sourceCount);
+
+		// Ordena por clave; los paquetes con la misma clave conservan el orden en que se añadieron.
+		void Sort(JobSystem* jobSystem);
+
+		// Reproduce los paquetes en orden (el de inserción si no se ha llamado a Sort).
+		void Submit(IRenderBackend& backend) const;
+
+		uint32_t GetCount() const					{ return static_cast<uint32_t>(m_packets.size()); }
+		const DrawPacket& GetPacket(uint32_t i) const	{ return m_packets[m_items[i].value]; }
+		uint64_t GetKey(uint32_t i) const			{ return m_items[i].key; }
+
+	private:
+		TaggedVector<RadixSortItem, MemoryTag::RenderCommands>	m_items;
+		TaggedVector<DrawPacket, MemoryTag::RenderCommands>		m_packets;
+		TaggedVector<uint8_t, MemoryTag::RenderCommands>		m_constants;
+		uint32_t					m_constantBytes;
+		RadixSorter					m_sorter;
+		std::vector<uint32_t>		m_appendBases;	// Append: paquete y constantes iniciales por fuente.
+	};
+}
@@ -0,0 +1,159 @@
+﻿#include "RenderStateCache.h"
+
+#include <cstring>
+
+using namespace DX;
+
+uint64_t DX::RenderStateStats::GetIssued() const
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < RenderStateSlotCount; i++)
+	{
+		total += issued[i];
+	}
+	return total;
+}
+
+uint64_t DX::RenderStateStats::GetFiltered() const
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < RenderStateSlotCount; i++)
+	{
+		total += filtered[i];
+	}
+	return total;
+}
+
+DX::RenderStateCache::RenderStateCache(IRenderStateSink* sink) :
+	m_sink(sink)
+{
+	Invalidate();
+	ResetStats();
+}
+
+void DX::RenderStateCache::Invalidate()
+{
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(&m_indexBuffer, 0, sizeof(m_indexBuffer));
+	m_topology = 0;
+	m_topologyValid = false;
+	m_inputLayout.valid = false;
+	m_vertexShader.valid = false;
+	for (ObjectState& constantBuffer : m_constantBuffers)
+	{
+		constantBuffer.valid = false;
+	}
+	m_pixelShader.valid = false;
+}
+
+void DX::RenderStateCache::ResetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+bool DX::RenderStateCache::Count(RenderStateSlot slot, bool changed)
+{
+	uint32_t index = static_cast<uint32_t>(slot);
+	if (changed)
+	{
+		m_stats.issued[index]++;
+	}
+	else
+	{
+		m_stats.filtered[index]++;
+	}
+	return changed;
+}
+
+void DX::RenderStateCache::SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset)
+{
+	if (slot >= MaxVertexBufferSlots)
+	{
+		Count(RenderStateSlot::VertexBuffer, true);
+		m_sink->SetVertexBuffer(slot, buffer, stride, offset);
+		return;
+	}
+
+	VertexBufferState& state = m_vertexBuffers[slot];
+	bool changed = !state.valid || state.buffer != buffer || state.stride != stride || state.offset != offset;
+	if (Count(RenderStateSlot::VertexBuffer, changed))
+	{
+		state.buffer = buffer;
+		state.stride = stride;
+		state.offset = offset;
+		state.valid = true;
+		m_sink->SetVertexBuffer(slot, buffer, stride, offset);
+	}
+}
+
+void DX::RenderStateCache::SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset)
+{
+	IndexBufferState& state = m_indexBuffer;
+	bool changed = !state.valid || state.buffer != buffer || state.format != format || state.offset != offset;
+	if (Count(RenderStateSlot::IndexBuffer, changed))
+	{
+		state.buffer = buffer;
+		state.format = format;
+		state.offset = offset;
+		state.valid = true;
+		m_sink->SetIndexBuffer(buffer, format, offset);
+	}
+}
+
+void DX::RenderStateCache::SetTopology(uint32_t topology)
+{
+	if (Count(RenderStateSlot::Topology, !m_topologyValid || m_topology != topology))
+	{
+		m_topology = topology;
+		m_topologyValid = true;
+		m_sink->SetTopology(topology);
+	}
+}
+
+void DX::RenderStateCache::SetInputLayout(const void* inputLayout)
+{
+	if (Count(RenderStateSlot::InputLayout, !m_inputLayout.valid || m_inputLayout.object != inputLayout))
+	{
+		m_inputLayout.object = inputLayout;
+		m_inputLayout.valid = true;
+		m_sink->SetInputLayout(inputLayout);
+	}
+}
+
+void DX::RenderStateCache::SetVertexShader(const void* shader)
+{
+	if (Count(RenderStateSlot::VertexShader, !m_vertexShader.valid || m_vertexShader.object != shader))
+	{
+		m_vertexShader.object = shader;
+		m_vertexShader.valid = true;
+		m_sink->SetVertexShader(shader);
+	}
+}
+
+void DX::RenderStateCache::SetVertexConstantBuffer(uint32_t slot, const void* buffer)
+{
+	if (slot >= MaxConstantBufferSlots)
+	{
+		Count(RenderStateSlot::ConstantBuffer, true);
+		m_sink->SetVertexConstantBuffer(slot, buffer);
+		return;
+	}
+
+	ObjectState& state = m_constantBuffers[slot];
+	if (Count(RenderStateSlot::ConstantBuffer, !state.valid || state.object != buffer))
+	{
+		state.object = buffer;
+		state.valid = true;
+		m_sink->SetVertexConstantBuffer(slot, buffer);
+	}
+}
+
+void DX::RenderStateCache::SetPixelShader(const void* shader)
+{
+	if (Count(RenderStateSlot::PixelShader, !m_pixelShader.valid || m_pixelShader.object != shader))
+	{
+		m_pixelShader.object = shader;
+		m_pixelShader.valid = true;
+		m_sink->SetPixelShader(shader);
+	}
+}
@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	// Estados de la canalización que filtra RenderStateCache.
+	enum class RenderStateSlot : uint32_t
+	{
+		VertexBuffer,
+		IndexBuffer,
+		Topology,
+		InputLayout,
+		VertexShader,
+		ConstantBuffer,
+		PixelShader,
+		Count
+	};
+
+	const uint32_t RenderStateSlotCount = static_cast<uint32_t>(RenderStateSlot::Count);
+
+	// Llamadas que llegaron al contexto y llamadas descartadas por redundantes, por estado.
+	struct RenderStateStats
+	{
+		uint64_t	issued[RenderStateSlotCount];
+		uint64_t	filtered[RenderStateSlotCount];
+
+		uint64_t GetIssued() const;
+		uint64_t GetFiltered() const;
+	};
+
+	// Contexto de dispositivo visto como una serie de asignaciones de estado. Los objetos son punteros
+	// opacos (ID3D11Buffer*, ID3D11VertexShader*...) y los formatos y topologías, valores numéricos del API.
+	class IRenderStateSink
+	{
+	public:
+		virtual ~IRenderStateSink() {}
+
+		virtual void SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset) = 0;
+		virtual void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) = 0;
+		virtual void SetTopology(uint32_t topology) = 0;
+		virtual void SetInputLayout(const void* inputLayout) = 0;
+		virtual void SetVertexShader(const void* shader) = 0;
+		virtual void SetVertexConstantBuffer(uint32_t slot, const void* buffer) = 0;
+		virtual void SetPixelShader(const void* shader) = 0;
+	};
+
+	// Recuerda el estado enlazado y solo pasa al destino las asignaciones que lo cambian. Cualquier código
+	// que toque el contexto sin pasar por aquí debe ir seguido de Invalidate. Las ranuras por encima de
+	// las que se siguen se pasan siempre.
+	class RenderStateCache : public IRenderStateSink
+	{
+	public:
+		static const uint32_t MaxVertexBufferSlots = 4;
+		static const uint32_t MaxConstantBufferSlots = 4;
+
+		explicit RenderStateCache(IRenderStateSink* sink = nullptr);
+
+		void SetSink(IRenderStateSink* sink)		{ m_sink = sink; Invalidate(); }
+
+		// Olvida el estado conocido: la siguiente asignación de cada estado se emite siempre.
+		void Invalidate();
+
+		const RenderStateStats& GetStats() const	{ return m_stats; }
+		void ResetStats();
+
+		virtual void SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset) override;
+		virtual void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) override;
+		virtual void SetTopology(uint32_t topology) override;
+		virtual void SetInputLayout(const void* inputLayout) override;
+		virtual void SetVertexShader(const void* shader) override;
+		virtual void SetVertexConstantBuffer(uint32_t slot, const void* buffer) override;
+		virtual void SetPixelShader(const void* shader) override;
+
+	private:
+		struct VertexBufferState
+		{
+			const void*	buffer;
+			uint32_t	stride;
+			uint32_t	offset;
+			bool		valid;
+		};
+
+		struct IndexBufferState
+		{
+			const void*	buffer;
+			uint32_t	format;
+			uint32_t	offset;
+			bool		valid;
+		};
+
+		struct ObjectState
+		{
+			const void*	object;
+			bool		valid;
+		};
+
+		// Cuenta la llamada y dice si hay que emitirla.
+		bool Count(RenderStateSlot slot, bool changed);
+
+		IRenderStateSink*	m_sink;
+		RenderStateStats	m_stats;
+
+		VertexBufferState	m_vertexBuffers[MaxVertexBufferSlots];
+		IndexBufferState	m_indexBuffer;
+		uint32_t			m_topology;
+		bool				m_topologyValid;
+		ObjectState			m_inputLayout;
+		ObjectState			m_vertexShader;
+		ObjectState			m_constantBuffers[MaxConstantBufferSlots];
+		ObjectState			m_pixelShader;
+	};
+}
@@ -0,0 +1,142 @@
+﻿#include "ResourceRegistry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "MemoryTracker.h"
+
+using namespace DX;
+
+namespace
+{
+	// Las copias se cargan a la etiqueta de memoria de lo que representan.
+	MemoryTag GetShadowTag(ShadowKind kind)
+	{
+		switch (kind)
+		{
+		case ShadowKind::Shader:		return MemoryTag::Shaders;
+		case ShadowKind::Mesh:			return MemoryTag::Meshes;
+		case ShadowKind::Texture:		return MemoryTag::Textures;
+		case ShadowKind::ConstantData:	return MemoryTag::ConstantData;
+		default:						return MemoryTag::General;
+		}
+	}
+}
+
+DX::ResourceRegistry::ResourceRegistry() :
+	m_nextId(1)
+{
+	memset(&m_lastRecovery, 0, sizeof(m_lastRecovery));
+}
+
+DX::ResourceRegistry::~ResourceRegistry()
+{
+	for (const Entry& entry : m_entries)
+	{
+		TrackFree(GetShadowTag(entry.kind), entry.data.size());
+	}
+}
+
+uint32_t DX::ResourceRegistry::Register(const void* owner, ShadowKind kind, ShadowPriority priority, const void* data, size_t size, const RecreateFunction& recreate)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Entry entry;
+	entry.id = m_nextId++;
+	entry.owner = owner;
+	entry.kind = kind;
+	entry.priority = priority;
+	entry.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+	entry.recreate = recreate;
+	TrackAllocation(GetShadowTag(kind), size);
+	m_entries.push_back(std::move(entry));
+
+	const Entry& stored = m_entries.back();
+	stored.recreate(stored.data.data(), stored.data.size());
+	return stored.id;
+}
+
+void DX::ResourceRegistry::UpdateShadow(uint32_t id, const void* data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (Entry& entry : m_entries)
+	{
+		if (entry.id == id)
+		{
+			TrackFree(GetShadowTag(entry.kind), entry.data.size());
+			TrackAllocation(GetShadowTag(entry.kind), size);
+			entry.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+			return;
+		}
+	}
+}
+
+void DX::ResourceRegistry::RemoveOwner(const void* owner)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const Entry& entry : m_entries)
+	{
+		if (entry.owner == owner)
+		{
+			TrackFree(GetShadowTag(entry.kind), entry.data.size());
+		}
+	}
+	m_entries.erase(
+		std::remove_if(m_entries.begin(), m_entries.end(), [owner](const Entry& entry) { return entry.owner == owner; }),
+		m_entries.end());
+}
+
+bool DX::ResourceRegistry::HasOwner(const void* owner) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const Entry& entry : m_entries)
+	{
+		if (entry.owner == owner)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+ShadowRecoveryStats DX::ResourceRegistry::RecreateAll()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	// La ordenación es estable: dentro de una prioridad se respeta el orden de registro, de modo que las
+	// dependencias entre entradas de un mismo representador se mantienen.
+	std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.priority < b.priority; });
+
+	ShadowRecoveryStats stats;
+	memset(&stats, 0, sizeof(stats));
+	for (const Entry& entry : m_entries)
+	{
+		entry.recreate(entry.data.data(), entry.data.size());
+		stats.resources++;
+		stats.bytes += entry.data.size();
+		if (entry.priority == ShadowPriority::Visible)
+		{
+			stats.visibleSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+		}
+	}
+	stats.totalSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	m_lastRecovery = stats;
+	return stats;
+}
+
+uint64_t DX::ResourceRegistry::GetShadowBytes(ShadowKind kind) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t bytes = 0;
+	for (const Entry& entry : m_entries)
+	{
+		if (entry.kind == kind)
+		{
+			bytes += entry.data.size();
+		}
+	}
+	return bytes;
+}
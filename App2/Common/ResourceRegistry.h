@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace DX
+{
+	enum class ShadowKind : uint32_t
+	{
+		Shader,
+		Mesh,
+		Texture,
+		ConstantData,
+		Count
+	};
+
+	// Orden de recreación: lo que se ve en pantalla vuelve primero.
+	enum class ShadowPriority : uint32_t
+	{
+		Visible,
+		Overlay,
+		Background,
+	};
+
+	struct ShadowRecoveryStats
+	{
+		uint32_t	resources;
+		uint64_t	bytes;
+		double		visibleSeconds;		// Hasta terminar la última entrada Visible.
+		double		totalSeconds;
+	};
+
+	// Copias compactas en la CPU de los datos con los que se crearon los recursos de la GPU (código de
+	// sombreadores, vértices, píxeles), cada una con la función que vuelve a crear el recurso a partir de
+	// ella. Al perder el dispositivo, RecreateAll reconstruye todo desde memoria, por prioridad, sin
+	// volver a leer archivos. Register también crea el recurso la primera vez, así que los dos caminos
+	// son el mismo.
+	class ResourceRegistry
+	{
+	public:
+		typedef std::function<void(const uint8_t* data, size_t size)> RecreateFunction;
+
+		ResourceRegistry();
+		~ResourceRegistry();
+
+		// Copia data, llama a recreate con la copia y devuelve el identificador de la entrada. owner agrupa
+		// las entradas de un representador para quitarlas juntas.
+		uint32_t Register(const void* owner, ShadowKind kind, ShadowPriority priority, const void* data, size_t size, const RecreateFunction& recreate);
+
+		// Sustituye la copia de una entrada cuyo contenido cambia (por ejemplo, el atlas de glifos).
+		void UpdateShadow(uint32_t id, const void* data, size_t size);
+
+		// Quita todas las entradas de owner; las funciones dejan de llamarse.
+		void RemoveOwner(const void* owner);
+
+		bool HasOwner(const void* owner) const;
+
+		// Vuelve a crear todos los recursos en orden de prioridad (y de registro dentro de cada una).
+		ShadowRecoveryStats RecreateAll();
+
+		// Bytes de las copias por tipo.
+		uint64_t GetShadowBytes(ShadowKind kind) const;
+		const ShadowRecoveryStats& GetLastRecovery() const	{ return m_lastRecovery; }
+
+	private:
+		struct Entry
+		{
+			uint32_t				id;
+			const void*				owner;
+			ShadowKind				kind;
+			ShadowPriority			priority;
+			std::vector<uint8_t>	data;
+			RecreateFunction		recreate;
+		};
+
+		mutable std::mutex		m_mutex;
+		std::vector<Entry>		m_entries;
+		uint32_t				m_nextId;
+		ShadowRecoveryStats		m_lastRecovery;
+	};
+}
@@ -0,0 +1,332 @@
+﻿#include "StartupGraph.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+
+using namespace DX;
+
+namespace
+{
+	void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+			}
+			fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+DX::StartupTimeline::StartupTimeline() :
+	m_origin(Clock::now())
+{
+}
+
+double DX::StartupTimeline::GetElapsedMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - m_origin).count();
+}
+
+void DX::StartupTimeline::AddInterval(const char* name, uint32_t thread, double startMilliseconds, double endMilliseconds, bool criticalPath)
+{
+	StartupTimelineEntry entry = { name, thread, startMilliseconds, endMilliseconds, criticalPath };
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.push_back(entry);
+}
+
+void DX::StartupTimeline::MarkEvent(const char* name)
+{
+	double now = GetElapsedMilliseconds();
+	AddInterval(name, JobSystem::GetCurrentThreadIndex(), now, now);
+}
+
+double DX::StartupTimeline::GetEventMilliseconds(const char* name) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const StartupTimelineEntry& entry : m_entries)
+	{
+		if (strcmp(entry.name, name) == 0)
+		{
+			return entry.startMilliseconds;
+		}
+	}
+	return -1.0;
+}
+
+std::vector<StartupTimelineEntry> DX::StartupTimeline::GetEntries() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries;
+}
+
+void DX::StartupTimeline::WriteReport(FILE* file) const
+{
+	std::vector<StartupTimelineEntry> entries = GetEntries();
+	std::stable_sort(entries.begin(), entries.end(), [](const StartupTimelineEntry& a, const StartupTimelineEntry& b)
+	{
+		return a.startMilliseconds < b.startMilliseconds;
+	});
+
+	fprintf(file, "  inicio (ms)   fin (ms)   dur. (ms)  subp.  paso\n");
+	for (const StartupTimelineEntry& entry : entries)
+	{
+		fprintf(file, "%c %10.2f %10.2f %10.2f %6u  %s\n",
+			entry.criticalPath ? '*' : ' ',
+			entry.startMilliseconds,
+			entry.endMilliseconds,
+			entry.endMilliseconds - entry.startMilliseconds,
+			entry.thread,
+			entry.name);
+	}
+}
+
+void DX::StartupTimeline::WriteChromeTrace(FILE* file) const
+{
+	std::vector<StartupTimelineEntry> entries = GetEntries();
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const StartupTimelineEntry& entry = entries[i];
+		fprintf(file, "%s{\"name\":", (i == 0) ? "" : ",\n");
+		WriteJsonString(file, entry.name);
+		if (entry.endMilliseconds > entry.startMilliseconds)
+		{
+			fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				entry.criticalPath ? "critico" : "arranque",
+				entry.thread,
+				entry.startMilliseconds * 1000.0,
+				(entry.endMilliseconds - entry.startMilliseconds) * 1000.0);
+		}
+		else
+		{
+			fprintf(file, ",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", entry.thread, entry.startMilliseconds * 1000.0);
+		}
+	}
+	fprintf(file, "\n]}\n");
+}
+
+DX::StartupGraph::StartupGraph() :
+	m_runMilliseconds(0.0),
+	m_criticalPathFirst(true)
+{
+}
+
+StartupTask DX::StartupGraph::AddTask(const char* name, double estimatedMilliseconds, const std::function<void()>& work)
+{
+	Task task;
+	task.name = name;
+	task.estimatedMilliseconds = estimatedMilliseconds;
+	task.work = work;
+	task.dependencyCount = 0;
+	task.priority = 0.0;
+	task.startMilliseconds = 0.0;
+	task.endMilliseconds = 0.0;
+	task.thread = 0;
+	m_tasks.push_back(task);
+	return static_cast<StartupTask>(m_tasks.size() - 1);
+}
+
+void DX::StartupGraph::DependsOn(StartupTask task, StartupTask dependency)
+{
+	m_tasks[dependency].dependents.push_back(task);
+	m_tasks[task].dependencyCount++;
+}
+
+// Orden topológico de Kahn; si no llega a todas las tareas es que hay un ciclo.
+bool DX::StartupGraph::ComputeOrder(std::vector<StartupTask>& order) const
+{
+	std::vector<uint32_t> remaining(m_tasks.size());
+	order.clear();
+	for (size_t i = 0; i < m_tasks.size(); i++)
+	{
+		remaining[i] = m_tasks[i].dependencyCount;
+		if (remaining[i] == 0)
+		{
+			order.push_back(static_cast<StartupTask>(i));
+		}
+	}
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		for (StartupTask dependent : m_tasks[order[i]].dependents)
+		{
+			if (--remaining[dependent] == 0)
+			{
+				order.push_back(dependent);
+			}
+		}
+	}
+	return order.size() == m_tasks.size();
+}
+
+// Camino de mayor duración medida desde una tarea sin dependencias hasta una sin dependientes.
+void DX::StartupGraph::ComputeCriticalPath(const std::vector<StartupTask>& order)
+{
+	std::vector<double> length(m_tasks.size(), 0.0);
+	std::vector<StartupTask> previous(m_tasks.size(), static_cast<StartupTask>(-1));
+	StartupTask last = static_cast<StartupTask>(-1);
+	for (StartupTask task : order)
+	{
+		length[task] += GetTaskMilliseconds(task);
+		if (last == static_cast<StartupTask>(-1) || length[task] > length[last])
+		{
+			last = task;
+		}
+		for (StartupTask dependent : m_tasks[task].dependents)
+		{
+			if (previous[dependent] == static_cast<StartupTask>(-1) || length[task] > length[previous[dependent]])
+			{
+				previous[dependent] = task;
+				length[dependent] = length[task];
+			}
+		}
+	}
+
+	m_criticalPath.clear();
+	for (StartupTask task = last; task != static_cast<StartupTask>(-1); task = previous[task])
+	{
+		m_criticalPath.push_back(task);
+	}
+	std::reverse(m_criticalPath.begin(), m_criticalPath.end());
+}
+
+bool DX::StartupGraph::Run(JobSystem* jobSystem, StartupTimeline* timeline)
+{
+	std::vector<StartupTask> order;
+	if (!ComputeOrder(order))
+	{
+		return false;
+	}
+
+	// Prioridad: duración estimada del camino más largo desde la tarea hasta el final del grafo.
+	for (size_t i = order.size(); i-- > 0;)
+	{
+		Task& task = m_tasks[order[i]];
+		double longest = 0.0;
+		for (StartupTask dependent : task.dependents)
+		{
+			longest = std::max(longest, m_tasks[dependent].priority);
+		}
+		task.priority = m_criticalPathFirst ? task.estimatedMilliseconds + longest : 0.0;
+	}
+
+	std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+	auto now = [timeline, runStart]()
+	{
+		return (timeline != nullptr) ? timeline->GetElapsedMilliseconds() : std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+	};
+	double startMilliseconds = now();
+
+	// Montículo de tareas listas: primero la de mayor prioridad y, a igualdad, la declarada antes.
+	auto lowerPriority = [this](StartupTask a, StartupTask b)
+	{
+		return (m_tasks[a].priority != m_tasks[b].priority) ? m_tasks[a].priority < m_tasks[b].priority : a > b;
+	};
+
+	std::mutex mutex;
+	std::condition_variable readyCondition;
+	std::vector<StartupTask> ready;
+	std::vector<uint32_t> remaining(m_tasks.size());
+	uint32_t finished = 0;
+	std::exception_ptr error;
+	for (size_t i = 0; i < m_tasks.size(); i++)
+	{
+		remaining[i] = m_tasks[i].dependencyCount;
+		if (remaining[i] == 0)
+		{
+			ready.push_back(static_cast<StartupTask>(i));
+		}
+	}
+	std::make_heap(ready.begin(), ready.end(), lowerPriority);
+
+	const uint32_t taskCount = static_cast<uint32_t>(m_tasks.size());
+	auto workerLoop = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			readyCondition.wait(lock, [&]() { return !ready.empty() || finished == taskCount || error != nullptr; });
+			if (finished == taskCount || error != nullptr)
+			{
+				return;
+			}
+
+			std::pop_heap(ready.begin(), ready.end(), lowerPriority);
+			StartupTask current = ready.back();
+			ready.pop_back();
+			lock.unlock();
+
+			Task& task = m_tasks[current];
+			task.thread = JobSystem::GetCurrentThreadIndex();
+			task.startMilliseconds = now();
+			std::exception_ptr taskError;
+			try
+			{
+				task.work();
+			}
+			catch (...)
+			{
+				taskError = std::current_exception();
+			}
+			task.endMilliseconds = now();
+
+			lock.lock();
+			if (taskError != nullptr)
+			{
+				error = taskError;
+			}
+			else
+			{
+				for (StartupTask dependent : task.dependents)
+				{
+					if (--remaining[dependent] == 0)
+					{
+						ready.push_back(dependent);
+						std::push_heap(ready.begin(), ready.end(), lowerPriority);
+					}
+				}
+				finished++;
+			}
+			readyCondition.notify_all();
+		}
+	};
+
+	uint32_t workers = (jobSystem != nullptr) ? jobSystem->GetThreadCount() : 1;
+	if (workers > 1)
+	{
+		jobSystem->ParallelFor(workers, 1, [&workerLoop](uint32_t, uint32_t) { workerLoop(); });
+	}
+	else
+	{
+		workerLoop();
+	}
+	m_runMilliseconds = now() - startMilliseconds;
+
+	if (error != nullptr)
+	{
+		std::rethrow_exception(error);
+	}
+
+	ComputeCriticalPath(order);
+	if (timeline != nullptr)
+	{
+		std::vector<bool> critical(m_tasks.size(), false);
+		for (StartupTask task : m_criticalPath)
+		{
+			critical[task] = true;
+		}
+		for (size_t i = 0; i < m_tasks.size(); i++)
+		{
+			timeline->AddInterval(m_tasks[i].name, m_tasks[i].thread, m_tasks[i].startMilliseconds, m_tasks[i].endMilliseconds, critical[i]);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace DX
+{
+	class JobSystem;
+
+	// Paso del arranque, en milisegundos desde que se creó la línea de tiempo. Los hitos (primer
+	// fotograma, escena completa) tienen la misma marca de inicio y de fin. Los nombres deben ser
+	// cadenas estáticas.
+	struct StartupTimelineEntry
+	{
+		const char*	name;
+		uint32_t	thread;
+		double		startMilliseconds;
+		double		endMilliseconds;
+		bool		criticalPath;
+	};
+
+	// Registro de todo lo que ocurre desde que arranca la aplicación hasta el primer fotograma completo.
+	// Se puede escribir desde cualquier subproceso.
+	class StartupTimeline
+	{
+	public:
+		StartupTimeline();
+
+		double GetElapsedMilliseconds() const;
+
+		void AddInterval(const char* name, uint32_t thread, double startMilliseconds, double endMilliseconds, bool criticalPath = false);
+		void MarkEvent(const char* name);
+
+		// Momento del primer hito con ese nombre, o un valor negativo si aún no ha ocurrido.
+		double GetEventMilliseconds(const char* name) const;
+
+		std::vector<StartupTimelineEntry> GetEntries() const;
+
+		// Tabla de texto ordenada por inicio, con los pasos del camino crítico marcados con '*'.
+		void WriteReport(FILE* file) const;
+
+		// Formato JSON de Chrome Trace Event, como Profiler::WriteChromeTrace.
+		void WriteChromeTrace(FILE* file) const;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		Clock::time_point					m_origin;
+		mutable std::mutex					m_mutex;
+		std::vector<StartupTimelineEntry>	m_entries;
+	};
+
+	typedef uint32_t StartupTask;
+
+	// Tareas de inicialización con sus dependencias. Run las ejecuta en paralelo en el sistema de tareas:
+	// en cuanto una tarea tiene sus dependencias resueltas pasa a la cola de listas, y de ahí sale primero
+	// la que tiene por delante el camino más largo (según las estimaciones), de modo que el camino
+	// crítico nunca espera detrás de trabajo que puede hacerse después.
+	class StartupGraph
+	{
+	public:
+		StartupGraph();
+
+		StartupTask AddTask(const char* name, double estimatedMilliseconds, const std::function<void()>& work);
+		void DependsOn(StartupTask task, StartupTask dependency);
+
+		// Si el grafo tiene un ciclo devuelve false sin ejecutar nada. Si una tarea lanza una excepción no se
+		// empiezan más tareas y la excepción se relanza aquí cuando terminan las que están en curso.
+		// timeline puede ser nulo.
+		bool Run(JobSystem* jobSystem, StartupTimeline* timeline);
+
+		// Sin prioridad por camino crítico las listas salen en orden de declaración; sirve para comparar.
+		void SetCriticalPathFirst(bool enabled)	{ m_criticalPathFirst = enabled; }
+
+		uint32_t GetTaskCount() const			{ return static_cast<uint32_t>(m_tasks.size()); }
+		const char* GetTaskName(StartupTask task) const	{ return m_tasks[task].name; }
+
+		// Después de Run: duración real de cada tarea y del camino crítico medido.
+		double GetTaskMilliseconds(StartupTask task) const	{ return m_tasks[task].endMilliseconds - m_tasks[task].startMilliseconds; }
+		double GetTaskEndMilliseconds(StartupTask task) const	{ return m_tasks[task].endMilliseconds; }
+		const std::vector<StartupTask>& GetCriticalPath() const	{ return m_criticalPath; }
+		double GetRunMilliseconds() const		{ return m_runMilliseconds; }
+
+	private:
+		struct Task
+		{
+			const char*					name;
+			double						estimatedMilliseconds;
+			std::function<void()>		work;
+			std::vector<StartupTask>	dependents;
+			uint32_t					dependencyCount;
+			double						priority;
+			double						startMilliseconds;
+			double						endMilliseconds;
+			uint32_t					thread;
+		};
+
+		bool ComputeOrder(std::vector<StartupTask>& order) const;
+		void ComputeCriticalPath(const std::vector<StartupTask>& order);
+
+		std::vector<Task>			m_tasks;
+		std::vector<StartupTask>	m_criticalPath;
+		double						m_runMilliseconds;
+		bool						m_criticalPathFirst;
+	};
+}
@@ -1,6 +1,14 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <stdexcept>
 #include <wrl.h>
+#else
+#include <chrono>
+#endif
 
 namespace DX
 {
@@ -19,46 +27,39 @@ namespace DX
 			m_isFixedTimeStep(false),
 			m_targetElapsedTicks(TicksPerSecond / 60)
 		{
-			if (!QueryPerformanceFrequency(&m_qpcFrequency))
-			{
-				throw ref new Platform::FailureException();
-			}
-
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw ref new Platform::FailureException();
-			}
+			m_qpcFrequency = QueryFrequency();
+			m_qpcLastTime = QueryCounter();
 
 			// Inicializar delta máximo en una décima parte de un segundo.
-			m_qpcMaxDelta = m_qpcFrequency.QuadPart / 10;
+			m_qpcMaxDelta = m_qpcFrequency / 10;
 		}
 
 		// Obtener el tiempo transcurrido desde la llamada a Update anterior.
-		uint64 GetElapsedTicks() const						{ return m_elapsedTicks; }
+		uint64_t GetElapsedTicks() const					{ return m_elapsedTicks; }
 		double GetElapsedSeconds() const					{ return TicksToSeconds(m_elapsedTicks); }
 
 		// Obtener el tiempo total desde el inicio del programa.
-		uint64 GetTotalTicks() const						{ return m_totalTicks; }
+		uint64_t GetTotalTicks() const						{ return m_totalTicks; }
 		double GetTotalSeconds() const						{ return TicksToSeconds(m_totalTicks); }
 
 		// Obtener el número total de actualizaciones desde el inicio del programa.
-		uint32 GetFrameCount() const						{ return m_frameCount; }
+		uint32_t GetFrameCount() const						{ return m_frameCount; }
 
 		// Obtener el valor de framerate actual.
-		uint32 GetFramesPerSecond() const					{ return m_framesPerSecond; }
+		uint32_t GetFramesPerSecond() const					{ return m_framesPerSecond; }
 
 		// Configurar si se va a usar el modo de timestep fijo o variable.
 		void SetFixedTimeStep(bool isFixedTimestep)			{ m_isFixedTimeStep = isFixedTimestep; }
 
 		// Configurar la frecuencia con la que se llama a Update cuando se usa el modo de timestep fijo.
-		void SetTargetElapsedTicks(uint64 targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
+		void SetTargetElapsedTicks(uint64_t targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
 		void SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
 		// Formato de entero que representa la hora en 10.000.000 pasos por segundo.
-		static const uint64 TicksPerSecond = 10000000;
+		static const uint64_t TicksPerSecond = 10000000;
 
-		static double TicksToSeconds(uint64 ticks)			{ return static_cast<double>(ticks) / TicksPerSecond; }
-		static uint64 SecondsToTicks(double seconds)		{ return static_cast<uint64>(seconds * TicksPerSecond); }
+		static double TicksToSeconds(uint64_t ticks)		{ return static_cast<double>(ticks) / TicksPerSecond; }
+		static uint64_t SecondsToTicks(double seconds)		{ return static_cast<uint64_t>(seconds * TicksPerSecond); }
 
 		// Después de una interrupción temporal intencionada (por ejemplo, una operación de E/S de bloqueo)
 		// se llama para evitar que la lógica de timestep fijo intente una recuperación
@@ -66,10 +67,7 @@ namespace DX
 
 		void ResetElapsedTime()
 		{
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw ref new Platform::FailureException();
-			}
+			m_qpcLastTime = QueryCounter();
 
 			m_leftOverTicks = 0;
 			m_framesPerSecond = 0;
@@ -82,14 +80,9 @@ namespace DX
 		void Tick(const TUpdate& update)
 		{
 			// Consultar la hora actual.
-			LARGE_INTEGER currentTime;
-
-			if (!QueryPerformanceCounter(&currentTime))
-			{
-				throw ref new Platform::FailureException();
-			}
+			uint64_t currentTime = QueryCounter();
 
-			uint64 timeDelta = currentTime.QuadPart - m_qpcLastTime.QuadPart;
+			uint64_t timeDelta = currentTime - m_qpcLastTime;
 
 			m_qpcLastTime = currentTime;
 			m_qpcSecondCounter += timeDelta;
@@ -102,10 +95,33 @@ namespace DX
 
 			// Convertir las unidades QPC en un formato de marca de graduación canónico. Este no puede desbordarse debido al bloqueo anterior.
 			timeDelta *= TicksPerSecond;
-			timeDelta /= m_qpcFrequency.QuadPart;
+			timeDelta /= m_qpcFrequency;
 
-			uint32 lastFrameCount = m_frameCount;
+			uint32_t lastFrameCount = m_frameCount;
+
+			Advance(timeDelta, update);
+
+			// Controlar el valor de framerate actual.
+			if (m_frameCount != lastFrameCount)
+			{
+				m_framesThisSecond++;
+			}
+
+			if (m_qpcSecondCounter >= m_qpcFrequency)
+			{
+				m_framesPerSecond = m_framesThisSecond;
+				m_framesThisSecond = 0;
+				m_qpcSecondCounter %= m_qpcFrequency;
+			}
+		}
 
+		// Avanza el reloj exactamente timeDelta marcas sin consultar el contador de la plataforma. Con timestep
+		// fijo, la secuencia de llamadas a Update depende solo de los avances pedidos, de modo que una
+		// exportación sin ventana reproduce la misma animación en cualquier máquina. No cuenta en
+		// GetFramesPerSecond.
+		template<typename TUpdate>
+		void Advance(uint64_t timeDelta, const TUpdate& update)
+		{
 			if (m_isFixedTimeStep)
 			{
 				// Lógica de actualización de timestep fijo
@@ -117,7 +133,7 @@ namespace DX
 				// acumulando tantos pequeños errores que borraría el marco. Es mejor redondear estas 
 				// pequeñas desviaciones a cero para dejar que todo siga su curso.
 
-				if (abs(static_cast<int64>(timeDelta - m_targetElapsedTicks)) < TicksPerSecond / 4000)
+				if (abs(static_cast<int64_t>(timeDelta - m_targetElapsedTicks)) < static_cast<int64_t>(TicksPerSecond / 4000))
 				{
 					timeDelta = m_targetElapsedTicks;
 				}
@@ -144,40 +160,66 @@ namespace DX
 
 				update();
 			}
+		}
 
-			// Controlar el valor de framerate actual.
-			if (m_frameCount != lastFrameCount)
+	private:
+		// Contador de alta resolución de la plataforma: QPC en Windows y steady_clock en el resto, de modo
+		// que el temporizador también se puede usar (y medir) fuera de la aplicación.
+#if defined(_WIN32)
+		static void ThrowCounterFailure()
+		{
+#if defined(__cplusplus_winrt)
+			throw ref new Platform::FailureException();
+#else
+			throw std::runtime_error("QueryPerformanceCounter");
+#endif
+		}
+
+		static uint64_t QueryFrequency()
+		{
+			LARGE_INTEGER frequency;
+			if (!QueryPerformanceFrequency(&frequency))
 			{
-				m_framesThisSecond++;
+				ThrowCounterFailure();
 			}
+			return frequency.QuadPart;
+		}
 
-			if (m_qpcSecondCounter >= static_cast<uint64>(m_qpcFrequency.QuadPart))
+		static uint64_t QueryCounter()
+		{
+			LARGE_INTEGER counter;
+			if (!QueryPerformanceCounter(&counter))
 			{
-				m_framesPerSecond = m_framesThisSecond;
-				m_framesThisSecond = 0;
-				m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
+				ThrowCounterFailure();
 			}
+			return counter.QuadPart;
 		}
+#else
+		static uint64_t QueryFrequency()				{ return 1000000000; }
+		static uint64_t QueryCounter()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+#endif
 
-	private:
 		// Los datos de tiempo de origen usan unidades QPC.
-		LARGE_INTEGER m_qpcFrequency;
-		LARGE_INTEGER m_qpcLastTime;
-		uint64 m_qpcMaxDelta;
+		uint64_t m_qpcFrequency;
+		uint64_t m_qpcLastTime;
+		uint64_t m_qpcMaxDelta;
 
 		// Los datos de tiempo derivados usan un formato de marca de graduación canónico.
-		uint64 m_elapsedTicks;
-		uint64 m_totalTicks;
-		uint64 m_leftOverTicks;
+		uint64_t m_elapsedTicks;
+		uint64_t m_totalTicks;
+		uint64_t m_leftOverTicks;
 
 		// Miembros para seguimiento del valor de framerate actual.
-		uint32 m_frameCount;
-		uint32 m_framesPerSecond;
-		uint32 m_framesThisSecond;
-		uint64 m_qpcSecondCounter;
+		uint32_t m_frameCount;
+		uint32_t m_framesPerSecond;
+		uint32_t m_framesThisSecond;
+		uint64_t m_qpcSecondCounter;
 
 		// Miembros para configurar el modo fijo de timestep.
 		bool m_isFixedTimeStep;
-		uint64 m_targetElapsedTicks;
+		uint64_t m_targetElapsedTicks;
 	};
 }
@@ -0,0 +1,496 @@
+﻿#include "SubdivisionStencils.h"
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t NoFace = 0xffffffffu;
+
+	// Topología de un nivel: caras en orden, con la arista que va de cada vértice al siguiente.
+	struct Topology
+	{
+		uint32_t				vertexCount;
+		std::vector<uint32_t>	faceSizes;
+		std::vector<uint32_t>	faceOffsets;
+		std::vector<uint32_t>	indices;
+		std::vector<uint32_t>	faceEdges;
+	};
+
+	struct Edge
+	{
+		uint32_t	v0;
+		uint32_t	v1;
+		uint32_t	face0;
+		uint32_t	face1;		// NoFace en las aristas de borde.
+	};
+
+	// Aristas, y aristas y caras que llegan a cada vértice (listas compactas por vértice).
+	struct Adjacency
+	{
+		std::vector<Edge>		edges;
+		std::vector<uint32_t>	vertexEdgeOffsets;
+		std::vector<uint32_t>	vertexEdges;
+		std::vector<uint32_t>	vertexFaceOffsets;
+		std::vector<uint32_t>	vertexFaces;
+	};
+
+	typedef std::vector<std::pair<uint32_t, float>> Terms;
+
+	void BuildAdjacency(Topology& topology, Adjacency& adjacency)
+	{
+		uint32_t faceCount = static_cast<uint32_t>(topology.faceSizes.size());
+		std::unordered_map<uint64_t, uint32_t> edgeMap;
+		edgeMap.reserve(topology.indices.size());
+		topology.faceEdges.resize(topology.indices.size());
+		adjacency.edges.clear();
+
+		for (uint32_t f = 0; f < faceCount; f++)
+		{
+			uint32_t size = topology.faceSizes[f];
+			uint32_t offset = topology.faceOffsets[f];
+			for (uint32_t i = 0; i < size; i++)
+			{
+				uint32_t a = topology.indices[offset + i];
+				uint32_t b = topology.indices[offset + (i + 1) % size];
+				uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+				auto found = edgeMap.find(key);
+				if (found == edgeMap.end())
+				{
+					Edge edge = { a, b, f, NoFace };
+					edgeMap.emplace(key, static_cast<uint32_t>(adjacency.edges.size()));
+					topology.faceEdges[offset + i] = static_cast<uint32_t>(adjacency.edges.size());
+					adjacency.edges.push_back(edge);
+				}
+				else
+				{
+					Edge& edge = adjacency.edges[found->second];
+					if (edge.face1 != NoFace)
+					{
+						throw std::invalid_argument("La malla de control no es una variedad: una arista tiene más de dos caras");
+					}
+					edge.face1 = f;
+					topology.faceEdges[offset + i] = found->second;
+				}
+			}
+		}
+
+		// Listas compactas: primero se cuentan y luego se rellenan.
+		uint32_t vertexCount = topology.vertexCount;
+		adjacency.vertexEdgeOffsets.assign(vertexCount + 1, 0);
+		adjacency.vertexFaceOffsets.assign(vertexCount + 1, 0);
+		for (const Edge& edge : adjacency.edges)
+		{
+			adjacency.vertexEdgeOffsets[edge.v0 + 1]++;
+			adjacency.vertexEdgeOffsets[edge.v1 + 1]++;
+		}
+		for (uint32_t index : topology.indices)
+		{
+			adjacency.vertexFaceOffsets[index + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			adjacency.vertexEdgeOffsets[v + 1] += adjacency.vertexEdgeOffsets[v];
+			adjacency.vertexFaceOffsets[v + 1] += adjacency.vertexFaceOffsets[v];
+		}
+
+		std::vector<uint32_t> edgeCursor(adjacency.vertexEdgeOffsets.begin(), adjacency.vertexEdgeOffsets.end() - 1);
+		std::vector<uint32_t> faceCursor(adjacency.vertexFaceOffsets.begin(), adjacency.vertexFaceOffsets.end() - 1);
+		adjacency.vertexEdges.resize(adjacency.vertexEdgeOffsets[vertexCount]);
+		adjacency.vertexFaces.resize(adjacency.vertexFaceOffsets[vertexCount]);
+		for (uint32_t e = 0; e < adjacency.edges.size(); e++)
+		{
+			adjacency.vertexEdges[edgeCursor[adjacency.edges[e].v0]++] = e;
+			adjacency.vertexEdges[edgeCursor[adjacency.edges[e].v1]++] = e;
+		}
+		for (uint32_t f = 0; f < faceCount; f++)
+		{
+			for (uint32_t i = 0; i < topology.faceSizes[f]; i++)
+			{
+				uint32_t index = topology.indices[topology.faceOffsets[f] + i];
+				adjacency.vertexFaces[faceCursor[index]++] = f;
+			}
+		}
+	}
+
+	void AddFacePoint(const Topology& topology, uint32_t face, float weight, Terms& terms)
+	{
+		uint32_t size = topology.faceSizes[face];
+		for (uint32_t i = 0; i < size; i++)
+		{
+			terms.push_back(std::make_pair(topology.indices[topology.faceOffsets[face] + i], weight / size));
+		}
+	}
+
+	// Regla de pliegue de un vértice con aristas de borde: 6/8 del vértice y 1/8 de cada vecino de borde.
+	// Devuelve false si el vértice no está en el borde. Las esquinas (más de dos aristas de borde) no se mueven.
+	bool AddBoundaryVertex(const Adjacency& adjacency, uint32_t v, Terms& terms)
+	{
+		uint32_t neighbours[2];
+		uint32_t boundaryEdges = 0;
+		for (uint32_t i = adjacency.vertexEdgeOffsets[v]; i < adjacency.vertexEdgeOffsets[v + 1]; i++)
+		{
+			const Edge& edge = adjacency.edges[adjacency.vertexEdges[i]];
+			if (edge.face1 == NoFace)
+			{
+				if (boundaryEdges < 2)
+				{
+					neighbours[boundaryEdges] = (edge.v0 == v) ? edge.v1 : edge.v0;
+				}
+				boundaryEdges++;
+			}
+		}
+
+		if (boundaryEdges == 0)
+		{
+			return false;
+		}
+		if (boundaryEdges == 2)
+		{
+			terms.push_back(std::make_pair(v, 0.75f));
+			terms.push_back(std::make_pair(neighbours[0], 0.125f));
+			terms.push_back(std::make_pair(neighbours[1], 0.125f));
+		}
+		else
+		{
+			terms.push_back(std::make_pair(v, 1.0f));
+		}
+		return true;
+	}
+
+	// Catmull-Clark: v' = ((n - 3) v + media de los puntos de cara + 2 media de los puntos medios) / n.
+	void GetCatmullClarkVertex(const Topology& topology, const Adjacency& adjacency, uint32_t v, Terms& terms)
+	{
+		if (AddBoundaryVertex(adjacency, v, terms))
+		{
+			return;
+		}
+
+		uint32_t valence = adjacency.vertexEdgeOffsets[v + 1] - adjacency.vertexEdgeOffsets[v];
+		float n = static_cast<float>(valence);
+		float n2 = n * n;
+		terms.push_back(std::make_pair(v, (n - 3.0f) / n + 1.0f / n));
+		for (uint32_t i = adjacency.vertexFaceOffsets[v]; i < adjacency.vertexFaceOffsets[v + 1]; i++)
+		{
+			AddFacePoint(topology, adjacency.vertexFaces[i], 1.0f / n2, terms);
+		}
+		for (uint32_t i = adjacency.vertexEdgeOffsets[v]; i < adjacency.vertexEdgeOffsets[v + 1]; i++)
+		{
+			const Edge& edge = adjacency.edges[adjacency.vertexEdges[i]];
+			terms.push_back(std::make_pair((edge.v0 == v) ? edge.v1 : edge.v0, 1.0f / n2));
+		}
+	}
+
+	// Catmull-Clark: media de los extremos y de los puntos de las dos caras.
+	void GetCatmullClarkEdge(const Topology& topology, const Edge& edge, Terms& terms)
+	{
+		if (edge.face1 == NoFace)
+		{
+			terms.push_back(std::make_pair(edge.v0, 0.5f));
+			terms.push_back(std::make_pair(edge.v1, 0.5f));
+			return;
+		}
+
+		terms.push_back(std::make_pair(edge.v0, 0.25f));
+		terms.push_back(std::make_pair(edge.v1, 0.25f));
+		AddFacePoint(topology, edge.face0, 0.25f, terms);
+		AddFacePoint(topology, edge.face1, 0.25f, terms);
+	}
+
+	// Loop: (1 - n beta) v + beta por vecino, con beta = 3/16 si n = 3 y 3 / (8 n) en otro caso.
+	void GetLoopVertex(const Adjacency& adjacency, uint32_t v, Terms& terms)
+	{
+		if (AddBoundaryVertex(adjacency, v, terms))
+		{
+			return;
+		}
+
+		uint32_t valence = adjacency.vertexEdgeOffsets[v + 1] - adjacency.vertexEdgeOffsets[v];
+		float beta = (valence == 3) ? 3.0f / 16.0f : 3.0f / (8.0f * valence);
+		terms.push_back(std::make_pair(v, 1.0f - valence * beta));
+		for (uint32_t i = adjacency.vertexEdgeOffsets[v]; i < adjacency.vertexEdgeOffsets[v + 1]; i++)
+		{
+			const Edge& edge = adjacency.edges[adjacency.vertexEdges[i]];
+			terms.push_back(std::make_pair((edge.v0 == v) ? edge.v1 : edge.v0, beta));
+		}
+	}
+
+	uint32_t GetOppositeVertex(const Topology& topology, uint32_t face, const Edge& edge)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			uint32_t index = topology.indices[topology.faceOffsets[face] + i];
+			if (index != edge.v0 && index != edge.v1)
+			{
+				return index;
+			}
+		}
+		return edge.v0;
+	}
+
+	// Loop: 3/8 de cada extremo y 1/8 de cada vértice opuesto.
+	void GetLoopEdge(const Topology& topology, const Edge& edge, Terms& terms)
+	{
+		if (edge.face1 == NoFace)
+		{
+			terms.push_back(std::make_pair(edge.v0, 0.5f));
+			terms.push_back(std::make_pair(edge.v1, 0.5f));
+			return;
+		}
+
+		terms.push_back(std::make_pair(edge.v0, 0.375f));
+		terms.push_back(std::make_pair(edge.v1, 0.375f));
+		terms.push_back(std::make_pair(GetOppositeVertex(topology, edge.face0, edge), 0.125f));
+		terms.push_back(std::make_pair(GetOppositeVertex(topology, edge.face1, edge), 0.125f));
+	}
+
+	void AddFace(Topology& topology, uint32_t a, uint32_t b, uint32_t c)
+	{
+		topology.faceSizes.push_back(3);
+		topology.faceOffsets.push_back(static_cast<uint32_t>(topology.indices.size()));
+		uint32_t face[3] = { a, b, c };
+		topology.indices.insert(topology.indices.end(), face, face + 3);
+	}
+
+	void AddFace(Topology& topology, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+	{
+		topology.faceSizes.push_back(4);
+		topology.faceOffsets.push_back(static_cast<uint32_t>(topology.indices.size()));
+		uint32_t face[4] = { a, b, c, d };
+		topology.indices.insert(topology.indices.end(), face, face + 4);
+	}
+
+	// Abanico desde el primer vértice de cada cara; conserva el sentido de giro.
+	template<typename TVector>
+	void Triangulate(const Topology& topology, TVector& triangles)
+	{
+		for (uint32_t f = 0; f < topology.faceSizes.size(); f++)
+		{
+			uint32_t offset = topology.faceOffsets[f];
+			for (uint32_t i = 1; i + 1 < topology.faceSizes[f]; i++)
+			{
+				uint32_t triangle[3] = { topology.indices[offset], topology.indices[offset + i], topology.indices[offset + i + 1] };
+				triangles.insert(triangles.end(), triangle, triangle + 3);
+			}
+		}
+	}
+}
+
+SubdivisionStencils::SubdivisionStencils(SubdivisionScheme scheme, const SubdivisionCage& cage, uint32_t maxLevel) :
+	m_buildMilliseconds(0.0)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	Topology topology;
+	topology.vertexCount = cage.vertexCount;
+	topology.faceSizes = cage.faceSizes;
+	topology.indices = cage.faceIndices;
+	uint32_t offset = 0;
+	for (uint32_t size : cage.faceSizes)
+	{
+		if (size < 3 || (scheme == SubdivisionScheme::Loop && size != 3))
+		{
+			throw std::invalid_argument("Cara no válida para el esquema de subdivisión");
+		}
+		topology.faceOffsets.push_back(offset);
+		offset += size;
+	}
+	if (offset != cage.faceIndices.size())
+	{
+		throw std::invalid_argument("faceIndices no coincide con faceSizes");
+	}
+	for (uint32_t index : cage.faceIndices)
+	{
+		if (index >= cage.vertexCount)
+		{
+			throw std::invalid_argument("Índice de vértice fuera de la malla de control");
+		}
+	}
+
+	// Nivel 0: cada vértice es él mismo.
+	m_levels.resize(maxLevel + 1);
+	Level& base = m_levels[0];
+	base.vertexCount = cage.vertexCount;
+	for (uint32_t v = 0; v < cage.vertexCount; v++)
+	{
+		base.offsets.push_back(v);
+		base.sources.push_back(v);
+		base.weights.push_back(1.0f);
+	}
+	base.offsets.push_back(cage.vertexCount);
+	Triangulate(topology, base.triangles);
+
+	// Cada nivel se calcula con reglas locales sobre el anterior y se compone con las plantillas de este,
+	// de modo que las tablas siempre se refieren a la malla de control.
+	Adjacency adjacency;
+	Terms terms;
+	std::vector<float> accumulator(cage.vertexCount, 0.0f);
+	std::vector<uint32_t> touched;
+	for (uint32_t levelIndex = 1; levelIndex <= maxLevel; levelIndex++)
+	{
+		BuildAdjacency(topology, adjacency);
+		const Level& previous = m_levels[levelIndex - 1];
+		Level& level = m_levels[levelIndex];
+		uint32_t vertexCount = topology.vertexCount;
+		uint32_t edgeCount = static_cast<uint32_t>(adjacency.edges.size());
+		uint32_t faceCount = static_cast<uint32_t>(topology.faceSizes.size());
+		level.vertexCount = vertexCount + edgeCount + ((scheme == SubdivisionScheme::CatmullClark) ? faceCount : 0);
+		level.offsets.reserve(level.vertexCount + 1);
+
+		// Vértices nuevos: primero los de los vértices, luego los de las aristas y (Catmull-Clark) los de las caras.
+		for (uint32_t v = 0; v < level.vertexCount; v++)
+		{
+			terms.clear();
+			if (v < vertexCount)
+			{
+				if (scheme == SubdivisionScheme::CatmullClark)
+				{
+					GetCatmullClarkVertex(topology, adjacency, v, terms);
+				}
+				else
+				{
+					GetLoopVertex(adjacency, v, terms);
+				}
+			}
+			else if (v < vertexCount + edgeCount)
+			{
+				const Edge& edge = adjacency.edges[v - vertexCount];
+				if (scheme == SubdivisionScheme::CatmullClark)
+				{
+					GetCatmullClarkEdge(topology, edge, terms);
+				}
+				else
+				{
+					GetLoopEdge(topology, edge, terms);
+				}
+			}
+			else
+			{
+				AddFacePoint(topology, v - vertexCount - edgeCount, 1.0f, terms);
+			}
+
+			for (const auto& term : terms)
+			{
+				for (uint32_t i = previous.offsets[term.first]; i < previous.offsets[term.first + 1]; i++)
+				{
+					uint32_t source = previous.sources[i];
+					if (accumulator[source] == 0.0f)
+					{
+						touched.push_back(source);
+					}
+					accumulator[source] += term.second * previous.weights[i];
+				}
+			}
+
+			// En orden de fuente, para que Apply lea la malla de control hacia delante.
+			std::sort(touched.begin(), touched.end());
+			level.offsets.push_back(static_cast<uint32_t>(level.sources.size()));
+			for (uint32_t source : touched)
+			{
+				level.sources.push_back(source);
+				level.weights.push_back(accumulator[source]);
+				accumulator[source] = 0.0f;
+			}
+			touched.clear();
+		}
+		level.offsets.push_back(static_cast<uint32_t>(level.sources.size()));
+
+		// Caras del nivel nuevo, en el mismo sentido de giro que su cara de origen.
+		Topology refined;
+		refined.vertexCount = level.vertexCount;
+		for (uint32_t f = 0; f < faceCount; f++)
+		{
+			uint32_t size = topology.faceSizes[f];
+			uint32_t faceOffset = topology.faceOffsets[f];
+			if (scheme == SubdivisionScheme::CatmullClark)
+			{
+				uint32_t facePoint = vertexCount + edgeCount + f;
+				for (uint32_t i = 0; i < size; i++)
+				{
+					uint32_t next = vertexCount + topology.faceEdges[faceOffset + i];
+					uint32_t previousEdge = vertexCount + topology.faceEdges[faceOffset + (i + size - 1) % size];
+					AddFace(refined, topology.indices[faceOffset + i], next, facePoint, previousEdge);
+				}
+			}
+			else
+			{
+				uint32_t a = topology.indices[faceOffset], b = topology.indices[faceOffset + 1], c = topology.indices[faceOffset + 2];
+				uint32_t ab = vertexCount + topology.faceEdges[faceOffset];
+				uint32_t bc = vertexCount + topology.faceEdges[faceOffset + 1];
+				uint32_t ca = vertexCount + topology.faceEdges[faceOffset + 2];
+				AddFace(refined, a, ab, ca);
+				AddFace(refined, b, bc, ab);
+				AddFace(refined, c, ca, bc);
+				AddFace(refined, ab, bc, ca);
+			}
+		}
+		Triangulate(refined, level.triangles);
+		topology = std::move(refined);
+	}
+
+	m_buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SubdivisionStencils::Apply(JobSystem* jobSystem, uint32_t level, const float* cage, uint32_t floatsPerVertex, float* out) const
+{
+	if (floatsPerVertex == 0 || floatsPerVertex % 4 != 0)
+	{
+		throw std::invalid_argument("floatsPerVertex debe ser múltiplo de 4");
+	}
+
+	const Level& table = m_levels[level];
+	jobSystem->ParallelFor(table.vertexCount, 256, [&table, cage, floatsPerVertex, out](uint32_t begin, uint32_t end)
+	{
+		const uint32_t* offsets = table.offsets.data();
+		const uint32_t* sources = table.sources.data();
+		const float* weights = table.weights.data();
+		for (uint32_t v = begin; v < end; v++)
+		{
+			float* target = out + static_cast<size_t>(v) * floatsPerVertex;
+			if (floatsPerVertex == 8)
+			{
+				// Caso de los vértices de la escena: dos bloques por vértice, cada peso se lee una vez.
+				SimdFloat4 low = SimdFloat4::Splat(0.0f);
+				SimdFloat4 high = low;
+				for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+				{
+					const float* source = cage + static_cast<size_t>(sources[i]) * 8;
+					SimdFloat4 weight = SimdFloat4::Splat(weights[i]);
+					low = low + weight * SimdFloat4::Load(source);
+					high = high + weight * SimdFloat4::Load(source + 4);
+				}
+				low.Store(target);
+				high.Store(target + 4);
+				continue;
+			}
+
+			for (uint32_t block = 0; block < floatsPerVertex; block += 4)
+			{
+				SimdFloat4 sum = SimdFloat4::Splat(0.0f);
+				for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+				{
+					sum = sum + SimdFloat4::Splat(weights[i]) * SimdFloat4::Load(cage + static_cast<size_t>(sources[i]) * floatsPerVertex + block);
+				}
+				sum.Store(target + block);
+			}
+		}
+	});
+}
+
+uint32_t SubdivisionStencils::SelectLevel(float cageEdgePixels, float targetEdgePixels) const
+{
+	uint32_t level = 0;
+	while (level + 1 < m_levels.size() && cageEdgePixels > targetEdgePixels)
+	{
+		cageEdgePixels *= 0.5f;
+		level++;
+	}
+	return level;
+}
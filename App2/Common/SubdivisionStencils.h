@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+namespace DX
+{
+	enum class SubdivisionScheme
+	{
+		CatmullClark,	// Caras de cualquier tamaño; desde el primer nivel todas son cuadriláteros.
+		Loop,			// Solo triángulos.
+	};
+
+	// Malla de control: faceSizes[f] vértices por cara, seguidos en faceIndices, en el orden de las agujas
+	// del reloj visto desde fuera (como el resto de la escena).
+	struct SubdivisionCage
+	{
+		uint32_t				vertexCount;
+		std::vector<uint32_t>	faceSizes;
+		std::vector<uint32_t>	faceIndices;
+	};
+
+	// Tablas de plantillas (stencils) de una superficie de subdivisión. Cada vértice refinado de cada nivel
+	// es una suma ponderada de vértices de la malla de control, así que la topología se recorre una sola vez
+	// al construir y cada fotograma basta con aplicar la tabla del nivel elegido a los vértices animados.
+	// Las aristas de borde siguen la regla de pliegue (punto medio y 1/8, 6/8, 1/8 en los vértices).
+	class SubdivisionStencils
+	{
+	public:
+		// Lanza std::invalid_argument si la malla no es una variedad o si Loop recibe caras que no son
+		// triángulos. El nivel 0 es la propia malla de control.
+		SubdivisionStencils(SubdivisionScheme scheme, const SubdivisionCage& cage, uint32_t maxLevel);
+
+		uint32_t GetLevelCount() const								{ return static_cast<uint32_t>(m_levels.size()); }
+		uint32_t GetCageVertexCount() const							{ return m_levels[0].vertexCount; }
+		uint32_t GetVertexCount(uint32_t level) const				{ return m_levels[level].vertexCount; }
+		double GetBuildMilliseconds() const							{ return m_buildMilliseconds; }
+
+		// Triángulos del nivel, índices a sus vértices refinados.
+		const TaggedVector<uint32_t, MemoryTag::Meshes>& GetTriangles(uint32_t level) const	{ return m_levels[level].triangles; }
+
+		// Plantilla del vértice i: offsets[i]..offsets[i + 1] en sources y weights.
+		const TaggedVector<uint32_t, MemoryTag::Meshes>& GetOffsets(uint32_t level) const	{ return m_levels[level].offsets; }
+		const TaggedVector<uint32_t, MemoryTag::Meshes>& GetSources(uint32_t level) const	{ return m_levels[level].sources; }
+		const TaggedVector<float, MemoryTag::Meshes>& GetWeights(uint32_t level) const		{ return m_levels[level].weights; }
+
+		// out[i] = suma de weight * cage[source] para cada vértice del nivel. Los vértices tienen
+		// floatsPerVertex flotantes (múltiplo de 4: posición, color, relleno...) y se combinan de cuatro en
+		// cuatro con SimdFloat4; los vértices refinados se reparten entre los subprocesos.
+		void Apply(JobSystem* jobSystem, uint32_t level, const float* cage, uint32_t floatsPerVertex, float* out) const;
+
+		// Cada nivel divide las aristas por dos: el menor nivel en el que una arista de la malla de control
+		// que ocupa cageEdgePixels en pantalla queda en targetEdgePixels o menos.
+		uint32_t SelectLevel(float cageEdgePixels, float targetEdgePixels) const;
+
+	private:
+		struct Level
+		{
+			uint32_t	vertexCount;
+			TaggedVector<uint32_t, MemoryTag::Meshes>	offsets;
+			TaggedVector<uint32_t, MemoryTag::Meshes>	sources;
+			TaggedVector<float, MemoryTag::Meshes>		weights;
+			TaggedVector<uint32_t, MemoryTag::Meshes>	triangles;
+		};
+
+		std::vector<Level>	m_levels;
+		double				m_buildMilliseconds;
+	};
+}
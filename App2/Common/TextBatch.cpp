@@ -0,0 +1,53 @@
+﻿#include "TextBatch.h"
+
+using namespace DX;
+
+void DX::TextBatch::AddLayout(const TextLayout& layout, float x, float y, uint32_t color)
+{
+	size_t first = m_vertices.size();
+	m_vertices.resize(first + layout.glyphs.size() * 4);
+
+	TextVertex* vertex = m_vertices.data() + first;
+	for (const TextLayoutGlyph& glyph : layout.glyphs)
+	{
+		float left = x + glyph.x;
+		float top = y + glyph.y;
+		float right = left + glyph.width;
+		float bottom = top + glyph.height;
+		vertex[0] = { left, top, glyph.u0, glyph.v0, color };
+		vertex[1] = { right, top, glyph.u1, glyph.v0, color };
+		vertex[2] = { left, bottom, glyph.u0, glyph.v1, color };
+		vertex[3] = { right, bottom, glyph.u1, glyph.v1, color };
+		vertex += 4;
+	}
+}
+
+void DX::TextBatch::AddText(TextLayoutCache& cache, const char* text, const TextFormat& format, float x, float y, uint32_t color)
+{
+	const TextLayout& layout = cache.GetLayout(text, format);
+	if (format.alignment == TextAlignment::Center)
+	{
+		x -= layout.width * 0.5f;
+	}
+	else if (format.alignment == TextAlignment::Trailing)
+	{
+		x -= layout.width;
+	}
+	AddLayout(layout, x, y, color);
+}
+
+void DX::TextBatch::BuildQuadIndices(uint32_t quadCount, std::vector<uint32_t>& indices)
+{
+	indices.resize(static_cast<size_t>(quadCount) * 6);
+	for (uint32_t q = 0; q < quadCount; q++)
+	{
+		uint32_t v = q * 4;
+		uint32_t* index = &indices[static_cast<size_t>(q) * 6];
+		index[0] = v;
+		index[1] = v + 1;
+		index[2] = v + 2;
+		index[3] = v + 2;
+		index[4] = v + 1;
+		index[5] = v + 3;
+	}
+}
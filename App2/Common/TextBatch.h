@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TextLayoutCache.h"
+#include "VertexFormat.h"
+
+namespace DX
+{
+	// Vértice de texto superpuesto en píxeles de pantalla. El color es RGBA8 con el rojo en el byte bajo.
+	struct TextVertex
+	{
+		float		x, y;
+		float		u, v;
+		uint32_t	color;
+	};
+
+	template<>
+	struct VertexLayoutOf<TextVertex> : VertexLayout<TextVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[2], offsetof(TextVertex, x)>,
+		VertexAttribute<VertexSemantic::TexCoord, 0, float[2], offsetof(TextVertex, u)>,
+		VertexAttribute<VertexSemantic::Color, 0, uint32_t, offsetof(TextVertex, color)>>
+	{
+	};
+
+	// Acumula los cuadrados de todo el texto de un fotograma en un único búfer de vértices, para
+	// dibujarlo con una sola llamada. La memoria se conserva entre fotogramas.
+	class TextBatch
+	{
+	public:
+		void Clear()								{ m_vertices.clear(); }
+
+		void AddLayout(const TextLayout& layout, float x, float y, uint32_t color);
+
+		// Maqueta (o reutiliza de la caché) el texto y lo añade. (x, y) es la esquina del texto
+		// según la alineación: izquierda, centro o derecha.
+		void AddText(TextLayoutCache& cache, const char* text, const TextFormat& format, float x, float y, uint32_t color);
+
+		const TextVertex* GetVertices() const		{ return m_vertices.data(); }
+		uint32_t GetVertexCount() const				{ return static_cast<uint32_t>(m_vertices.size()); }
+		uint32_t GetQuadCount() const				{ return static_cast<uint32_t>(m_vertices.size() / 4); }
+
+		// Índices de dos triángulos por cuadrado, compartidos por todos los lotes.
+		static void BuildQuadIndices(uint32_t quadCount, std::vector<uint32_t>& indices);
+
+	private:
+		TaggedVector<TextVertex, MemoryTag::Text>	m_vertices;
+	};
+}
@@ -0,0 +1,298 @@
+﻿#include "TextLayoutCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t EmptySlot = 0xffffffff;
+
+	uint64_t HashText(const char* text, size_t length, const TextFormat& format)
+	{
+		// FNV-1a sobre el texto y los campos del formato.
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ static_cast<uint8_t>(text[i])) * 1099511628211ull;
+		}
+
+		uint32_t widthBits;
+		memcpy(&widthBits, &format.maxWidth, sizeof(widthBits));
+		hash = (hash ^ format.pixelSize) * 1099511628211ull;
+		hash = (hash ^ widthBits) * 1099511628211ull;
+		hash = (hash ^ static_cast<uint32_t>(format.alignment)) * 1099511628211ull;
+		return hash;
+	}
+
+	bool SameFormat(const TextFormat& a, const TextFormat& b)
+	{
+		return a.pixelSize == b.pixelSize && a.maxWidth == b.maxWidth && a.alignment == b.alignment;
+	}
+
+	// Decodifica un punto de código UTF-8 y avanza el puntero. Las secuencias no válidas devuelven '?'.
+	uint32_t DecodeUtf8(const char*& text, const char* end)
+	{
+		uint8_t lead = static_cast<uint8_t>(*text++);
+		if (lead < 0x80)
+		{
+			return lead;
+		}
+
+		uint32_t extra = (lead >= 0xf0) ? 3 : (lead >= 0xe0) ? 2 : (lead >= 0xc0) ? 1 : 0;
+		if (extra == 0 || static_cast<uint32_t>(end - text) < extra)
+		{
+			return '?';
+		}
+
+		uint32_t codepoint = lead & (0x3f >> extra);
+		for (uint32_t i = 0; i < extra; i++)
+		{
+			codepoint = (codepoint << 6) | (static_cast<uint8_t>(*text++) & 0x3f);
+		}
+		return codepoint;
+	}
+}
+
+DX::TextLayoutCache::TextLayoutCache(GlyphAtlas* atlas, uint32_t capacity) :
+	m_atlas(atlas),
+	m_capacity(capacity),
+	m_liveCount(0),
+	m_frame(0),
+	m_hits(0),
+	m_misses(0)
+{
+	uint32_t slotCount = 16;
+	while (slotCount < capacity * 2)
+	{
+		slotCount *= 2;
+	}
+	m_slots.assign(slotCount, EmptySlot);
+	m_entries.reserve(capacity);
+}
+
+uint32_t DX::TextLayoutCache::FindSlot(uint64_t hash, const char* text, size_t length, const TextFormat& format) const
+{
+	uint32_t mask = static_cast<uint32_t>(m_slots.size() - 1);
+	uint32_t slot = static_cast<uint32_t>(hash) & mask;
+	while (m_slots[slot] != EmptySlot)
+	{
+		const Entry& entry = m_entries[m_slots[slot]];
+		if (entry.hash == hash && entry.text.size() == length && SameFormat(entry.format, format) && memcmp(entry.text.data(), text, length) == 0)
+		{
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+void DX::TextLayoutCache::RebuildSlots(uint32_t slotCount)
+{
+	m_slots.assign(slotCount, EmptySlot);
+	uint32_t mask = slotCount - 1;
+	for (uint32_t i = 0; i < m_entries.size(); i++)
+	{
+		if (m_entries[i].live)
+		{
+			uint32_t slot = static_cast<uint32_t>(m_entries[i].hash) & mask;
+			while (m_slots[slot] != EmptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			m_slots[slot] = i;
+		}
+	}
+}
+
+const TextLayout& DX::TextLayoutCache::GetLayout(const char* text, const TextFormat& format)
+{
+	size_t length = strlen(text);
+	uint64_t hash = HashText(text, length, format);
+	uint32_t slot = FindSlot(hash, text, length, format);
+
+	if (m_slots[slot] != EmptySlot)
+	{
+		Entry& entry = m_entries[m_slots[slot]];
+		if (entry.atlasGeneration != m_atlas->GetGeneration())
+		{
+			BuildLayout(entry);
+		}
+		entry.lastUsedFrame = m_frame;
+		m_hits++;
+		return entry.layout;
+	}
+
+	m_misses++;
+
+	// La tabla se mantiene como mucho medio llena para que el sondeo sea corto.
+	if ((m_liveCount + 1) * 2 > m_slots.size())
+	{
+		RebuildSlots(static_cast<uint32_t>(m_slots.size() * 2));
+		slot = FindSlot(hash, text, length, format);
+	}
+
+	uint32_t index;
+	if (!m_freeEntries.empty())
+	{
+		index = m_freeEntries.back();
+		m_freeEntries.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_entries.size());
+		m_entries.push_back(Entry());
+	}
+
+	Entry& entry = m_entries[index];
+	entry.hash = hash;
+	entry.text.assign(text, length);
+	entry.format = format;
+	entry.lastUsedFrame = m_frame;
+	entry.live = true;
+	BuildLayout(entry);
+
+	m_slots[slot] = index;
+	m_liveCount++;
+	return entry.layout;
+}
+
+void DX::TextLayoutCache::NextFrame()
+{
+	if (m_liveCount > m_capacity)
+	{
+		for (uint32_t i = 0; i < m_entries.size(); i++)
+		{
+			Entry& entry = m_entries[i];
+			if (entry.live && entry.lastUsedFrame < m_frame)
+			{
+				entry.live = false;
+				m_freeEntries.push_back(i);
+				m_liveCount--;
+			}
+		}
+		RebuildSlots(static_cast<uint32_t>(m_slots.size()));
+	}
+
+	m_frame++;
+}
+
+// Coloca los glifos línea a línea, con ajuste en los espacios si hay ancho máximo, y aplica la alineación.
+void DX::TextLayoutCache::BuildLayout(Entry& entry)
+{
+	const TextFormat& format = entry.format;
+	TextLayout& layout = entry.layout;
+
+	// Si el atlas se vacía a mitad de la maquetación, los glifos ya colocados tienen coordenadas
+	// de textura obsoletas; se repite una vez con el atlas ya vacío.
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		uint32_t generation = m_atlas->GetGeneration();
+		float lineHeight = m_atlas->GetFontMetrics(format.pixelSize).lineHeight;
+
+		layout.glyphs.clear();
+		m_lines.clear();
+
+		float penX = 0.0f;
+		float penY = 0.0f;
+		uint32_t lineStart = 0;
+		uint32_t breakGlyph = 0;		// Primer glifo después del último espacio de la línea.
+		float breakX = 0.0f;			// Posición del lápiz después de ese espacio.
+		float breakWidth = 0.0f;		// Ancho de la línea antes de ese espacio.
+		bool hasBreak = false;
+
+		const char* cursor = entry.text.c_str();
+		const char* end = cursor + entry.text.size();
+		while (cursor < end)
+		{
+			uint32_t codepoint = DecodeUtf8(cursor, end);
+			if (codepoint == '\n')
+			{
+				m_lines.push_back({ lineStart, penX });
+				lineStart = static_cast<uint32_t>(layout.glyphs.size());
+				penX = 0.0f;
+				penY += lineHeight;
+				hasBreak = false;
+				continue;
+			}
+
+			const AtlasGlyph& glyph = m_atlas->GetGlyph(codepoint, format.pixelSize);
+			if (format.maxWidth > 0.0f && penX > 0.0f && penX + glyph.advance > format.maxWidth && codepoint != ' ')
+			{
+				if (hasBreak)
+				{
+					// Las letras de la palabra actual pasan a la línea siguiente.
+					m_lines.push_back({ lineStart, breakWidth });
+					for (uint32_t i = breakGlyph; i < layout.glyphs.size(); i++)
+					{
+						layout.glyphs[i].x -= breakX;
+						layout.glyphs[i].y += lineHeight;
+					}
+					lineStart = breakGlyph;
+					penX -= breakX;
+				}
+				else
+				{
+					m_lines.push_back({ lineStart, penX });
+					lineStart = static_cast<uint32_t>(layout.glyphs.size());
+					penX = 0.0f;
+				}
+				penY += lineHeight;
+				hasBreak = false;
+			}
+
+			if (glyph.width > 0.0f)
+			{
+				TextLayoutGlyph quad;
+				quad.x = penX + glyph.offsetX;
+				quad.y = penY + glyph.offsetY;
+				quad.width = glyph.width;
+				quad.height = glyph.height;
+				quad.u0 = glyph.u0;
+				quad.v0 = glyph.v0;
+				quad.u1 = glyph.u1;
+				quad.v1 = glyph.v1;
+				layout.glyphs.push_back(quad);
+			}
+
+			if (codepoint == ' ')
+			{
+				breakWidth = penX;
+				breakX = penX + glyph.advance;
+				breakGlyph = static_cast<uint32_t>(layout.glyphs.size());
+				hasBreak = true;
+			}
+			penX += glyph.advance;
+		}
+		m_lines.push_back({ lineStart, penX });
+
+		float width = 0.0f;
+		for (const Line& line : m_lines)
+		{
+			width = std::max(width, line.width);
+		}
+		layout.width = (format.maxWidth > 0.0f) ? format.maxWidth : width;
+		layout.height = penY + lineHeight;
+
+		if (format.alignment != TextAlignment::Leading)
+		{
+			float factor = (format.alignment == TextAlignment::Center) ? 0.5f : 1.0f;
+			for (size_t l = 0; l < m_lines.size(); l++)
+			{
+				uint32_t lineEnd = (l + 1 < m_lines.size()) ? m_lines[l + 1].firstGlyph : static_cast<uint32_t>(layout.glyphs.size());
+				float offset = (layout.width - m_lines[l].width) * factor;
+				for (uint32_t i = m_lines[l].firstGlyph; i < lineEnd; i++)
+				{
+					layout.glyphs[i].x += offset;
+				}
+			}
+		}
+
+		entry.atlasGeneration = m_atlas->GetGeneration();
+		if (entry.atlasGeneration == generation)
+		{
+			break;
+		}
+	}
+}
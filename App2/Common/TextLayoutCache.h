@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GlyphAtlas.h"
+#include "MemoryTracker.h"
+
+namespace DX
+{
+	enum class TextAlignment
+	{
+		Leading,
+		Center,
+		Trailing
+	};
+
+	// Formato de una maquetación. maxWidth = 0 desactiva el ajuste de línea.
+	struct TextFormat
+	{
+		TextFormat() : pixelSize(16), maxWidth(0.0f), alignment(TextAlignment::Leading) {}
+		TextFormat(uint32_t size, float width, TextAlignment align) : pixelSize(size), maxWidth(width), alignment(align) {}
+
+		uint32_t		pixelSize;
+		float			maxWidth;
+		TextAlignment	alignment;
+	};
+
+	// Cuadrado de un glifo relativo al origen de la maquetación (esquina superior izquierda).
+	struct TextLayoutGlyph
+	{
+		float	x, y;
+		float	width, height;
+		float	u0, v0, u1, v1;
+	};
+
+	struct TextLayout
+	{
+		TaggedVector<TextLayoutGlyph, MemoryTag::Text>	glyphs;
+		float							width;
+		float							height;
+	};
+
+	// Caché de maquetaciones indexada por texto (UTF-8) y formato. Una consulta que acierta solo calcula
+	// un hash y compara el texto, sin reservar memoria. Las entradas que no se usan durante un fotograma
+	// pueden desalojarse, y su memoria se reutiliza para maquetaciones nuevas.
+	class TextLayoutCache
+	{
+	public:
+		TextLayoutCache(GlyphAtlas* atlas, uint32_t capacity = 1024);
+
+		// La referencia es válida hasta la siguiente llamada a GetLayout o NextFrame.
+		const TextLayout& GetLayout(const char* text, const TextFormat& format);
+
+		// Marca el final de un fotograma. Si la caché pasa de su capacidad, desaloja lo que no se ha usado en él.
+		void NextFrame();
+
+		uint32_t GetEntryCount() const		{ return m_liveCount; }
+		uint64_t GetHitCount() const		{ return m_hits; }
+		uint64_t GetMissCount() const		{ return m_misses; }
+
+	private:
+		struct Entry
+		{
+			uint64_t		hash;
+			std::string		text;
+			TextFormat		format;
+			uint32_t		atlasGeneration;
+			uint64_t		lastUsedFrame;
+			bool			live;
+			TextLayout		layout;
+		};
+
+		struct Line
+		{
+			uint32_t	firstGlyph;
+			float		width;
+		};
+
+		void BuildLayout(Entry& entry);
+		uint32_t FindSlot(uint64_t hash, const char* text, size_t length, const TextFormat& format) const;
+		void RebuildSlots(uint32_t slotCount);
+
+		GlyphAtlas*				m_atlas;
+		uint32_t				m_capacity;
+
+		// Direccionamiento abierto con sondeo lineal; cada hueco guarda un índice en m_entries.
+		TaggedVector<uint32_t, MemoryTag::Text>	m_slots;
+		TaggedVector<Entry, MemoryTag::Text>	m_entries;
+		TaggedVector<uint32_t, MemoryTag::Text>	m_freeEntries;
+		uint32_t				m_liveCount;
+
+		TaggedVector<Line, MemoryTag::Text>	m_lines;
+		uint64_t				m_frame;
+		uint64_t				m_hits;
+		uint64_t				m_misses;
+	};
+}
@@ -0,0 +1,622 @@
+﻿#include "TriangleBvh.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const float Infinity = 1e30f;
+
+	// Coste de bajar por un nodo frente al de probar un triángulo, en la fórmula de la SAH.
+	const float TraversalCost = 1.0f;
+
+	// Por debajo de este número de triángulos el agrupado de un nodo se hace en un solo subproceso.
+	const uint32_t ParallelBinningThreshold = 32 * 1024;
+
+	// Sin el tratamiento de NaN de fminf/fmaxf (que el compilador no siempre convierte en minss/maxss): las
+	// cajas se combinan una vez por triángulo en cada nivel de la construcción.
+	inline Vector3 BoundsMin(const Vector3& a, const Vector3& b)
+	{
+		return Vector3((a.x < b.x) ? a.x : b.x, (a.y < b.y) ? a.y : b.y, (a.z < b.z) ? a.z : b.z);
+	}
+
+	inline Vector3 BoundsMax(const Vector3& a, const Vector3& b)
+	{
+		return Vector3((a.x > b.x) ? a.x : b.x, (a.y > b.y) ? a.y : b.y, (a.z > b.z) ? a.z : b.z);
+	}
+
+	struct Bin
+	{
+		Vector3		min;
+		Vector3		max;
+		uint32_t	count;
+	};
+
+	void ResetBins(Bin bins[3][TriangleBvh::BinCount], uint32_t binCount)
+	{
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			for (uint32_t b = 0; b < binCount; b++)
+			{
+				bins[axis][b].min = Vector3(Infinity, Infinity, Infinity);
+				bins[axis][b].max = Vector3(-Infinity, -Infinity, -Infinity);
+				bins[axis][b].count = 0;
+			}
+		}
+	}
+
+	float SurfaceArea(const Vector3& min, const Vector3& max)
+	{
+		Vector3 size = max - min;
+		if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+		{
+			return 0.0f;
+		}
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	inline uint32_t GetBin(float centroid, float minimum, float scale, uint32_t binCount)
+	{
+		int32_t bin = static_cast<int32_t>((centroid - minimum) * scale);
+		return static_cast<uint32_t>(std::min(std::max(bin, 0), static_cast<int32_t>(binCount) - 1));
+	}
+
+	// Componente de la dirección sin ceros, para que la inversa sea finita en la prueba de las cajas.
+	inline float SafeInverse(float d)
+	{
+		const float tiny = 1e-12f;
+		return 1.0f / ((fabsf(d) < tiny) ? ((d < 0.0f) ? -tiny : tiny) : d);
+	}
+}
+
+TriangleBvh::TriangleBvh()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+TriangleBvh::Aabb TriangleBvh::ComputeBounds(uint32_t first, uint32_t count, bool centroids) const
+{
+	Aabb bounds = { Vector3(Infinity, Infinity, Infinity), Vector3(-Infinity, -Infinity, -Infinity) };
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		uint32_t triangle = m_order[i];
+		if (centroids)
+		{
+			bounds.min = BoundsMin(bounds.min, m_centroids[triangle]);
+			bounds.max = BoundsMax(bounds.max, m_centroids[triangle]);
+		}
+		else
+		{
+			bounds.min = BoundsMin(bounds.min, m_triangleBounds[triangle].min);
+			bounds.max = BoundsMax(bounds.max, m_triangleBounds[triangle].max);
+		}
+	}
+	return bounds;
+}
+
+// Mejor corte por SAH entre los planos de los cajones de cada eje, repartiendo los centroides sobre su
+// propia caja. Los nodos pequeños usan tantos cajones como triángulos (hasta BinCount): son la mayoría y,
+// con todos los cajones, el barrido costaba más que el agrupado. Con jobSystem, los cajones se llenan por
+// tramos en paralelo y se suman después.
+TriangleBvh::SplitResult TriangleBvh::Split(JobSystem* jobSystem, uint32_t first, uint32_t count, const Aabb& bounds)
+{
+	SplitResult result = { true, first };
+	if (count <= 1)
+	{
+		return result;
+	}
+
+	Aabb centroidBounds = ComputeBounds(first, count, true);
+	Vector3 extent = centroidBounds.max - centroidBounds.min;
+	uint32_t binCount = std::min(count, static_cast<uint32_t>(BinCount));
+	float scale[3];
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		scale[axis] = (extent[axis] > 0.0f) ? binCount * 0.9999f / extent[axis] : 0.0f;
+	}
+
+	Bin bins[3][BinCount];
+	auto fillBins = [this, &centroidBounds, &scale, binCount](Bin target[3][BinCount], uint32_t begin, uint32_t end)
+	{
+		ResetBins(target, binCount);
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t triangle = m_order[i];
+			const Aabb& triangleBounds = m_triangleBounds[triangle];
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = target[axis][GetBin(m_centroids[triangle][axis], centroidBounds.min[axis], scale[axis], binCount)];
+				bin.min = BoundsMin(bin.min, triangleBounds.min);
+				bin.max = BoundsMax(bin.max, triangleBounds.max);
+				bin.count++;
+			}
+		}
+	};
+
+	if (jobSystem != nullptr && count >= ParallelBinningThreshold)
+	{
+		uint32_t chunkCount = jobSystem->GetThreadCount() * 4;
+		uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+		std::vector<Bin> partial(static_cast<size_t>(chunkCount) * 3 * BinCount);
+		jobSystem->ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t chunk = begin; chunk < end; chunk++)
+			{
+				uint32_t chunkFirst = first + std::min(count, chunk * chunkSize);
+				uint32_t chunkEnd = first + std::min(count, (chunk + 1) * chunkSize);
+				fillBins(reinterpret_cast<Bin(*)[BinCount]>(&partial[static_cast<size_t>(chunk) * 3 * BinCount]), chunkFirst, chunkEnd);
+			}
+		});
+
+		ResetBins(bins, binCount);
+		for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			const Bin* source = &partial[static_cast<size_t>(chunk) * 3 * BinCount];
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t b = 0; b < binCount; b++)
+				{
+					const Bin& from = source[axis * BinCount + b];
+					bins[axis][b].min = BoundsMin(bins[axis][b].min, from.min);
+					bins[axis][b].max = BoundsMax(bins[axis][b].max, from.max);
+					bins[axis][b].count += from.count;
+				}
+			}
+		}
+	}
+	else
+	{
+		fillBins(bins, first, first + count);
+	}
+
+	// Barrido: áreas y cuentas acumuladas desde la derecha y después desde la izquierda.
+	float bestCost = Infinity;
+	uint32_t bestAxis = 0;
+	uint32_t bestBin = 0;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		if (scale[axis] == 0.0f)
+		{
+			continue;
+		}
+
+		float rightArea[BinCount];
+		uint32_t rightCount[BinCount];
+		Vector3 min(Infinity, Infinity, Infinity), max(-Infinity, -Infinity, -Infinity);
+		uint32_t running = 0;
+		for (uint32_t b = binCount - 1; b > 0; b--)
+		{
+			min = BoundsMin(min, bins[axis][b].min);
+			max = BoundsMax(max, bins[axis][b].max);
+			running += bins[axis][b].count;
+			rightArea[b] = SurfaceArea(min, max);
+			rightCount[b] = running;
+		}
+
+		min = Vector3(Infinity, Infinity, Infinity);
+		max = Vector3(-Infinity, -Infinity, -Infinity);
+		running = 0;
+		for (uint32_t b = 0; b + 1 < binCount; b++)
+		{
+			min = BoundsMin(min, bins[axis][b].min);
+			max = BoundsMax(max, bins[axis][b].max);
+			running += bins[axis][b].count;
+			if (running == 0 || rightCount[b + 1] == 0)
+			{
+				continue;
+			}
+
+			float cost = SurfaceArea(min, max) * running + rightArea[b + 1] * rightCount[b + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b + 1;
+			}
+		}
+	}
+
+	float area = SurfaceArea(bounds.min, bounds.max);
+	float splitCost = TraversalCost + ((area > 0.0f) ? bestCost / area : 0.0f);
+	if (count <= MaxLeafTriangles && (bestCost == Infinity || splitCost >= static_cast<float>(count)))
+	{
+		return result;
+	}
+
+	result.leaf = false;
+	if (bestCost == Infinity)
+	{
+		// Todos los centroides coinciden: se parte por la mitad del orden.
+		result.middle = first + count / 2;
+		return result;
+	}
+
+	float minimum = centroidBounds.min[bestAxis];
+	float axisScale = scale[bestAxis];
+	uint32_t* begin = m_order.data() + first;
+	uint32_t* middle = std::partition(begin, begin + count, [this, bestAxis, bestBin, minimum, axisScale, binCount](uint32_t triangle)
+	{
+		return GetBin(m_centroids[triangle][bestAxis], minimum, axisScale, binCount) < bestBin;
+	});
+	result.middle = first + static_cast<uint32_t>(middle - begin);
+	return result;
+}
+
+// Subárbol completo de un tramo del orden, en un vector propio (se llama en paralelo para tramos disjuntos).
+uint32_t TriangleBvh::BuildSubtree(std::vector<BuildNode>& nodes, uint32_t first, uint32_t count)
+{
+	uint32_t index = static_cast<uint32_t>(nodes.size());
+	BuildNode node;
+	node.bounds = ComputeBounds(first, count, false);
+	node.first = first;
+	node.count = count;
+	node.left = 0;
+	node.right = 0;
+	nodes.push_back(node);
+
+	SplitResult split = Split(nullptr, first, count, node.bounds);
+	if (split.leaf)
+	{
+		return index;
+	}
+
+	uint32_t left = BuildSubtree(nodes, first, split.middle - first);
+	uint32_t right = BuildSubtree(nodes, split.middle, first + count - split.middle);
+	nodes[index].count = 0;
+	nodes[index].left = left;
+	nodes[index].right = right;
+	return index;
+}
+
+// Niveles superiores: se parten con agrupado en paralelo hasta que los tramos bajan de taskThreshold, y
+// esos se dejan como tareas (con su nodo reservado) para construirlos después en paralelo.
+uint32_t TriangleBvh::BuildTop(JobSystem* jobSystem, uint32_t first, uint32_t count, uint32_t taskThreshold, std::vector<BuildTask>& tasks)
+{
+	uint32_t index = static_cast<uint32_t>(m_buildNodes.size());
+	BuildNode node;
+	node.bounds = ComputeBounds(first, count, false);
+	node.first = first;
+	node.count = count;
+	node.left = 0;
+	node.right = 0;
+	m_buildNodes.push_back(node);
+
+	if (count <= taskThreshold)
+	{
+		BuildTask task = { index, first, count };
+		tasks.push_back(task);
+		return index;
+	}
+
+	SplitResult split = Split(jobSystem, first, count, node.bounds);
+	if (split.leaf)
+	{
+		return index;
+	}
+
+	uint32_t left = BuildTop(jobSystem, first, split.middle - first, taskThreshold, tasks);
+	uint32_t right = BuildTop(jobSystem, split.middle, first + count - split.middle, taskThreshold, tasks);
+	m_buildNodes[index].count = 0;
+	m_buildNodes[index].left = left;
+	m_buildNodes[index].right = right;
+	return index;
+}
+
+// Pliega el árbol binario en nodos de cuatro hijos: se abre el hijo interior de mayor área hasta tener cuatro.
+uint32_t TriangleBvh::Collapse(uint32_t node, uint32_t depth)
+{
+	m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+	uint32_t children[4];
+	uint32_t childCount = 0;
+	const BuildNode& source = m_buildNodes[node];
+	if (source.count > 0)
+	{
+		children[childCount++] = node;
+	}
+	else
+	{
+		children[childCount++] = source.left;
+		children[childCount++] = source.right;
+		while (childCount < 4)
+		{
+			int32_t best = -1;
+			float bestArea = -1.0f;
+			for (uint32_t i = 0; i < childCount; i++)
+			{
+				const BuildNode& child = m_buildNodes[children[i]];
+				float area = SurfaceArea(child.bounds.min, child.bounds.max);
+				if (child.count == 0 && area > bestArea)
+				{
+					best = static_cast<int32_t>(i);
+					bestArea = area;
+				}
+			}
+			if (best < 0)
+			{
+				break;
+			}
+
+			const BuildNode& opened = m_buildNodes[children[best]];
+			children[best] = opened.left;
+			children[childCount++] = opened.right;
+		}
+	}
+
+	uint32_t index = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back(WideNode());
+	for (uint32_t slot = 0; slot < 4; slot++)
+	{
+		WideNode& wide = m_nodes[index];
+		if (slot >= childCount)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				wide.bounds[k][slot] = Infinity;
+				wide.bounds[k + 3][slot] = -Infinity;
+			}
+			wide.child[slot] = NoChild;
+			wide.count[slot] = 0;
+			continue;
+		}
+
+		const BuildNode& child = m_buildNodes[children[slot]];
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			wide.bounds[k][slot] = child.bounds.min[k];
+			wide.bounds[k + 3][slot] = child.bounds.max[k];
+		}
+		if (child.count > 0)
+		{
+			wide.child[slot] = child.first;
+			wide.count[slot] = child.count;
+			m_stats.leaves++;
+		}
+		else
+		{
+			uint32_t grandchild = Collapse(children[slot], depth + 1);
+			m_nodes[index].child[slot] = grandchild;
+			m_nodes[index].count[slot] = 0;
+		}
+	}
+	return index;
+}
+
+void TriangleBvh::Build(JobSystem* jobSystem, const Vector3* positions, uint32_t triangleCount)
+{
+	DX_PROFILE_SCOPE("TriangleBvh::Build");
+	auto start = std::chrono::steady_clock::now();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.triangleCount = triangleCount;
+	m_nodes.clear();
+	m_triangles.clear();
+	m_buildNodes.clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	m_triangleBounds.resize(triangleCount);
+	m_centroids.resize(triangleCount);
+	m_order.resize(triangleCount);
+	jobSystem->ParallelFor(triangleCount, 1024, [this, positions](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t t = begin; t < end; t++)
+		{
+			const Vector3* v = positions + static_cast<size_t>(t) * 3;
+			m_triangleBounds[t].min = BoundsMin(BoundsMin(v[0], v[1]), v[2]);
+			m_triangleBounds[t].max = BoundsMax(BoundsMax(v[0], v[1]), v[2]);
+			m_centroids[t] = (m_triangleBounds[t].min + m_triangleBounds[t].max) * 0.5f;
+			m_order[t] = t;
+		}
+	});
+
+	// Unas cuantas tareas por subproceso para repartir bien los subárboles de tamaños distintos.
+	uint32_t taskThreshold = std::max(1024u, triangleCount / (jobSystem->GetThreadCount() * 8));
+	std::vector<BuildTask> tasks;
+	BuildTop(jobSystem, 0, triangleCount, taskThreshold, tasks);
+
+	std::vector<std::vector<BuildNode>> subtrees(tasks.size());
+	jobSystem->ParallelFor(static_cast<uint32_t>(tasks.size()), 1, [this, &tasks, &subtrees](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			BuildSubtree(subtrees[i], tasks[i].first, tasks[i].count);
+		}
+	});
+
+	// Cada subárbol se añade al final; su raíz sustituye al nodo reservado.
+	for (size_t i = 0; i < tasks.size(); i++)
+	{
+		const std::vector<BuildNode>& subtree = subtrees[i];
+		uint32_t offset = static_cast<uint32_t>(m_buildNodes.size()) - 1;
+		for (size_t n = 1; n < subtree.size(); n++)
+		{
+			BuildNode node = subtree[n];
+			if (node.count == 0)
+			{
+				node.left += offset;
+				node.right += offset;
+			}
+			m_buildNodes.push_back(node);
+		}
+
+		BuildNode root = subtree[0];
+		if (root.count == 0)
+		{
+			root.left += offset;
+			root.right += offset;
+		}
+		m_buildNodes[tasks[i].node] = root;
+	}
+	m_stats.binaryNodes = static_cast<uint32_t>(m_buildNodes.size());
+
+	m_nodes.reserve(m_buildNodes.size() / 2 + 1);
+	Collapse(0, 1);
+	m_stats.wideNodes = static_cast<uint32_t>(m_nodes.size());
+
+	// Triángulos en el orden de las hojas.
+	m_triangles.resize(triangleCount);
+	jobSystem->ParallelFor(triangleCount, 1024, [this, positions](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t t = m_order[i];
+			const Vector3* v = positions + static_cast<size_t>(t) * 3;
+			m_triangles[i].v0 = v[0];
+			m_triangles[i].edge1 = v[1] - v[0];
+			m_triangles[i].edge2 = v[2] - v[0];
+			m_triangles[i].index = t;
+		}
+	});
+
+	m_stats.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool TriangleBvh::IntersectLeaf(const Ray& ray, uint32_t first, uint32_t count, bool anyHit, RayHit& hit) const
+{
+	bool found = false;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const Triangle& triangle = m_triangles[i];
+		Vector3 p = Cross(ray.direction, triangle.edge2);
+		float determinant = Dot(triangle.edge1, p);
+		if (fabsf(determinant) < 1e-12f)
+		{
+			continue;
+		}
+
+		float inverse = 1.0f / determinant;
+		Vector3 s = ray.origin - triangle.v0;
+		float u = Dot(s, p) * inverse;
+		if (u < 0.0f || u > 1.0f)
+		{
+			continue;
+		}
+
+		Vector3 q = Cross(s, triangle.edge1);
+		float v = Dot(ray.direction, q) * inverse;
+		if (v < 0.0f || u + v > 1.0f)
+		{
+			continue;
+		}
+
+		float t = Dot(triangle.edge2, q) * inverse;
+		if (t >= 0.0f && t <= hit.distance)
+		{
+			hit.distance = t;
+			hit.triangle = triangle.index;
+			hit.u = u;
+			hit.v = v;
+			found = true;
+			if (anyHit)
+			{
+				return true;
+			}
+		}
+	}
+	return found;
+}
+
+// Pila de nodos con su distancia de entrada: los que quedan detrás del impacto más cercano se descartan
+// al sacarlos. Los hijos visitados se apilan de más lejano a más cercano.
+bool TriangleBvh::Traverse(const Ray& ray, bool anyHit, RayHit& hit) const
+{
+	if (m_nodes.empty())
+	{
+		return false;
+	}
+
+	SimdFloat4 origin[3] = { SimdFloat4::Splat(ray.origin.x), SimdFloat4::Splat(ray.origin.y), SimdFloat4::Splat(ray.origin.z) };
+	SimdFloat4 inverse[3] = { SimdFloat4::Splat(SafeInverse(ray.direction.x)), SimdFloat4::Splat(SafeInverse(ray.direction.y)), SimdFloat4::Splat(SafeInverse(ray.direction.z)) };
+	SimdFloat4 zero = SimdFloat4::Splat(0.0f);
+
+	struct Entry
+	{
+		uint32_t	node;
+		float		distance;
+	};
+	Entry stack[96];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+
+	hit.distance = ray.maxDistance;
+	bool found = false;
+	while (stackSize > 0)
+	{
+		Entry entry = stack[--stackSize];
+		if (entry.distance > hit.distance)
+		{
+			continue;
+		}
+
+		const WideNode& node = m_nodes[entry.node];
+		SimdFloat4 nearT = zero;
+		SimdFloat4 farT = SimdFloat4::Splat(hit.distance);
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			SimdFloat4 t0 = (SimdFloat4::Load(node.bounds[axis]) - origin[axis]) * inverse[axis];
+			SimdFloat4 t1 = (SimdFloat4::Load(node.bounds[axis + 3]) - origin[axis]) * inverse[axis];
+			nearT = Max(nearT, Min(t0, t1));
+			farT = Min(farT, Max(t0, t1));
+		}
+		int mask = LessEqualMask(nearT, farT);
+		float distances[4];
+		nearT.Store(distances);
+
+		Entry children[4];
+		uint32_t childCount = 0;
+		for (uint32_t slot = 0; slot < 4; slot++)
+		{
+			if ((mask & (1 << slot)) == 0 || node.child[slot] == NoChild)
+			{
+				continue;
+			}
+
+			if (node.count[slot] > 0)
+			{
+				if (IntersectLeaf(ray, node.child[slot], node.count[slot], anyHit, hit))
+				{
+					found = true;
+					if (anyHit)
+					{
+						return true;
+					}
+				}
+			}
+			else
+			{
+				// Inserción ordenada de más lejano a más cercano.
+				Entry child = { node.child[slot], distances[slot] };
+				uint32_t position = childCount++;
+				while (position > 0 && children[position - 1].distance < child.distance)
+				{
+					children[position] = children[position - 1];
+					position--;
+				}
+				children[position] = child;
+			}
+		}
+
+		for (uint32_t i = 0; i < childCount; i++)
+		{
+			stack[stackSize++] = children[i];
+		}
+	}
+	return found;
+}
+
+bool TriangleBvh::Intersect(const Ray& ray, RayHit& hit) const
+{
+	return Traverse(ray, false, hit);
+}
+
+bool TriangleBvh::IsOccluded(const Ray& ray) const
+{
+	RayHit hit;
+	return Traverse(ray, true, hit);
+}
@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "VectorMath.h"
+
+namespace DX
+{
+	struct Ray
+	{
+		Vector3		origin;
+		Vector3		direction;
+		float		maxDistance;
+	};
+
+	struct RayHit
+	{
+		float		distance;
+		uint32_t	triangle;	// Índice en el orden de Build.
+		float		u;			// Coordenadas baricéntricas de los vértices 1 y 2.
+		float		v;
+	};
+
+	struct BvhStats
+	{
+		uint32_t	triangleCount;
+		uint32_t	binaryNodes;
+		uint32_t	wideNodes;
+		uint32_t	leaves;
+		uint32_t	maxDepth;		// En nodos anchos.
+		double		buildMilliseconds;
+	};
+
+	// Jerarquía de volúmenes envolventes sobre triángulos. Se construye como árbol binario con SAH por
+	// cajones (binned SAH): los niveles superiores reparten el agrupado entre los subprocesos y los
+	// subárboles que quedan se construyen en paralelo, uno por tarea. Después se pliega en un árbol de
+	// cuatro hijos cuyas cajas se guardan por componentes, de modo que un rayo se prueba contra los cuatro
+	// hijos a la vez con SimdFloat4 y se baja primero por el más cercano.
+	class TriangleBvh
+	{
+	public:
+		static const uint32_t MaxLeafTriangles = 4;
+		static const uint32_t BinCount = 16;
+
+		TriangleBvh();
+
+		// positions tiene tres vértices por triángulo; se copian, así que puede liberarse después.
+		void Build(JobSystem* jobSystem, const Vector3* positions, uint32_t triangleCount);
+
+		// Impacto más cercano en [0, maxDistance]; los triángulos se ven por las dos caras.
+		bool Intersect(const Ray& ray, RayHit& hit) const;
+
+		// Cualquier impacto en [0, maxDistance] (rayos de sombra).
+		bool IsOccluded(const Ray& ray) const;
+
+		const BvhStats& GetStats() const	{ return m_stats; }
+
+	private:
+		struct Aabb
+		{
+			Vector3	min;
+			Vector3	max;
+		};
+
+		struct BuildNode
+		{
+			Aabb		bounds;
+			uint32_t	first;		// Hojas: primera posición en el orden de triángulos.
+			uint32_t	count;		// 0 en los nodos interiores.
+			uint32_t	left;
+			uint32_t	right;
+		};
+
+		// Cajas de los cuatro hijos por componentes: minX, minY, minZ, maxX, maxY, maxZ.
+		struct WideNode
+		{
+			float		bounds[6][4];
+			uint32_t	child[4];	// Nodo ancho o primer triángulo de la hoja; NoChild si la ranura está vacía.
+			uint32_t	count[4];	// Triángulos de la hoja; 0 si el hijo es un nodo.
+		};
+
+		// Triángulo preparado para Möller-Trumbore.
+		struct Triangle
+		{
+			Vector3		v0;
+			Vector3		edge1;
+			Vector3		edge2;
+			uint32_t	index;
+		};
+
+		struct SplitResult
+		{
+			bool		leaf;
+			uint32_t	middle;
+		};
+
+		struct BuildTask
+		{
+			uint32_t	node;
+			uint32_t	first;
+			uint32_t	count;
+		};
+
+		static const uint32_t NoChild = 0xffffffffu;
+
+		Aabb ComputeBounds(uint32_t first, uint32_t count, bool centroids) const;
+		SplitResult Split(JobSystem* jobSystem, uint32_t first, uint32_t count, const Aabb& bounds);
+		uint32_t BuildTop(JobSystem* jobSystem, uint32_t first, uint32_t count, uint32_t taskThreshold, std::vector<BuildTask>& tasks);
+		uint32_t BuildSubtree(std::vector<BuildNode>& nodes, uint32_t first, uint32_t count);
+		uint32_t Collapse(uint32_t node, uint32_t depth);
+		bool IntersectLeaf(const Ray& ray, uint32_t first, uint32_t count, bool anyHit, RayHit& hit) const;
+		bool Traverse(const Ray& ray, bool anyHit, RayHit& hit) const;
+
+		// Datos de construcción por triángulo.
+		std::vector<Aabb>		m_triangleBounds;
+		std::vector<Vector3>	m_centroids;
+		std::vector<uint32_t>	m_order;
+		std::vector<BuildNode>	m_buildNodes;
+
+		TaggedVector<WideNode, MemoryTag::Meshes>	m_nodes;
+		TaggedVector<Triangle, MemoryTag::Meshes>	m_triangles;
+		BvhStats									m_stats;
+	};
+}
@@ -0,0 +1,533 @@
+﻿#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DX_SIMD_SSE 1
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define DX_SIMD_SSE4 1
+#include <smmintrin.h>
+#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace DX
+{
+	const float Pi = 3.14159265f;
+	const float TwoPi = 6.28318531f;
+
+	inline float ToRadians(float degrees)					{ return degrees * (Pi / 180.0f); }
+
+	// Tipos matemáticos portátiles usados por los sistemas de CPU que no dependen de DirectXMath.
+	// Se mantiene la misma convención que la escena: sistema diestro y matrices principales de fila.
+	struct Vector3
+	{
+		float x, y, z;
+
+		Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
+		Vector3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+
+		float operator[](int i) const						{ return (&x)[i]; }
+		float& operator[](int i)							{ return (&x)[i]; }
+
+		Vector3 operator-() const							{ return Vector3(-x, -y, -z); }
+		Vector3 operator+(const Vector3& v) const			{ return Vector3(x + v.x, y + v.y, z + v.z); }
+		Vector3 operator-(const Vector3& v) const			{ return Vector3(x - v.x, y - v.y, z - v.z); }
+		Vector3 operator*(float s) const					{ return Vector3(x * s, y * s, z * s); }
+		Vector3& operator+=(const Vector3& v)				{ x += v.x; y += v.y; z += v.z; return *this; }
+		Vector3& operator-=(const Vector3& v)				{ x -= v.x; y -= v.y; z -= v.z; return *this; }
+		Vector3& operator*=(float s)						{ x *= s; y *= s; z *= s; return *this; }
+	};
+
+	inline Vector3 operator*(float s, const Vector3& v)		{ return v * s; }
+
+	inline float Dot(const Vector3& a, const Vector3& b)	{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float LengthSquared(const Vector3& v)			{ return Dot(v, v); }
+	inline float Length(const Vector3& v)					{ return sqrtf(Dot(v, v)); }
+
+	inline Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	inline Vector3 Normalize(const Vector3& v)
+	{
+		float length = Length(v);
+		return (length > 1e-12f) ? v * (1.0f / length) : Vector3();
+	}
+
+	inline Vector3 Min(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z));
+	}
+
+	inline Vector3 Max(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z));
+	}
+
+	// Matriz 3x3 almacenada por filas.
+	struct Matrix3
+	{
+		Vector3 r[3];
+
+		Matrix3() {}
+		Matrix3(const Vector3& r0, const Vector3& r1, const Vector3& r2) { r[0] = r0; r[1] = r1; r[2] = r2; }
+
+		static Matrix3 Identity()							{ return Matrix3(Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1)); }
+		static Matrix3 Diagonal(const Vector3& d)			{ return Matrix3(Vector3(d.x, 0, 0), Vector3(0, d.y, 0), Vector3(0, 0, d.z)); }
+
+		// Columna i; en una matriz de rotación es el eje local i expresado en el espacio del mundo.
+		Vector3 Column(int i) const							{ return Vector3(r[0][i], r[1][i], r[2][i]); }
+
+		Vector3 operator*(const Vector3& v) const			{ return Vector3(Dot(r[0], v), Dot(r[1], v), Dot(r[2], v)); }
+
+		Matrix3 operator*(const Matrix3& m) const
+		{
+			Vector3 c0 = m.Column(0), c1 = m.Column(1), c2 = m.Column(2);
+			return Matrix3(
+				Vector3(Dot(r[0], c0), Dot(r[0], c1), Dot(r[0], c2)),
+				Vector3(Dot(r[1], c0), Dot(r[1], c1), Dot(r[1], c2)),
+				Vector3(Dot(r[2], c0), Dot(r[2], c1), Dot(r[2], c2)));
+		}
+
+		Matrix3 Transposed() const							{ return Matrix3(Column(0), Column(1), Column(2)); }
+	};
+
+	struct Quaternion
+	{
+		float x, y, z, w;
+
+		Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+		Quaternion(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+
+		static Quaternion RotationAxis(const Vector3& axis, float radians)
+		{
+			Vector3 n = Normalize(axis);
+			float s = sinf(radians * 0.5f);
+			return Quaternion(n.x * s, n.y * s, n.z * s, cosf(radians * 0.5f));
+		}
+
+		Quaternion operator*(const Quaternion& q) const
+		{
+			return Quaternion(
+				w * q.x + x * q.w + y * q.z - z * q.y,
+				w * q.y - x * q.z + y * q.w + z * q.x,
+				w * q.z + x * q.y - y * q.x + z * q.w,
+				w * q.w - x * q.x - y * q.y - z * q.z);
+		}
+	};
+
+	inline Quaternion Normalize(const Quaternion& q)
+	{
+		float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		float inv = (length > 1e-12f) ? 1.0f / length : 0.0f;
+		return Quaternion(q.x * inv, q.y * inv, q.z * inv, q.w * inv);
+	}
+
+	// Matriz de rotación que transforma vectores locales en vectores del mundo (v' = M * v).
+	inline Matrix3 ToMatrix3(const Quaternion& q)
+	{
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		return Matrix3(
+			Vector3(1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy)),
+			Vector3(2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx)),
+			Vector3(2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy)));
+	}
+
+	inline Vector3 Rotate(const Quaternion& q, const Vector3& v)
+	{
+		Vector3 u(q.x, q.y, q.z);
+		Vector3 t = 2.0f * Cross(u, v);
+		return v + q.w * t + Cross(u, t);
+	}
+
+	// Integra una velocidad angular (rad/s en el espacio del mundo) durante dt segundos.
+	inline Quaternion IntegrateRotation(const Quaternion& q, const Vector3& angularVelocity, float dt)
+	{
+		Quaternion spin(angularVelocity.x, angularVelocity.y, angularVelocity.z, 0.0f);
+		Quaternion dq = spin * q;
+		float h = 0.5f * dt;
+		return Normalize(Quaternion(q.x + dq.x * h, q.y + dq.y * h, q.z + dq.z * h, q.w + dq.w * h));
+	}
+
+	// Interpolación lineal normalizada; con claves densas es indistinguible de slerp y mucho más barata.
+	// Se toma el camino corto invirtiendo b si los cuaterniones están en hemisferios opuestos.
+	inline Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t)
+	{
+		float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+		float tb = (dot < 0.0f) ? -t : t;
+		float ta = 1.0f - t;
+		return Normalize(Quaternion(a.x * ta + b.x * tb, a.y * ta + b.y * tb, a.z * ta + b.z * tb, a.w * ta + b.w * tb));
+	}
+
+	// Matriz 4x4 por filas con la convención de DirectXMath (vectores fila, v' = v * M). Tiene la misma
+	// disposición en memoria que XMFLOAT4X4, así que los representadores pueden copiarla tal cual.
+	struct Matrix4
+	{
+		float m[4][4];
+
+		static Matrix4 Identity()
+		{
+			Matrix4 r;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					r.m[i][j] = (i == j) ? 1.0f : 0.0f;
+				}
+			}
+			return r;
+		}
+
+		static Matrix4 Scaling(const Vector3& s)
+		{
+			Matrix4 r = Identity();
+			r.m[0][0] = s.x;
+			r.m[1][1] = s.y;
+			r.m[2][2] = s.z;
+			return r;
+		}
+
+		static Matrix4 Translation(const Vector3& t)
+		{
+			Matrix4 r = Identity();
+			r.m[3][0] = t.x;
+			r.m[3][1] = t.y;
+			r.m[3][2] = t.z;
+			return r;
+		}
+
+		static Matrix4 RotationY(float radians)
+		{
+			float s = sinf(radians), c = cosf(radians);
+			Matrix4 r = Identity();
+			r.m[0][0] = c;
+			r.m[0][2] = -s;
+			r.m[2][0] = s;
+			r.m[2][2] = c;
+			return r;
+		}
+
+		// Las filas son los ejes locales en el mundo: la traspuesta de ToMatrix3.
+		static Matrix4 RotationQuaternion(const Quaternion& q)
+		{
+			Matrix3 rotation = ToMatrix3(q);
+			Matrix4 r = Identity();
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					r.m[i][j] = rotation.r[j][i];
+				}
+			}
+			return r;
+		}
+
+		// Escala, después rotación y después traslación, como XMMatrixAffineTransformation sin pivote.
+		static Matrix4 AffineTransformation(const Vector3& scale, const Quaternion& rotation, const Vector3& translation)
+		{
+			Matrix4 r = RotationQuaternion(rotation);
+			for (int j = 0; j < 3; j++)
+			{
+				r.m[0][j] *= scale.x;
+				r.m[1][j] *= scale.y;
+				r.m[2][j] *= scale.z;
+			}
+			r.m[3][0] = translation.x;
+			r.m[3][1] = translation.y;
+			r.m[3][2] = translation.z;
+			return r;
+		}
+
+		// Igual que XMMatrixPerspectiveFovRH: profundidad de recorte en [0, 1].
+		static Matrix4 PerspectiveFovRH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+		{
+			float height = cosf(0.5f * fovAngleY) / sinf(0.5f * fovAngleY);
+			float range = farZ / (nearZ - farZ);
+			Matrix4 r = {};
+			r.m[0][0] = height / aspectRatio;
+			r.m[1][1] = height;
+			r.m[2][2] = range;
+			r.m[2][3] = -1.0f;
+			r.m[3][2] = range * nearZ;
+			return r;
+		}
+
+		// Igual que XMMatrixOrthographicOffCenterRH: profundidad de recorte en [0, 1].
+		static Matrix4 OrthographicOffCenterRH(float left, float right, float bottom, float top, float nearZ, float farZ)
+		{
+			float width = 1.0f / (right - left);
+			float height = 1.0f / (top - bottom);
+			float range = 1.0f / (nearZ - farZ);
+			Matrix4 r = {};
+			r.m[0][0] = width + width;
+			r.m[1][1] = height + height;
+			r.m[2][2] = range;
+			r.m[3][0] = -(left + right) * width;
+			r.m[3][1] = -(top + bottom) * height;
+			r.m[3][2] = range * nearZ;
+			r.m[3][3] = 1.0f;
+			return r;
+		}
+
+		// Igual que XMMatrixLookAtRH.
+		static Matrix4 LookAtRH(const Vector3& eye, const Vector3& at, const Vector3& up)
+		{
+			Vector3 zAxis = Normalize(eye - at);
+			Vector3 xAxis = Normalize(Cross(up, zAxis));
+			Vector3 yAxis = Cross(zAxis, xAxis);
+			Matrix4 r;
+			for (int i = 0; i < 3; i++)
+			{
+				r.m[i][0] = xAxis[i];
+				r.m[i][1] = yAxis[i];
+				r.m[i][2] = zAxis[i];
+				r.m[i][3] = 0.0f;
+			}
+			r.m[3][0] = -Dot(xAxis, eye);
+			r.m[3][1] = -Dot(yAxis, eye);
+			r.m[3][2] = -Dot(zAxis, eye);
+			r.m[3][3] = 1.0f;
+			return r;
+		}
+
+		Matrix4 operator*(const Matrix4& b) const
+		{
+			Matrix4 r;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					r.m[i][j] = m[i][0] * b.m[0][j] + m[i][1] * b.m[1][j] + m[i][2] * b.m[2][j] + m[i][3] * b.m[3][j];
+				}
+			}
+			return r;
+		}
+
+		Matrix4 Transposed() const
+		{
+			Matrix4 r;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					r.m[i][j] = m[j][i];
+				}
+			}
+			return r;
+		}
+	};
+
+	// Transforma el punto (p, 1) y devuelve las cuatro componentes homogéneas en out.
+	inline void TransformPoint(const Vector3& p, const Matrix4& matrix, float out[4])
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			out[j] = p.x * matrix.m[0][j] + p.y * matrix.m[1][j] + p.z * matrix.m[2][j] + matrix.m[3][j];
+		}
+	}
+
+	// Vector de cuatro flotantes con la implementación SIMD disponible en la plataforma (SSE2, NEON o escalar).
+	struct SimdFloat4
+	{
+#if defined(DX_SIMD_SSE)
+		__m128 v;
+		static SimdFloat4 Load(const float* p)				{ SimdFloat4 r; r.v = _mm_loadu_ps(p); return r; }
+		static SimdFloat4 Splat(float s)					{ SimdFloat4 r; r.v = _mm_set1_ps(s); return r; }
+		static SimdFloat4 Set(float x, float y, float z, float w)	{ SimdFloat4 r; r.v = _mm_setr_ps(x, y, z, w); return r; }
+		void Store(float* p) const							{ _mm_storeu_ps(p, v); }
+		SimdFloat4 operator+(SimdFloat4 b) const			{ SimdFloat4 r; r.v = _mm_add_ps(v, b.v); return r; }
+		SimdFloat4 operator-(SimdFloat4 b) const			{ SimdFloat4 r; r.v = _mm_sub_ps(v, b.v); return r; }
+		SimdFloat4 operator*(SimdFloat4 b) const			{ SimdFloat4 r; r.v = _mm_mul_ps(v, b.v); return r; }
+		SimdFloat4 operator/(SimdFloat4 b) const			{ SimdFloat4 r; r.v = _mm_div_ps(v, b.v); return r; }
+		friend SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; r.v = _mm_min_ps(a.v, b.v); return r; }
+		friend SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; r.v = _mm_max_ps(a.v, b.v); return r; }
+		friend SimdFloat4 Abs(SimdFloat4 a)					{ SimdFloat4 r; r.v = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); return r; }
+		friend SimdFloat4 Sqrt(SimdFloat4 a)				{ SimdFloat4 r; r.v = _mm_sqrt_ps(a.v); return r; }
+		// Máscara de bits (un bit por componente) de a <= b.
+		friend int LessEqualMask(SimdFloat4 a, SimdFloat4 b){ return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+		// Entero más cercano (los empates, al par). Sin SSE4.1 pasa por enteros de 32 bits.
+#if defined(DX_SIMD_SSE4)
+		friend SimdFloat4 Round(SimdFloat4 a)				{ SimdFloat4 r; r.v = _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); return r; }
+#else
+		friend SimdFloat4 Round(SimdFloat4 a)				{ SimdFloat4 r; r.v = _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)); return r; }
+#endif
+#elif defined(DX_SIMD_NEON)
+		float32x4_t v;
+		static SimdFloat4 Load(const float* p)				{ SimdFloat4 r; r.v = vld1q_f32(p); return r; }
+		static SimdFloat4 Splat(float s)					{ SimdFloat4 r; r.v = vdupq_n_f32(s); return r; }
+		static SimdFloat4 Set(float x, float y, float z, float w)	{ const float t[4] = { x, y, z, w }; return Load(t); }
+		void Store(float* p) const							{ vst1q_f32(p, v); }
+		SimdFloat4 operator+(SimdFloat4 b) const			{ SimdFloat4 r; r.v = vaddq_f32(v, b.v); return r; }
+		SimdFloat4 operator-(SimdFloat4 b) const			{ SimdFloat4 r; r.v = vsubq_f32(v, b.v); return r; }
+		SimdFloat4 operator*(SimdFloat4 b) const			{ SimdFloat4 r; r.v = vmulq_f32(v, b.v); return r; }
+		SimdFloat4 operator/(SimdFloat4 b) const
+		{
+			float a[4], c[4];
+			Store(a); b.Store(c);
+			for (int i = 0; i < 4; i++) { a[i] /= c[i]; }
+			return Load(a);
+		}
+		friend SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; r.v = vminq_f32(a.v, b.v); return r; }
+		friend SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; r.v = vmaxq_f32(a.v, b.v); return r; }
+		friend SimdFloat4 Abs(SimdFloat4 a)					{ SimdFloat4 r; r.v = vabsq_f32(a.v); return r; }
+		friend SimdFloat4 Sqrt(SimdFloat4 a)
+		{
+			float t[4];
+			a.Store(t);
+			for (int i = 0; i < 4; i++) { t[i] = sqrtf(t[i]); }
+			return Load(t);
+		}
+		friend int LessEqualMask(SimdFloat4 a, SimdFloat4 b)
+		{
+			uint32_t m[4];
+			vst1q_u32(m, vcleq_f32(a.v, b.v));
+			return (m[0] & 1) | ((m[1] & 1) << 1) | ((m[2] & 1) << 2) | ((m[3] & 1) << 3);
+		}
+#if defined(__aarch64__) || defined(_M_ARM64)
+		friend SimdFloat4 Round(SimdFloat4 a)				{ SimdFloat4 r; r.v = vrndnq_f32(a.v); return r; }
+#else
+		friend SimdFloat4 Round(SimdFloat4 a)
+		{
+			float t[4];
+			a.Store(t);
+			for (int i = 0; i < 4; i++) { t[i] = nearbyintf(t[i]); }
+			return Load(t);
+		}
+#endif
+#else
+		float v[4];
+		static SimdFloat4 Load(const float* p)				{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = p[i]; } return r; }
+		static SimdFloat4 Splat(float s)					{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = s; } return r; }
+		static SimdFloat4 Set(float x, float y, float z, float w)	{ SimdFloat4 r; r.v[0] = x; r.v[1] = y; r.v[2] = z; r.v[3] = w; return r; }
+		void Store(float* p) const							{ for (int i = 0; i < 4; i++) { p[i] = v[i]; } }
+		SimdFloat4 operator+(SimdFloat4 b) const			{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = v[i] + b.v[i]; } return r; }
+		SimdFloat4 operator-(SimdFloat4 b) const			{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = v[i] - b.v[i]; } return r; }
+		SimdFloat4 operator*(SimdFloat4 b) const			{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = v[i] * b.v[i]; } return r; }
+		SimdFloat4 operator/(SimdFloat4 b) const			{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = v[i] / b.v[i]; } return r; }
+		friend SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = fminf(a.v[i], b.v[i]); } return r; }
+		friend SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b)	{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = fmaxf(a.v[i], b.v[i]); } return r; }
+		friend SimdFloat4 Abs(SimdFloat4 a)					{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = fabsf(a.v[i]); } return r; }
+		friend SimdFloat4 Sqrt(SimdFloat4 a)				{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = sqrtf(a.v[i]); } return r; }
+		friend int LessEqualMask(SimdFloat4 a, SimdFloat4 b)
+		{
+			int mask = 0;
+			for (int i = 0; i < 4; i++) { mask |= (a.v[i] <= b.v[i]) ? (1 << i) : 0; }
+			return mask;
+		}
+		friend SimdFloat4 Round(SimdFloat4 a)				{ SimdFloat4 r; for (int i = 0; i < 4; i++) { r.v[i] = nearbyintf(a.v[i]); } return r; }
+#endif
+	};
+
+	// Seno y coseno de cuatro ángulos. Se resta el múltiplo k de pi más cercano (con pi partido en tres
+	// trozos para no perder precisión) y se evalúan las series de Taylor en [-pi/2, pi/2]; el signo es
+	// (-1)^k, calculado sin comparaciones. Error absoluto por debajo de 1e-6 hasta |x| ~ 1e4.
+	inline void SinCos(SimdFloat4 x, SimdFloat4& sine, SimdFloat4& cosine)
+	{
+		SimdFloat4 k = Round(x * SimdFloat4::Splat(1.0f / Pi));
+		SimdFloat4 y = x - k * SimdFloat4::Splat(3.140625f);
+		y = y - k * SimdFloat4::Splat(9.67502593994140625e-4f);
+		y = y - k * SimdFloat4::Splat(1.509957990978376432e-7f);
+
+		SimdFloat4 parity = Abs(k - SimdFloat4::Splat(2.0f) * Round(k * SimdFloat4::Splat(0.5f)));
+		SimdFloat4 sign = SimdFloat4::Splat(1.0f) - SimdFloat4::Splat(2.0f) * parity;
+
+		SimdFloat4 y2 = y * y;
+		SimdFloat4 s = y2 * SimdFloat4::Splat(-2.5052108e-8f) + SimdFloat4::Splat(2.7557319e-6f);
+		s = s * y2 + SimdFloat4::Splat(-1.9841270e-4f);
+		s = s * y2 + SimdFloat4::Splat(8.3333333e-3f);
+		s = s * y2 + SimdFloat4::Splat(-1.6666667e-1f);
+		s = s * y2 * y + y;
+
+		SimdFloat4 c = y2 * SimdFloat4::Splat(2.0876757e-9f) + SimdFloat4::Splat(-2.7557319e-7f);
+		c = c * y2 + SimdFloat4::Splat(2.4801587e-5f);
+		c = c * y2 + SimdFloat4::Splat(-1.3888889e-3f);
+		c = c * y2 + SimdFloat4::Splat(4.1666668e-2f);
+		c = c * y2 + SimdFloat4::Splat(-0.5f);
+		c = c * y2 + SimdFloat4::Splat(1.0f);
+
+		sine = s * sign;
+		cosine = c * sign;
+	}
+
+	// Seno y coseno de count ángulos, de cuatro en cuatro; el resto pasa por el mismo núcleo, de modo que
+	// un ángulo da el mismo resultado en cualquier posición.
+	inline void SinCos(const float* angles, uint32_t count, float* sines, float* cosines)
+	{
+		uint32_t i = 0;
+		SimdFloat4 sine, cosine;
+		for (; i + 4 <= count; i += 4)
+		{
+			SinCos(SimdFloat4::Load(angles + i), sine, cosine);
+			sine.Store(sines + i);
+			cosine.Store(cosines + i);
+		}
+
+		if (i < count)
+		{
+			float tail[4] = {}, tailSines[4], tailCosines[4];
+			for (uint32_t j = i; j < count; j++)
+			{
+				tail[j - i] = angles[j];
+			}
+			SinCos(SimdFloat4::Load(tail), sine, cosine);
+			sine.Store(tailSines);
+			cosine.Store(tailCosines);
+			for (uint32_t j = i; j < count; j++)
+			{
+				sines[j] = tailSines[j - i];
+				cosines[j] = tailCosines[j - i];
+			}
+		}
+	}
+
+	// TransformPoint para count puntos guardados como estructura de arrays, cuatro a la vez y con las
+	// operaciones en el mismo orden, así que el resultado es idéntico. Las salidas nulas no se escriben.
+	inline void TransformPoints(const Matrix4& matrix, const float* x, const float* y, const float* z, uint32_t count, float* outX, float* outY, float* outZ, float* outW)
+	{
+		float* outputs[4] = { outX, outY, outZ, outW };
+		SimdFloat4 rows[4][4];
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				rows[i][j] = SimdFloat4::Splat(matrix.m[i][j]);
+			}
+		}
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			SimdFloat4 px = SimdFloat4::Load(x + i);
+			SimdFloat4 py = SimdFloat4::Load(y + i);
+			SimdFloat4 pz = SimdFloat4::Load(z + i);
+			for (int j = 0; j < 4; j++)
+			{
+				if (outputs[j] != nullptr)
+				{
+					(px * rows[0][j] + py * rows[1][j] + pz * rows[2][j] + rows[3][j]).Store(outputs[j] + i);
+				}
+			}
+		}
+
+		for (; i < count; i++)
+		{
+			float out[4];
+			TransformPoint(Vector3(x[i], y[i], z[i]), matrix, out);
+			for (int j = 0; j < 4; j++)
+			{
+				if (outputs[j] != nullptr)
+				{
+					outputs[j][i] = out[j];
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,251 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace DX
+{
+	enum class VertexSemantic : uint8_t
+	{
+		Position,
+		Normal,
+		Color,
+		TexCoord,
+	};
+
+	enum class VertexElementFormat : uint8_t
+	{
+		Float1,
+		Float2,
+		Float3,
+		Float4,
+		UNorm8x4,		// Cuatro bytes normalizados a [0, 1].
+	};
+
+	// Un atributo tal como lo ve el backend para crear el diseño de entrada.
+	struct VertexElement
+	{
+		VertexSemantic		semantic;
+		uint32_t			semanticIndex;
+		VertexElementFormat	format;
+		uint32_t			offset;
+	};
+
+	// Componentes de un tipo de almacenamiento: float[N], o uint8_t[4] o uint32_t para cuatro bytes normalizados.
+	template<typename TStorage>
+	struct VertexComponents;
+
+	template<size_t TCount>
+	struct VertexComponents<float[TCount]>
+	{
+		static_assert(TCount >= 1 && TCount <= 4, "Un atributo flotante tiene de una a cuatro componentes");
+		typedef float Component;
+		static const uint32_t Count = static_cast<uint32_t>(TCount);
+		static const VertexElementFormat Format = static_cast<VertexElementFormat>(static_cast<uint32_t>(VertexElementFormat::Float1) + TCount - 1);
+	};
+
+	template<>
+	struct VertexComponents<uint8_t[4]>
+	{
+		typedef uint8_t Component;
+		static const uint32_t Count = 4;
+		static const VertexElementFormat Format = VertexElementFormat::UNorm8x4;
+	};
+
+	template<>
+	struct VertexComponents<uint32_t> : VertexComponents<uint8_t[4]>
+	{
+	};
+
+	// Atributo de un formato: semántica, tipo de almacenamiento y desplazamiento (offsetof) en el vértice.
+	template<VertexSemantic TSemantic, uint32_t TSemanticIndex, typename TStorage, uint32_t TOffset>
+	struct VertexAttribute
+	{
+		typedef VertexComponents<TStorage> Components;
+		static const VertexSemantic Semantic = TSemantic;
+		static const uint32_t SemanticIndex = TSemanticIndex;
+		static const uint32_t Offset = TOffset;
+
+		static VertexElement Describe()
+		{
+			VertexElement element = { Semantic, SemanticIndex, Components::Format, Offset };
+			return element;
+		}
+	};
+
+	// Resultado de buscar un atributo que el formato no tiene.
+	struct MissingVertexAttribute
+	{
+	};
+
+	template<VertexSemantic TSemantic, uint32_t TSemanticIndex, typename... TAttributes>
+	struct FindVertexAttribute
+	{
+		typedef MissingVertexAttribute Type;
+	};
+
+	template<VertexSemantic TSemantic, uint32_t TSemanticIndex, typename TFirst, typename... TRest>
+	struct FindVertexAttribute<TSemantic, TSemanticIndex, TFirst, TRest...>
+	{
+		typedef typename std::conditional<TFirst::Semantic == TSemantic && TFirst::SemanticIndex == TSemanticIndex,
+			TFirst,
+			typename FindVertexAttribute<TSemantic, TSemanticIndex, TRest...>::Type>::type Type;
+	};
+
+	namespace VertexFormatDetail
+	{
+		inline float ToFloat(float value)			{ return value; }
+		inline float ToFloat(uint8_t value)			{ return value * (1.0f / 255.0f); }
+
+		template<typename TComponent>
+		TComponent FromFloat(float value);
+
+		template<>
+		inline float FromFloat<float>(float value)	{ return value; }
+
+		// Satura sin saltos: las comparaciones quedan en min y max.
+		template<>
+		inline uint8_t FromFloat<uint8_t>(float value)
+		{
+			value = (value < 0.0f) ? 0.0f : value;
+			value = (value > 1.0f) ? 1.0f : value;
+			return static_cast<uint8_t>(value * 255.0f + 0.5f);
+		}
+
+		// Las componentes que el origen no tiene valen 0, salvo la cuarta (w, alfa), que vale 1.
+		template<typename TTarget, typename TSource>
+		struct AttributeCopy
+		{
+			static void Apply(const uint8_t* source, uint8_t* target)
+			{
+				typedef typename TSource::Components::Component SourceComponent;
+				typedef typename TTarget::Components::Component TargetComponent;
+				const uint32_t sourceCount = TSource::Components::Count;
+				for (uint32_t i = 0; i < TTarget::Components::Count; i++)
+				{
+					float value = (i == 3) ? 1.0f : 0.0f;
+					if (i < sourceCount)
+					{
+						SourceComponent component;
+						memcpy(&component, source + TSource::Offset + i * sizeof(SourceComponent), sizeof(component));
+						value = ToFloat(component);
+					}
+					TargetComponent converted = FromFloat<TargetComponent>(value);
+					memcpy(target + TTarget::Offset + i * sizeof(TargetComponent), &converted, sizeof(converted));
+				}
+			}
+		};
+
+		template<typename TTarget>
+		struct AttributeCopy<TTarget, MissingVertexAttribute>
+		{
+			static void Apply(const uint8_t*, uint8_t* target)
+			{
+				typedef typename TTarget::Components::Component TargetComponent;
+				for (uint32_t i = 0; i < TTarget::Components::Count; i++)
+				{
+					TargetComponent converted = FromFloat<TargetComponent>((i == 3) ? 1.0f : 0.0f);
+					memcpy(target + TTarget::Offset + i * sizeof(TargetComponent), &converted, sizeof(converted));
+				}
+			}
+		};
+
+		template<typename TOtherAttribute, typename TAttribute>
+		struct SameAttribute
+		{
+			static const bool Value = TOtherAttribute::Offset == TAttribute::Offset && TOtherAttribute::Components::Format == TAttribute::Components::Format;
+		};
+
+		template<typename TAttribute>
+		struct SameAttribute<MissingVertexAttribute, TAttribute>
+		{
+			static const bool Value = false;
+		};
+
+		template<typename TOther, typename TAttribute>
+		struct AttributeMatches : SameAttribute<typename TOther::template Find<TAttribute::Semantic, TAttribute::SemanticIndex>::Type, TAttribute>
+		{
+		};
+
+		template<typename TOther, typename... TAttributes>
+		struct AllAttributesMatch
+		{
+			static const bool Value = true;
+		};
+
+		template<typename TOther, typename TFirst, typename... TRest>
+		struct AllAttributesMatch<TOther, TFirst, TRest...>
+		{
+			static const bool Value = AttributeMatches<TOther, TFirst>::Value && AllAttributesMatch<TOther, TRest...>::Value;
+		};
+	}
+
+	// Formato de vértice descrito en el propio tipo. De él salen el paso, los elementos del diseño de entrada y
+	// las conversiones entre formatos, todo al compilar: una conversión es una secuencia fija de copias por
+	// atributo, sin comprobar formatos ni desplazamientos mientras recorre los vértices.
+	template<typename TVertex, typename... TAttributes>
+	struct VertexLayout
+	{
+		static_assert(sizeof...(TAttributes) > 0, "Un formato de vértice necesita al menos un atributo");
+
+		typedef TVertex Vertex;
+		static const uint32_t Stride = sizeof(TVertex);
+		static const uint32_t ElementCount = sizeof...(TAttributes);
+
+		template<VertexSemantic TSemantic, uint32_t TSemanticIndex>
+		struct Find
+		{
+			typedef typename FindVertexAttribute<TSemantic, TSemanticIndex, TAttributes...>::Type Type;
+		};
+
+		static const VertexElement* GetElements()
+		{
+			static const VertexElement elements[] = { TAttributes::Describe()... };
+			return elements;
+		}
+
+		// Escribe en target cada atributo de este formato a partir del de la misma semántica en TSourceLayout.
+		template<typename TSourceLayout>
+		static void ConvertFrom(const uint8_t* source, uint8_t* target)
+		{
+			int expand[] = { (VertexFormatDetail::AttributeCopy<TAttributes, typename TSourceLayout::template Find<TAttributes::Semantic, TAttributes::SemanticIndex>::Type>::Apply(source, target), 0)... };
+			(void)expand;
+		}
+
+		// Mismos atributos en los mismos desplazamientos que TOther (el paso puede ser distinto): los dos
+		// formatos pueden compartir diseño de entrada.
+		template<typename TOther>
+		struct MatchesElements
+		{
+			static const bool Value = ElementCount == TOther::ElementCount && VertexFormatDetail::AllAttributesMatch<TOther, TAttributes...>::Value;
+		};
+	};
+
+	// Cada tipo de vértice especializa VertexLayoutOf heredando de su VertexLayout.
+	template<typename TVertex>
+	struct VertexLayoutOf;
+
+	template<typename TVertexA, typename TVertexB>
+	struct VertexElementsMatch
+	{
+		static const bool Value = VertexLayoutOf<TVertexA>::template MatchesElements<VertexLayoutOf<TVertexB>>::Value;
+	};
+
+	// Los atributos que el destino no tiene se descartan; los que el origen no tiene, toman su valor por defecto.
+	template<typename TTarget, typename TSource>
+	inline void ConvertVertex(const TSource& source, TTarget& target)
+	{
+		VertexLayoutOf<TTarget>::template ConvertFrom<VertexLayoutOf<TSource>>(reinterpret_cast<const uint8_t*>(&source), reinterpret_cast<uint8_t*>(&target));
+	}
+
+	template<typename TTarget, typename TSource>
+	inline void ConvertVertices(const TSource* source, uint32_t count, TTarget* target)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ConvertVertex(source[i], target[i]);
+		}
+	}
+}
@@ -0,0 +1,119 @@
+﻿#include "AnimationExporter.h"
+#include "SceneTracing.h"
+#include "../Common/ContentHash.h"
+#include "../Common/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	double GetMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+AnimationExportDesc AnimationExportDesc::CreateDefault(uint32_t width, uint32_t height)
+{
+	AnimationExportDesc desc;
+	desc.frameCount = 48;
+	desc.framesPerSecond = 24;
+	desc.samplesPerPixel = 16;
+	desc.tracer = PathTracerDesc::CreateDefault(width, height);
+	return desc;
+}
+
+AnimationExporter::AnimationExporter(JobSystem* jobSystem, const AnimationExportDesc& desc) :
+	m_jobSystem(jobSystem),
+	m_desc(desc)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void AnimationExporter::Run(SceneSimulation& simulation, FrameArena& frameArena)
+{
+	DX_PROFILE_SCOPE("AnimationExporter::Run");
+	auto start = std::chrono::steady_clock::now();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.threads = m_jobSystem->GetThreadCount();
+
+	// Mismo timestep fijo que App2Main.
+	StepTimer timer;
+	timer.SetFixedTimeStep(true);
+	timer.SetTargetElapsedSeconds(1.0 / 60);
+	simulation.CompleteStreaming();
+
+	AsyncFileWriter writer;
+	std::vector<TraceScene> batch(m_stats.threads);
+	std::vector<uint64_t> frameHashes(m_desc.frameCount);
+	std::atomic<uint64_t> rays(0);
+	uint64_t previousTicks = 0;
+	for (uint32_t batchFirst = 0; batchFirst < m_desc.frameCount; batchFirst += m_stats.threads)
+	{
+		// La simulación es secuencial: cada fotograma se avanza y se copia antes de trazar la tanda. Las
+		// marcas de cada fotograma salen del total acumulado para que no se pierdan restos de la división.
+		auto simulateStart = std::chrono::steady_clock::now();
+		uint32_t batchCount = std::min(m_stats.threads, m_desc.frameCount - batchFirst);
+		for (uint32_t i = 0; i < batchCount; i++)
+		{
+			uint64_t frameTicks = (static_cast<uint64_t>(batchFirst + i) + 1) * StepTimer::TicksPerSecond / m_desc.framesPerSecond;
+			frameArena.BeginFrame();
+			timer.Advance(frameTicks - previousTicks, [&]() { simulation.Step(timer, frameArena); });
+			simulation.UpdateStreaming();
+			previousTicks = frameTicks;
+
+			batch[i].positions.clear();
+			batch[i].albedo.clear();
+			AddSceneSimulation(batch[i], simulation);
+		}
+		m_stats.simulateMilliseconds += GetMilliseconds(simulateStart);
+
+		// Dentro de un trabajo, el ParallelFor del trazador y de la jerarquía se ejecuta en serie.
+		auto renderStart = std::chrono::steady_clock::now();
+		m_jobSystem->ParallelFor(batchCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				DX_PROFILE_SCOPE("AnimationExporter::RenderFrame");
+				PathTracer tracer(m_jobSystem, m_desc.tracer);
+				tracer.SetScene(batch[i]);
+				SetSceneCamera(tracer);
+				uint64_t frameRays = 0;
+				for (uint32_t sample = 0; sample < m_desc.samplesPerPixel; sample++)
+				{
+					tracer.RenderPass();
+					frameRays += tracer.GetStats().rays;
+				}
+				rays += frameRays;
+
+				std::vector<uint8_t> bytes;
+				tracer.EncodeBmp(bytes);
+				frameHashes[batchFirst + i] = HashContent(bytes.data(), bytes.size());
+				if (!m_desc.pathFormat.empty())
+				{
+					char path[512];
+					snprintf(path, sizeof(path), m_desc.pathFormat.c_str(), batchFirst + i);
+					writer.Enqueue(path, std::move(bytes));
+				}
+			}
+		});
+		m_stats.renderMilliseconds += GetMilliseconds(renderStart);
+		m_stats.frames += batchCount;
+	}
+
+	writer.Flush();
+	m_stats.writer = writer.GetStats();
+	m_stats.rays = rays;
+	m_stats.imageHash = HashContent(frameHashes.data(), frameHashes.size() * sizeof(uint64_t));
+	m_stats.totalMilliseconds = GetMilliseconds(start);
+	m_stats.framesPerHour = (m_stats.totalMilliseconds > 0.0) ? m_stats.frames * 3600000.0 / m_stats.totalMilliseconds : 0.0;
+	m_stats.raysPerSecond = (m_stats.renderMilliseconds > 0.0) ? m_stats.rays / (m_stats.renderMilliseconds / 1000.0) : 0.0;
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../Common/AsyncFileWriter.h"
+#include "../Common/FrameArena.h"
+#include "../Common/JobSystem.h"
+#include "../Common/PathTracer.h"
+#include "SceneSimulation.h"
+
+namespace App2
+{
+	struct AnimationExportDesc
+	{
+		uint32_t			frameCount;
+		uint32_t			framesPerSecond;	// De la animación; la simulación sigue con pasos fijos de 1/60 s.
+		uint32_t			samplesPerPixel;
+		DX::PathTracerDesc	tracer;				// Tamaño de la imagen, rebotes, cielo y sol.
+		std::string			pathFormat;			// printf con el número de fotograma, p. ej. "frame_%04u.bmp"; vacío: no se escribe.
+
+		static AnimationExportDesc CreateDefault(uint32_t width, uint32_t height);
+	};
+
+	struct AnimationExportStats
+	{
+		uint32_t	frames;
+		uint32_t	threads;
+		double		simulateMilliseconds;	// Pasos, terreno, vóxeles y copia de la escena, en el subproceso que llama.
+		double		renderMilliseconds;		// Tiempo real de las tandas de trazado.
+		double		totalMilliseconds;		// Hasta que el último archivo está en el disco.
+		double		framesPerHour;
+		uint64_t	rays;
+		double		raysPerSecond;
+		uint64_t	imageHash;				// De los hashes de las imágenes en orden: no depende del número de subprocesos.
+		DX::AsyncFileWriterStats	writer;
+	};
+
+	// Exporta una animación sin ventana ni GPU. La simulación avanza como en App2Main::Update, pero con
+	// StepTimer::Advance en lugar del reloj de la máquina, así que el resultado es el mismo en cualquier
+	// nodo. Cada fotograma se copia en su propia TraceScene y los fotogramas se trazan en tandas de tantos
+	// como subprocesos, cada uno entero en un subproceso (paralelismo por fotograma: no hay sincronización
+	// dentro de una imagen y las jerarquías se construyen a la vez). Las imágenes pasan a un AsyncFileWriter,
+	// de modo que la escritura en el disco se solapa con el trazado de la tanda siguiente.
+	class AnimationExporter
+	{
+	public:
+		AnimationExporter(DX::JobSystem* jobSystem, const AnimationExportDesc& desc);
+
+		// simulation debe estar recién creada: el reloj de la exportación empieza en cero.
+		void Run(SceneSimulation& simulation, DX::FrameArena& frameArena);
+
+		const AnimationExportDesc& GetDesc() const		{ return m_desc; }
+		const AnimationExportStats& GetStats() const	{ return m_stats; }
+
+	private:
+		DX::JobSystem*			m_jobSystem;
+		AnimationExportDesc		m_desc;
+		AnimationExportStats	m_stats;
+	};
+}
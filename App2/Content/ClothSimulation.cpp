@@ -0,0 +1,496 @@
+﻿#include "ClothSimulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Tamaño de los bloques de trabajo paralelos sobre restricciones, en grupos de cuatro.
+	const uint32_t ConstraintBatchGrain = 128;
+
+	uint64_t MakeEdgeKey(uint32_t a, uint32_t b)
+	{
+		return (a < b) ? ((static_cast<uint64_t>(a) << 32) | b) : ((static_cast<uint64_t>(b) << 32) | a);
+	}
+
+	Vector3 InverseRotate(const Quaternion& q, const Vector3& v)
+	{
+		return Rotate(Quaternion(-q.x, -q.y, -q.z, q.w), v);
+	}
+
+	Vector3 TransformPoint(const ClothBonePose& pose, const Vector3& local)
+	{
+		return pose.position + Rotate(pose.rotation, local);
+	}
+}
+
+ClothMeshDesc ClothMeshDesc::CreateGrid(uint32_t width, uint32_t height, float spacing, const Vector3& origin)
+{
+	ClothMeshDesc mesh;
+	mesh.positions.reserve(width * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			mesh.positions.push_back(origin + Vector3(x * spacing, -(y * spacing), 0.0f));
+		}
+	}
+
+	// La diagonal de cada cuadrado se alterna para que la tela no tenga una dirección preferida al doblarse.
+	mesh.indices.reserve((width - 1) * (height - 1) * 6);
+	for (uint32_t y = 0; y + 1 < height; y++)
+	{
+		for (uint32_t x = 0; x + 1 < width; x++)
+		{
+			uint32_t i0 = y * width + x;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + width;
+			uint32_t i3 = i2 + 1;
+			if (((x + y) & 1) == 0)
+			{
+				uint32_t triangles[6] = { i0, i2, i3, i0, i3, i1 };
+				mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+			}
+			else
+			{
+				uint32_t triangles[6] = { i0, i2, i1, i1, i2, i3 };
+				mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+			}
+		}
+	}
+	return mesh;
+}
+
+ClothSimulation::ClothSimulation(JobSystem* jobSystem, const ClothMeshDesc& mesh) :
+	m_jobSystem(jobSystem),
+	m_particleCount(static_cast<uint32_t>(mesh.positions.size())),
+	m_indices(mesh.indices),
+	m_restPositions(mesh.positions.begin(), mesh.positions.end()),
+	m_gravity(0.0f, -9.81f, 0.0f),
+	m_solverIterations(8),
+	m_stretchStiffness(1.0f),
+	m_bendStiffness(0.3f),
+	m_damping(0.99f)
+{
+	// Se reserva al menos una partícula de relleno y se redondea a un múltiplo de cuatro para la integración SIMD.
+	uint32_t paddedCount = (m_particleCount + 1 + 3) & ~3u;
+	m_positionX.assign(paddedCount, 0.0f);
+	m_positionY.assign(paddedCount, 0.0f);
+	m_positionZ.assign(paddedCount, 0.0f);
+	m_invMass.assign(paddedCount, 0.0f);
+	for (uint32_t i = 0; i < m_particleCount; i++)
+	{
+		m_positionX[i] = mesh.positions[i].x;
+		m_positionY[i] = mesh.positions[i].y;
+		m_positionZ[i] = mesh.positions[i].z;
+		m_invMass[i] = 1.0f;
+	}
+	m_previousX = m_positionX;
+	m_previousY = m_positionY;
+	m_previousZ = m_positionZ;
+	m_normals.resize(m_particleCount, Vector3(0.0f, 0.0f, 1.0f));
+
+	// Adyacencia vértice-triángulo.
+	uint32_t triangleCount = static_cast<uint32_t>(m_indices.size() / 3);
+	m_vertexTriangleStart.assign(m_particleCount + 1, 0);
+	for (uint32_t index : m_indices)
+	{
+		m_vertexTriangleStart[index + 1]++;
+	}
+	for (uint32_t i = 0; i < m_particleCount; i++)
+	{
+		m_vertexTriangleStart[i + 1] += m_vertexTriangleStart[i];
+	}
+	m_vertexTriangles.resize(m_indices.size());
+	std::vector<uint32_t> cursor(m_vertexTriangleStart.begin(), m_vertexTriangleStart.end() - 1);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			m_vertexTriangles[cursor[m_indices[t * 3 + k]]++] = t;
+		}
+	}
+
+	BuildConstraints();
+	UpdateStiffness();
+
+	m_stats = ClothStats();
+	m_stats.particles = m_particleCount;
+	m_stats.constraints = static_cast<uint32_t>(std::count_if(m_constraintA.begin(), m_constraintA.end(), [this](uint32_t a) { return a != m_particleCount; }));
+	m_stats.colors = static_cast<uint32_t>(m_colorStart.size() - 1);
+}
+
+// Crea una restricción por arista y una de flexión entre los vértices opuestos de cada arista compartida,
+// y las reparte en colores con un coloreado voraz del grafo de restricciones.
+void ClothSimulation::BuildConstraints()
+{
+	struct EdgeEntry
+	{
+		uint64_t	key;
+		uint32_t	opposite;
+	};
+
+	std::vector<EdgeEntry> edgeEntries;
+	edgeEntries.reserve(m_indices.size());
+	for (size_t t = 0; t + 2 < m_indices.size(); t += 3)
+	{
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t a = m_indices[t + k];
+			uint32_t b = m_indices[t + (k + 1) % 3];
+			uint32_t c = m_indices[t + (k + 2) % 3];
+			edgeEntries.push_back({ MakeEdgeKey(a, b), c });
+		}
+	}
+	std::sort(edgeEntries.begin(), edgeEntries.end(), [](const EdgeEntry& x, const EdgeEntry& y) { return x.key < y.key; });
+
+	std::vector<uint64_t> edges;
+	std::vector<uint64_t> bends;
+	for (size_t i = 0; i < edgeEntries.size(); )
+	{
+		size_t j = i + 1;
+		while (j < edgeEntries.size() && edgeEntries[j].key == edgeEntries[i].key)
+		{
+			j++;
+		}
+		edges.push_back(edgeEntries[i].key);
+		if (j - i == 2 && edgeEntries[i].opposite != edgeEntries[i + 1].opposite)
+		{
+			bends.push_back(MakeEdgeKey(edgeEntries[i].opposite, edgeEntries[i + 1].opposite));
+		}
+		i = j;
+	}
+
+	std::sort(bends.begin(), bends.end());
+	bends.erase(std::unique(bends.begin(), bends.end()), bends.end());
+	bends.erase(std::remove_if(bends.begin(), bends.end(), [&edges](uint64_t key) { return std::binary_search(edges.begin(), edges.end(), key); }), bends.end());
+
+	// Coloreado voraz: cada partícula guarda una máscara de los colores que ya la usan (hasta 64,
+	// muy por encima de lo que necesita una malla de tela).
+	struct ColoredConstraint
+	{
+		uint32_t	a;
+		uint32_t	b;
+		uint32_t	color;
+		uint8_t		bend;
+	};
+
+	std::vector<ColoredConstraint> constraints;
+	constraints.reserve(edges.size() + bends.size());
+	std::vector<uint64_t> usedColors(m_particleCount, 0);
+	uint32_t colorCount = 0;
+	auto addConstraint = [&](uint64_t key, uint8_t bend)
+	{
+		uint32_t a = static_cast<uint32_t>(key >> 32);
+		uint32_t b = static_cast<uint32_t>(key & 0xffffffff);
+		uint64_t freeColors = ~(usedColors[a] | usedColors[b]);
+		if (freeColors == 0)
+		{
+			throw std::invalid_argument("ClothSimulation: la malla necesita demasiados colores de restricciones.");
+		}
+
+		uint32_t color = 0;
+		while ((freeColors & (1ull << color)) == 0)
+		{
+			color++;
+		}
+		usedColors[a] |= 1ull << color;
+		usedColors[b] |= 1ull << color;
+		colorCount = std::max(colorCount, color + 1);
+		constraints.push_back({ a, b, color, bend });
+	};
+
+	for (uint64_t key : edges)
+	{
+		addConstraint(key, 0);
+	}
+	for (uint64_t key : bends)
+	{
+		addConstraint(key, 1);
+	}
+
+	// Orden final: por color y, dentro de cada color, por partícula para mejorar la localidad.
+	std::sort(constraints.begin(), constraints.end(), [](const ColoredConstraint& x, const ColoredConstraint& y)
+	{
+		return (x.color != y.color) ? (x.color < y.color) : (x.a < y.a);
+	});
+
+	uint32_t dummy = m_particleCount;
+	m_colorStart.assign(1, 0);
+	m_constraintA.clear();
+	m_constraintB.clear();
+	m_restLength.clear();
+	m_isBend.clear();
+	size_t next = 0;
+	for (uint32_t color = 0; color < colorCount; color++)
+	{
+		while (next < constraints.size() && constraints[next].color == color)
+		{
+			const ColoredConstraint& constraint = constraints[next++];
+			m_constraintA.push_back(constraint.a);
+			m_constraintB.push_back(constraint.b);
+			m_restLength.push_back(Length(m_restPositions[constraint.b] - m_restPositions[constraint.a]));
+			m_isBend.push_back(constraint.bend);
+		}
+
+		// Relleno hasta un múltiplo de cuatro con restricciones sobre la partícula ficticia, que no se mueve.
+		while (m_constraintA.size() % 4 != 0)
+		{
+			m_constraintA.push_back(dummy);
+			m_constraintB.push_back(dummy);
+			m_restLength.push_back(0.0f);
+			m_isBend.push_back(0);
+		}
+		m_colorStart.push_back(static_cast<uint32_t>(m_constraintA.size()));
+	}
+}
+
+void ClothSimulation::SetSolverIterations(uint32_t iterations)
+{
+	m_solverIterations = std::max(iterations, 1u);
+	UpdateStiffness();
+}
+
+void ClothSimulation::SetStiffness(float stretch, float bend)
+{
+	m_stretchStiffness = stretch;
+	m_bendStiffness = bend;
+	UpdateStiffness();
+}
+
+// k' = 1 - (1 - k)^(1/n), de modo que n iteraciones con k' equivalen a una con k.
+void ClothSimulation::UpdateStiffness()
+{
+	float inverseIterations = 1.0f / m_solverIterations;
+	float stretch = 1.0f - powf(1.0f - std::min(std::max(m_stretchStiffness, 0.0f), 1.0f), inverseIterations);
+	float bend = 1.0f - powf(1.0f - std::min(std::max(m_bendStiffness, 0.0f), 1.0f), inverseIterations);
+
+	m_stiffness.resize(m_constraintA.size());
+	for (size_t i = 0; i < m_stiffness.size(); i++)
+	{
+		m_stiffness[i] = m_isBend[i] ? bend : stretch;
+	}
+}
+
+void ClothSimulation::AttachParticle(uint32_t particle, uint32_t bone)
+{
+	ClothBonePose pose = (bone < m_bonePoses.size()) ? m_bonePoses[bone] : ClothBonePose();
+	Attachment attachment;
+	attachment.particle = particle;
+	attachment.bone = bone;
+	attachment.localPosition = InverseRotate(pose.rotation, GetParticlePosition(particle) - pose.position);
+	m_attachments.push_back(attachment);
+	m_invMass[particle] = 0.0f;
+}
+
+void ClothSimulation::SetBonePoses(const ClothBonePose* poses, uint32_t count)
+{
+	m_bonePoses.assign(poses, poses + count);
+}
+
+void ClothSimulation::Step(float dt)
+{
+	DX_PROFILE_SCOPE("ClothSimulation::Step");
+	auto start = std::chrono::steady_clock::now();
+
+	Integrate(dt);
+
+	// Las partículas fijadas siguen a su hueso.
+	for (const Attachment& attachment : m_attachments)
+	{
+		if (attachment.bone < m_bonePoses.size())
+		{
+			Vector3 position = TransformPoint(m_bonePoses[attachment.bone], attachment.localPosition);
+			m_positionX[attachment.particle] = position.x;
+			m_positionY[attachment.particle] = position.y;
+			m_positionZ[attachment.particle] = position.z;
+		}
+	}
+
+	m_worldColliders.clear();
+	for (const ClothCollider& collider : m_colliders)
+	{
+		ClothBonePose pose = (collider.bone < m_bonePoses.size()) ? m_bonePoses[collider.bone] : ClothBonePose();
+		WorldCapsule capsule;
+		capsule.start = TransformPoint(pose, collider.localStart);
+		capsule.axis = TransformPoint(pose, collider.localEnd) - capsule.start;
+		float lengthSquared = LengthSquared(capsule.axis);
+		capsule.inverseAxisLengthSquared = (lengthSquared > 0.0f) ? 1.0f / lengthSquared : 0.0f;
+		capsule.radius = collider.radius;
+		m_worldColliders.push_back(capsule);
+	}
+
+	for (uint32_t iteration = 0; iteration < m_solverIterations; iteration++)
+	{
+		for (uint32_t color = 0; color + 1 < m_colorStart.size(); color++)
+		{
+			SolveColor(color);
+		}
+		if (!m_worldColliders.empty())
+		{
+			SolveCollisions();
+		}
+	}
+
+	m_stats.solverMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Verlet con amortiguación, cuatro partículas a la vez. Las partículas con masa inversa 0 no se mueven.
+void ClothSimulation::Integrate(float dt)
+{
+	DX_PROFILE_SCOPE("ClothSimulation::Integrate");
+	uint32_t groups = static_cast<uint32_t>(m_positionX.size() / 4);
+	float damping = m_damping;
+	Vector3 step = m_gravity * (dt * dt);
+
+	m_jobSystem->ParallelFor(groups, ParticleGrain / 4, [this, damping, step](uint32_t begin, uint32_t end)
+	{
+		SimdFloat4 dampingV = SimdFloat4::Splat(damping);
+		SimdFloat4 stepX = SimdFloat4::Splat(step.x);
+		SimdFloat4 stepY = SimdFloat4::Splat(step.y);
+		SimdFloat4 stepZ = SimdFloat4::Splat(step.z);
+
+		for (uint32_t g = begin; g < end; g++)
+		{
+			uint32_t i = g * 4;
+			SimdFloat4 w = SimdFloat4::Load(&m_invMass[i]);
+			SimdFloat4 x = SimdFloat4::Load(&m_positionX[i]);
+			SimdFloat4 y = SimdFloat4::Load(&m_positionY[i]);
+			SimdFloat4 z = SimdFloat4::Load(&m_positionZ[i]);
+			SimdFloat4 factor = dampingV * w;
+
+			(x + (x - SimdFloat4::Load(&m_previousX[i])) * factor + stepX * w).Store(&m_positionX[i]);
+			(y + (y - SimdFloat4::Load(&m_previousY[i])) * factor + stepY * w).Store(&m_positionY[i]);
+			(z + (z - SimdFloat4::Load(&m_previousZ[i])) * factor + stepZ * w).Store(&m_positionZ[i]);
+			x.Store(&m_previousX[i]);
+			y.Store(&m_previousY[i]);
+			z.Store(&m_previousZ[i]);
+		}
+	});
+}
+
+// Proyecta las restricciones de distancia de un color. Ninguna partícula aparece dos veces en un
+// color, así que cada grupo de cuatro se lee, se resuelve con SimdFloat4 y se escribe sin conflictos.
+void ClothSimulation::SolveColor(uint32_t color)
+{
+	uint32_t first = m_colorStart[color];
+	uint32_t batches = (m_colorStart[color + 1] - first) / 4;
+
+	m_jobSystem->ParallelFor(batches, ConstraintBatchGrain, [this, first](uint32_t begin, uint32_t end)
+	{
+		const SimdFloat4 epsilon = SimdFloat4::Splat(1e-9f);
+		float* px = m_positionX.data();
+		float* py = m_positionY.data();
+		float* pz = m_positionZ.data();
+		const float* invMass = m_invMass.data();
+
+		for (uint32_t batch = begin; batch < end; batch++)
+		{
+			uint32_t c = first + batch * 4;
+			const uint32_t* a = &m_constraintA[c];
+			const uint32_t* b = &m_constraintB[c];
+
+			SimdFloat4 ax = SimdFloat4::Set(px[a[0]], px[a[1]], px[a[2]], px[a[3]]);
+			SimdFloat4 ay = SimdFloat4::Set(py[a[0]], py[a[1]], py[a[2]], py[a[3]]);
+			SimdFloat4 az = SimdFloat4::Set(pz[a[0]], pz[a[1]], pz[a[2]], pz[a[3]]);
+			SimdFloat4 bx = SimdFloat4::Set(px[b[0]], px[b[1]], px[b[2]], px[b[3]]);
+			SimdFloat4 by = SimdFloat4::Set(py[b[0]], py[b[1]], py[b[2]], py[b[3]]);
+			SimdFloat4 bz = SimdFloat4::Set(pz[b[0]], pz[b[1]], pz[b[2]], pz[b[3]]);
+			SimdFloat4 wa = SimdFloat4::Set(invMass[a[0]], invMass[a[1]], invMass[a[2]], invMass[a[3]]);
+			SimdFloat4 wb = SimdFloat4::Set(invMass[b[0]], invMass[b[1]], invMass[b[2]], invMass[b[3]]);
+
+			SimdFloat4 dx = bx - ax;
+			SimdFloat4 dy = by - ay;
+			SimdFloat4 dz = bz - az;
+			SimdFloat4 length = Sqrt(dx * dx + dy * dy + dz * dz);
+			SimdFloat4 error = length - SimdFloat4::Load(&m_restLength[c]);
+
+			// s = k * C / ((wa + wb) * |d|); si ambas masas inversas son 0 la corrección se anula al multiplicar.
+			SimdFloat4 s = SimdFloat4::Load(&m_stiffness[c]) * error / ((wa + wb) * length + epsilon);
+			SimdFloat4 sa = s * wa;
+			SimdFloat4 sb = s * wb;
+
+			float out[6][4];
+			(ax + dx * sa).Store(out[0]);
+			(ay + dy * sa).Store(out[1]);
+			(az + dz * sa).Store(out[2]);
+			(bx - dx * sb).Store(out[3]);
+			(by - dy * sb).Store(out[4]);
+			(bz - dz * sb).Store(out[5]);
+			for (int k = 0; k < 4; k++)
+			{
+				px[a[k]] = out[0][k];
+				py[a[k]] = out[1][k];
+				pz[a[k]] = out[2][k];
+				px[b[k]] = out[3][k];
+				py[b[k]] = out[4][k];
+				pz[b[k]] = out[5][k];
+			}
+		}
+	});
+}
+
+// Saca las partículas de las esferas y cápsulas de los huesos.
+void ClothSimulation::SolveCollisions()
+{
+	DX_PROFILE_SCOPE("ClothSimulation::SolveCollisions");
+	m_jobSystem->ParallelFor(m_particleCount, ParticleGrain, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (m_invMass[i] == 0.0f)
+			{
+				continue;
+			}
+
+			Vector3 p(m_positionX[i], m_positionY[i], m_positionZ[i]);
+			bool moved = false;
+			for (const WorldCapsule& capsule : m_worldColliders)
+			{
+				float t = Dot(p - capsule.start, capsule.axis) * capsule.inverseAxisLengthSquared;
+				t = std::min(std::max(t, 0.0f), 1.0f);
+				Vector3 closest = capsule.start + capsule.axis * t;
+				Vector3 offset = p - closest;
+				float distanceSquared = LengthSquared(offset);
+				if (distanceSquared < capsule.radius * capsule.radius && distanceSquared > 0.0f)
+				{
+					p = closest + offset * (capsule.radius / sqrtf(distanceSquared));
+					moved = true;
+				}
+			}
+
+			if (moved)
+			{
+				m_positionX[i] = p.x;
+				m_positionY[i] = p.y;
+				m_positionZ[i] = p.z;
+			}
+		}
+	});
+}
+
+// Normal de cada vértice como suma de las normales (ponderadas por área) de sus triángulos.
+void ClothSimulation::ComputeNormals()
+{
+	DX_PROFILE_SCOPE("ClothSimulation::ComputeNormals");
+	m_jobSystem->ParallelFor(m_particleCount, ParticleGrain, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Vector3 normal;
+			for (uint32_t k = m_vertexTriangleStart[i]; k < m_vertexTriangleStart[i + 1]; k++)
+			{
+				const uint32_t* triangle = &m_indices[m_vertexTriangles[k] * 3];
+				Vector3 p0 = GetParticlePosition(triangle[0]);
+				normal += Cross(GetParticlePosition(triangle[1]) - p0, GetParticlePosition(triangle[2]) - p0);
+			}
+			float length = Length(normal);
+			m_normals[i] = (length > 0.0f) ? normal * (1.0f / length) : Vector3(0.0f, 0.0f, 1.0f);
+		}
+	});
+}
@@ -0,0 +1,197 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Common/JobSystem.h"
+#include "../Common/MemoryTracker.h"
+#include "../Common/Profiler.h"
+#include "../Common/VectorMath.h"
+#include "../Common/VertexFormat.h"
+
+namespace App2
+{
+	// Malla de tela: posiciones iniciales de las partículas y triángulos que las unen.
+	struct ClothMeshDesc
+	{
+		std::vector<DX::Vector3>	positions;
+		std::vector<uint32_t>		indices;
+
+		// Rejilla de width x height partículas separadas spacing en el plano XY, colgando hacia -Y desde origin.
+		static ClothMeshDesc CreateGrid(uint32_t width, uint32_t height, float spacing, const DX::Vector3& origin);
+	};
+
+	// Pose de un hueso del esqueleto en espacio del mundo.
+	struct ClothBonePose
+	{
+		DX::Quaternion	rotation;
+		DX::Vector3		position;
+	};
+
+	// Colisionador unido a un hueso. Una esfera es una cápsula con los dos extremos iguales.
+	struct ClothCollider
+	{
+		uint32_t	bone;
+		DX::Vector3	localStart;
+		DX::Vector3	localEnd;
+		float		radius;
+
+		static ClothCollider Sphere(uint32_t bone, const DX::Vector3& center, float radius)		{ return { bone, center, center, radius }; }
+		static ClothCollider Capsule(uint32_t bone, const DX::Vector3& start, const DX::Vector3& end, float radius)	{ return { bone, start, end, radius }; }
+	};
+
+	// Vértice completo de la tela. WriteVertices lo convierte al formato de destino, que toma de él los
+	// atributos que tenga: el color es la normal remapeada a [0, 1].
+	struct ClothVertex
+	{
+		float	position[3];
+		float	normal[3];
+		float	color[3];
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<App2::ClothVertex> : VertexLayout<App2::ClothVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(App2::ClothVertex, position)>,
+		VertexAttribute<VertexSemantic::Normal, 0, float[3], offsetof(App2::ClothVertex, normal)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(App2::ClothVertex, color)>>
+	{
+	};
+}
+
+namespace App2
+{
+
+	// Contadores del último paso de simulación.
+	struct ClothStats
+	{
+		uint32_t	particles;
+		uint32_t	constraints;
+		uint32_t	colors;
+		double		solverMilliseconds;
+	};
+
+	// Tela por dinámica basada en posiciones. Las restricciones de distancia (aristas y flexión) se
+	// agrupan por colores de forma que ninguna partícula aparezca dos veces en un color: cada color se
+	// resuelve en paralelo y de cuatro en cuatro con SimdFloat4 sin escrituras en conflicto.
+	class ClothSimulation
+	{
+	public:
+		ClothSimulation(DX::JobSystem* jobSystem, const ClothMeshDesc& mesh);
+
+		// Fija una partícula a un hueso; la partícula sigue la pose del hueso y no se simula.
+		void AttachParticle(uint32_t particle, uint32_t bone);
+		void AddCollider(const ClothCollider& collider)			{ m_colliders.push_back(collider); }
+		void SetBonePoses(const ClothBonePose* poses, uint32_t count);
+
+		void SetGravity(const DX::Vector3& gravity)				{ m_gravity = gravity; }
+		// La rigidez (0..1) se corrige según el número de iteraciones para que no dependa de él.
+		void SetSolverIterations(uint32_t iterations);
+		void SetStiffness(float stretch, float bend);
+		void SetDamping(float damping)							{ m_damping = damping; }
+
+		void Step(float deltaSeconds);
+
+		// Escribe todas las partículas en vertices, normalmente un búfer dinámico asignado con
+		// D3D11_MAP_WRITE_DISCARD, en el formato de TVertex (que necesita VertexLayoutOf).
+		template<typename TVertex>
+		void WriteVertices(TVertex* vertices);
+
+		uint32_t GetParticleCount() const						{ return m_particleCount; }
+		const std::vector<uint32_t>& GetIndices() const			{ return m_indices; }
+		DX::Vector3 GetParticlePosition(uint32_t particle) const	{ return DX::Vector3(m_positionX[particle], m_positionY[particle], m_positionZ[particle]); }
+		const ClothStats& GetStats() const						{ return m_stats; }
+
+	private:
+		// Tamaño de los bloques de trabajo paralelos sobre partículas.
+		static const uint32_t ParticleGrain = 1024;
+
+		struct Attachment
+		{
+			uint32_t	particle;
+			uint32_t	bone;
+			DX::Vector3	localPosition;
+		};
+
+		struct WorldCapsule
+		{
+			DX::Vector3	start;
+			DX::Vector3	axis;
+			float		inverseAxisLengthSquared;
+			float		radius;
+		};
+
+		void BuildConstraints();
+		void UpdateStiffness();
+		void Integrate(float deltaSeconds);
+		void SolveColor(uint32_t color);
+		void SolveCollisions();
+		void ComputeNormals();
+
+		DX::JobSystem*				m_jobSystem;
+		uint32_t					m_particleCount;
+		std::vector<uint32_t>		m_indices;
+
+		// Partículas en SoA. Hay una partícula ficticia de masa infinita al final para rellenar
+		// los grupos de cuatro restricciones.
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_positionX;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_positionY;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_positionZ;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_previousX;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_previousY;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_previousZ;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_invMass;
+		DX::TaggedVector<DX::Vector3, DX::MemoryTag::Cloth>	m_restPositions;
+		DX::TaggedVector<DX::Vector3, DX::MemoryTag::Cloth>	m_normals;
+
+		// Restricciones ordenadas por color; cada color empieza en un múltiplo de cuatro.
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Cloth>	m_constraintA;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Cloth>	m_constraintB;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_restLength;
+		DX::TaggedVector<float, DX::MemoryTag::Cloth>	m_stiffness;
+		DX::TaggedVector<uint8_t, DX::MemoryTag::Cloth>	m_isBend;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Cloth>	m_colorStart;
+
+		// Adyacencia vértice-triángulo (CSR) para calcular normales en paralelo sin conflictos.
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Cloth>	m_vertexTriangleStart;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Cloth>	m_vertexTriangles;
+
+		std::vector<Attachment>		m_attachments;
+		std::vector<ClothCollider>	m_colliders;
+		std::vector<WorldCapsule>	m_worldColliders;
+		std::vector<ClothBonePose>	m_bonePoses;
+
+		DX::Vector3					m_gravity;
+		uint32_t					m_solverIterations;
+		float						m_stretchStiffness;
+		float						m_bendStiffness;
+		float						m_damping;
+		ClothStats					m_stats;
+	};
+
+	// Escribe los vértices en orden secuencial y sin leer del destino, que suele ser memoria de combinación
+	// de escritura. La conversión a TVertex se resuelve al compilar.
+	template<typename TVertex>
+	void ClothSimulation::WriteVertices(TVertex* vertices)
+	{
+		DX_PROFILE_SCOPE("ClothSimulation::WriteVertices");
+		ComputeNormals();
+
+		m_jobSystem->ParallelFor(m_particleCount, ParticleGrain, [this, vertices](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const DX::Vector3& n = m_normals[i];
+				ClothVertex vertex =
+				{
+					{ m_positionX[i], m_positionY[i], m_positionZ[i] },
+					{ n.x, n.y, n.z },
+					{ n.x * 0.5f + 0.5f, n.y * 0.5f + 0.5f, n.z * 0.5f + 0.5f },
+				};
+				DX::ConvertVertex(vertex, vertices[i]);
+			}
+		});
+	}
+}
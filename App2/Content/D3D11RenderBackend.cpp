@@ -0,0 +1,150 @@
+﻿#include "pch.h"
+#include "D3D11RenderBackend.h"
+
+using namespace App2;
+
+void D3D11StateSink::SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset)
+{
+	ID3D11Buffer* vertexBuffer = static_cast<ID3D11Buffer*>(const_cast<void*>(buffer));
+	UINT strides = stride;
+	UINT offsets = offset;
+	m_context->IASetVertexBuffers(slot, 1, &vertexBuffer, &strides, &offsets);
+}
+
+void D3D11StateSink::SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset)
+{
+	m_context->IASetIndexBuffer(static_cast<ID3D11Buffer*>(const_cast<void*>(buffer)), static_cast<DXGI_FORMAT>(format), offset);
+}
+
+void D3D11StateSink::SetTopology(uint32_t topology)
+{
+	m_context->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+void D3D11StateSink::SetInputLayout(const void* inputLayout)
+{
+	m_context->IASetInputLayout(static_cast<ID3D11InputLayout*>(const_cast<void*>(inputLayout)));
+}
+
+void D3D11StateSink::SetVertexShader(const void* shader)
+{
+	m_context->VSSetShader(static_cast<ID3D11VertexShader*>(const_cast<void*>(shader)), nullptr, 0);
+}
+
+void D3D11StateSink::SetVertexConstantBuffer(uint32_t slot, const void* buffer)
+{
+	ID3D11Buffer* constantBuffer = static_cast<ID3D11Buffer*>(const_cast<void*>(buffer));
+	m_context->VSSetConstantBuffers1(slot, 1, &constantBuffer, nullptr, nullptr);
+}
+
+void D3D11StateSink::SetPixelShader(const void* shader)
+{
+	m_context->PSSetShader(static_cast<ID3D11PixelShader*>(const_cast<void*>(shader)), nullptr, 0);
+}
+
+D3D11RenderBackend::D3D11RenderBackend() :
+	m_context(nullptr),
+	m_activeConstants(nullptr),
+	m_shaderBound(false),
+	m_meshBound(false),
+	m_stateCache(&m_stateSink)
+{
+}
+
+uint32 D3D11RenderBackend::RegisterShader(ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11InputLayout* inputLayout)
+{
+	Shader shader;
+	shader.vertexShader = vertexShader;
+	shader.pixelShader = pixelShader;
+	shader.inputLayout = inputLayout;
+	return m_shaders.Create(shader);
+}
+
+uint32 D3D11RenderBackend::RegisterMaterial(ID3D11Buffer* constantBuffer)
+{
+	return m_materials.Create(constantBuffer);
+}
+
+uint32 D3D11RenderBackend::RegisterMesh(ID3D11Buffer* vertexBuffer, uint32 stride, ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat, D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	Mesh mesh;
+	mesh.vertexBuffer = vertexBuffer;
+	mesh.indexBuffer = indexBuffer;
+	mesh.stride = stride;
+	mesh.indexFormat = indexFormat;
+	mesh.topology = topology;
+	return m_meshes.Create(mesh);
+}
+
+void D3D11RenderBackend::Clear()
+{
+	m_shaders.Clear();
+	m_materials.Clear();
+	m_meshes.Clear();
+	m_context = nullptr;
+	m_activeConstants = nullptr;
+	m_stateSink.SetContext(nullptr);
+	m_stateCache.Invalidate();
+}
+
+void D3D11RenderBackend::Begin(ID3D11DeviceContext3* context)
+{
+	m_context = context;
+	m_activeConstants = nullptr;
+	m_shaderBound = false;
+	m_meshBound = false;
+	m_stateSink.SetContext(context);
+	m_stateCache.Invalidate();
+	m_stateCache.ResetStats();
+}
+
+void D3D11RenderBackend::BindShader(uint32_t shader)
+{
+	const Shader* entry = m_shaders.Get(shader);
+	m_shaderBound = (entry != nullptr);
+	if (m_shaderBound)
+	{
+		m_stateCache.SetInputLayout(entry->inputLayout.Get());
+		m_stateCache.SetVertexShader(entry->vertexShader.Get());
+		m_stateCache.SetPixelShader(entry->pixelShader.Get());
+	}
+}
+
+void D3D11RenderBackend::BindMaterial(uint32_t material)
+{
+	const Microsoft::WRL::ComPtr<ID3D11Buffer>* entry = m_materials.Get(material);
+	m_activeConstants = (entry != nullptr) ? entry->Get() : nullptr;
+	if (m_activeConstants != nullptr)
+	{
+		m_stateCache.SetVertexConstantBuffer(0, m_activeConstants);
+	}
+}
+
+void D3D11RenderBackend::BindMesh(uint32_t mesh)
+{
+	const Mesh* entry = m_meshes.Get(mesh);
+	m_meshBound = (entry != nullptr);
+	if (m_meshBound)
+	{
+		m_stateCache.SetVertexBuffer(0, entry->vertexBuffer.Get(), entry->stride, 0);
+		m_stateCache.SetIndexBuffer(entry->indexBuffer.Get(), entry->indexFormat, 0);
+		m_stateCache.SetTopology(entry->topology);
+	}
+}
+
+void D3D11RenderBackend::UpdateConstants(const void* data, uint32_t)
+{
+	if (m_activeConstants != nullptr)
+	{
+		m_context->UpdateSubresource1(m_activeConstants, 0, NULL, data, 0, 0, 0);
+	}
+}
+
+// Un identificador liberado deja el paquete sin dibujar en lugar de usar el estado del anterior.
+void D3D11RenderBackend::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	if (m_shaderBound && m_meshBound && m_activeConstants != nullptr)
+	{
+		m_context->DrawIndexed(indexCount, startIndex, baseVertex);
+	}
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+
+#include "..\Common\HandlePool.h"
+#include "..\Common\RenderCommandBuffer.h"
+#include "..\Common\RenderStateCache.h"
+
+namespace App2
+{
+	// Traduce las asignaciones de estado de DX::RenderStateCache a llamadas del contexto de Direct3D 11.
+	class D3D11StateSink : public DX::IRenderStateSink
+	{
+	public:
+		D3D11StateSink() : m_context(nullptr) {}
+
+		void SetContext(ID3D11DeviceContext3* context) { m_context = context; }
+
+		virtual void SetVertexBuffer(uint32_t slot, const void* buffer, uint32_t stride, uint32_t offset) override;
+		virtual void SetIndexBuffer(const void* buffer, uint32_t format, uint32_t offset) override;
+		virtual void SetTopology(uint32_t topology) override;
+		virtual void SetInputLayout(const void* inputLayout) override;
+		virtual void SetVertexShader(const void* shader) override;
+		virtual void SetVertexConstantBuffer(uint32_t slot, const void* buffer) override;
+		virtual void SetPixelShader(const void* shader) override;
+
+	private:
+		ID3D11DeviceContext3* m_context;
+	};
+
+	// Reproduce búferes de comandos sobre el contexto inmediato de Direct3D 11. Los representadores
+	// registran sus recursos una vez y usan en los paquetes los identificadores devueltos: generacionales
+	// de 16 bits (10 de índice y 6 de generación), para que quepan en DrawPacket. Un paquete con un
+	// identificador liberado no se dibuja. Los enlaces pasan por una caché de estado, así que los paquetes
+	// que repiten estado no generan llamadas.
+	class D3D11RenderBackend : public DX::IRenderBackend
+	{
+	public:
+		D3D11RenderBackend();
+
+		// Sombreadores de vértices y píxeles con su diseño de entrada.
+		uint32 RegisterShader(ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11InputLayout* inputLayout);
+
+		// Búfer de constantes del material, enlazado en la ranura 0 del sombreador de vértices. UpdateConstants
+		// escribe en el del material activo.
+		uint32 RegisterMaterial(ID3D11Buffer* constantBuffer);
+
+		uint32 RegisterMesh(ID3D11Buffer* vertexBuffer, uint32 stride, ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat, D3D11_PRIMITIVE_TOPOLOGY topology);
+
+		// Sueltan un recurso; su identificador deja de ser válido. Devuelven false si ya no lo era.
+		bool ReleaseShader(uint32 shader)		{ return m_shaders.Destroy(shader); }
+		bool ReleaseMaterial(uint32 material)	{ return m_materials.Destroy(material); }
+		bool ReleaseMesh(uint32 mesh)			{ return m_meshes.Destroy(mesh); }
+
+		// Suelta todas las referencias, por ejemplo al perder el dispositivo.
+		void Clear();
+		bool IsEmpty() const { return m_shaders.IsEmpty() && m_materials.IsEmpty() && m_meshes.IsEmpty(); }
+
+		// Contexto sobre el que se reproducen los siguientes paquetes. Otros representadores cambian el
+		// estado entre fotogramas, así que la caché se vacía y sus contadores empiezan de cero.
+		void Begin(ID3D11DeviceContext3* context);
+
+		const DX::RenderStateStats& GetStateStats() const { return m_stateCache.GetStats(); }
+
+		virtual void BindShader(uint32_t shader) override;
+		virtual void BindMaterial(uint32_t material) override;
+		virtual void BindMesh(uint32_t mesh) override;
+		virtual void UpdateConstants(const void* data, uint32_t size) override;
+		virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+
+	private:
+		struct Shader
+		{
+			Microsoft::WRL::ComPtr<ID3D11VertexShader>	vertexShader;
+			Microsoft::WRL::ComPtr<ID3D11PixelShader>	pixelShader;
+			Microsoft::WRL::ComPtr<ID3D11InputLayout>	inputLayout;
+		};
+
+		struct Mesh
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	vertexBuffer;
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	indexBuffer;
+			uint32									stride;
+			DXGI_FORMAT								indexFormat;
+			D3D11_PRIMITIVE_TOPOLOGY				topology;
+		};
+
+		DX::HandlePool<Shader, DX::MemoryTag::Shaders, 10, 6>								m_shaders;
+		DX::HandlePool<Microsoft::WRL::ComPtr<ID3D11Buffer>, DX::MemoryTag::ConstantData, 10, 6>	m_materials;
+		DX::HandlePool<Mesh, DX::MemoryTag::Meshes, 10, 6>									m_meshes;
+
+		ID3D11DeviceContext3*	m_context;
+		ID3D11Buffer*			m_activeConstants;
+		bool					m_shaderBound;
+		bool					m_meshBound;
+		D3D11StateSink			m_stateSink;
+		DX::RenderStateCache	m_stateCache;
+	};
+}
@@ -0,0 +1,15 @@
+Texture2D glyphAtlas : register(t0);
+SamplerState glyphSampler : register(s0);
+
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+float4 main(PixelShaderInput input) : SV_TARGET
+{
+	float coverage = glyphAtlas.Sample(glyphSampler, input.uv).r;
+	return float4(input.color.rgb, input.color.a * coverage);
+}
@@ -0,0 +1,262 @@
+﻿#include "pch.h"
+#include "OverlayTextRenderer.h"
+
+#include "..\Common\DirectXHelper.h"
+
+using namespace App2;
+
+using namespace DirectX;
+using namespace Windows::Foundation;
+
+namespace
+{
+	const uint32 AtlasSize = 512;
+	const uint32 InitialQuadCapacity = 4096;
+}
+
+OverlayTextRenderer::OverlayTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+	m_deviceResources(deviceResources),
+	m_atlas(&m_rasterizer, AtlasSize, AtlasSize),
+	m_layoutCache(&m_atlas),
+	m_quadCapacity(0),
+	m_loadingComplete(false),
+	m_shadowsRegistered(false)
+{
+	CreateDeviceDependentResources();
+	CreateWindowSizeDependentResources();
+}
+
+OverlayTextRenderer::~OverlayTextRenderer()
+{
+	m_deviceResources->GetResourceRegistry()->RemoveOwner(this);
+}
+
+// Proyección ortográfica en píxeles con el origen en la esquina superior izquierda.
+void OverlayTextRenderer::CreateWindowSizeDependentResources()
+{
+	Size outputSize = m_deviceResources->GetOutputSize();
+	DX::Matrix4 ortho = DX::Matrix4::OrthographicOffCenterRH(0.0f, outputSize.Width, outputSize.Height, 0.0f, 0.0f, 1.0f);
+
+	XMFLOAT4X4 orientation = m_deviceResources->GetOrientationTransform3D();
+	DX::Matrix4 orientationMatrix;
+	memcpy(&orientationMatrix, &orientation, sizeof(orientationMatrix));
+
+	// El sombreador espera la matriz por columnas.
+	m_projection = (ortho * orientationMatrix).Transposed();
+}
+
+void OverlayTextRenderer::AddText(const char* text, float x, float y, uint32 color, const DX::TextFormat& format)
+{
+	m_batch.AddText(m_layoutCache, text, format, x, y, color);
+}
+
+// Dibuja todo el texto acumulado en el fotograma con una sola llamada y vacía el lote.
+void OverlayTextRenderer::Render()
+{
+	if (!m_loadingComplete || m_batch.GetQuadCount() == 0)
+	{
+		m_batch.Clear();
+		m_layoutCache.NextFrame();
+		return;
+	}
+
+	auto context = m_deviceResources->GetD3DDeviceContext();
+
+	// Subir solo la parte del atlas que ha cambiado.
+	uint32_t left, top, right, bottom;
+	if (m_atlas.GetDirtyRect(left, top, right, bottom))
+	{
+		D3D11_BOX box = { left, top, 0, right, bottom, 1 };
+		context->UpdateSubresource(
+			m_atlasTexture.Get(),
+			0,
+			&box,
+			m_atlas.GetPixels() + top * m_atlas.GetWidth() + left,
+			m_atlas.GetWidth(),
+			0
+			);
+		m_atlas.ClearDirtyRect();
+	}
+
+	EnsureBufferCapacity(m_batch.GetQuadCount());
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(
+		context->Map(m_vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)
+		);
+	memcpy(mapped.pData, m_batch.GetVertices(), m_batch.GetVertexCount() * sizeof(DX::TextVertex));
+	context->Unmap(m_vertexBuffer.Get(), 0);
+
+	context->UpdateSubresource1(m_constantBuffer.Get(), 0, NULL, &m_projection, 0, 0, 0);
+
+	UINT stride = sizeof(DX::TextVertex);
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+	context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context->IASetInputLayout(m_inputLayout.Get());
+
+	context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	context->VSSetConstantBuffers1(0, 1, m_constantBuffer.GetAddressOf(), nullptr, nullptr);
+	context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+	context->PSSetShaderResources(0, 1, m_atlasView.GetAddressOf());
+	context->PSSetSamplers(0, 1, m_sampler.GetAddressOf());
+
+	context->OMSetBlendState(m_blendState.Get(), nullptr, 0xffffffff);
+	context->OMSetDepthStencilState(m_depthState.Get(), 0);
+	context->RSSetState(m_rasterizerState.Get());
+
+	context->DrawIndexed(m_batch.GetQuadCount() * 6, 0, 0);
+
+	// Restablecer el estado predeterminado para el resto de representadores.
+	context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+	context->OMSetDepthStencilState(nullptr, 0);
+	context->RSSetState(nullptr);
+
+	m_batch.Clear();
+	m_layoutCache.NextFrame();
+}
+
+// Los búferes de vértices e índices solo crecen, así que en régimen estable no se vuelven a crear.
+void OverlayTextRenderer::EnsureBufferCapacity(uint32 quadCount)
+{
+	if (quadCount <= m_quadCapacity)
+	{
+		return;
+	}
+
+	uint32 capacity = (m_quadCapacity > 0) ? m_quadCapacity : InitialQuadCapacity;
+	while (capacity < quadCount)
+	{
+		capacity *= 2;
+	}
+
+	auto device = m_deviceResources->GetD3DDevice();
+
+	CD3D11_BUFFER_DESC vertexBufferDesc(capacity * 4 * sizeof(DX::TextVertex), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	DX::ThrowIfFailed(
+		device->CreateBuffer(&vertexBufferDesc, nullptr, &m_vertexBuffer)
+		);
+
+	std::vector<uint32_t> indices;
+	DX::TextBatch::BuildQuadIndices(capacity, indices);
+	D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+	indexBufferData.pSysMem = indices.data();
+	CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(indices.size() * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER);
+	DX::ThrowIfFailed(
+		device->CreateBuffer(&indexBufferDesc, &indexBufferData, &m_indexBuffer)
+		);
+
+	m_quadCapacity = capacity;
+}
+
+void OverlayTextRenderer::CreateDeviceDependentResources()
+{
+	// Tras perder el dispositivo, el registro ya lo ha recreado todo, después de la escena.
+	DX::ResourceRegistry* registry = m_deviceResources->GetResourceRegistry();
+	if (m_shadowsRegistered)
+	{
+		m_loadingComplete = true;
+		return;
+	}
+	registry->RemoveOwner(this);
+
+	// Cargue los sombreadores de forma asincrónica.
+	auto loadVSTask = DX::ReadDataAsync(L"OverlayTextVertexShader.cso");
+	auto loadPSTask = DX::ReadDataAsync(L"OverlayTextPixelShader.cso");
+
+	// Los sombreadores, el diseño de entrada y los estados salen de la caché del dispositivo; el registro
+	// guarda el código de los sombreadores para recrearlos sin los archivos.
+	auto createVSTask = loadVSTask.then([this, registry](const std::vector<byte>& fileData) {
+		registry->Register(this, DX::ShadowKind::Shader, DX::ShadowPriority::Overlay, &fileData[0], fileData.size(), [this](const uint8_t* data, size_t size) {
+			DX::D3D11ResourceCache* cache = m_deviceResources->GetResourceCache();
+			m_vertexShader = cache->GetVertexShader(data, size);
+
+			m_inputLayout = cache->GetInputLayout<DX::TextVertex>(data, size);
+		});
+	});
+
+	auto createPSTask = loadPSTask.then([this, registry](const std::vector<byte>& fileData) {
+		registry->Register(this, DX::ShadowKind::Shader, DX::ShadowPriority::Overlay, &fileData[0], fileData.size(), [this](const uint8_t* data, size_t size) {
+			m_pixelShader = m_deviceResources->GetResourceCache()->GetPixelShader(data, size);
+		});
+
+		registry->Register(this, DX::ShadowKind::ConstantData, DX::ShadowPriority::Overlay, nullptr, 0, [this](const uint8_t*, size_t) {
+			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
+			DX::ThrowIfFailed(
+				m_deviceResources->GetD3DDevice()->CreateBuffer(
+					&constantBufferDesc,
+					nullptr,
+					&m_constantBuffer
+					)
+				);
+		});
+	});
+
+	// Una vez cargados los sombreadores, cree el atlas y los estados de canalización. Los píxeles del
+	// atlas ya están en la CPU en m_atlas, así que la entrada no necesita copia propia.
+	auto createStateTask = (createPSTask && createVSTask).then([this, registry] () {
+		registry->Register(this, DX::ShadowKind::Texture, DX::ShadowPriority::Overlay, nullptr, 0, [this](const uint8_t*, size_t) {
+			auto device = m_deviceResources->GetD3DDevice();
+			DX::D3D11ResourceCache* cache = m_deviceResources->GetResourceCache();
+
+			CD3D11_TEXTURE2D_DESC textureDesc(DXGI_FORMAT_R8_UNORM, m_atlas.GetWidth(), m_atlas.GetHeight(), 1, 1);
+			D3D11_SUBRESOURCE_DATA textureData = {0};
+			textureData.pSysMem = m_atlas.GetPixels();
+			textureData.SysMemPitch = m_atlas.GetWidth();
+			DX::ThrowIfFailed(
+				device->CreateTexture2D(&textureDesc, &textureData, &m_atlasTexture)
+				);
+			DX::ThrowIfFailed(
+				device->CreateShaderResourceView(m_atlasTexture.Get(), nullptr, &m_atlasView)
+				);
+			m_atlas.ClearDirtyRect();
+
+			// Muestreo de punto: la fuente de mapa de bits se dibuja a escala entera.
+			CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+			samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+			m_sampler = cache->GetSamplerState(samplerDesc);
+
+			CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
+			blendDesc.RenderTarget[0].BlendEnable = TRUE;
+			blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+			blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+			m_blendState = cache->GetBlendState(blendDesc);
+
+			CD3D11_DEPTH_STENCIL_DESC depthDesc(D3D11_DEFAULT);
+			depthDesc.DepthEnable = FALSE;
+			m_depthState = cache->GetDepthStencilState(depthDesc);
+
+			CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+			rasterizerDesc.CullMode = D3D11_CULL_NONE;
+			m_rasterizerState = cache->GetRasterizerState(rasterizerDesc);
+
+			EnsureBufferCapacity(InitialQuadCapacity);
+		});
+	});
+
+	createStateTask.then([this] () {
+		m_shadowsRegistered = true;
+		m_loadingComplete = true;
+	});
+}
+
+void OverlayTextRenderer::ReleaseDeviceDependentResources()
+{
+	m_loadingComplete = false;
+	m_inputLayout.Reset();
+	m_vertexShader.Reset();
+	m_pixelShader.Reset();
+	m_constantBuffer.Reset();
+	m_vertexBuffer.Reset();
+	m_indexBuffer.Reset();
+	m_atlasTexture.Reset();
+	m_atlasView.Reset();
+	m_sampler.Reset();
+	m_blendState.Reset();
+	m_depthState.Reset();
+	m_rasterizerState.Reset();
+	m_quadCapacity = 0;
+}
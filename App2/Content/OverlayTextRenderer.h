@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "..\Common\DeviceResources.h"
+#include "..\Common\BitmapFont.h"
+#include "..\Common\TextBatch.h"
+#include "..\Common\VectorMath.h"
+
+namespace App2
+{
+	// Dibuja texto superpuesto (etiquetas, estadísticas) con Direct3D: todas las cadenas de un fotograma
+	// se acumulan en un lote de cuadrados que se dibuja con una sola llamada sobre un atlas de glifos.
+	// Las maquetaciones se guardan en caché, de modo que repetir una etiqueta no reserva memoria.
+	class OverlayTextRenderer
+	{
+	public:
+		OverlayTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		~OverlayTextRenderer();
+		void CreateDeviceDependentResources();
+		void CreateWindowSizeDependentResources();
+		void ReleaseDeviceDependentResources();
+
+		// Añade texto al fotograma actual. (x, y) está en píxeles desde la esquina superior izquierda.
+		void AddText(const char* text, float x, float y, uint32 color, const DX::TextFormat& format);
+		void Render();
+
+	private:
+		void EnsureBufferCapacity(uint32 quadCount);
+
+		// Puntero almacenado en caché para los recursos del dispositivo.
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
+		// Sistema de texto portátil.
+		DX::BitmapFontRasterizer	m_rasterizer;
+		DX::GlyphAtlas				m_atlas;
+		DX::TextLayoutCache			m_layoutCache;
+		DX::TextBatch				m_batch;
+
+		// Recursos de Direct3D.
+		Microsoft::WRL::ComPtr<ID3D11InputLayout>			m_inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader>			m_vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader>			m_pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>				m_constantBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>				m_vertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>				m_indexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D>				m_atlasTexture;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>	m_atlasView;
+		Microsoft::WRL::ComPtr<ID3D11SamplerState>			m_sampler;
+		Microsoft::WRL::ComPtr<ID3D11BlendState>			m_blendState;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState>		m_depthState;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState>		m_rasterizerState;
+
+		DX::Matrix4				m_projection;
+		uint32					m_quadCapacity;
+		bool					m_loadingComplete;
+		bool					m_shadowsRegistered;
+	};
+}
@@ -0,0 +1,28 @@
+cbuffer OverlayTextConstantBuffer : register(b0)
+{
+	matrix projection;
+};
+
+struct VertexShaderInput
+{
+	float2 pos : POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+PixelShaderInput main(VertexShaderInput input)
+{
+	PixelShaderInput output;
+	output.pos = mul(float4(input.pos, 0.0f, 1.0f), projection);
+	output.uv = input.uv;
+	output.color = input.color;
+
+	return output;
+}
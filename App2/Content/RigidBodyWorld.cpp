@@ -0,0 +1,986 @@
+﻿#include "RigidBodyWorld.h"
+#include "../Common/Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <stdexcept>
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Parámetros del solucionador.
+	const float BaumgarteFactor = 0.2f;
+	const float PenetrationSlop = 0.005f;
+
+	// Distancia a la que se generan contactos especulativos antes de que las cajas se toquen.
+	// Evita que los puntos de una cara apoyada aparezcan y desaparezcan entre pasos.
+	const float ContactMargin = 0.01f;
+	const float SleepLinearThreshold = 0.02f;
+	const float SleepAngularThreshold = 0.04f;
+	const float SleepDelaySeconds = 0.5f;
+
+	// Tamaño de los bloques de trabajo paralelos.
+	const uint32_t BroadphaseGrain = 512;
+	const uint32_t NarrowphaseGrain = 256;
+	const uint32_t IntegrationGrain = 1024;
+
+	const uint32_t InvalidIndex = 0xffffffff;
+
+	uint64_t MakePairKey(uint32_t a, uint32_t b)
+	{
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Construye una base ortonormal (t0, t1) perpendicular a n.
+	void ComputeTangents(const Vector3& n, Vector3& t0, Vector3& t1)
+	{
+		if (fabsf(n.x) > 0.57735f)
+		{
+			t0 = Normalize(Vector3(n.y, -n.x, 0.0f));
+		}
+		else
+		{
+			t0 = Normalize(Vector3(0.0f, n.z, -n.y));
+		}
+		t1 = Cross(n, t0);
+	}
+
+	// Caja orientada expresada en el espacio del mundo.
+	struct Box
+	{
+		Vector3	center;
+		Vector3	axis[3];
+		Vector3	half;
+	};
+
+	// Polígono de recorte con espacio suficiente para recortar un cuadrilátero contra cuatro planos.
+	struct ClipPolygon
+	{
+		Vector3		points[8];
+		uint32_t	count;
+	};
+
+	// Recorta el polígono contra el semiespacio dot(n, p) <= offset (Sutherland-Hodgman).
+	void ClipAgainstPlane(const ClipPolygon& input, const Vector3& n, float offset, ClipPolygon& output)
+	{
+		output.count = 0;
+		if (input.count == 0)
+		{
+			return;
+		}
+
+		Vector3 a = input.points[input.count - 1];
+		float da = Dot(n, a) - offset;
+		for (uint32_t i = 0; i < input.count; i++)
+		{
+			Vector3 b = input.points[i];
+			float db = Dot(n, b) - offset;
+
+			if (da <= 0.0f && output.count < 8)
+			{
+				output.points[output.count++] = a;
+			}
+
+			if ((da < 0.0f && db > 0.0f) || (da > 0.0f && db < 0.0f))
+			{
+				if (output.count < 8)
+				{
+					output.points[output.count++] = a + (b - a) * (da / (da - db));
+				}
+			}
+
+			a = b;
+			da = db;
+		}
+	}
+
+	// Genera puntos de contacto cara-cara recortando la cara incidente contra la cara de referencia.
+	// refNormal apunta desde la caja de referencia hacia la incidente.
+	uint32_t ClipFaceContacts(const Box& reference, int referenceAxis, const Vector3& refNormal, const Box& incident,
+		Vector3* outPoints, float* outDepths)
+	{
+		// Cara incidente: la más antiparalela a la normal de referencia.
+		int incidentAxis = 0;
+		float best = -1.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			float d = fabsf(Dot(incident.axis[i], refNormal));
+			if (d > best)
+			{
+				best = d;
+				incidentAxis = i;
+			}
+		}
+
+		float side = (Dot(incident.axis[incidentAxis], refNormal) > 0.0f) ? -1.0f : 1.0f;
+		Vector3 incidentCenter = incident.center + incident.axis[incidentAxis] * (side * incident.half[incidentAxis]);
+		int u = (incidentAxis + 1) % 3;
+		int v = (incidentAxis + 2) % 3;
+		Vector3 du = incident.axis[u] * incident.half[u];
+		Vector3 dv = incident.axis[v] * incident.half[v];
+
+		ClipPolygon polygon;
+		polygon.count = 4;
+		polygon.points[0] = incidentCenter + du + dv;
+		polygon.points[1] = incidentCenter - du + dv;
+		polygon.points[2] = incidentCenter - du - dv;
+		polygon.points[3] = incidentCenter + du - dv;
+
+		// Recortar contra los cuatro planos laterales de la cara de referencia.
+		int ru = (referenceAxis + 1) % 3;
+		int rv = (referenceAxis + 2) % 3;
+		ClipPolygon clipped;
+		const Vector3 sideAxes[2] = { reference.axis[ru], reference.axis[rv] };
+		const float sideExtents[2] = { reference.half[ru], reference.half[rv] };
+		for (int s = 0; s < 2; s++)
+		{
+			float centerOffset = Dot(sideAxes[s], reference.center);
+			ClipAgainstPlane(polygon, sideAxes[s], centerOffset + sideExtents[s], clipped);
+			ClipAgainstPlane(clipped, -sideAxes[s], -centerOffset + sideExtents[s], polygon);
+		}
+
+		// Conservar los puntos que están por debajo de la cara de referencia.
+		float faceOffset = Dot(refNormal, reference.center) + reference.half[referenceAxis];
+		Vector3 candidates[8];
+		float depths[8];
+		uint32_t candidateCount = 0;
+		for (uint32_t i = 0; i < polygon.count; i++)
+		{
+			float separation = Dot(refNormal, polygon.points[i]) - faceOffset;
+			if (separation <= ContactMargin)
+			{
+				candidates[candidateCount] = polygon.points[i];
+				depths[candidateCount] = -separation;
+				candidateCount++;
+			}
+		}
+
+		if (candidateCount <= 4)
+		{
+			for (uint32_t i = 0; i < candidateCount; i++)
+			{
+				outPoints[i] = candidates[i];
+				outDepths[i] = depths[i];
+			}
+			return candidateCount;
+		}
+
+		// Reducir a cuatro puntos: el más profundo, el más alejado de él y los extremos a ambos lados.
+		uint32_t chosen[4];
+		chosen[0] = 0;
+		for (uint32_t i = 1; i < candidateCount; i++)
+		{
+			if (depths[i] > depths[chosen[0]])
+			{
+				chosen[0] = i;
+			}
+		}
+
+		chosen[1] = chosen[0];
+		float farthest = -1.0f;
+		for (uint32_t i = 0; i < candidateCount; i++)
+		{
+			float d = LengthSquared(candidates[i] - candidates[chosen[0]]);
+			if (d > farthest)
+			{
+				farthest = d;
+				chosen[1] = i;
+			}
+		}
+
+		Vector3 edge = candidates[chosen[1]] - candidates[chosen[0]];
+		Vector3 perpendicular = Cross(refNormal, edge);
+		float minSide = 0.0f, maxSide = 0.0f;
+		chosen[2] = chosen[0];
+		chosen[3] = chosen[1];
+		for (uint32_t i = 0; i < candidateCount; i++)
+		{
+			float d = Dot(perpendicular, candidates[i] - candidates[chosen[0]]);
+			if (d < minSide)
+			{
+				minSide = d;
+				chosen[2] = i;
+			}
+			if (d > maxSide)
+			{
+				maxSide = d;
+				chosen[3] = i;
+			}
+		}
+
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			bool duplicate = false;
+			for (uint32_t j = 0; j < i; j++)
+			{
+				duplicate |= (chosen[j] == chosen[i]);
+			}
+
+			if (!duplicate)
+			{
+				outPoints[count] = candidates[chosen[i]];
+				outDepths[count] = depths[chosen[i]];
+				count++;
+			}
+		}
+		return count;
+	}
+
+	// Prueba de ejes separadores entre dos cajas orientadas. Devuelve el número de puntos de contacto
+	// (0 si están separadas), la normal de A hacia B y las posiciones y profundidades en el mundo.
+	uint32_t CollideBoxes(const Box& a, const Box& b, Vector3& normal, Vector3* points, float* depths)
+	{
+		const float epsilon = 1e-6f;
+		Vector3 d = b.center - a.center;
+
+		// R[i][j] = Ai . Bj y traslación expresada en el espacio de A.
+		float R[3][3], absR[3][3], t[3];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				R[i][j] = Dot(a.axis[i], b.axis[j]);
+				absR[i][j] = fabsf(R[i][j]) + epsilon;
+			}
+			t[i] = Dot(d, a.axis[i]);
+		}
+
+		// Ejes de las caras de A.
+		float bestFaceA = -FLT_MAX;
+		int bestAxisA = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float rb = b.half.x * absR[i][0] + b.half.y * absR[i][1] + b.half.z * absR[i][2];
+			float separation = fabsf(t[i]) - (a.half[i] + rb);
+			if (separation > ContactMargin)
+			{
+				return 0;
+			}
+			if (separation > bestFaceA)
+			{
+				bestFaceA = separation;
+				bestAxisA = i;
+			}
+		}
+
+		// Ejes de las caras de B.
+		float bestFaceB = -FLT_MAX;
+		int bestAxisB = 0;
+		for (int j = 0; j < 3; j++)
+		{
+			float ra = a.half.x * absR[0][j] + a.half.y * absR[1][j] + a.half.z * absR[2][j];
+			float projected = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+			float separation = fabsf(projected) - (ra + b.half[j]);
+			if (separation > ContactMargin)
+			{
+				return 0;
+			}
+			if (separation > bestFaceB)
+			{
+				bestFaceB = separation;
+				bestAxisB = j;
+			}
+		}
+
+		// Ejes arista-arista Ai x Bj. Se evalúan los nueve a la vez en formato SoA con SIMD.
+		alignas(16) float numerator[12], radius[12], lengthSq[12];
+		for (int i = 0; i < 3; i++)
+		{
+			int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; j++)
+			{
+				int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+				int k = i * 3 + j;
+				numerator[k] = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+				radius[k] = a.half[i1] * absR[i2][j] + a.half[i2] * absR[i1][j]
+					+ b.half[j1] * absR[i][j2] + b.half[j2] * absR[i][j1];
+				lengthSq[k] = fmaxf(1.0f - R[i][j] * R[i][j], 0.0f);
+			}
+		}
+		for (int k = 9; k < 12; k++)
+		{
+			numerator[k] = 0.0f;
+			radius[k] = 1.0f;
+			lengthSq[k] = 1.0f;
+		}
+
+		alignas(16) float edgeSeparation[12];
+		const SimdFloat4 minLengthSq = SimdFloat4::Splat(1e-6f);
+		for (int k = 0; k < 12; k += 4)
+		{
+			SimdFloat4 length = Sqrt(Max(SimdFloat4::Load(lengthSq + k), minLengthSq));
+			SimdFloat4 separation = Abs(SimdFloat4::Load(numerator + k)) - SimdFloat4::Load(radius + k);
+			(separation / length).Store(edgeSeparation + k);
+		}
+
+		float bestEdge = -FLT_MAX;
+		int bestEdgeIndex = -1;
+		for (int k = 0; k < 9; k++)
+		{
+			// Ejes casi paralelos: la prueba de caras ya cubre este caso.
+			if (lengthSq[k] < 1e-6f)
+			{
+				continue;
+			}
+			if (edgeSeparation[k] > ContactMargin)
+			{
+				return 0;
+			}
+			if (edgeSeparation[k] > bestEdge)
+			{
+				bestEdge = edgeSeparation[k];
+				bestEdgeIndex = k;
+			}
+		}
+
+		// Preferir las caras salvo que una arista sea claramente mejor; estabiliza las pilas.
+		const float relativeTolerance = 0.95f;
+		const float absoluteTolerance = 0.01f * fminf(fminf(a.half.x, a.half.y), fminf(a.half.z, fminf(b.half.x, fminf(b.half.y, b.half.z))));
+
+		bool useFaceB = bestFaceB > relativeTolerance * bestFaceA + absoluteTolerance;
+		float bestFace = useFaceB ? bestFaceB : bestFaceA;
+
+		if (bestEdgeIndex >= 0 && bestEdge > relativeTolerance * bestFace + absoluteTolerance)
+		{
+			int i = bestEdgeIndex / 3;
+			int j = bestEdgeIndex % 3;
+			normal = Normalize(Cross(a.axis[i], b.axis[j]));
+			if (Dot(normal, d) < 0.0f)
+			{
+				normal = -normal;
+			}
+
+			// Aristas de soporte de cada caja en la dirección de la normal.
+			Vector3 pointA = a.center;
+			Vector3 pointB = b.center;
+			for (int k = 0; k < 3; k++)
+			{
+				if (k != i)
+				{
+					pointA += a.axis[k] * ((Dot(a.axis[k], normal) > 0.0f) ? a.half[k] : -a.half[k]);
+				}
+				if (k != j)
+				{
+					pointB += b.axis[k] * ((Dot(b.axis[k], normal) < 0.0f) ? b.half[k] : -b.half[k]);
+				}
+			}
+
+			// Puntos más cercanos entre las dos rectas.
+			Vector3 directionA = a.axis[i];
+			Vector3 directionB = b.axis[j];
+			Vector3 r = pointA - pointB;
+			float dAB = Dot(directionA, directionB);
+			float denominator = 1.0f - dAB * dAB;
+			float sA = 0.0f, sB = 0.0f;
+			if (denominator > 1e-6f)
+			{
+				float e = Dot(directionA, r);
+				float f = Dot(directionB, r);
+				sA = (dAB * f - e) / denominator;
+				sB = (f - dAB * e) / denominator;
+				sA = fmaxf(-a.half[i], fminf(a.half[i], sA));
+				sB = fmaxf(-b.half[j], fminf(b.half[j], sB));
+			}
+
+			Vector3 closestA = pointA + directionA * sA;
+			Vector3 closestB = pointB + directionB * sB;
+			points[0] = (closestA + closestB) * 0.5f;
+			depths[0] = -bestEdge;
+			return 1;
+		}
+
+		if (useFaceB)
+		{
+			Vector3 referenceNormal = b.axis[bestAxisB] * ((Dot(d, b.axis[bestAxisB]) > 0.0f) ? -1.0f : 1.0f);
+			normal = -referenceNormal;
+			return ClipFaceContacts(b, bestAxisB, referenceNormal, a, points, depths);
+		}
+
+		normal = a.axis[bestAxisA] * ((t[bestAxisA] > 0.0f) ? 1.0f : -1.0f);
+		return ClipFaceContacts(a, bestAxisA, normal, b, points, depths);
+	}
+}
+
+RigidBodyWorld::RigidBodyWorld(DX::JobSystem* jobSystem) :
+	m_jobSystem(jobSystem),
+	m_gravity(0.0f, -9.81f, 0.0f),
+	m_solverIterations(10),
+	m_sortInvalid(true),
+	m_deltaSeconds(0.0f)
+{
+	m_stats = RigidBodyWorldStats();
+	m_threadSolverBodies.resize(m_jobSystem->GetThreadCount());
+	m_threadSolverPoints.resize(m_jobSystem->GetThreadCount());
+}
+
+uint32_t RigidBodyWorld::AddBody(const RigidBodyDesc& desc)
+{
+	RigidBody body;
+	body.position = desc.position;
+	body.orientation = Normalize(desc.orientation);
+	body.linearVelocity = desc.linearVelocity;
+	body.angularVelocity = desc.angularVelocity;
+	body.halfExtents = desc.halfExtents;
+	body.friction = desc.friction;
+	body.sleepTime = 0.0f;
+	body.sleeping = false;
+
+	if (desc.mass > 0.0f)
+	{
+		// Tensor de inercia de una caja sólida: m/3 * (hy² + hz²) con semiextensiones h.
+		Vector3 h = desc.halfExtents;
+		float k = desc.mass / 3.0f;
+		body.invMass = 1.0f / desc.mass;
+		body.invInertiaLocal = Vector3(1.0f / (k * (h.y * h.y + h.z * h.z)), 1.0f / (k * (h.x * h.x + h.z * h.z)), 1.0f / (k * (h.x * h.x + h.y * h.y)));
+	}
+	else
+	{
+		body.invMass = 0.0f;
+		body.invInertiaLocal = Vector3();
+		body.linearVelocity = Vector3();
+		body.angularVelocity = Vector3();
+	}
+
+	body.rotation = ToMatrix3(body.orientation);
+	body.invInertiaWorld = body.rotation * Matrix3::Diagonal(body.invInertiaLocal) * body.rotation.Transposed();
+
+	uint32_t index = static_cast<uint32_t>(m_bodies.size());
+	m_bodies.push_back(body);
+	m_aabbs.push_back(Aabb());
+	m_sortedBodies.push_back(index);
+	m_sortInvalid = true;
+	return index;
+}
+
+// Avanza la simulación un paso. Con DX::StepTimer en modo fijo, deltaSeconds es siempre el mismo.
+void RigidBodyWorld::Step(float deltaSeconds)
+{
+	if (deltaSeconds <= 0.0f || m_bodies.empty())
+	{
+		return;
+	}
+
+	DX_PROFILE_SCOPE("RigidBodyWorld::Step");
+	m_deltaSeconds = deltaSeconds;
+	auto start = std::chrono::steady_clock::now();
+
+	UpdateDerivedState();
+	UpdateBroadphase();
+	m_stats.broadphaseMilliseconds = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	UpdateNarrowphase();
+	m_stats.narrowphaseMilliseconds = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	BuildIslands();
+
+	m_jobSystem->ParallelFor(static_cast<uint32_t>(m_islands.size()), 1, [this](uint32_t begin, uint32_t end)
+	{
+		DX_PROFILE_SCOPE("RigidBodyWorld::SolveIslands");
+		// El índice del subproceso es global; solo es válido para los trabajadores del JobSystem de la escena.
+		uint32_t thread = JobSystem::GetCurrentThreadIndex();
+		if (thread >= m_threadSolverBodies.size())
+		{
+			throw std::out_of_range("El subproceso no tiene memoria del resolvedor: no es de este JobSystem");
+		}
+		for (uint32_t i = begin; i < end; i++)
+		{
+			SolveIsland(m_islands[i], m_deltaSeconds, m_threadSolverBodies[thread], m_threadSolverPoints[thread]);
+		}
+	});
+
+	// Conservar los contactos resueltos para el arranque en caliente del siguiente paso.
+	m_previousManifolds.swap(m_sortedManifolds);
+	// Índice ordenado por par en lugar de una tabla hash: reutiliza su memoria de un paso a otro.
+	m_previousManifoldIndex.clear();
+	for (uint32_t i = 0; i < m_previousManifolds.size(); i++)
+	{
+		const ContactManifold& manifold = m_previousManifolds[i];
+		m_previousManifoldIndex.push_back(std::make_pair(MakePairKey(manifold.bodyA, manifold.bodyB), i));
+	}
+	std::sort(m_previousManifoldIndex.begin(), m_previousManifoldIndex.end());
+
+	m_stats.solverMilliseconds = MillisecondsSince(start);
+}
+
+// Recalcula rotación, inercia en el mundo y caja delimitadora de los cuerpos despiertos.
+void RigidBodyWorld::UpdateDerivedState()
+{
+	DX_PROFILE_SCOPE("RigidBodyWorld::UpdateDerivedState");
+	m_jobSystem->ParallelFor(static_cast<uint32_t>(m_bodies.size()), IntegrationGrain, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			RigidBody& body = m_bodies[i];
+			if (!body.IsAwake() && !m_sortInvalid)
+			{
+				continue;
+			}
+
+			body.rotation = ToMatrix3(body.orientation);
+			body.invInertiaWorld = body.rotation * Matrix3::Diagonal(body.invInertiaLocal) * body.rotation.Transposed();
+
+			Aabb& box = m_aabbs[i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const Vector3& row = body.rotation.r[axis];
+				float extent = fabsf(row.x) * body.halfExtents.x + fabsf(row.y) * body.halfExtents.y + fabsf(row.z) * body.halfExtents.z;
+				box.min[axis] = body.position[axis] - extent - ContactMargin;
+				box.max[axis] = body.position[axis] + extent + ContactMargin;
+			}
+			box.min[3] = 0.0f;
+			box.max[3] = 0.0f;
+		}
+	});
+}
+
+// Barrido y poda sobre el eje X. El orden se mantiene entre pasos y se corrige por inserción,
+// que es casi lineal cuando los objetos se mueven poco.
+void RigidBodyWorld::UpdateBroadphase()
+{
+	DX_PROFILE_SCOPE("RigidBodyWorld::UpdateBroadphase");
+	auto lessMinX = [this](uint32_t a, uint32_t b) { return m_aabbs[a].min[0] < m_aabbs[b].min[0]; };
+
+	if (m_sortInvalid)
+	{
+		std::sort(m_sortedBodies.begin(), m_sortedBodies.end(), lessMinX);
+		m_sortInvalid = false;
+	}
+	else
+	{
+		for (size_t i = 1; i < m_sortedBodies.size(); i++)
+		{
+			uint32_t body = m_sortedBodies[i];
+			float key = m_aabbs[body].min[0];
+			size_t j = i;
+			while (j > 0 && m_aabbs[m_sortedBodies[j - 1]].min[0] > key)
+			{
+				m_sortedBodies[j] = m_sortedBodies[j - 1];
+				j--;
+			}
+			m_sortedBodies[j] = body;
+		}
+	}
+
+	// Cada bloque del barrido escribe en su propia lista; concatenarlas en orden hace el resultado determinista.
+	uint32_t count = static_cast<uint32_t>(m_sortedBodies.size());
+	uint32_t chunkCount = (count + BroadphaseGrain - 1) / BroadphaseGrain;
+	if (m_chunkPairs.size() < chunkCount)
+	{
+		m_chunkPairs.resize(chunkCount);
+	}
+
+	m_jobSystem->ParallelFor(count, BroadphaseGrain, [this, count](uint32_t begin, uint32_t end)
+	{
+		std::vector<uint64_t>& pairs = m_chunkPairs[begin / BroadphaseGrain];
+		pairs.clear();
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t a = m_sortedBodies[i];
+			const Aabb& boxA = m_aabbs[a];
+			SimdFloat4 minA = SimdFloat4::Load(boxA.min);
+			SimdFloat4 maxA = SimdFloat4::Load(boxA.max);
+			bool awakeA = m_bodies[a].IsAwake();
+
+			for (uint32_t k = i + 1; k < count; k++)
+			{
+				uint32_t b = m_sortedBodies[k];
+				const Aabb& boxB = m_aabbs[b];
+				if (boxB.min[0] > boxA.max[0])
+				{
+					break;
+				}
+
+				// Al menos uno de los dos cuerpos debe estar despierto y ser dinámico.
+				if (!awakeA && !m_bodies[b].IsAwake())
+				{
+					continue;
+				}
+
+				int overlap = LessEqualMask(minA, SimdFloat4::Load(boxB.max)) & LessEqualMask(SimdFloat4::Load(boxB.min), maxA);
+				if ((overlap & 0x7) == 0x7)
+				{
+					pairs.push_back((a < b) ? MakePairKey(a, b) : MakePairKey(b, a));
+				}
+			}
+		}
+	});
+
+	m_pairs.clear();
+	for (uint32_t c = 0; c < chunkCount; c++)
+	{
+		m_pairs.insert(m_pairs.end(), m_chunkPairs[c].begin(), m_chunkPairs[c].end());
+	}
+	m_stats.broadphasePairs = static_cast<uint32_t>(m_pairs.size());
+}
+
+// Colisión caja-caja de cada par y recuperación de los impulsos acumulados del paso anterior.
+void RigidBodyWorld::UpdateNarrowphase()
+{
+	DX_PROFILE_SCOPE("RigidBodyWorld::UpdateNarrowphase");
+	uint32_t pairCount = static_cast<uint32_t>(m_pairs.size());
+	m_pairManifolds.resize(pairCount);
+
+	m_jobSystem->ParallelFor(pairCount, NarrowphaseGrain, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t p = begin; p < end; p++)
+		{
+			uint32_t indexA = static_cast<uint32_t>(m_pairs[p] >> 32);
+			uint32_t indexB = static_cast<uint32_t>(m_pairs[p] & 0xffffffff);
+			const RigidBody& bodyA = m_bodies[indexA];
+			const RigidBody& bodyB = m_bodies[indexB];
+
+			Box boxA, boxB;
+			boxA.center = bodyA.position;
+			boxA.half = bodyA.halfExtents;
+			boxB.center = bodyB.position;
+			boxB.half = bodyB.halfExtents;
+			for (int k = 0; k < 3; k++)
+			{
+				boxA.axis[k] = bodyA.rotation.Column(k);
+				boxB.axis[k] = bodyB.rotation.Column(k);
+			}
+
+			ContactManifold& manifold = m_pairManifolds[p];
+			Vector3 points[4];
+			float depths[4];
+			manifold.pointCount = CollideBoxes(boxA, boxB, manifold.normal, points, depths);
+			if (manifold.pointCount == 0)
+			{
+				continue;
+			}
+
+			manifold.bodyA = indexA;
+			manifold.bodyB = indexB;
+			manifold.friction = sqrtf(bodyA.friction * bodyB.friction);
+			ComputeTangents(manifold.normal, manifold.tangent[0], manifold.tangent[1]);
+
+			auto previous = std::lower_bound(m_previousManifoldIndex.begin(), m_previousManifoldIndex.end(), std::make_pair(m_pairs[p], 0u));
+			const ContactManifold* old = (previous != m_previousManifoldIndex.end() && previous->first == m_pairs[p]) ? &m_previousManifolds[previous->second] : nullptr;
+			float matchDistance = 0.25f * fminf(bodyA.halfExtents.x, fminf(bodyA.halfExtents.y, bodyA.halfExtents.z));
+			float matchDistanceSq = matchDistance * matchDistance;
+
+			for (uint32_t k = 0; k < manifold.pointCount; k++)
+			{
+				ContactPoint& point = manifold.points[k];
+				point.localA = bodyA.rotation.Transposed() * (points[k] - bodyA.position);
+				point.rA = points[k] - bodyA.position;
+				point.rB = points[k] - bodyB.position;
+				point.penetration = depths[k];
+				point.impulse[0] = 0.0f;
+				point.impulse[1] = 0.0f;
+				point.impulse[2] = 0.0f;
+
+				if (old != nullptr)
+				{
+					for (uint32_t m = 0; m < old->pointCount; m++)
+					{
+						if (LengthSquared(old->points[m].localA - point.localA) < matchDistanceSq)
+						{
+							point.impulse[0] = old->points[m].impulse[0];
+							point.impulse[1] = old->points[m].impulse[1];
+							point.impulse[2] = old->points[m].impulse[2];
+							break;
+						}
+					}
+				}
+			}
+		}
+	});
+
+	m_manifolds.clear();
+	uint32_t pointCount = 0;
+	for (uint32_t p = 0; p < pairCount; p++)
+	{
+		if (m_pairManifolds[p].pointCount > 0)
+		{
+			m_manifolds.push_back(p);
+			pointCount += m_pairManifolds[p].pointCount;
+		}
+	}
+
+	m_stats.manifolds = static_cast<uint32_t>(m_manifolds.size());
+	m_stats.contactPoints = pointCount;
+}
+
+uint32_t RigidBodyWorld::FindRoot(uint32_t body)
+{
+	while (m_parents[body] != body)
+	{
+		m_parents[body] = m_parents[m_parents[body]];
+		body = m_parents[body];
+	}
+	return body;
+}
+
+// Agrupa los cuerpos despiertos conectados por contactos. Los cuerpos estáticos no unen islas.
+void RigidBodyWorld::BuildIslands()
+{
+	DX_PROFILE_SCOPE("RigidBodyWorld::BuildIslands");
+	uint32_t bodyCount = static_cast<uint32_t>(m_bodies.size());
+	m_parents.resize(bodyCount);
+	m_localIndex.resize(bodyCount);
+
+	// Un cuerpo dormido que toca uno despierto se despierta.
+	for (uint32_t p : m_manifolds)
+	{
+		const ContactManifold& manifold = m_pairManifolds[p];
+		RigidBody& bodyA = m_bodies[manifold.bodyA];
+		RigidBody& bodyB = m_bodies[manifold.bodyB];
+		if (bodyA.sleeping && bodyB.IsAwake())
+		{
+			bodyA.sleeping = false;
+			bodyA.sleepTime = 0.0f;
+		}
+		if (bodyB.sleeping && bodyA.IsAwake())
+		{
+			bodyB.sleeping = false;
+			bodyB.sleepTime = 0.0f;
+		}
+	}
+
+	for (uint32_t i = 0; i < bodyCount; i++)
+	{
+		m_parents[i] = i;
+	}
+
+	for (uint32_t p : m_manifolds)
+	{
+		const ContactManifold& manifold = m_pairManifolds[p];
+		if (m_bodies[manifold.bodyA].IsAwake() && m_bodies[manifold.bodyB].IsAwake())
+		{
+			uint32_t rootA = FindRoot(manifold.bodyA);
+			uint32_t rootB = FindRoot(manifold.bodyB);
+			if (rootA != rootB)
+			{
+				m_parents[rootA] = rootB;
+			}
+		}
+	}
+
+	// Numerar las islas por su raíz y repartir cuerpos y contactos por orden de conteo.
+	m_islands.clear();
+	m_rootIsland.assign(bodyCount, InvalidIndex);
+	uint32_t awakeBodies = 0;
+	for (uint32_t i = 0; i < bodyCount; i++)
+	{
+		if (!m_bodies[i].IsAwake())
+		{
+			continue;
+		}
+
+		awakeBodies++;
+		uint32_t root = FindRoot(i);
+		if (m_rootIsland[root] == InvalidIndex)
+		{
+			m_rootIsland[root] = static_cast<uint32_t>(m_islands.size());
+			Island island = { 0, 0, 0, 0 };
+			m_islands.push_back(island);
+		}
+
+		m_islands[m_rootIsland[root]].bodyCount++;
+	}
+
+	for (uint32_t p : m_manifolds)
+	{
+		const ContactManifold& manifold = m_pairManifolds[p];
+		uint32_t dynamicBody = m_bodies[manifold.bodyA].IsAwake() ? manifold.bodyA : manifold.bodyB;
+		m_islands[m_rootIsland[FindRoot(dynamicBody)]].manifoldCount++;
+	}
+
+	uint32_t bodyOffset = 0, manifoldOffset = 0;
+	for (Island& island : m_islands)
+	{
+		island.firstBody = bodyOffset;
+		island.firstManifold = manifoldOffset;
+		bodyOffset += island.bodyCount;
+		manifoldOffset += island.manifoldCount;
+		island.bodyCount = 0;
+		island.manifoldCount = 0;
+	}
+
+	m_islandBodies.resize(awakeBodies);
+	for (uint32_t i = 0; i < bodyCount; i++)
+	{
+		if (m_bodies[i].IsAwake())
+		{
+			Island& island = m_islands[m_rootIsland[FindRoot(i)]];
+			m_localIndex[i] = island.bodyCount + 1;
+			m_islandBodies[island.firstBody + island.bodyCount++] = i;
+		}
+	}
+
+	m_sortedManifolds.resize(m_manifolds.size());
+	for (uint32_t p : m_manifolds)
+	{
+		const ContactManifold& manifold = m_pairManifolds[p];
+		uint32_t dynamicBody = m_bodies[manifold.bodyA].IsAwake() ? manifold.bodyA : manifold.bodyB;
+		Island& island = m_islands[m_rootIsland[FindRoot(dynamicBody)]];
+		m_sortedManifolds[island.firstManifold + island.manifoldCount++] = manifold;
+	}
+
+	// Resolver primero las islas grandes equilibra mejor la carga entre subprocesos.
+	std::stable_sort(m_islands.begin(), m_islands.end(), [](const Island& a, const Island& b)
+	{
+		return a.manifoldCount > b.manifoldCount;
+	});
+
+	m_stats.awakeBodies = awakeBodies;
+	m_stats.islands = static_cast<uint32_t>(m_islands.size());
+}
+
+// Integra velocidades, resuelve los contactos de la isla por impulsos secuenciales e integra posiciones.
+// Cada isla trabaja sobre una copia local de las velocidades; el índice 0 representa a cualquier cuerpo estático.
+void RigidBodyWorld::SolveIsland(const Island& island, float dt, std::vector<SolverBody>& solverBodies, std::vector<SolverPoint>& solverPoints)
+{
+	solverBodies.resize(island.bodyCount + 1);
+	solverBodies[0].linearVelocity = Vector3();
+	solverBodies[0].angularVelocity = Vector3();
+	solverBodies[0].invInertia = Matrix3::Diagonal(Vector3());
+	solverBodies[0].invMass = 0.0f;
+
+	for (uint32_t i = 0; i < island.bodyCount; i++)
+	{
+		const RigidBody& body = m_bodies[m_islandBodies[island.firstBody + i]];
+		SolverBody& solverBody = solverBodies[i + 1];
+		solverBody.linearVelocity = body.linearVelocity + m_gravity * dt;
+		solverBody.angularVelocity = body.angularVelocity;
+		solverBody.invInertia = body.invInertiaWorld;
+		solverBody.invMass = body.invMass;
+	}
+
+	ContactManifold* manifolds = m_sortedManifolds.data() + island.firstManifold;
+	const float inverseDt = 1.0f / dt;
+
+	uint32_t pointCount = 0;
+	for (uint32_t m = 0; m < island.manifoldCount; m++)
+	{
+		pointCount += manifolds[m].pointCount;
+	}
+	solverPoints.resize(pointCount);
+
+	// Preparar brazos, masas efectivas y arranque en caliente. Los términos angulares se precalculan
+	// para que cada iteración solo haga productos escalares.
+	SolverPoint* solverPoint = solverPoints.data();
+	for (uint32_t m = 0; m < island.manifoldCount; m++)
+	{
+		ContactManifold& manifold = manifolds[m];
+		SolverBody& a = solverBodies[m_bodies[manifold.bodyA].IsAwake() ? m_localIndex[manifold.bodyA] : 0];
+		SolverBody& b = solverBodies[m_bodies[manifold.bodyB].IsAwake() ? m_localIndex[manifold.bodyB] : 0];
+		const Vector3 axes[3] = { manifold.normal, manifold.tangent[0], manifold.tangent[1] };
+
+		for (uint32_t k = 0; k < manifold.pointCount; k++, solverPoint++)
+		{
+			ContactPoint& point = manifold.points[k];
+			for (int c = 0; c < 3; c++)
+			{
+				solverPoint->armA[c] = Cross(point.rA, axes[c]);
+				solverPoint->armB[c] = Cross(point.rB, axes[c]);
+				solverPoint->angularA[c] = a.invInertia * solverPoint->armA[c];
+				solverPoint->angularB[c] = b.invInertia * solverPoint->armB[c];
+				float mass = a.invMass + b.invMass + Dot(solverPoint->armA[c], solverPoint->angularA[c]) + Dot(solverPoint->armB[c], solverPoint->angularB[c]);
+				solverPoint->mass[c] = (mass > 0.0f) ? 1.0f / mass : 0.0f;
+
+				a.linearVelocity -= axes[c] * (point.impulse[c] * a.invMass);
+				a.angularVelocity -= solverPoint->angularA[c] * point.impulse[c];
+				b.linearVelocity += axes[c] * (point.impulse[c] * b.invMass);
+				b.angularVelocity += solverPoint->angularB[c] * point.impulse[c];
+			}
+
+			// Los puntos especulativos (penetración negativa) permiten acercarse justo hasta tocarse.
+			solverPoint->bias = (point.penetration < 0.0f) ? point.penetration * inverseDt
+				: BaumgarteFactor * inverseDt * fmaxf(0.0f, point.penetration - PenetrationSlop);
+		}
+	}
+
+	for (uint32_t iteration = 0; iteration < m_solverIterations; iteration++)
+	{
+		solverPoint = solverPoints.data();
+		for (uint32_t m = 0; m < island.manifoldCount; m++)
+		{
+			ContactManifold& manifold = manifolds[m];
+			SolverBody& a = solverBodies[m_bodies[manifold.bodyA].IsAwake() ? m_localIndex[manifold.bodyA] : 0];
+			SolverBody& b = solverBodies[m_bodies[manifold.bodyB].IsAwake() ? m_localIndex[manifold.bodyB] : 0];
+			const Vector3 axes[3] = { manifold.normal, manifold.tangent[0], manifold.tangent[1] };
+
+			for (uint32_t k = 0; k < manifold.pointCount; k++, solverPoint++)
+			{
+				ContactPoint& point = manifold.points[k];
+
+				// Fricción primero (c = 1, 2), limitada por el impulso normal acumulado; después la
+				// restricción de no penetración (c = 0).
+				for (int step = 0; step < 3; step++)
+				{
+					int c = (step + 1) % 3;
+					float velocity = Dot(axes[c], b.linearVelocity - a.linearVelocity)
+						+ Dot(solverPoint->armB[c], b.angularVelocity) - Dot(solverPoint->armA[c], a.angularVelocity);
+
+					float lambda, accumulated;
+					if (c == 0)
+					{
+						lambda = (solverPoint->bias - velocity) * solverPoint->mass[0];
+						accumulated = fmaxf(0.0f, point.impulse[0] + lambda);
+					}
+					else
+					{
+						float limit = manifold.friction * point.impulse[0];
+						lambda = -velocity * solverPoint->mass[c];
+						accumulated = fmaxf(-limit, fminf(limit, point.impulse[c] + lambda));
+					}
+					lambda = accumulated - point.impulse[c];
+					point.impulse[c] = accumulated;
+
+					a.linearVelocity -= axes[c] * (lambda * a.invMass);
+					a.angularVelocity -= solverPoint->angularA[c] * lambda;
+					b.linearVelocity += axes[c] * (lambda * b.invMass);
+					b.angularVelocity += solverPoint->angularB[c] * lambda;
+				}
+			}
+		}
+	}
+
+	// Integrar posiciones y decidir si la isla entera puede dormirse.
+	float minSleepTime = FLT_MAX;
+	for (uint32_t i = 0; i < island.bodyCount; i++)
+	{
+		RigidBody& body = m_bodies[m_islandBodies[island.firstBody + i]];
+		const SolverBody& solverBody = solverBodies[i + 1];
+		body.linearVelocity = solverBody.linearVelocity;
+		body.angularVelocity = solverBody.angularVelocity;
+		body.position += body.linearVelocity * dt;
+		body.orientation = IntegrateRotation(body.orientation, body.angularVelocity, dt);
+
+		if (LengthSquared(body.linearVelocity) > SleepLinearThreshold * SleepLinearThreshold ||
+			LengthSquared(body.angularVelocity) > SleepAngularThreshold * SleepAngularThreshold)
+		{
+			body.sleepTime = 0.0f;
+		}
+		else
+		{
+			body.sleepTime += dt;
+		}
+		minSleepTime = fminf(minSleepTime, body.sleepTime);
+	}
+
+	if (minSleepTime >= SleepDelaySeconds)
+	{
+		for (uint32_t i = 0; i < island.bodyCount; i++)
+		{
+			RigidBody& body = m_bodies[m_islandBodies[island.firstBody + i]];
+			body.sleeping = true;
+			body.linearVelocity = Vector3();
+			body.angularVelocity = Vector3();
+		}
+	}
+}
@@ -0,0 +1,170 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "../Common/JobSystem.h"
+#include "../Common/MemoryTracker.h"
+#include "../Common/VectorMath.h"
+
+namespace App2
+{
+	// Parámetros de creación de un cuerpo rígido con forma de caja orientada.
+	struct RigidBodyDesc
+	{
+		RigidBodyDesc() : halfExtents(0.5f, 0.5f, 0.5f), mass(1.0f), friction(0.6f) {}
+
+		DX::Vector3		position;
+		DX::Quaternion	orientation;
+		DX::Vector3		halfExtents;
+		DX::Vector3		linearVelocity;
+		DX::Vector3		angularVelocity;
+		float			mass;		// Una masa de 0 crea un cuerpo estático (por ejemplo, el suelo).
+		float			friction;
+	};
+
+	// Estado de simulación de un cuerpo. Los campos derivados se recalculan en cada paso.
+	struct RigidBody
+	{
+		DX::Vector3		position;
+		DX::Quaternion	orientation;
+		DX::Vector3		linearVelocity;
+		DX::Vector3		angularVelocity;
+		DX::Vector3		halfExtents;
+		DX::Vector3		invInertiaLocal;
+		DX::Matrix3		rotation;
+		DX::Matrix3		invInertiaWorld;
+		float			invMass;
+		float			friction;
+		float			sleepTime;
+		bool			sleeping;
+
+		bool IsStatic() const	{ return invMass == 0.0f; }
+		bool IsAwake() const	{ return invMass != 0.0f && !sleeping; }
+	};
+
+	// Contadores del último paso de simulación.
+	struct RigidBodyWorldStats
+	{
+		uint32_t	awakeBodies;
+		uint32_t	broadphasePairs;
+		uint32_t	manifolds;
+		uint32_t	contactPoints;
+		uint32_t	islands;
+		double		broadphaseMilliseconds;
+		double		narrowphaseMilliseconds;
+		double		solverMilliseconds;
+	};
+
+	// Mundo de cuerpos rígidos con cajas orientadas: fase amplia de barrido y poda incremental,
+	// fase estrecha caja-caja por ejes separadores y un solucionador de impulsos secuenciales
+	// que resuelve en paralelo las islas de cuerpos en contacto. Está pensado para avanzar con el
+	// timestep fijo de DX::StepTimer.
+	class RigidBodyWorld
+	{
+	public:
+		RigidBodyWorld(DX::JobSystem* jobSystem);
+
+		uint32_t AddBody(const RigidBodyDesc& desc);
+		void Step(float deltaSeconds);
+
+		void SetGravity(const DX::Vector3& gravity)				{ m_gravity = gravity; }
+		void SetSolverIterations(uint32_t iterations)			{ m_solverIterations = iterations; }
+
+		const std::vector<RigidBody>& GetBodies() const			{ return m_bodies; }
+		const RigidBodyWorldStats& GetStats() const				{ return m_stats; }
+
+	private:
+		struct ContactPoint
+		{
+			DX::Vector3	localA;			// Posición en el espacio de A; se usa para emparejar con el paso anterior.
+			DX::Vector3	rA;
+			DX::Vector3	rB;
+			float		penetration;
+			float		impulse[3];		// Impulsos acumulados: normal, tangente 0 y tangente 1.
+		};
+
+		struct ContactManifold
+		{
+			uint32_t		bodyA;
+			uint32_t		bodyB;
+			DX::Vector3		normal;		// De A hacia B.
+			DX::Vector3		tangent[2];
+			float			friction;
+			uint32_t		pointCount;
+			ContactPoint	points[4];
+		};
+
+		struct Aabb
+		{
+			float min[4];
+			float max[4];
+		};
+
+		struct SolverBody
+		{
+			DX::Vector3	linearVelocity;
+			DX::Vector3	angularVelocity;
+			DX::Matrix3	invInertia;
+			float		invMass;
+		};
+
+		// Datos de una restricción de contacto precalculados para las iteraciones del solucionador.
+		// Por eje (normal, tangente 0, tangente 1): r x eje, inercia inversa aplicada y masa efectiva.
+		struct SolverPoint
+		{
+			DX::Vector3	armA[3];
+			DX::Vector3	armB[3];
+			DX::Vector3	angularA[3];
+			DX::Vector3	angularB[3];
+			float		mass[3];
+			float		bias;
+		};
+
+		struct Island
+		{
+			uint32_t	firstBody;
+			uint32_t	bodyCount;
+			uint32_t	firstManifold;
+			uint32_t	manifoldCount;
+		};
+
+		void UpdateDerivedState();
+		void UpdateBroadphase();
+		void UpdateNarrowphase();
+		void BuildIslands();
+		void SolveIsland(const Island& island, float deltaSeconds, std::vector<SolverBody>& solverBodies, std::vector<SolverPoint>& solverPoints);
+		uint32_t FindRoot(uint32_t body);
+
+		DX::JobSystem*					m_jobSystem;
+		std::vector<RigidBody>			m_bodies;
+		DX::TaggedVector<Aabb, DX::MemoryTag::Physics>	m_aabbs;
+		DX::Vector3						m_gravity;
+		uint32_t						m_solverIterations;
+		RigidBodyWorldStats				m_stats;
+
+		// Fase amplia: índices ordenados por el mínimo en X; se reordenan por inserción en cada paso
+		// porque el orden cambia muy poco entre fotogramas.
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_sortedBodies;
+		bool							m_sortInvalid;
+		std::vector<std::vector<uint64_t>>	m_chunkPairs;
+		DX::TaggedVector<uint64_t, DX::MemoryTag::Physics>	m_pairs;
+
+		// Fase estrecha y arranque en caliente a partir de los contactos del paso anterior.
+		DX::TaggedVector<ContactManifold, DX::MemoryTag::Physics>	m_pairManifolds;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_manifolds;
+		DX::TaggedVector<ContactManifold, DX::MemoryTag::Physics>	m_previousManifolds;
+		DX::TaggedVector<std::pair<uint64_t, uint32_t>, DX::MemoryTag::Physics>	m_previousManifoldIndex;
+
+		// Islas: unión-búsqueda sobre los cuerpos dinámicos despiertos.
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_parents;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_localIndex;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_islandBodies;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Physics>	m_rootIsland;
+		DX::TaggedVector<Island, DX::MemoryTag::Physics>	m_islands;
+		DX::TaggedVector<ContactManifold, DX::MemoryTag::Physics>	m_sortedManifolds;
+		std::vector<std::vector<SolverBody>>	m_threadSolverBodies;
+		std::vector<std::vector<SolverPoint>>	m_threadSolverPoints;
+		float							m_deltaSeconds;
+	};
+}
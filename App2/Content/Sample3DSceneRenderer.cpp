@@ -2,37 +2,117 @@
 #include "Sample3DSceneRenderer.h"
 
 #include "..\Common\DirectXHelper.h"
+#include "SceneCamera.h"
+
+#include <algorithm>
 
 using namespace App2;
 
 using namespace DirectX;
 using namespace Windows::Foundation;
 
+namespace
+{
+	static_assert(sizeof(DX::Matrix4) == sizeof(XMFLOAT4X4), "DX::Matrix4 debe tener la disposición de XMFLOAT4X4");
+
+	// Los sombreadores esperan matrices por columnas, así que se copian traspuestas.
+	void StoreTransposed(DX::Matrix4& target, const DX::Matrix4& source)
+	{
+		target = source.Transposed();
+	}
+
+	// Todos los dibujos de la escena son opacos y van en la primera pasada.
+	const uint32 OpaquePass = 0;
+
+	// Superficie suave: cubo de control de lado 2 * SmoothHalfSize en SmoothCenter, refinado hasta que sus
+	// aristas miden unos SmoothEdgePixels en pantalla. Cada vértice refinado es VertexPositionColor más dos
+	// flotantes de relleno, para que SubdivisionStencils lo combine en dos bloques de cuatro.
+	struct SmoothVertex
+	{
+		float	pos[3];
+		float	color[3];
+		float	padding[2];
+	};
+
+	const DX::Vector3 SmoothCenter(0.55f, -0.25f, 0.25f);
+	const float SmoothHalfSize = 0.12f;
+	const uint32 SmoothMaxLevel = 4;
+	const float SmoothEdgePixels = 8.0f;
+	const uint32 SmoothFloatsPerVertex = sizeof(SmoothVertex) / sizeof(float);
+
+	// Triángulos de oclusores por fotograma: los trozos se añaden enteros mientras quepan.
+	const uint32 OccluderTriangleBudget = 24000;
+
+	// Las caras del cubo como cuadriláteros, con la numeración y el sentido de giro de cubeVertices y
+	// cubeIndices: el vértice i está en x = bit 2, y = bit 1, z = bit 0.
+	DX::SubdivisionCage CreateSmoothCage()
+	{
+		static const uint32_t faces[] =
+		{
+			0, 2, 3, 1,	// -x
+			4, 5, 7, 6,	// +x
+			0, 1, 5, 4,	// -y
+			2, 6, 7, 3,	// +y
+			0, 4, 6, 2,	// -z
+			1, 3, 7, 5,	// +z
+		};
+
+		DX::SubdivisionCage cage;
+		cage.vertexCount = 8;
+		cage.faceSizes.assign(6, 4);
+		cage.faceIndices.assign(faces, faces + ARRAYSIZE(faces));
+		return cage;
+	}
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<SmoothVertex> : VertexLayout<SmoothVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(SmoothVertex, pos)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(SmoothVertex, color)>>
+	{
+	};
+}
+
 // Carga los sombreadores de vértices y píxeles de los archivos y crea instancias de la geometría de cubo.
 Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
 	m_loadingComplete(false),
+	m_shadowsRegistered(false),
 	m_degreesPerSecond(45),
 	m_indexCount(0),
 	m_tracking(false),
+	m_rigidBodyWorld(nullptr),
+	m_occlusion(DX::OcclusionCullerDesc::CreateDefault()),
+	m_cloth(nullptr),
+	m_clothIndexCount(0),
+	m_terrain(nullptr),
+	m_voxelVolume(nullptr),
+	m_jobSystem(nullptr),
+	m_recorder(256),
+	m_shaderId(DX::InvalidPoolHandle),
+	m_materialId(DX::InvalidPoolHandle),
+	m_cubeMeshId(DX::InvalidPoolHandle),
+	m_clothMeshId(DX::InvalidPoolHandle),
+	m_smoothStencils(DX::SubdivisionScheme::CatmullClark, CreateSmoothCage(), SmoothMaxLevel),
+	m_smoothCage(8 * SmoothFloatsPerVertex, 0.0f),
+	m_smoothSeconds(0.0f),
+	m_pixelsPerUnit(0.0f),
 	m_deviceResources(deviceResources)
 {
 	CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
 }
 
+Sample3DSceneRenderer::~Sample3DSceneRenderer()
+{
+	m_deviceResources->GetResourceRegistry()->RemoveOwner(this);
+}
+
 // Inicializa los parámetros de vista cuando cambia el tamaño de la ventana.
 void Sample3DSceneRenderer::CreateWindowSizeDependentResources()
 {
 	Size outputSize = m_deviceResources->GetOutputSize();
-	float aspectRatio = outputSize.Width / outputSize.Height;
-	float fovAngleY = 70.0f * XM_PI / 180.0f;
-
-	// Este es un ejemplo sencillo de los cambios que se pueden realizar cuando la aplicación está en
-	// vista Portrait o Snapped.
-	if (aspectRatio < 1.0f)
-	{
-		fovAngleY *= 2.0f;
-	}
 
 	// Observe que la matriz OrientationTransform3D se ha multiplicado posteriormente aquí
 	// con el fin de orientar correctamente la escena para que coincida con la orientación de pantalla.
@@ -41,39 +121,35 @@ void Sample3DSceneRenderer::CreateWindowSizeDependentResources()
 	// no se deberá aplicar esta transformación.
 
 	// En este ejemplo se usa un sistema de coordenadas diestras que emplea matrices principales de fila.
-	XMMATRIX perspectiveMatrix = XMMatrixPerspectiveFovRH(
-		fovAngleY,
-		aspectRatio,
-		0.01f,
-		100.0f
-		);
-
+	// Las matrices se calculan en SceneCamera, sin DirectXMath, para poder medirlas fuera de la aplicación;
+	// solo la orientación llega de DeviceResources como XMFLOAT4X4.
 	XMFLOAT4X4 orientation = m_deviceResources->GetOrientationTransform3D();
+	DX::Matrix4 orientationMatrix;
+	memcpy(&orientationMatrix, &orientation, sizeof(orientationMatrix));
 
-	XMMATRIX orientationMatrix = XMLoadFloat4x4(&orientation);
-
-	XMStoreFloat4x4(
-		&m_constantBufferData.projection,
-		XMMatrixTranspose(perspectiveMatrix * orientationMatrix)
-		);
+	DX::Matrix4 projection = ComputeSceneProjection(outputSize.Width, outputSize.Height, orientationMatrix);
+	DX::Matrix4 view = ComputeSceneView();
+	StoreTransposed(m_constantBufferData.projection, projection);
+	StoreTransposed(m_constantBufferData.view, view);
 
-	// La posición ocular es (0;0,7;1,5) y se mira al punto (0;-0,1;0) con el vector superior en el eje y.
-	static const XMVECTORF32 eye = { 0.0f, 0.7f, 1.5f, 0.0f };
-	static const XMVECTORF32 at = { 0.0f, -0.1f, 0.0f, 0.0f };
-	static const XMVECTORF32 up = { 0.0f, 1.0f, 0.0f, 0.0f };
+	// Escala vertical de la proyección en píxeles, para medir la superficie suave en pantalla.
+	m_pixelsPerUnit = 0.5f * outputSize.Height * sqrtf(projection.m[1][0] * projection.m[1][0] + projection.m[1][1] * projection.m[1][1]);
 
-	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookAtRH(eye, at, up)));
+	// Tronco para descartar los cuerpos que quedan fuera de la pantalla.
+	m_viewProjection = view * projection;
+	m_frustum = DX::Frustum::FromViewProjection(m_viewProjection);
 }
 
 // Se llama una vez por fotograma, gira el cubo y calcula las matrices de modelo y vista.
 void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 {
+	m_smoothSeconds = static_cast<float>(timer.GetTotalSeconds());
 	if (!m_tracking)
 	{
 		// Convierta los grados en radianes y, a continuación, convierta los segundos en ángulo de giro
-		float radiansPerSecond = XMConvertToRadians(m_degreesPerSecond);
+		float radiansPerSecond = DX::ToRadians(m_degreesPerSecond);
 		double totalRotation = timer.GetTotalSeconds() * radiansPerSecond;
-		float radians = static_cast<float>(fmod(totalRotation, XM_2PI));
+		float radians = static_cast<float>(fmod(totalRotation, DX::TwoPi));
 
 		Rotate(radians);
 	}
@@ -83,7 +159,7 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 void Sample3DSceneRenderer::Rotate(float radians)
 {
 	// Prepárese para pasar al sombreador la matriz de modelo actualizada
-	XMStoreFloat4x4(&m_constantBufferData.model, XMMatrixTranspose(XMMatrixRotationY(radians)));
+	StoreTransposed(m_constantBufferData.model, ComputeCubeModel(radians));
 }
 
 void Sample3DSceneRenderer::StartTracking()
@@ -96,7 +172,7 @@ void Sample3DSceneRenderer::TrackingUpdate(float positionX)
 {
 	if (m_tracking)
 	{
-		float radians = XM_2PI * 2.0f * positionX / m_deviceResources->GetOutputSize().Width;
+		float radians = DX::TwoPi * 2.0f * positionX / m_deviceResources->GetOutputSize().Width;
 		Rotate(radians);
 	}
 }
@@ -106,7 +182,8 @@ void Sample3DSceneRenderer::StopTracking()
 	m_tracking = false;
 }
 
-// Presenta un fotograma usando los sombreadores de vértices y píxeles.
+// Presenta un fotograma usando los sombreadores de vértices y píxeles. Los dibujos se graban en el búfer de
+// comandos, se ordenan por clave y se reproducen, de modo que los que comparten estado quedan juntos.
 void Sample3DSceneRenderer::Render()
 {
 	// La carga es asincrónica. Dibuje solo formas geométricas una vez que se haya cargado.
@@ -115,154 +192,746 @@ void Sample3DSceneRenderer::Render()
 		return;
 	}
 
+	if (m_renderBackend.IsEmpty())
+	{
+		RegisterRenderResources();
+	}
+	SyncTerrainChunks();
+	SyncVoxelChunks();
+	RasterizeOccluders();
+
 	auto context = m_deviceResources->GetD3DDeviceContext();
+	m_commandBuffer.Reset();
 
-	// Prepare el búfer de constantes para enviarlo al dispositivo de gráficos.
-	context->UpdateSubresource1(
-		m_constantBuffer.Get(),
-		0,
-		NULL,
-		&m_constantBufferData,
-		0,
-		0,
-		0
-		);
+	if (m_rigidBodyWorld == nullptr)
+	{
+		AddCube(m_commandBuffer, m_constantBufferData, DX::Vector3(0.0f, 0.0f, 0.0f));
+	}
+	else
+	{
+		// Un cubo por cuerpo rígido visible, probado con su esfera envolvente. Los cuerpos se graban en
+		// paralelo, cada tramo en su lista, y las listas se unen en orden.
+		const std::vector<RigidBody>& bodies = m_rigidBodyWorld->GetBodies();
+		m_recorder.Record(m_jobSystem, static_cast<uint32>(bodies.size()), [this, &bodies](DX::RenderCommandBuffer& list, uint32 begin, uint32 end)
+		{
+			ModelViewProjectionConstantBuffer constants = m_constantBufferData;
+			for (uint32 i = begin; i < end; i++)
+			{
+				const RigidBody& body = bodies[i];
+				float radius = DX::Length(body.halfExtents);
+				if (!m_frustum.IntersectsSphere(body.position, radius) || !m_occlusion.IsSphereVisible(body.position, radius))
+				{
+					continue;
+				}
+
+				StoreTransposed(constants.model, ComputeBodyModel(body));
+				AddCube(list, constants, body.position);
+			}
+		});
+		m_recorder.Merge(m_jobSystem, m_commandBuffer);
+	}
 
-	// Cada vértice es una instancia del struct VertexPositionColor.
-	UINT stride = sizeof(VertexPositionColor);
-	UINT offset = 0;
-	context->IASetVertexBuffers(
-		0,
-		1,
-		m_vertexBuffer.GetAddressOf(),
-		&stride,
-		&offset
-		);
+	AddTerrain(m_commandBuffer);
+	AddVoxels(m_commandBuffer);
+	AddCloth(context);
+	AddSmoothSurface(context);
+
+	m_commandBuffer.Sort(m_jobSystem);
+	m_renderBackend.Begin(context);
+	m_commandBuffer.Submit(m_renderBackend);
+}
+
+// Rasteriza como oclusores los trozos de terreno y de vóxeles dentro del tronco, del más cercano al más
+// lejano, hasta OccluderTriangleBudget triángulos. Usa las mallas de la CPU, que no cambian hasta la próxima
+// actualización del terreno o del volumen.
+void Sample3DSceneRenderer::RasterizeOccluders()
+{
+	m_occlusion.BeginFrame(m_viewProjection);
+	m_occluderCandidates.clear();
+	DX::Vector3 eye = GetSceneEyePosition();
+
+	if (m_terrain != nullptr)
+	{
+		for (uint32 i = 0; i < m_terrain->GetChunkCount(); i++)
+		{
+			const TerrainChunk& chunk = m_terrain->GetChunk(i);
+			if (!m_frustum.IntersectsSphere(chunk.center, chunk.radius))
+			{
+				continue;
+			}
+
+			const std::vector<uint16_t>& indices = m_terrain->GetIndices(chunk.lod);
+			OccluderCandidate candidate = { DX::Length(chunk.center - eye) - chunk.radius, chunk.vertices.data(), static_cast<uint32>(chunk.vertices.size()), indices.data(), nullptr, static_cast<uint32>(indices.size()) };
+			m_occluderCandidates.push_back(candidate);
+		}
+	}
 
-	context->IASetIndexBuffer(
+	if (m_voxelVolume != nullptr)
+	{
+		for (uint32 i = 0; i < m_voxelVolume->GetChunkCount(); i++)
+		{
+			const VoxelChunkMesh& mesh = m_voxelVolume->GetChunkMesh(i);
+			if (mesh.indices.empty() || !m_frustum.IntersectsSphere(mesh.center, mesh.radius))
+			{
+				continue;
+			}
+
+			OccluderCandidate candidate = { DX::Length(mesh.center - eye) - mesh.radius, mesh.vertices.data(), static_cast<uint32>(mesh.vertices.size()), nullptr, mesh.indices.data(), static_cast<uint32>(mesh.indices.size()) };
+			m_occluderCandidates.push_back(candidate);
+		}
+	}
+
+	std::sort(m_occluderCandidates.begin(), m_occluderCandidates.end(), [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.distance < b.distance; });
+	uint32 triangles = 0;
+	for (const OccluderCandidate& candidate : m_occluderCandidates)
+	{
+		if (triangles + candidate.indexCount / 3 > OccluderTriangleBudget)
+		{
+			break;
+		}
+
+		triangles += candidate.indexCount / 3;
+		if (candidate.shortIndices != nullptr)
+		{
+			m_occlusion.AddOccluder(candidate.positions, sizeof(VertexPositionColor), candidate.vertexCount, candidate.shortIndices, candidate.indexCount);
+		}
+		else
+		{
+			m_occlusion.AddOccluder(candidate.positions, sizeof(VertexPositionColor), candidate.vertexCount, candidate.indices, candidate.indexCount);
+		}
+	}
+	m_occlusion.Rasterize(m_jobSystem);
+}
+
+// Registra en el backend los sombreadores, el búfer de constantes y las mallas, con los identificadores
+// que usarán los paquetes.
+void Sample3DSceneRenderer::RegisterRenderResources()
+{
+	m_shaderId = m_renderBackend.RegisterShader(m_vertexShader.Get(), m_pixelShader.Get(), m_inputLayout.Get());
+	m_materialId = m_renderBackend.RegisterMaterial(m_constantBuffer.Get());
+
+	// Cada índice del cubo es un entero no firmado de 16 bits (corto).
+	m_cubeMeshId = m_renderBackend.RegisterMesh(
+		m_vertexBuffer.Get(),
+		sizeof(VertexPositionColor),
 		m_indexBuffer.Get(),
-		DXGI_FORMAT_R16_UINT, // Cada índice es un entero no firmado de 16 bits (corto).
-		0
+		DXGI_FORMAT_R16_UINT,
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
 		);
 
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	RegisterClothMesh();
+	RegisterSmoothMeshes();
+}
+
+void Sample3DSceneRenderer::RegisterClothMesh()
+{
+	if (m_clothVertexBuffer != nullptr)
+	{
+		m_clothMeshId = m_renderBackend.RegisterMesh(
+			m_clothVertexBuffer.Get(),
+			sizeof(VertexPositionColor),
+			m_clothIndexBuffer.Get(),
+			DXGI_FORMAT_R32_UINT,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+			);
+	}
+}
 
-	context->IASetInputLayout(m_inputLayout.Get());
+// Graba en list un dibujo de la malla del cubo con las constantes dadas; center da la profundidad de la
+// clave. No modifica el representador, así que se puede llamar desde varios subprocesos.
+void Sample3DSceneRenderer::AddCube(DX::RenderCommandBuffer& list, const ModelViewProjectionConstantBuffer& constants, const DX::Vector3& center) const
+{
+	float clip[4];
+	DX::TransformPoint(center, m_viewProjection, clip);
+	float depth = (clip[3] > 0.0f) ? clip[2] / clip[3] : 0.0f;
+
+	DX::DrawPacket packet;
+	packet.shader = static_cast<uint16_t>(m_shaderId);
+	packet.material = static_cast<uint16_t>(m_materialId);
+	packet.mesh = static_cast<uint16_t>(m_cubeMeshId);
+	packet.constantOffset = list.AddConstants(&constants, sizeof(constants));
+	packet.constantSize = sizeof(constants);
+	packet.indexCount = m_indexCount;
+	packet.startIndex = 0;
+	packet.baseVertex = 0;
+	list.Add(DX::RenderSortKey::Opaque(OpaquePass, m_shaderId, m_materialId, depth), packet);
+}
 
-	// Adjunte nuestro sombreador de vértices.
-	context->VSSetShader(
-		m_vertexShader.Get(),
-		nullptr,
-		0
-		);
+// Solo se sustituye la malla de la tela; el resto de recursos registrados conserva sus identificadores.
+void Sample3DSceneRenderer::SetCloth(ClothSimulation* cloth)
+{
+	m_cloth = cloth;
+	m_renderBackend.ReleaseMesh(m_clothMeshId);
+	m_clothMeshId = DX::InvalidPoolHandle;
+	m_clothVertexBuffer.Reset();
+	m_clothIndexBuffer.Reset();
+	m_clothIndexCount = 0;
+	CreateClothResources();
+	if (!m_renderBackend.IsEmpty())
+	{
+		RegisterClothMesh();
+	}
+}
+
+// Crea el búfer de vértices dinámico de la tela y un búfer de índices con las dos caras de cada triángulo.
+void Sample3DSceneRenderer::CreateClothResources()
+{
+	if (m_cloth == nullptr)
+	{
+		return;
+	}
 
-	// Envíe el búfer de constantes al dispositivo de gráficos.
-	context->VSSetConstantBuffers1(
-		0,
-		1,
-		m_constantBuffer.GetAddressOf(),
-		nullptr,
-		nullptr
+	CD3D11_BUFFER_DESC vertexBufferDesc(
+		m_cloth->GetParticleCount() * sizeof(VertexPositionColor),
+		D3D11_BIND_VERTEX_BUFFER,
+		D3D11_USAGE_DYNAMIC,
+		D3D11_CPU_ACCESS_WRITE
+		);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&vertexBufferDesc,
+			nullptr,
+			&m_clothVertexBuffer
+			)
 		);
 
-	// Adjunte nuestro sombreador de píxeles.
-	context->PSSetShader(
-		m_pixelShader.Get(),
-		nullptr,
-		0
+	const std::vector<uint32_t>& indices = m_cloth->GetIndices();
+	std::vector<uint32_t> twoSidedIndices(indices);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		twoSidedIndices.push_back(indices[i]);
+		twoSidedIndices.push_back(indices[i + 2]);
+		twoSidedIndices.push_back(indices[i + 1]);
+	}
+	m_clothIndexCount = static_cast<uint32>(twoSidedIndices.size());
+
+	D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+	indexBufferData.pSysMem = twoSidedIndices.data();
+	CD3D11_BUFFER_DESC indexBufferDesc(m_clothIndexCount * sizeof(uint32_t), D3D11_BIND_INDEX_BUFFER);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&indexBufferDesc,
+			&indexBufferData,
+			&m_clothIndexBuffer
+			)
 		);
+}
+
+// Escribe la tela en el búfer dinámico y graba su dibujo. La normal se muestra como color.
+void Sample3DSceneRenderer::AddCloth(ID3D11DeviceContext3* context)
+{
+	if (m_cloth == nullptr || m_clothVertexBuffer == nullptr)
+	{
+		return;
+	}
 
-	// Dibuje los objetos.
-	context->DrawIndexed(
-		m_indexCount,
-		0,
-		0
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(
+		context->Map(m_clothVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)
 		);
+	m_cloth->WriteVertices(static_cast<VertexPositionColor*>(mapped.pData));
+	context->Unmap(m_clothVertexBuffer.Get(), 0);
+
+	ModelViewProjectionConstantBuffer constants = m_constantBufferData;
+	StoreTransposed(constants.model, DX::Matrix4::Identity());
+
+	DX::DrawPacket packet;
+	packet.shader = static_cast<uint16_t>(m_shaderId);
+	packet.material = static_cast<uint16_t>(m_materialId);
+	packet.mesh = static_cast<uint16_t>(m_clothMeshId);
+	packet.constantOffset = m_commandBuffer.AddConstants(&constants, sizeof(constants));
+	packet.constantSize = sizeof(constants);
+	packet.indexCount = m_clothIndexCount;
+	packet.startIndex = 0;
+	packet.baseVertex = 0;
+	m_commandBuffer.Add(DX::RenderSortKey::Opaque(OpaquePass, m_shaderId, m_materialId, 1.0f), packet);
 }
 
-void Sample3DSceneRenderer::CreateDeviceDependentResources()
+// Búferes de índices del terreno, uno por nivel de detalle.
+void Sample3DSceneRenderer::CreateTerrainResources()
 {
-	// Cargue los sombreadores de forma asincrónica.
-	auto loadVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso");
-	auto loadPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso");
+	if (m_terrain == nullptr)
+	{
+		return;
+	}
 
-	// Una vez cargado el archivo del sombreador de vértices, cree el diseño de entrada y el sombreador.
-	auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
+	for (uint32 lod = 0; lod < m_terrain->GetDesc().lodCount; lod++)
+	{
+		const std::vector<uint16_t>& indices = m_terrain->GetIndices(lod);
+		D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+		indexBufferData.pSysMem = indices.data();
+		CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(indices.size() * sizeof(uint16_t)), D3D11_BIND_INDEX_BUFFER);
+		Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateVertexShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_vertexShader
+			m_deviceResources->GetD3DDevice()->CreateBuffer(
+				&indexBufferDesc,
+				&indexBufferData,
+				&indexBuffer
 				)
 			);
+		m_terrainIndexBuffers.push_back(indexBuffer);
+	}
+}
 
-		static const D3D11_INPUT_ELEMENT_DESC vertexDesc [] =
+void Sample3DSceneRenderer::SetTerrain(TerrainStreamer* terrain)
+{
+	m_terrain = terrain;
+	for (const auto& entry : m_terrainChunks)
+	{
+		m_renderBackend.ReleaseMesh(entry.second.meshId);
+	}
+	m_terrainChunks.clear();
+	m_terrainIndexBuffers.clear();
+	CreateTerrainResources();
+}
+
+// Aplica los trozos cargados y descargados desde el fotograma anterior. Si no hay ninguno creado (al
+// empezar o tras perder el dispositivo) se crean todos los que están cargados en ese momento.
+void Sample3DSceneRenderer::SyncTerrainChunks()
+{
+	if (m_terrain == nullptr || m_terrainIndexBuffers.empty())
+	{
+		return;
+	}
+
+	if (m_terrainChunks.empty())
+	{
+		for (uint32 i = 0; i < m_terrain->GetChunkCount(); i++)
 		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		};
+			CreateTerrainChunk(m_terrain->GetChunkHandle(i), m_terrain->GetChunk(i));
+		}
+	}
+	else
+	{
+		for (DX::PoolHandle handle : m_terrain->GetUnloadedChunks())
+		{
+			auto found = m_terrainChunks.find(handle);
+			if (found != m_terrainChunks.end())
+			{
+				m_renderBackend.ReleaseMesh(found->second.meshId);
+				m_terrainChunks.erase(found);
+			}
+		}
+
+		// Un trozo cargado y descargado antes de este fotograma ya no está en el terreno.
+		for (DX::PoolHandle handle : m_terrain->GetLoadedChunks())
+		{
+			const TerrainChunk* chunk = m_terrain->FindChunk(handle);
+			if (chunk != nullptr)
+			{
+				CreateTerrainChunk(handle, *chunk);
+			}
+		}
+	}
+	m_terrain->ClearChanges();
+}
 
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateInputLayout(
-				vertexDesc,
-				ARRAYSIZE(vertexDesc),
-				&fileData[0],
-				fileData.size(),
-				&m_inputLayout
-				)
-			);
-	});
+void Sample3DSceneRenderer::CreateTerrainChunk(DX::PoolHandle handle, const TerrainChunk& chunk)
+{
+	static_assert(DX::VertexElementsMatch<TerrainVertex, VertexPositionColor>::Value && sizeof(TerrainVertex) == sizeof(VertexPositionColor), "TerrainVertex debe tener la disposición de VertexPositionColor");
+
+	TerrainChunkResources resources;
+	D3D11_SUBRESOURCE_DATA vertexBufferData = {0};
+	vertexBufferData.pSysMem = chunk.vertices.data();
+	CD3D11_BUFFER_DESC vertexBufferDesc(static_cast<UINT>(chunk.vertices.size() * sizeof(TerrainVertex)), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&vertexBufferDesc,
+			&vertexBufferData,
+			&resources.vertexBuffer
+			)
+		);
 
-	// Una vez cargado el archivo del sombreador de píxeles, cree el búfer de constantes y el sombreador.
-	auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreatePixelShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_pixelShader
-				)
-			);
+	resources.meshId = m_renderBackend.RegisterMesh(
+		resources.vertexBuffer.Get(),
+		sizeof(VertexPositionColor),
+		m_terrainIndexBuffers[chunk.lod].Get(),
+		DXGI_FORMAT_R16_UINT,
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+		);
+	resources.indexCount = static_cast<uint32>(m_terrain->GetIndices(chunk.lod).size());
+	resources.center = chunk.center;
+	resources.radius = chunk.radius;
+	m_terrainChunks[handle] = resources;
+}
+
+// Graba un dibujo por trozo visible. Todos usan la matriz de modelo identidad, así que comparten las
+// constantes.
+void Sample3DSceneRenderer::AddTerrain(DX::RenderCommandBuffer& list)
+{
+	if (m_terrainChunks.empty())
+	{
+		return;
+	}
+
+	ModelViewProjectionConstantBuffer constants = m_constantBufferData;
+	StoreTransposed(constants.model, DX::Matrix4::Identity());
+	uint32 constantOffset = list.AddConstants(&constants, sizeof(constants));
+
+	for (const auto& entry : m_terrainChunks)
+	{
+		const TerrainChunkResources& chunk = entry.second;
+		if (!m_frustum.IntersectsSphere(chunk.center, chunk.radius) || !m_occlusion.IsSphereVisible(chunk.center, chunk.radius))
+		{
+			continue;
+		}
+
+		float clip[4];
+		DX::TransformPoint(chunk.center, m_viewProjection, clip);
+		float depth = (clip[3] > 0.0f) ? clip[2] / clip[3] : 0.0f;
+
+		DX::DrawPacket packet;
+		packet.shader = static_cast<uint16_t>(m_shaderId);
+		packet.material = static_cast<uint16_t>(m_materialId);
+		packet.mesh = static_cast<uint16_t>(chunk.meshId);
+		packet.constantOffset = constantOffset;
+		packet.constantSize = sizeof(constants);
+		packet.indexCount = chunk.indexCount;
+		packet.startIndex = 0;
+		packet.baseVertex = 0;
+		list.Add(DX::RenderSortKey::Opaque(OpaquePass, m_shaderId, m_materialId, depth), packet);
+	}
+}
+
+void Sample3DSceneRenderer::SetVoxelVolume(VoxelVolume* volume)
+{
+	m_voxelVolume = volume;
+	for (const VoxelChunkResources& chunk : m_voxelChunks)
+	{
+		if (chunk.meshId != DX::InvalidPoolHandle)
+		{
+			m_renderBackend.ReleaseMesh(chunk.meshId);
+		}
+	}
+	m_voxelChunks.clear();
+}
 
-		CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ModelViewProjectionConstantBuffer) , D3D11_BIND_CONSTANT_BUFFER);
+// Vuelve a crear los trozos mallados desde el fotograma anterior. Sin recursos (al empezar o tras perder
+// el dispositivo) se crean todos.
+void Sample3DSceneRenderer::SyncVoxelChunks()
+{
+	if (m_voxelVolume == nullptr)
+	{
+		return;
+	}
+
+	if (m_voxelChunks.empty())
+	{
+		m_voxelChunks.resize(m_voxelVolume->GetChunkCount());
+		for (VoxelChunkResources& resources : m_voxelChunks)
+		{
+			resources.meshId = DX::InvalidPoolHandle;
+			resources.indexCount = 0;
+		}
+		for (uint32 chunk = 0; chunk < m_voxelVolume->GetChunkCount(); chunk++)
+		{
+			CreateVoxelChunk(chunk);
+		}
+	}
+	else
+	{
+		for (uint32 chunk : m_voxelVolume->GetChangedChunks())
+		{
+			CreateVoxelChunk(chunk);
+		}
+	}
+	m_voxelVolume->ClearChanges();
+}
+
+void Sample3DSceneRenderer::CreateVoxelChunk(uint32 chunk)
+{
+	static_assert(DX::VertexElementsMatch<VoxelVertex, VertexPositionColor>::Value && sizeof(VoxelVertex) == sizeof(VertexPositionColor), "VoxelVertex debe tener la disposición de VertexPositionColor");
+
+	VoxelChunkResources& resources = m_voxelChunks[chunk];
+	if (resources.meshId != DX::InvalidPoolHandle)
+	{
+		m_renderBackend.ReleaseMesh(resources.meshId);
+	}
+	resources.vertexBuffer.Reset();
+	resources.indexBuffer.Reset();
+	resources.meshId = DX::InvalidPoolHandle;
+	resources.indexCount = 0;
+
+	const VoxelChunkMesh& mesh = m_voxelVolume->GetChunkMesh(chunk);
+	if (mesh.indices.empty())
+	{
+		return;
+	}
+
+	D3D11_SUBRESOURCE_DATA vertexBufferData = {0};
+	vertexBufferData.pSysMem = mesh.vertices.data();
+	CD3D11_BUFFER_DESC vertexBufferDesc(static_cast<UINT>(mesh.vertices.size() * sizeof(VoxelVertex)), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&vertexBufferDesc,
+			&vertexBufferData,
+			&resources.vertexBuffer
+			)
+		);
+
+	D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+	indexBufferData.pSysMem = mesh.indices.data();
+	CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(mesh.indices.size() * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&indexBufferDesc,
+			&indexBufferData,
+			&resources.indexBuffer
+			)
+		);
+
+	resources.meshId = m_renderBackend.RegisterMesh(
+		resources.vertexBuffer.Get(),
+		sizeof(VertexPositionColor),
+		resources.indexBuffer.Get(),
+		DXGI_FORMAT_R32_UINT,
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+		);
+	resources.indexCount = static_cast<uint32>(mesh.indices.size());
+	resources.center = mesh.center;
+	resources.radius = mesh.radius;
+}
+
+// Igual que el terreno: matriz de modelo identidad compartida y un dibujo por trozo visible.
+void Sample3DSceneRenderer::AddVoxels(DX::RenderCommandBuffer& list)
+{
+	if (m_voxelChunks.empty())
+	{
+		return;
+	}
+
+	ModelViewProjectionConstantBuffer constants = m_constantBufferData;
+	StoreTransposed(constants.model, DX::Matrix4::Identity());
+	uint32 constantOffset = list.AddConstants(&constants, sizeof(constants));
+
+	for (const VoxelChunkResources& chunk : m_voxelChunks)
+	{
+		if (chunk.indexCount == 0 || !m_frustum.IntersectsSphere(chunk.center, chunk.radius) || !m_occlusion.IsSphereVisible(chunk.center, chunk.radius))
+		{
+			continue;
+		}
+
+		float clip[4];
+		DX::TransformPoint(chunk.center, m_viewProjection, clip);
+		float depth = (clip[3] > 0.0f) ? clip[2] / clip[3] : 0.0f;
+
+		DX::DrawPacket packet;
+		packet.shader = static_cast<uint16_t>(m_shaderId);
+		packet.material = static_cast<uint16_t>(m_materialId);
+		packet.mesh = static_cast<uint16_t>(chunk.meshId);
+		packet.constantOffset = constantOffset;
+		packet.constantSize = sizeof(constants);
+		packet.indexCount = chunk.indexCount;
+		packet.startIndex = 0;
+		packet.baseVertex = 0;
+		list.Add(DX::RenderSortKey::Opaque(OpaquePass, m_shaderId, m_materialId, depth), packet);
+	}
+}
+
+// Un búfer de vértices dinámico con capacidad para el nivel más fino y un búfer de índices por nivel.
+void Sample3DSceneRenderer::CreateSmoothResources()
+{
+	uint32 levelCount = m_smoothStencils.GetLevelCount();
+	CD3D11_BUFFER_DESC vertexBufferDesc(
+		m_smoothStencils.GetVertexCount(levelCount - 1) * sizeof(SmoothVertex),
+		D3D11_BIND_VERTEX_BUFFER,
+		D3D11_USAGE_DYNAMIC,
+		D3D11_CPU_ACCESS_WRITE
+		);
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateBuffer(
+			&vertexBufferDesc,
+			nullptr,
+			&m_smoothVertexBuffer
+			)
+		);
+
+	m_smoothIndexBuffers.clear();
+	for (uint32 level = 0; level < levelCount; level++)
+	{
+		const DX::TaggedVector<uint32_t, DX::MemoryTag::Meshes>& triangles = m_smoothStencils.GetTriangles(level);
+		D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+		indexBufferData.pSysMem = triangles.data();
+		CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(triangles.size() * sizeof(uint32_t)), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+		Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 		DX::ThrowIfFailed(
 			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&constantBufferDesc,
-				nullptr,
-				&m_constantBuffer
+				&indexBufferDesc,
+				&indexBufferData,
+				&indexBuffer
 				)
 			);
+		m_smoothIndexBuffers.push_back(indexBuffer);
+	}
+}
+
+// El diseño de entrada lee la posición y el color al principio de cada vértice; el relleno solo cambia el paso.
+void Sample3DSceneRenderer::RegisterSmoothMeshes()
+{
+	static_assert(DX::VertexElementsMatch<SmoothVertex, VertexPositionColor>::Value, "SmoothVertex debe empezar como VertexPositionColor");
+
+	m_smoothMeshIds.clear();
+	for (const auto& indexBuffer : m_smoothIndexBuffers)
+	{
+		m_smoothMeshIds.push_back(m_renderBackend.RegisterMesh(
+			m_smoothVertexBuffer.Get(),
+			sizeof(SmoothVertex),
+			indexBuffer.Get(),
+			DXGI_FORMAT_R32_UINT,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+			));
+	}
+}
+
+// Anima las esquinas del cubo de control (cada una late con su fase y el conjunto gira), elige el nivel por
+// el tamaño en pantalla de una arista y escribe los vértices refinados directamente en el búfer dinámico.
+void Sample3DSceneRenderer::AddSmoothSurface(ID3D11DeviceContext3* context)
+{
+	if (m_jobSystem == nullptr || m_smoothVertexBuffer == nullptr || m_smoothMeshIds.empty())
+	{
+		return;
+	}
+
+	float clip[4];
+	DX::TransformPoint(SmoothCenter, m_viewProjection, clip);
+	if (clip[3] <= 0.0f || !m_frustum.IntersectsSphere(SmoothCenter, SmoothHalfSize * 2.5f))
+	{
+		return;
+	}
+	float edgePixels = 2.0f * SmoothHalfSize * m_pixelsPerUnit / clip[3];
+	uint32 level = m_smoothStencils.SelectLevel(edgePixels, SmoothEdgePixels);
+
+	// El ángulo de giro y las fases de los ocho vértices, en una sola pasada de SinCos.
+	float angles[9];
+	float sines[9];
+	float cosines[9];
+	for (uint32 i = 0; i < 8; i++)
+	{
+		angles[i] = 2.0f * m_smoothSeconds + 1.7f * i;
+	}
+	angles[8] = 0.5f * m_smoothSeconds;
+	DX::SinCos(angles, 9, sines, cosines);
+
+	float cosAngle = cosines[8];
+	float sinAngle = sines[8];
+	for (uint32 i = 0; i < 8; i++)
+	{
+		float pulse = SmoothHalfSize * (1.0f + 0.3f * sines[i]);
+		float x = ((i & 4) ? pulse : -pulse);
+		float y = ((i & 2) ? pulse : -pulse);
+		float z = ((i & 1) ? pulse : -pulse);
+		float* vertex = &m_smoothCage[i * SmoothFloatsPerVertex];
+		vertex[0] = SmoothCenter.x + x * cosAngle + z * sinAngle;
+		vertex[1] = SmoothCenter.y + y;
+		vertex[2] = SmoothCenter.z - x * sinAngle + z * cosAngle;
+		vertex[3] = (i & 4) ? 1.0f : 0.0f;
+		vertex[4] = (i & 2) ? 1.0f : 0.0f;
+		vertex[5] = (i & 1) ? 1.0f : 0.0f;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(
+		context->Map(m_smoothVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)
+		);
+	m_smoothStencils.Apply(m_jobSystem, level, m_smoothCage.data(), SmoothFloatsPerVertex, static_cast<float*>(mapped.pData));
+	context->Unmap(m_smoothVertexBuffer.Get(), 0);
+
+	ModelViewProjectionConstantBuffer constants = m_constantBufferData;
+	StoreTransposed(constants.model, DX::Matrix4::Identity());
+
+	DX::DrawPacket packet;
+	packet.shader = static_cast<uint16_t>(m_shaderId);
+	packet.material = static_cast<uint16_t>(m_materialId);
+	packet.mesh = static_cast<uint16_t>(m_smoothMeshIds[level]);
+	packet.constantOffset = m_commandBuffer.AddConstants(&constants, sizeof(constants));
+	packet.constantSize = sizeof(constants);
+	packet.indexCount = static_cast<uint32>(m_smoothStencils.GetTriangles(level).size());
+	packet.startIndex = 0;
+	packet.baseVertex = 0;
+	m_commandBuffer.Add(DX::RenderSortKey::Opaque(OpaquePass, m_shaderId, m_materialId, clip[2] / clip[3]), packet);
+}
+
+void Sample3DSceneRenderer::CreateDeviceDependentResources()
+{
+	CreateClothResources();
+	CreateTerrainResources();
+	CreateSmoothResources();
+
+	// Tras perder el dispositivo, DeviceResources ya ha vuelto a crear los sombreadores, el búfer de
+	// constantes y el cubo a partir de las copias del registro, así que no hay que leer los archivos.
+	DX::ResourceRegistry* registry = m_deviceResources->GetResourceRegistry();
+	if (m_shadowsRegistered)
+	{
+		m_loadingComplete = true;
+		return;
+	}
+	registry->RemoveOwner(this);
+
+	// Cargue los sombreadores de forma asincrónica.
+	auto loadVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso");
+	auto loadPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso");
+
+	// Una vez cargado el archivo del sombreador de vértices, obtenga el diseño de entrada y el sombreador
+	// de la caché del dispositivo, que los comparte con otros representadores que usen los mismos. El
+	// registro guarda el código para recrearlos sin el archivo.
+	auto createVSTask = loadVSTask.then([this, registry](const std::vector<byte>& fileData) {
+		registry->Register(this, DX::ShadowKind::Shader, DX::ShadowPriority::Visible, &fileData[0], fileData.size(), [this](const uint8_t* data, size_t size) {
+			DX::D3D11ResourceCache* cache = m_deviceResources->GetResourceCache();
+			m_vertexShader = cache->GetVertexShader(data, size);
+
+			m_inputLayout = cache->GetInputLayout<VertexPositionColor>(data, size);
+		});
+	});
+
+	// Una vez cargado el archivo del sombreador de píxeles, cree el búfer de constantes y el sombreador.
+	// Las constantes se escriben en cada fotograma, así que del búfer basta con la descripción.
+	auto createPSTask = loadPSTask.then([this, registry](const std::vector<byte>& fileData) {
+		registry->Register(this, DX::ShadowKind::Shader, DX::ShadowPriority::Visible, &fileData[0], fileData.size(), [this](const uint8_t* data, size_t size) {
+			m_pixelShader = m_deviceResources->GetResourceCache()->GetPixelShader(data, size);
+		});
+
+		registry->Register(this, DX::ShadowKind::ConstantData, DX::ShadowPriority::Visible, nullptr, 0, [this](const uint8_t*, size_t) {
+			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ModelViewProjectionConstantBuffer) , D3D11_BIND_CONSTANT_BUFFER);
+			DX::ThrowIfFailed(
+				m_deviceResources->GetD3DDevice()->CreateBuffer(
+					&constantBufferDesc,
+					nullptr,
+					&m_constantBuffer
+					)
+				);
+		});
 	});
 
 	// Una vez cargados ambos sombreadores, cree la malla.
-	auto createCubeTask = (createPSTask && createVSTask).then([this] () {
+	auto createCubeTask = (createPSTask && createVSTask).then([this, registry] () {
 
 		// Cargue los vértices de malla. Cada vértice tiene una posición y un color.
 		static const VertexPositionColor cubeVertices[] = 
 		{
-			{XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f)},
-			{XMFLOAT3(-0.5f, -0.5f,  0.5f), XMFLOAT3(0.0f, 0.0f, 1.0f)},
-			{XMFLOAT3(-0.5f,  0.5f, -0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f)},
-			{XMFLOAT3(-0.5f,  0.5f,  0.5f), XMFLOAT3(0.0f, 1.0f, 1.0f)},
-			{XMFLOAT3( 0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, 0.0f, 0.0f)},
-			{XMFLOAT3( 0.5f, -0.5f,  0.5f), XMFLOAT3(1.0f, 0.0f, 1.0f)},
-			{XMFLOAT3( 0.5f,  0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f)},
-			{XMFLOAT3( 0.5f,  0.5f,  0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f)},
+			{{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f, 0.0f}},
+			{{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}},
+			{{-0.5f,  0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
+			{{-0.5f,  0.5f,  0.5f}, {0.0f, 1.0f, 1.0f}},
+			{{ 0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+			{{ 0.5f, -0.5f,  0.5f}, {1.0f, 0.0f, 1.0f}},
+			{{ 0.5f,  0.5f, -0.5f}, {1.0f, 1.0f, 0.0f}},
+			{{ 0.5f,  0.5f,  0.5f}, {1.0f, 1.0f, 1.0f}},
 		};
 
-		D3D11_SUBRESOURCE_DATA vertexBufferData = {0};
-		vertexBufferData.pSysMem = cubeVertices;
-		vertexBufferData.SysMemPitch = 0;
-		vertexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(cubeVertices), D3D11_BIND_VERTEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&vertexBufferDesc,
-				&vertexBufferData,
-				&m_vertexBuffer
-				)
-			);
+		registry->Register(this, DX::ShadowKind::Mesh, DX::ShadowPriority::Visible, cubeVertices, sizeof(cubeVertices), [this](const uint8_t* data, size_t size) {
+			D3D11_SUBRESOURCE_DATA vertexBufferData = {0};
+			vertexBufferData.pSysMem = data;
+			vertexBufferData.SysMemPitch = 0;
+			vertexBufferData.SysMemSlicePitch = 0;
+			CD3D11_BUFFER_DESC vertexBufferDesc(static_cast<UINT>(size), D3D11_BIND_VERTEX_BUFFER);
+			DX::ThrowIfFailed(
+				m_deviceResources->GetD3DDevice()->CreateBuffer(
+					&vertexBufferDesc,
+					&vertexBufferData,
+					&m_vertexBuffer
+					)
+				);
+		});
 
 		// Cargue los índices de malla. Cada trío de índices representa
 		// un triángulo que se va a presentar en la pantalla.
@@ -292,22 +961,26 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 		m_indexCount = ARRAYSIZE(cubeIndices);
 
-		D3D11_SUBRESOURCE_DATA indexBufferData = {0};
-		indexBufferData.pSysMem = cubeIndices;
-		indexBufferData.SysMemPitch = 0;
-		indexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC indexBufferDesc(sizeof(cubeIndices), D3D11_BIND_INDEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&indexBufferDesc,
-				&indexBufferData,
-				&m_indexBuffer
-				)
-			);
+		registry->Register(this, DX::ShadowKind::Mesh, DX::ShadowPriority::Visible, cubeIndices, sizeof(cubeIndices), [this](const uint8_t* data, size_t size) {
+			D3D11_SUBRESOURCE_DATA indexBufferData = {0};
+			indexBufferData.pSysMem = data;
+			indexBufferData.SysMemPitch = 0;
+			indexBufferData.SysMemSlicePitch = 0;
+			CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(size), D3D11_BIND_INDEX_BUFFER);
+			DX::ThrowIfFailed(
+				m_deviceResources->GetD3DDevice()->CreateBuffer(
+					&indexBufferDesc,
+					&indexBufferData,
+					&m_indexBuffer
+					)
+				);
+		});
 	});
 
-	// Una vez cargado el cubo, el objeto está listo para su presentación.
+	// Una vez cargado el cubo, el objeto está listo para su presentación. La tela no necesita copia: su
+	// búfer de vértices se reescribe cada fotograma y los índices salen de la simulación.
 	createCubeTask.then([this] () {
+		m_shadowsRegistered = true;
 		m_loadingComplete = true;
 	});
 }
@@ -321,4 +994,13 @@ void Sample3DSceneRenderer::ReleaseDeviceDependentResources()
 	m_constantBuffer.Reset();
 	m_vertexBuffer.Reset();
 	m_indexBuffer.Reset();
+	m_clothVertexBuffer.Reset();
+	m_clothIndexBuffer.Reset();
+	m_terrainIndexBuffers.clear();
+	m_terrainChunks.clear();
+	m_voxelChunks.clear();
+	m_smoothVertexBuffer.Reset();
+	m_smoothIndexBuffers.clear();
+	m_smoothMeshIds.clear();
+	m_renderBackend.Clear();
 }
\ No newline at end of file
@@ -3,6 +3,17 @@
 #include "..\Common\DeviceResources.h"
 #include "ShaderStructures.h"
 #include "..\Common\StepTimer.h"
+#include "RigidBodyWorld.h"
+#include "ClothSimulation.h"
+#include "TerrainStreamer.h"
+#include "VoxelVolume.h"
+#include "..\Common\Frustum.h"
+#include "..\Common\OcclusionCuller.h"
+#include "..\Common\JobSystem.h"
+#include "..\Common\RenderCommandBuffer.h"
+#include "..\Common\SubdivisionStencils.h"
+#include "..\Common\ParallelCommandRecorder.h"
+#include "D3D11RenderBackend.h"
 
 namespace App2
 {
@@ -11,6 +22,7 @@ namespace App2
 	{
 	public:
 		Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		~Sample3DSceneRenderer();
 		void CreateDeviceDependentResources();
 		void CreateWindowSizeDependentResources();
 		void ReleaseDeviceDependentResources();
@@ -20,10 +32,34 @@ namespace App2
 		void TrackingUpdate(float positionX);
 		void StopTracking();
 		bool IsTracking() { return m_tracking; }
+		bool IsLoadingComplete() const { return m_loadingComplete; }
+		void SetRigidBodyWorld(const RigidBodyWorld* world) { m_rigidBodyWorld = world; }
+		void SetCloth(ClothSimulation* cloth);
+		void SetTerrain(TerrainStreamer* terrain);
+		void SetVoxelVolume(VoxelVolume* volume);
+		void SetJobSystem(DX::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+		const DX::RenderStateStats& GetRenderStateStats() const { return m_renderBackend.GetStateStats(); }
+		DX::OcclusionStats GetOcclusionStats() const { return m_occlusion.GetStats(); }
 
 
 	private:
 		void Rotate(float radians);
+		void RegisterRenderResources();
+		void RegisterClothMesh();
+		void RasterizeOccluders();
+		void AddCube(DX::RenderCommandBuffer& list, const ModelViewProjectionConstantBuffer& constants, const DX::Vector3& center) const;
+		void CreateClothResources();
+		void AddCloth(ID3D11DeviceContext3* context);
+		void CreateTerrainResources();
+		void SyncTerrainChunks();
+		void CreateTerrainChunk(DX::PoolHandle handle, const TerrainChunk& chunk);
+		void AddTerrain(DX::RenderCommandBuffer& list);
+		void SyncVoxelChunks();
+		void CreateVoxelChunk(uint32 chunk);
+		void AddVoxels(DX::RenderCommandBuffer& list);
+		void CreateSmoothResources();
+		void RegisterSmoothMeshes();
+		void AddSmoothSurface(ID3D11DeviceContext3* context);
 
 	private:
 		// Puntero almacenado en caché para los recursos del dispositivo.
@@ -41,8 +77,88 @@ namespace App2
 		ModelViewProjectionConstantBuffer	m_constantBufferData;
 		uint32	m_indexCount;
 
+		// Si hay un mundo físico, se dibuja un cubo por cuerpo en lugar del cubo giratorio.
+		const RigidBodyWorld*	m_rigidBodyWorld;
+		DX::Frustum				m_frustum;
+		DX::Matrix4				m_viewProjection;
+
+		// Descarte por oclusión: en cada fotograma se rasterizan los trozos de terreno y de vóxeles más
+		// cercanos y se prueban contra ellos los cuerpos y los propios trozos.
+		struct OccluderCandidate
+		{
+			float				distance;
+			const void*			positions;
+			uint32				vertexCount;
+			const uint16_t*		shortIndices;
+			const uint32_t*		indices;
+			uint32				indexCount;
+		};
+
+		DX::OcclusionCuller				m_occlusion;
+		std::vector<OccluderCandidate>	m_occluderCandidates;
+
+		// Los dibujos se graban como paquetes (los cuerpos, en paralelo), se ordenan por clave y se
+		// reproducen en el contexto.
+		DX::JobSystem*				m_jobSystem;
+		DX::ParallelCommandRecorder	m_recorder;
+		DX::RenderCommandBuffer		m_commandBuffer;
+		D3D11RenderBackend			m_renderBackend;
+		uint32						m_shaderId;
+		uint32						m_materialId;
+		uint32						m_cubeMeshId;
+		uint32						m_clothMeshId;
+
+		// Tela: la simulación escribe directamente en un búfer de vértices dinámico en cada fotograma.
+		ClothSimulation*							m_cloth;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_clothVertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_clothIndexBuffer;
+		uint32										m_clothIndexCount;
+
+		// Terreno: un búfer de índices por nivel de detalle, común a todos los trozos, y un búfer de
+		// vértices inmutable con su malla del backend por cada trozo cargado. Los trozos se crean y se
+		// sueltan en Render según los cambios que anota TerrainStreamer.
+		struct TerrainChunkResources
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	vertexBuffer;
+			uint32									meshId;
+			uint32									indexCount;
+			DX::Vector3								center;
+			float									radius;
+		};
+
+		TerrainStreamer*											m_terrain;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>>			m_terrainIndexBuffers;
+		std::unordered_map<DX::PoolHandle, TerrainChunkResources>	m_terrainChunks;
+
+		// Vóxeles: búferes inmutables de vértices e índices por trozo, en el orden de VoxelVolume. Se
+		// vuelven a crear en Render los trozos que el volumen ha mallado de nuevo; los vacíos no tienen malla.
+		struct VoxelChunkResources
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	vertexBuffer;
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	indexBuffer;
+			uint32									meshId;
+			uint32									indexCount;
+			DX::Vector3								center;
+			float									radius;
+		};
+
+		VoxelVolume*						m_voxelVolume;
+		std::vector<VoxelChunkResources>	m_voxelChunks;
+
+		// Superficie suave: el cubo como malla de control de Catmull-Clark, con los vértices animados en la
+		// CPU y refinados en cada fotograma al nivel que pide su tamaño en pantalla. Comparten un búfer de
+		// vértices dinámico; cada nivel tiene su búfer de índices y su malla del backend.
+		DX::SubdivisionStencils								m_smoothStencils;
+		std::vector<float>									m_smoothCage;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>				m_smoothVertexBuffer;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>>	m_smoothIndexBuffers;
+		std::vector<uint32>									m_smoothMeshIds;
+		float												m_smoothSeconds;
+		float												m_pixelsPerUnit;	// A distancia 1 del ojo.
+
 		// Variables usadas con el bucle de representación.
 		bool	m_loadingComplete;
+		bool	m_shadowsRegistered;
 		float	m_degreesPerSecond;
 		bool	m_tracking;
 	};
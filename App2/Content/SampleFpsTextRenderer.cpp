@@ -8,10 +8,11 @@ using namespace Microsoft::WRL;
 
 // Inicializa los recursos D2D usados para la representación del texto.
 SampleFpsTextRenderer::SampleFpsTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) : 
-	m_text(L""),
+	m_displayedFps(0xffffffff),
 	m_deviceResources(deviceResources)
 {
 	ZeroMemory(&m_textMetrics, sizeof(DWRITE_TEXT_METRICS));
+	m_text[0] = L'\0';
 
 	// Crear recursos independientes del dispositivo
 	ComPtr<IDWriteTextFormat> textFormat;
@@ -46,16 +47,30 @@ SampleFpsTextRenderer::SampleFpsTextRenderer(const std::shared_ptr<DX::DeviceRes
 // Actualiza el texto que se va a mostrar.
 void SampleFpsTextRenderer::Update(DX::StepTimer const& timer)
 {
-	// Actualice el texto para mostrar.
+	// Actualice el texto para mostrar. El valor solo cambia una vez por segundo, así que
+	// la cadena y la maquetación se reutilizan mientras no cambie.
 	uint32 fps = timer.GetFramesPerSecond();
+	if (fps == m_displayedFps)
+	{
+		return;
+	}
+	m_displayedFps = fps;
 
-	m_text = (fps > 0) ? std::to_wstring(fps) + L" FPS" : L" - FPS";
+	// Se formatea en un búfer fijo para no reservar memoria en el montón.
+	if (fps > 0)
+	{
+		swprintf_s(m_text, L"%u FPS", fps);
+	}
+	else
+	{
+		wcscpy_s(m_text, L" - FPS");
+	}
 
 	ComPtr<IDWriteTextLayout> textLayout;
 	DX::ThrowIfFailed(
 		m_deviceResources->GetDWriteFactory()->CreateTextLayout(
-			m_text.c_str(),
-			(uint32) m_text.length(),
+			m_text,
+			(uint32) wcslen(m_text),
 			m_textFormat.Get(),
 			240.0f, // Ancho máximo del texto de entrada.
 			50.0f, // Alto máximo del texto de entrada.
@@ -21,7 +21,8 @@ namespace App2
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
 		// Recursos relacionados con la representación del texto.
-		std::wstring                                    m_text;
+		wchar_t                                         m_text[32];
+		uint32                                          m_displayedFps;
 		DWRITE_TEXT_METRICS	                            m_textMetrics;
 		Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>    m_whiteBrush;
 		Microsoft::WRL::ComPtr<ID2D1DrawingStateBlock1> m_stateBlock;
@@ -0,0 +1,47 @@
+﻿#include "SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+Matrix4 App2::ComputeSceneProjection(float width, float height, const Matrix4& orientation)
+{
+	return Matrix4::PerspectiveFovRH(GetSceneFovAngleY(width, height), width / height, 0.01f, 100.0f) * orientation;
+}
+
+float App2::GetSceneFovAngleY(float width, float height)
+{
+	float fovAngleY = 70.0f * 3.14159265f / 180.0f;
+
+	// Este es un ejemplo sencillo de los cambios que se pueden realizar cuando la aplicación está en
+	// vista Portrait o Snapped.
+	if (width < height)
+	{
+		fovAngleY *= 2.0f;
+	}
+	return fovAngleY;
+}
+
+Vector3 App2::GetSceneEyePosition()
+{
+	return Vector3(0.0f, 0.7f, 1.5f);
+}
+
+Vector3 App2::GetSceneTargetPosition()
+{
+	return Vector3(0.0f, -0.1f, 0.0f);
+}
+
+Matrix4 App2::ComputeSceneView()
+{
+	return Matrix4::LookAtRH(GetSceneEyePosition(), GetSceneTargetPosition(), Vector3(0.0f, 1.0f, 0.0f));
+}
+
+Matrix4 App2::ComputeCubeModel(float radians)
+{
+	return Matrix4::RotationY(radians);
+}
+
+Matrix4 App2::ComputeBodyModel(const RigidBody& body)
+{
+	return Matrix4::AffineTransformation(body.halfExtents * 2.0f, body.orientation, body.position);
+}
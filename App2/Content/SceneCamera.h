@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include "../Common/VectorMath.h"
+#include "RigidBodyWorld.h"
+
+namespace App2
+{
+	// Matrices de la escena de ejemplo sin dependencias de Direct3D, para que el representador y las
+	// pruebas de rendimiento calculen exactamente lo mismo. Todas usan vectores fila (v' = v * M);
+	// el representador las traspone al copiarlas en el búfer de constantes.
+
+	// Proyección en perspectiva para un destino de width x height, ya multiplicada por la transformación
+	// de orientación de la pantalla (DeviceResources::GetOrientationTransform3D).
+	DX::Matrix4 ComputeSceneProjection(float width, float height, const DX::Matrix4& orientation);
+
+	// Campo de visión vertical de la proyección, en radianes: 70 grados, el doble en vertical.
+	float GetSceneFovAngleY(float width, float height);
+
+	// Cámara fija en GetSceneEyePosition() = (0; 0,7; 1,5) mirando a GetSceneTargetPosition() = (0; -0,1; 0).
+	DX::Vector3 GetSceneEyePosition();
+	DX::Vector3 GetSceneTargetPosition();
+	DX::Matrix4 ComputeSceneView();
+
+	// Cubo de ejemplo girado alrededor del eje Y.
+	DX::Matrix4 ComputeCubeModel(float radians);
+
+	// El cubo de la malla mide 1 de lado, así que se escala al tamaño de la caja del cuerpo.
+	DX::Matrix4 ComputeBodyModel(const RigidBody& body);
+}
@@ -0,0 +1,158 @@
+﻿#include "SceneSimulation.h"
+#include "SceneCamera.h"
+
+#include <cmath>
+
+using namespace App2;
+using namespace DX;
+
+SceneSimulation::SceneSimulation(JobSystem* jobSystem) :
+	m_jobSystem(jobSystem),
+	m_voxelEdits(0),
+	m_voxelEditsSinceFill(0)
+{
+}
+
+// Crea una pila de cubos sobre un suelo estático.
+void SceneSimulation::CreateRigidBodies()
+{
+	const float size = 0.1f;
+	m_rigidBodyWorld = std::unique_ptr<RigidBodyWorld>(new RigidBodyWorld(m_jobSystem));
+
+	// La escena está a escala 1:10, así que la gravedad se escala igual para que se comporte como cajas de un metro.
+	m_rigidBodyWorld->SetGravity(Vector3(0.0f, -0.981f, 0.0f));
+
+	RigidBodyDesc ground;
+	ground.mass = 0.0f;
+	ground.halfExtents = Vector3(1.0f, 0.05f, 1.0f);
+	ground.position = Vector3(0.0f, -0.55f, 0.0f);
+	m_rigidBodyWorld->AddBody(ground);
+
+	for (uint32_t i = 0; i < 27; i++)
+	{
+		uint32_t layer = i / 9;
+		uint32_t cell = i % 9;
+		RigidBodyDesc box;
+		box.halfExtents = Vector3(size * 0.5f, size * 0.5f, size * 0.5f);
+		box.position = Vector3(
+			((cell % 3) - 1.0f) * size * 1.05f + (layer % 2) * size * 0.3f,
+			-0.5f + size * 0.5f + layer * size * 1.02f + 0.2f,
+			((cell / 3) - 1.0f) * size * 1.05f);
+		box.orientation = Quaternion::RotationAxis(Vector3(0.0f, 1.0f, 0.0f), 0.1f * layer);
+		m_rigidBodyWorld->AddBody(box);
+	}
+}
+
+// Crea una capa colgada de un hueso fijo y una esfera unida a un hueso que se balancea contra ella.
+void SceneSimulation::CreateCloth(FrameArena& frameArena)
+{
+	const uint32_t side = 32;
+	ClothMeshDesc mesh = ClothMeshDesc::CreateGrid(side, side, 0.02f, Vector3(-0.31f, 0.4f, -0.5f));
+	m_cloth = std::unique_ptr<ClothSimulation>(new ClothSimulation(m_jobSystem, mesh));
+	m_cloth->SetSolverIterations(16);
+
+	UpdateClothBones(0.0, frameArena);
+	for (uint32_t x = 0; x < side; x++)
+	{
+		m_cloth->AttachParticle(x, 0);
+	}
+	m_cloth->AddCollider(ClothCollider::Sphere(1, Vector3(), 0.1f));
+}
+
+// Solo prepara los índices; los trozos se generan en UpdateStreaming alrededor de la cámara.
+void SceneSimulation::CreateTerrain()
+{
+	m_terrain = std::unique_ptr<TerrainStreamer>(new TerrainStreamer(m_jobSystem, TerrainDesc::CreateDefault()));
+}
+
+void SceneSimulation::CreateVoxels()
+{
+	VoxelVolumeDesc desc;
+	desc.chunksX = 3;
+	desc.chunksY = 2;
+	desc.chunksZ = 3;
+	desc.chunkCells = 16;
+	desc.voxelSize = 0.025f;
+	desc.origin = Vector3(-2.4f, -0.6f, -2.0f);
+	m_voxelVolume = std::unique_ptr<VoxelVolume>(new VoxelVolume(m_jobSystem, desc));
+	FillVoxelVolume();
+	m_voxelVolume->Remesh();
+}
+
+void SceneSimulation::Create(FrameArena& frameArena)
+{
+	CreateRigidBodies();
+	CreateCloth(frameArena);
+	CreateTerrain();
+	CreateVoxels();
+}
+
+void SceneSimulation::Step(const StepTimer& timer, FrameArena& frameArena)
+{
+	float elapsedSeconds = static_cast<float>(timer.GetElapsedSeconds());
+	m_rigidBodyWorld->Step(elapsedSeconds);
+	UpdateClothBones(timer.GetTotalSeconds(), frameArena);
+	m_cloth->Step(elapsedSeconds);
+	UpdateVoxelEdits(timer.GetTotalSeconds());
+}
+
+void SceneSimulation::UpdateStreaming()
+{
+	m_terrain->Update(GetSceneEyePosition());
+	m_voxelVolume->Remesh();
+}
+
+void SceneSimulation::CompleteStreaming()
+{
+	do
+	{
+		m_terrain->Update(GetSceneEyePosition());
+	} while (m_terrain->GetStats().pendingChunks > 0);
+	m_voxelVolume->Remesh();
+}
+
+// Hueso 0: hombros de la capa, fijo. Hueso 1: esfera que oscila por detrás de la tela.
+void SceneSimulation::UpdateClothBones(double totalSeconds, FrameArena& frameArena)
+{
+	ArenaVector<ClothBonePose> poses(2, ClothBonePose(), ArenaAllocator<ClothBonePose>(frameArena.GetArena()));
+	poses[1].position = Vector3(0.25f * static_cast<float>(sin(totalSeconds)), 0.1f, -0.45f);
+	m_cloth->SetBonePoses(poses.data(), static_cast<uint32_t>(poses.size()));
+}
+
+// Roca ondulada a la izquierda de la escena, apoyada en el fondo del volumen.
+void SceneSimulation::FillVoxelVolume()
+{
+	const Vector3 center(-1.8f, -0.3f, -1.4f);
+	const float radius = 0.4f;
+	m_voxelVolume->Fill([center, radius](const Vector3& p)
+	{
+		Vector3 d = p - center;
+		float ripple = 0.03f * sinf(d.x * 23.0f) * sinf(d.y * 19.0f) * sinf(d.z * 21.0f);
+		return Length(d) - radius + ripple;
+	});
+	m_voxelEditsSinceFill = 0;
+}
+
+// Cada medio segundo excava una esfera en un punto de la roca; tras 24 la vuelve a rellenar. Las
+// posiciones salen de una secuencia fija para que la escena sea reproducible.
+void SceneSimulation::UpdateVoxelEdits(double totalSeconds)
+{
+	if (totalSeconds < 0.5 * (m_voxelEdits + 1))
+	{
+		return;
+	}
+
+	m_voxelEdits++;
+	if (m_voxelEditsSinceFill == 24)
+	{
+		FillVoxelVolume();
+		return;
+	}
+
+	float angle = 2.39996f * m_voxelEdits;
+	float height = 0.1f * static_cast<float>(m_voxelEdits % 5) - 0.2f;
+	float ring = sqrtf(0.38f * 0.38f - height * height);
+	Vector3 point(-1.8f + ring * cosf(angle), -0.3f + height, -1.4f + ring * sinf(angle));
+	m_voxelVolume->SubtractSphere(point, 0.09f);
+	m_voxelEditsSinceFill++;
+}
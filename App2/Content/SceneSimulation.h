@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "../Common/FrameArena.h"
+#include "../Common/JobSystem.h"
+#include "../Common/StepTimer.h"
+#include "ClothSimulation.h"
+#include "RigidBodyWorld.h"
+#include "TerrainStreamer.h"
+#include "VoxelVolume.h"
+
+namespace App2
+{
+	// Contenido animado de la escena de ejemplo sin dependencias de Direct3D: la pila de cubos, la tela
+	// colgada de dos huesos, el terreno alrededor de la cámara y la roca de vóxeles que se va excavando.
+	// App2Main lo avanza con el reloj de la ventana y AnimationExporter con un reloj determinista, de modo
+	// que los fotogramas exportados son los mismos que se ven en la aplicación.
+	class SceneSimulation
+	{
+	public:
+		explicit SceneSimulation(DX::JobSystem* jobSystem);
+
+		// Cada parte se crea por separado para que el arranque las reparta entre tareas en paralelo;
+		// Create las crea todas en orden. La tela reserva las poses iniciales de los huesos en la arena.
+		void CreateRigidBodies();
+		void CreateCloth(DX::FrameArena& frameArena);
+		void CreateTerrain();
+		void CreateVoxels();
+		void Create(DX::FrameArena& frameArena);
+
+		// Un paso fijo: se llama desde StepTimer::Tick o StepTimer::Advance.
+		void Step(const DX::StepTimer& timer, DX::FrameArena& frameArena);
+
+		// Una vez por fotograma (no por paso fijo), para que el tope de trozos generados sea por fotograma.
+		void UpdateStreaming();
+
+		// Como UpdateStreaming, pero genera todo el terreno pendiente sin tope: para empezar una exportación
+		// con la escena completa.
+		void CompleteStreaming();
+
+		RigidBodyWorld* GetRigidBodyWorld() const	{ return m_rigidBodyWorld.get(); }
+		ClothSimulation* GetCloth() const			{ return m_cloth.get(); }
+		TerrainStreamer* GetTerrain() const			{ return m_terrain.get(); }
+		VoxelVolume* GetVoxelVolume() const			{ return m_voxelVolume.get(); }
+
+	private:
+		void UpdateClothBones(double totalSeconds, DX::FrameArena& frameArena);
+		void FillVoxelVolume();
+		void UpdateVoxelEdits(double totalSeconds);
+
+		DX::JobSystem*						m_jobSystem;
+		std::unique_ptr<RigidBodyWorld>		m_rigidBodyWorld;
+		std::unique_ptr<ClothSimulation>	m_cloth;
+		std::unique_ptr<TerrainStreamer>	m_terrain;
+
+		// Roca de vóxeles que se va excavando; m_voxelEditsSinceFill cuenta las esferas quitadas desde el último relleno.
+		std::unique_ptr<VoxelVolume>		m_voxelVolume;
+		uint32_t							m_voxelEdits;
+		uint32_t							m_voxelEditsSinceFill;
+	};
+}
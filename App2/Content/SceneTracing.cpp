@@ -0,0 +1,110 @@
+﻿#include "SceneTracing.h"
+#include "SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Los índices de cubeIndices: la esquina i está en x = bit 2, y = bit 1, z = bit 0 y su color es ese mismo punto.
+	const uint16_t CubeIndices[] =
+	{
+		0, 2, 1, 1, 2, 3,	// -x
+		4, 5, 6, 5, 7, 6,	// +x
+		0, 1, 5, 0, 5, 4,	// -y
+		2, 6, 7, 2, 7, 3,	// +y
+		0, 4, 6, 0, 6, 2,	// -z
+		1, 3, 7, 1, 7, 5,	// +z
+	};
+
+	Vector3 GetCorner(uint32_t corner)
+	{
+		return Vector3((corner & 4) ? 1.0f : 0.0f, (corner & 2) ? 1.0f : 0.0f, (corner & 1) ? 1.0f : 0.0f);
+	}
+
+	// Triángulos indexados de vértices con posición y color (TerrainVertex y VoxelVertex).
+	template<typename TVertex, typename TIndex>
+	void AddIndexedTriangles(TraceScene& scene, const TVertex* vertices, const TIndex* indices, size_t indexCount)
+	{
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const TVertex& a = vertices[indices[i]];
+			const TVertex& b = vertices[indices[i + 1]];
+			const TVertex& c = vertices[indices[i + 2]];
+			Vector3 color(
+				(a.color[0] + b.color[0] + c.color[0]) * (1.0f / 3.0f),
+				(a.color[1] + b.color[1] + c.color[1]) * (1.0f / 3.0f),
+				(a.color[2] + b.color[2] + c.color[2]) * (1.0f / 3.0f));
+			scene.AddTriangle(
+				Vector3(a.position[0], a.position[1], a.position[2]),
+				Vector3(b.position[0], b.position[1], b.position[2]),
+				Vector3(c.position[0], c.position[1], c.position[2]),
+				color);
+		}
+	}
+}
+
+void App2::AddRigidBodies(TraceScene& scene, const RigidBodyWorld& world)
+{
+	for (const RigidBody& body : world.GetBodies())
+	{
+		Matrix4 model = ComputeBodyModel(body);
+		Vector3 corners[8];
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			float transformed[4];
+			TransformPoint(GetCorner(corner) - Vector3(0.5f, 0.5f, 0.5f), model, transformed);
+			corners[corner] = Vector3(transformed[0], transformed[1], transformed[2]);
+		}
+
+		for (uint32_t i = 0; i < sizeof(CubeIndices) / sizeof(CubeIndices[0]); i += 3)
+		{
+			uint16_t a = CubeIndices[i], b = CubeIndices[i + 1], c = CubeIndices[i + 2];
+			Vector3 color = (GetCorner(a) + GetCorner(b) + GetCorner(c)) * (1.0f / 3.0f);
+			scene.AddTriangle(corners[a], corners[b], corners[c], color);
+		}
+	}
+}
+
+void App2::AddTerrain(TraceScene& scene, const TerrainStreamer& terrain)
+{
+	for (uint32_t i = 0; i < terrain.GetChunkCount(); i++)
+	{
+		const TerrainChunk& chunk = terrain.GetChunk(i);
+		const std::vector<uint16_t>& indices = terrain.GetIndices(chunk.lod);
+		AddIndexedTriangles(scene, chunk.vertices.data(), indices.data(), indices.size());
+	}
+}
+
+void App2::AddVoxelVolume(TraceScene& scene, const VoxelVolume& volume)
+{
+	for (uint32_t chunk = 0; chunk < volume.GetChunkCount(); chunk++)
+	{
+		const VoxelChunkMesh& mesh = volume.GetChunkMesh(chunk);
+		AddIndexedTriangles(scene, mesh.vertices.data(), mesh.indices.data(), mesh.indices.size());
+	}
+}
+
+void App2::AddCloth(TraceScene& scene, const ClothSimulation& cloth, const Vector3& color)
+{
+	const std::vector<uint32_t>& indices = cloth.GetIndices();
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		scene.AddTriangle(cloth.GetParticlePosition(indices[i]), cloth.GetParticlePosition(indices[i + 1]), cloth.GetParticlePosition(indices[i + 2]), color);
+	}
+}
+
+void App2::AddSceneSimulation(TraceScene& scene, const SceneSimulation& simulation)
+{
+	AddRigidBodies(scene, *simulation.GetRigidBodyWorld());
+	AddTerrain(scene, *simulation.GetTerrain());
+	AddVoxelVolume(scene, *simulation.GetVoxelVolume());
+	AddCloth(scene, *simulation.GetCloth(), Vector3(0.7f, 0.2f, 0.2f));
+}
+
+void App2::SetSceneCamera(PathTracer& tracer)
+{
+	const PathTracerDesc& desc = tracer.GetDesc();
+	float fovAngleY = GetSceneFovAngleY(static_cast<float>(desc.width), static_cast<float>(desc.height));
+	tracer.SetCamera(GetSceneEyePosition(), GetSceneTargetPosition(), Vector3(0.0f, 1.0f, 0.0f), fovAngleY);
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include "../Common/PathTracer.h"
+#include "ClothSimulation.h"
+#include "RigidBodyWorld.h"
+#include "SceneSimulation.h"
+#include "TerrainStreamer.h"
+#include "VoxelVolume.h"
+
+namespace App2
+{
+	// Copian en un DX::TraceScene los triángulos que dibuja Sample3DSceneRenderer, en espacio del mundo y
+	// con el mismo sentido de giro, para trazar la escena sin GPU. El albedo de cada triángulo es la media
+	// de los colores de sus vértices; el terreno y los vóxeles ya llevan en ellos su iluminación
+	// precalculada, así que salen algo más oscuros que en la ventana.
+
+	// Un cubo por cuerpo, con los colores de las esquinas de cubeVertices.
+	void AddRigidBodies(DX::TraceScene& scene, const RigidBodyWorld& world);
+
+	// Trozos cargados, faldones incluidos.
+	void AddTerrain(DX::TraceScene& scene, const TerrainStreamer& terrain);
+
+	void AddVoxelVolume(DX::TraceScene& scene, const VoxelVolume& volume);
+
+	// La tela en su posición actual, de un solo color.
+	void AddCloth(DX::TraceScene& scene, const ClothSimulation& cloth, const DX::Vector3& color);
+
+	// Todo el contenido de la simulación, con la tela en rojo.
+	void AddSceneSimulation(DX::TraceScene& scene, const SceneSimulation& simulation);
+
+	// La cámara de SceneCamera para una imagen del tamaño del trazador.
+	void SetSceneCamera(DX::PathTracer& tracer);
+}
@@ -1,19 +1,34 @@
 ﻿#pragma once
 
+#include <cstddef>
+#include "..\Common\VectorMath.h"
+#include "..\Common\VertexFormat.h"
+
 namespace App2
 {
-	// Búfer de constantes usado para enviar matrices MVP al sombreador de vértices.
+	// Búfer de constantes usado para enviar matrices MVP al sombreador de vértices. Las matrices van
+	// traspuestas, por columnas, como las espera el sombreador.
 	struct ModelViewProjectionConstantBuffer
 	{
-		DirectX::XMFLOAT4X4 model;
-		DirectX::XMFLOAT4X4 view;
-		DirectX::XMFLOAT4X4 projection;
+		DX::Matrix4 model;
+		DX::Matrix4 view;
+		DX::Matrix4 projection;
 	};
 
 	// Se usa para enviar datos de vértice al sombreador de vértices.
 	struct VertexPositionColor
 	{
-		DirectX::XMFLOAT3 pos;
-		DirectX::XMFLOAT3 color;
+		float pos[3];
+		float color[3];
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<App2::VertexPositionColor> : VertexLayout<App2::VertexPositionColor,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(App2::VertexPositionColor, pos)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(App2::VertexPositionColor, color)>>
+	{
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,333 @@
+﻿#include "TerrainStreamer.h"
+#include "../Common/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Vértices del borde de una rejilla de (res + 1) x (res + 1), en orden alrededor del trozo.
+	uint32_t GetPerimeterVertex(uint32_t res, uint32_t k)
+	{
+		uint32_t side = k / res;
+		uint32_t offset = k % res;
+		uint32_t row = res + 1;
+		switch (side)
+		{
+		case 0:		return offset;									// z mínima, x creciente
+		case 1:		return offset * row + res;						// x máxima, z creciente
+		case 2:		return res * row + (res - offset);				// z máxima, x decreciente
+		default:	return (res - offset) * row;					// x mínima, z decreciente
+		}
+	}
+
+	// Color por altura y pendiente con la iluminación de una luz direccional ya aplicada, porque el
+	// sombreador de la escena solo interpola el color.
+	void ShadeVertex(float normalizedHeight, const Vector3& normal, float* color)
+	{
+		const Vector3 light(0.424f, 0.848f, 0.318f);
+		float lighting = 0.35f + 0.65f * std::max(0.0f, Dot(normal, light));
+
+		float t = std::min(1.0f, std::max(0.0f, normalizedHeight * 0.5f + 0.5f));
+		Vector3 low(0.20f, 0.38f, 0.16f);
+		Vector3 high(0.46f, 0.50f, 0.28f);
+		Vector3 rock(0.45f, 0.42f, 0.38f);
+		Vector3 base = low + (high - low) * t;
+		if (normal.y < 0.8f)
+		{
+			float steep = std::min(1.0f, (0.8f - normal.y) * 5.0f);
+			base = base + (rock - base) * steep;
+		}
+		color[0] = base.x * lighting;
+		color[1] = base.y * lighting;
+		color[2] = base.z * lighting;
+	}
+}
+
+TerrainDesc TerrainDesc::CreateDefault()
+{
+	TerrainDesc desc;
+	desc.seed = 7;
+	desc.noise.octaves = 5;
+	desc.noise.frequency = 0.15f;
+	desc.noise.lacunarity = 2.0f;
+	desc.noise.gain = 0.5f;
+	desc.baseHeight = -0.7f;
+	desc.heightScale = 1.5f;
+	desc.flatRadius = 2.0f;
+	desc.chunkSize = 2.0f;
+	desc.chunkQuads = 32;
+	desc.lodCount = 3;
+	desc.lodDistance = 2.0f;
+	desc.viewDistance = 6.0f;
+	desc.hysteresis = 0.25f;
+	desc.skirtDepth = 0.25f;
+	desc.maxChunksPerUpdate = 4;
+	return desc;
+}
+
+TerrainStreamer::TerrainStreamer(JobSystem* jobSystem, const TerrainDesc& desc) :
+	m_jobSystem(jobSystem),
+	m_desc(desc),
+	m_noise(desc.seed),
+	m_heights(jobSystem->GetThreadCount())
+{
+	if (desc.chunkQuads == 0 || desc.chunkQuads > 128 || (desc.chunkQuads & (desc.chunkQuads - 1)) != 0 ||
+		desc.lodCount == 0 || (desc.chunkQuads >> (desc.lodCount - 1)) == 0)
+	{
+		throw std::invalid_argument("chunkQuads debe ser una potencia de dos de 1 a 128 con lodCount niveles");
+	}
+
+	m_indices.resize(desc.lodCount);
+	for (uint32_t lod = 0; lod < desc.lodCount; lod++)
+	{
+		BuildIndices(lod);
+	}
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+uint64_t TerrainStreamer::MakeKey(int32_t x, int32_t z)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+uint32_t TerrainStreamer::GetLod(float distance) const
+{
+	float level = std::max(0.0f, distance) / m_desc.lodDistance;
+	return std::min(m_desc.lodCount - 1, static_cast<uint32_t>(level));
+}
+
+float TerrainStreamer::GetChunkDistance(int32_t x, int32_t z, float eyeX, float eyeZ) const
+{
+	float dx = x + 0.5f - eyeX;
+	float dz = z + 0.5f - eyeZ;
+	return sqrtf(dx * dx + dz * dz);
+}
+
+// Dentro de flatRadius del origen la altura es baseHeight; hasta el doble de ese radio se mezcla con el ruido.
+float TerrainStreamer::ShapeHeight(float noise, float x, float z) const
+{
+	float blend = 1.0f;
+	if (m_desc.flatRadius > 0.0f)
+	{
+		float t = (sqrtf(x * x + z * z) - m_desc.flatRadius) / m_desc.flatRadius;
+		t = std::min(1.0f, std::max(0.0f, t));
+		blend = t * t * (3.0f - 2.0f * t);
+	}
+	return m_desc.baseHeight + m_desc.heightScale * noise * blend;
+}
+
+float TerrainStreamer::GetHeight(float x, float z) const
+{
+	return ShapeHeight(m_noise.Fractal(x, z, m_desc.noise), x, z);
+}
+
+// Triángulos en el sentido de las agujas del reloj vistos desde arriba. Los del faldón van por las dos
+// caras para no depender de qué lado del trozo mira la cámara.
+void TerrainStreamer::BuildIndices(uint32_t lod)
+{
+	uint32_t res = m_desc.chunkQuads >> lod;
+	uint32_t row = res + 1;
+	uint32_t gridVertices = row * row;
+	std::vector<uint16_t>& indices = m_indices[lod];
+	indices.clear();
+	indices.reserve(res * res * 6 + res * 4 * 12);
+
+	for (uint32_t j = 0; j < res; j++)
+	{
+		for (uint32_t i = 0; i < res; i++)
+		{
+			uint16_t i0 = static_cast<uint16_t>(j * row + i);
+			uint16_t i1 = static_cast<uint16_t>(i0 + 1);
+			uint16_t i2 = static_cast<uint16_t>(i0 + row);
+			uint16_t i3 = static_cast<uint16_t>(i2 + 1);
+			uint16_t quad[6] = { i0, i1, i2, i1, i3, i2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	uint32_t perimeter = res * 4;
+	for (uint32_t k = 0; k < perimeter; k++)
+	{
+		uint32_t next = (k + 1) % perimeter;
+		uint16_t a = static_cast<uint16_t>(GetPerimeterVertex(res, k));
+		uint16_t b = static_cast<uint16_t>(GetPerimeterVertex(res, next));
+		uint16_t lowA = static_cast<uint16_t>(gridVertices + k);
+		uint16_t lowB = static_cast<uint16_t>(gridVertices + next);
+		uint16_t skirt[12] = { a, b, lowA, b, lowB, lowA, a, lowA, b, b, lowA, lowB };
+		indices.insert(indices.end(), skirt, skirt + 12);
+	}
+}
+
+// Las alturas se muestrean con un borde de una celda para calcular las normales por diferencias centrales;
+// las posiciones salen de índices enteros de la rejilla global del nivel, así que los bordes de trozos
+// vecinos (y los vértices que comparten niveles distintos) coinciden exactamente.
+void TerrainStreamer::GenerateChunk(TerrainChunk& chunk, std::vector<float>& heights) const
+{
+	uint32_t res = m_desc.chunkQuads >> chunk.lod;
+	uint32_t row = res + 1;
+	uint32_t stride = res + 3;
+	float step = m_desc.chunkSize / res;
+	int32_t firstX = chunk.x * static_cast<int32_t>(res) - 1;
+	int32_t firstZ = chunk.z * static_cast<int32_t>(res) - 1;
+
+	heights.resize(stride * stride);
+	for (uint32_t j = 0; j < stride; j++)
+	{
+		float worldZ = static_cast<float>(firstZ + static_cast<int32_t>(j)) * step;
+		float* line = &heights[j * stride];
+		m_noise.FractalRow(firstX, step, worldZ, stride, m_desc.noise, line);
+		for (uint32_t i = 0; i < stride; i++)
+		{
+			line[i] = ShapeHeight(line[i], static_cast<float>(firstX + static_cast<int32_t>(i)) * step, worldZ);
+		}
+	}
+
+	chunk.vertices.resize(row * row + res * 4);
+	float minY = heights[stride + 1];
+	float maxY = minY;
+	float inverseScale = (m_desc.heightScale != 0.0f) ? 1.0f / m_desc.heightScale : 0.0f;
+	for (uint32_t j = 0; j < row; j++)
+	{
+		for (uint32_t i = 0; i < row; i++)
+		{
+			const float* h = &heights[(j + 1) * stride + (i + 1)];
+			Vector3 normal = Normalize(Vector3(h[-1] - h[1], 2.0f * step, h[-static_cast<int32_t>(stride)] - h[stride]));
+
+			TerrainVertex& vertex = chunk.vertices[j * row + i];
+			vertex.position[0] = static_cast<float>(firstX + 1 + static_cast<int32_t>(i)) * step;
+			vertex.position[1] = h[0];
+			vertex.position[2] = static_cast<float>(firstZ + 1 + static_cast<int32_t>(j)) * step;
+			ShadeVertex((h[0] - m_desc.baseHeight) * inverseScale, normal, vertex.color);
+			minY = std::min(minY, h[0]);
+			maxY = std::max(maxY, h[0]);
+		}
+	}
+
+	for (uint32_t k = 0; k < res * 4; k++)
+	{
+		TerrainVertex& skirt = chunk.vertices[row * row + k];
+		skirt = chunk.vertices[GetPerimeterVertex(res, k)];
+		skirt.position[1] -= m_desc.skirtDepth;
+	}
+	minY -= m_desc.skirtDepth;
+
+	float half = m_desc.chunkSize * 0.5f;
+	float halfHeight = (maxY - minY) * 0.5f;
+	chunk.center = Vector3((chunk.x + 0.5f) * m_desc.chunkSize, minY + halfHeight, (chunk.z + 0.5f) * m_desc.chunkSize);
+	chunk.radius = sqrtf(2.0f * half * half + halfHeight * halfHeight);
+}
+
+void TerrainStreamer::Update(const Vector3& eye)
+{
+	DX_PROFILE_SCOPE("TerrainStreamer::Update");
+	auto start = std::chrono::steady_clock::now();
+	float eyeX = eye.x / m_desc.chunkSize;
+	float eyeZ = eye.z / m_desc.chunkSize;
+	m_stats.unloadedChunks = 0;
+
+	// Descarga. Se recorre al revés porque Destroy mueve el último trozo al hueco.
+	for (uint32_t i = m_chunks.GetCount(); i-- > 0;)
+	{
+		const TerrainChunk& chunk = m_chunks[i];
+		if (GetChunkDistance(chunk.x, chunk.z, eyeX, eyeZ) > m_desc.viewDistance + m_desc.hysteresis)
+		{
+			PoolHandle handle = m_chunks.GetHandle(i);
+			m_chunkMap.erase(MakeKey(chunk.x, chunk.z));
+			m_unloaded.push_back(handle);
+			m_chunks.Destroy(handle);
+			m_stats.unloadedChunks++;
+		}
+	}
+
+	// Trozos que faltan o cuyo nivel ya no vale, aunque se tenga en cuenta el margen.
+	m_requests.clear();
+	int32_t radius = static_cast<int32_t>(ceilf(m_desc.viewDistance));
+	int32_t centerX = static_cast<int32_t>(floorf(eyeX));
+	int32_t centerZ = static_cast<int32_t>(floorf(eyeZ));
+	for (int32_t z = centerZ - radius; z <= centerZ + radius; z++)
+	{
+		for (int32_t x = centerX - radius; x <= centerX + radius; x++)
+		{
+			float distance = GetChunkDistance(x, z, eyeX, eyeZ);
+			if (distance > m_desc.viewDistance)
+			{
+				continue;
+			}
+
+			auto found = m_chunkMap.find(MakeKey(x, z));
+			if (found != m_chunkMap.end())
+			{
+				uint32_t lod = m_chunks.Get(found->second)->lod;
+				if (lod >= GetLod(distance - m_desc.hysteresis) && lod <= GetLod(distance + m_desc.hysteresis))
+				{
+					continue;
+				}
+			}
+
+			Request request = { x, z, GetLod(distance), distance };
+			m_requests.push_back(request);
+		}
+	}
+
+	// Los más cercanos primero, hasta el tope de la llamada, generados en paralelo.
+	uint32_t count = std::min(static_cast<uint32_t>(m_requests.size()), m_desc.maxChunksPerUpdate);
+	std::partial_sort(m_requests.begin(), m_requests.begin() + count, m_requests.end(), [](const Request& a, const Request& b)
+	{
+		return a.distance < b.distance;
+	});
+
+	m_generated.resize(count);
+	m_jobSystem->ParallelFor(count, 1, [this](uint32_t begin, uint32_t end)
+	{
+		// El índice del subproceso es global; solo es válido para los trabajadores del JobSystem del terreno.
+		uint32_t thread = JobSystem::GetCurrentThreadIndex();
+		if (thread >= m_heights.size())
+		{
+			throw std::out_of_range("El subproceso no tiene alturas de trabajo: no es de este JobSystem");
+		}
+		std::vector<float>& heights = m_heights[thread];
+		for (uint32_t i = begin; i < end; i++)
+		{
+			TerrainChunk& chunk = m_generated[i];
+			chunk.x = m_requests[i].x;
+			chunk.z = m_requests[i].z;
+			chunk.lod = m_requests[i].lod;
+			GenerateChunk(chunk, heights);
+		}
+	});
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t key = MakeKey(m_generated[i].x, m_generated[i].z);
+		auto found = m_chunkMap.find(key);
+		if (found != m_chunkMap.end())
+		{
+			m_unloaded.push_back(found->second);
+			m_chunks.Destroy(found->second);
+			m_stats.unloadedChunks++;
+		}
+
+		PoolHandle handle = m_chunks.Create(std::move(m_generated[i]));
+		m_chunkMap[key] = handle;
+		m_loaded.push_back(handle);
+	}
+
+	m_stats.loadedChunks = m_chunks.GetCount();
+	m_stats.pendingChunks = static_cast<uint32_t>(m_requests.size()) - count;
+	m_stats.generatedChunks = count;
+	m_stats.totalGeneratedChunks += count;
+	m_stats.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TerrainStreamer::ClearChanges()
+{
+	m_loaded.clear();
+	m_unloaded.clear();
+}
@@ -0,0 +1,145 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../Common/GradientNoise.h"
+#include "../Common/HandlePool.h"
+#include "../Common/JobSystem.h"
+#include "../Common/MemoryTracker.h"
+#include "../Common/VectorMath.h"
+#include "../Common/VertexFormat.h"
+
+namespace App2
+{
+	// Posición y color, tres flotantes cada uno: el renderizador comprueba que coincide con VertexPositionColor.
+	struct TerrainVertex
+	{
+		float	position[3];
+		float	color[3];
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<App2::TerrainVertex> : VertexLayout<App2::TerrainVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(App2::TerrainVertex, position)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(App2::TerrainVertex, color)>>
+	{
+	};
+}
+
+namespace App2
+{
+
+	// Distancias en trozos (lados de chunkSize unidades del mundo), medidas en el plano XZ desde el ojo hasta
+	// el centro de cada trozo.
+	struct TerrainDesc
+	{
+		uint32_t		seed;
+		DX::NoiseDesc	noise;
+		float			baseHeight;
+		float			heightScale;
+		float			flatRadius;			// Alrededor del origen el terreno baja a baseHeight (la escena está ahí).
+		float			chunkSize;
+		uint32_t		chunkQuads;			// Cuadrados por lado en el nivel 0: potencia de dos, como mucho 128.
+		uint32_t		lodCount;			// Cada nivel tiene la mitad de resolución que el anterior.
+		float			lodDistance;		// Nivel = distancia / lodDistance.
+		float			viewDistance;		// Se cargan los trozos a esta distancia o menos.
+		float			hysteresis;			// Margen antes de descargar un trozo o cambiar su nivel.
+		float			skirtDepth;
+		uint32_t		maxChunksPerUpdate;	// Tope de trozos generados en cada Update.
+
+		static TerrainDesc CreateDefault();
+	};
+
+	struct TerrainChunk
+	{
+		int32_t			x;
+		int32_t			z;
+		uint32_t		lod;
+		DX::Vector3		center;		// Esfera envolvente, faldón incluido.
+		float			radius;
+		DX::TaggedVector<TerrainVertex, DX::MemoryTag::Meshes>	vertices;
+	};
+
+	struct TerrainStats
+	{
+		uint32_t	loadedChunks;
+		uint32_t	pendingChunks;			// Trozos que faltan o tienen otro nivel tras la última llamada.
+		uint32_t	generatedChunks;		// En la última llamada.
+		uint32_t	unloadedChunks;			// En la última llamada, incluidos los sustituidos por otro nivel.
+		uint64_t	totalGeneratedChunks;
+		double		updateMilliseconds;
+	};
+
+	// Terreno de alturas dividido en trozos que se generan alrededor del ojo. Cada Update descarga los
+	// trozos lejanos y genera en paralelo, de más cercano a más lejano, como mucho maxChunksPerUpdate de
+	// los que faltan o han cambiado de nivel de detalle; el resto espera a la siguiente llamada. Las grietas
+	// entre niveles se tapan con un faldón vertical en el borde de cada trozo. Los trozos viven en un
+	// HandlePool: quien los dibuja sigue los cambios con GetLoadedChunks y GetUnloadedChunks.
+	class TerrainStreamer
+	{
+	public:
+		TerrainStreamer(DX::JobSystem* jobSystem, const TerrainDesc& desc);
+
+		void Update(const DX::Vector3& eye);
+
+		// Altura del terreno en (x, z); en los vértices del nivel 0 coincide con la de la malla.
+		float GetHeight(float x, float z) const;
+
+		const TerrainDesc& GetDesc() const						{ return m_desc; }
+		const TerrainStats& GetStats() const					{ return m_stats; }
+
+		// Índices de 16 bits comunes a todos los trozos de un nivel: rejilla y faldón (por las dos caras).
+		const std::vector<uint16_t>& GetIndices(uint32_t lod) const	{ return m_indices[lod]; }
+
+		// Trozos cargados, en orden denso.
+		uint32_t GetChunkCount() const							{ return m_chunks.GetCount(); }
+		const TerrainChunk& GetChunk(uint32_t i) const			{ return m_chunks[i]; }
+		DX::PoolHandle GetChunkHandle(uint32_t i) const			{ return m_chunks.GetHandle(i); }
+		const TerrainChunk* FindChunk(DX::PoolHandle handle) const	{ return m_chunks.Get(handle); }
+
+		// Cambios acumulados desde la última llamada a ClearChanges. Un trozo que cambia de nivel aparece
+		// como descargado y cargado con otro identificador; uno cargado y descargado entre dos consultas
+		// aparece en las dos listas y FindChunk ya no lo encuentra.
+		const std::vector<DX::PoolHandle>& GetLoadedChunks() const		{ return m_loaded; }
+		const std::vector<DX::PoolHandle>& GetUnloadedChunks() const	{ return m_unloaded; }
+		void ClearChanges();
+
+	private:
+		struct Request
+		{
+			int32_t		x;
+			int32_t		z;
+			uint32_t	lod;
+			float		distance;
+		};
+
+		static uint64_t MakeKey(int32_t x, int32_t z);
+		uint32_t GetLod(float distance) const;
+		float GetChunkDistance(int32_t x, int32_t z, float eyeX, float eyeZ) const;
+		void BuildIndices(uint32_t lod);
+		void GenerateChunk(TerrainChunk& chunk, std::vector<float>& heights) const;
+		float ShapeHeight(float noise, float x, float z) const;
+
+		DX::JobSystem*		m_jobSystem;
+		TerrainDesc			m_desc;
+		DX::GradientNoise	m_noise;
+		std::vector<std::vector<uint16_t>>	m_indices;
+
+		DX::HandlePool<TerrainChunk, DX::MemoryTag::Meshes>	m_chunks;
+		std::unordered_map<uint64_t, DX::PoolHandle>		m_chunkMap;
+
+		// Memoria reutilizada entre llamadas: peticiones, trozos recién generados y alturas por subproceso.
+		std::vector<Request>				m_requests;
+		std::vector<TerrainChunk>			m_generated;
+		std::vector<std::vector<float>>		m_heights;
+
+		std::vector<DX::PoolHandle>	m_loaded;
+		std::vector<DX::PoolHandle>	m_unloaded;
+		TerrainStats				m_stats;
+	};
+}
@@ -0,0 +1,414 @@
+﻿#include "VoxelVolume.h"
+#include "../Common/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace App2;
+using namespace DX;
+
+const float VoxelVolume::AirDensity = 1.0f;
+
+namespace
+{
+	// Índice del bit menos significativo a 1 (bits != 0). Con mitades de 32 bits para que valga también en ARM.
+	inline uint32_t LowestBit(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(bits)))
+		{
+			return index;
+		}
+		_BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+		return index + 32;
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+	}
+
+	// Aristas de una celda como pares de esquinas; la esquina c está en (c & 1, (c >> 1) & 1, c >> 2).
+	const uint8_t CellEdges[12][2] =
+	{
+		{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+		{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+	};
+
+	// Piedra iluminada por una luz direccional; el sombreador de la escena solo interpola el color.
+	void ShadeVertex(const Vector3& normal, float* color)
+	{
+		const Vector3 light(0.424f, 0.848f, 0.318f);
+		float lighting = 0.3f + 0.7f * std::max(0.0f, Dot(normal, light));
+		color[0] = 0.58f * lighting;
+		color[1] = 0.52f * lighting;
+		color[2] = 0.46f * lighting;
+	}
+
+	// Dos triángulos en el sentido de las agujas del reloj vistos desde fuera del sólido. c[sa][sb] son
+	// las celdas alrededor de la arista; positive indica que el sólido está en su extremo menor.
+	inline void AddQuad(TaggedVector<uint32_t, MemoryTag::Voxels>& indices, const uint32_t c[2][2], bool positive)
+	{
+		if (positive)
+		{
+			uint32_t quad[6] = { c[0][0], c[0][1], c[1][1], c[0][0], c[1][1], c[1][0] };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+		else
+		{
+			uint32_t quad[6] = { c[0][0], c[1][1], c[0][1], c[0][0], c[1][0], c[1][1] };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+VoxelVolume::VoxelVolume(JobSystem* jobSystem, const VoxelVolumeDesc& desc) :
+	m_jobSystem(jobSystem),
+	m_desc(desc),
+	m_pointsX(desc.chunksX * desc.chunkCells + 1),
+	m_pointsY(desc.chunksY * desc.chunkCells + 1),
+	m_pointsZ(desc.chunksZ * desc.chunkCells + 1),
+	m_scratch(jobSystem->GetThreadCount())
+{
+	if (desc.chunkCells < 2 || desc.chunkCells > 62 || desc.chunksX == 0 || desc.chunksY == 0 || desc.chunksZ == 0)
+	{
+		throw std::invalid_argument("chunkCells debe estar entre 2 y 62 y el volumen debe tener algún trozo");
+	}
+
+	m_density.assign(static_cast<size_t>(m_pointsX) * m_pointsY * m_pointsZ, AirDensity);
+	uint32_t chunkCount = desc.chunksX * desc.chunksY * desc.chunksZ;
+	m_meshes.resize(chunkCount);
+	for (VoxelChunkMesh& mesh : m_meshes)
+	{
+		mesh.radius = 0.0f;
+	}
+	m_dirty.assign(chunkCount, 0);
+	m_changed.assign(chunkCount, 0);
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void VoxelVolume::MarkAllDirty()
+{
+	MarkDirty(0, 0, 0, m_pointsX - 1, m_pointsY - 1, m_pointsZ - 1);
+}
+
+// Un trozo lee las muestras de su esquina mínima hasta chunkCells + 1 más allá (una celda de solape con el
+// siguiente), así que una muestra cambiada puede afectar a dos trozos por eje.
+void VoxelVolume::MarkDirty(uint32_t minX, uint32_t minY, uint32_t minZ, uint32_t maxX, uint32_t maxY, uint32_t maxZ)
+{
+	uint32_t n = m_desc.chunkCells;
+	auto range = [n](uint32_t minPoint, uint32_t maxPoint, uint32_t chunks, uint32_t& first, uint32_t& last)
+	{
+		first = (minPoint > n + 1) ? (minPoint - n - 1 + n - 1) / n : 0;
+		last = std::min(chunks - 1, maxPoint / n);
+	};
+
+	uint32_t firstX, lastX, firstY, lastY, firstZ, lastZ;
+	range(minX, maxX, m_desc.chunksX, firstX, lastX);
+	range(minY, maxY, m_desc.chunksY, firstY, lastY);
+	range(minZ, maxZ, m_desc.chunksZ, firstZ, lastZ);
+	for (uint32_t z = firstZ; z <= lastZ; z++)
+	{
+		for (uint32_t y = firstY; y <= lastY; y++)
+		{
+			for (uint32_t x = firstX; x <= lastX; x++)
+			{
+				uint32_t chunk = (z * m_desc.chunksY + y) * m_desc.chunksX + x;
+				if (!m_dirty[chunk])
+				{
+					m_dirty[chunk] = 1;
+					m_dirtyChunks.push_back(chunk);
+				}
+			}
+		}
+	}
+}
+
+// Recorre las muestras interiores dentro de la caja de la esfera y combina cada una con la distancia a ella.
+template<typename TCombine>
+void VoxelVolume::EditSphere(const Vector3& center, float radius, const TCombine& combine)
+{
+	Vector3 local = (center - m_desc.origin) * (1.0f / m_desc.voxelSize);
+	float reach = radius / m_desc.voxelSize + 1.0f;
+	if (local.x + reach < 1.0f || local.y + reach < 1.0f || local.z + reach < 1.0f ||
+		local.x - reach > m_pointsX - 2.0f || local.y - reach > m_pointsY - 2.0f || local.z - reach > m_pointsZ - 2.0f)
+	{
+		return;
+	}
+
+	// Solo muestras interiores: la capa exterior sigue siendo aire.
+	auto clampRange = [](float value, uint32_t points)
+	{
+		return static_cast<uint32_t>(std::min(std::max(value, 1.0f), static_cast<float>(points - 2)));
+	};
+	uint32_t minX = clampRange(floorf(local.x - reach), m_pointsX);
+	uint32_t minY = clampRange(floorf(local.y - reach), m_pointsY);
+	uint32_t minZ = clampRange(floorf(local.z - reach), m_pointsZ);
+	uint32_t maxX = clampRange(ceilf(local.x + reach), m_pointsX);
+	uint32_t maxY = clampRange(ceilf(local.y + reach), m_pointsY);
+	uint32_t maxZ = clampRange(ceilf(local.z + reach), m_pointsZ);
+
+	for (uint32_t z = minZ; z <= maxZ; z++)
+	{
+		for (uint32_t y = minY; y <= maxY; y++)
+		{
+			for (uint32_t x = minX; x <= maxX; x++)
+			{
+				float sphere = Length(GetPointPosition(x, y, z) - center) - radius;
+				float& density = m_density[GetPointIndex(x, y, z)];
+				density = combine(density, sphere);
+			}
+		}
+	}
+	MarkDirty(minX, minY, minZ, maxX, maxY, maxZ);
+}
+
+void VoxelVolume::AddSphere(const Vector3& center, float radius)
+{
+	EditSphere(center, radius, [](float density, float sphere) { return std::min(density, sphere); });
+}
+
+void VoxelVolume::SubtractSphere(const Vector3& center, float radius)
+{
+	EditSphere(center, radius, [](float density, float sphere) { return std::max(density, -sphere); });
+}
+
+void VoxelVolume::Remesh()
+{
+	DX_PROFILE_SCOPE("VoxelVolume::Remesh");
+	auto start = std::chrono::steady_clock::now();
+	uint32_t count = static_cast<uint32_t>(m_dirtyChunks.size());
+	m_jobSystem->ParallelFor(count, 1, [this](uint32_t begin, uint32_t end)
+	{
+		// El índice del subproceso es global; solo es válido para los trabajadores del JobSystem del volumen.
+		uint32_t thread = JobSystem::GetCurrentThreadIndex();
+		if (thread >= m_scratch.size())
+		{
+			throw std::out_of_range("El subproceso no tiene memoria de mallado: no es de este JobSystem");
+		}
+		Scratch& scratch = m_scratch[thread];
+		for (uint32_t i = begin; i < end; i++)
+		{
+			MeshChunk(m_dirtyChunks[i], scratch);
+		}
+	});
+
+	for (uint32_t chunk : m_dirtyChunks)
+	{
+		m_dirty[chunk] = 0;
+		if (!m_changed[chunk])
+		{
+			m_changed[chunk] = 1;
+			m_changedChunks.push_back(chunk);
+		}
+	}
+	m_dirtyChunks.clear();
+
+	m_stats.vertices = 0;
+	m_stats.triangles = 0;
+	for (const VoxelChunkMesh& mesh : m_meshes)
+	{
+		m_stats.vertices += static_cast<uint32_t>(mesh.vertices.size());
+		m_stats.triangles += static_cast<uint32_t>(mesh.indices.size() / 3);
+	}
+	m_stats.remeshedChunks = count;
+	m_stats.totalRemeshedChunks += count;
+	m_stats.remeshMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void VoxelVolume::ClearChanges()
+{
+	for (uint32_t chunk : m_changedChunks)
+	{
+		m_changed[chunk] = 0;
+	}
+	m_changedChunks.clear();
+}
+
+// Redes de superficie sobre las celdas del trozo más una de solape en cada eje positivo (la que comparte
+// con el siguiente trozo). Cada arista pertenece al trozo que contiene la menor de sus cuatro celdas, así
+// que ningún cuadrilátero se genera dos veces.
+void VoxelVolume::MeshChunk(uint32_t chunk, Scratch& scratch)
+{
+	uint32_t n = m_desc.chunkCells;
+	uint32_t chunkX = chunk % m_desc.chunksX;
+	uint32_t chunkY = (chunk / m_desc.chunksX) % m_desc.chunksY;
+	uint32_t chunkZ = chunk / (m_desc.chunksX * m_desc.chunksY);
+	uint32_t baseX = chunkX * n;
+	uint32_t baseY = chunkY * n;
+	uint32_t baseZ = chunkZ * n;
+
+	// Celdas con vértice posible: las del trozo y la de solape, si existe.
+	uint32_t cellsX = std::min(n + 1, m_pointsX - 1 - baseX);
+	uint32_t cellsY = std::min(n + 1, m_pointsY - 1 - baseY);
+	uint32_t cellsZ = std::min(n + 1, m_pointsZ - 1 - baseZ);
+	uint32_t rowsY = cellsY + 1;
+	uint32_t pointsX = cellsX + 1;
+
+	// Signos de las muestras, una fila de bits por (y, z), de cuatro en cuatro.
+	scratch.signs.resize(rowsY * (cellsZ + 1));
+	SimdFloat4 zero = SimdFloat4::Splat(0.0f);
+	for (uint32_t z = 0; z <= cellsZ; z++)
+	{
+		for (uint32_t y = 0; y <= cellsY; y++)
+		{
+			const float* row = &m_density[GetPointIndex(baseX, baseY + y, baseZ + z)];
+			uint64_t bits = 0;
+			uint32_t x = 0;
+			for (; x + 4 <= pointsX; x += 4)
+			{
+				bits |= static_cast<uint64_t>(LessEqualMask(SimdFloat4::Load(row + x), zero)) << x;
+			}
+			for (; x < pointsX; x++)
+			{
+				bits |= static_cast<uint64_t>(row[x] <= 0.0f) << x;
+			}
+			scratch.signs[z * rowsY + y] = bits;
+		}
+	}
+	auto signs = [&scratch, rowsY](uint32_t y, uint32_t z) { return scratch.signs[z * rowsY + y]; };
+
+	VoxelChunkMesh& mesh = m_meshes[chunk];
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	uint32_t stride = n + 1;
+	scratch.cellVertex.resize(stride * stride * stride);
+
+	// Celdas mixtas: alguna esquina sólida y alguna no, 64 celdas de una fila a la vez.
+	uint64_t cellMask = (1ull << cellsX) - 1;
+	Vector3 boundsMin(1e30f, 1e30f, 1e30f);
+	Vector3 boundsMax(-1e30f, -1e30f, -1e30f);
+	for (uint32_t z = 0; z < cellsZ; z++)
+	{
+		for (uint32_t y = 0; y < cellsY; y++)
+		{
+			uint64_t r00 = signs(y, z), r10 = signs(y + 1, z), r01 = signs(y, z + 1), r11 = signs(y + 1, z + 1);
+			uint64_t any = r00 | r10 | r01 | r11;
+			uint64_t all = r00 & r10 & r01 & r11;
+			uint64_t mixed = ((any | (any >> 1)) & ~(all & (all >> 1))) & cellMask;
+			while (mixed != 0)
+			{
+				uint32_t x = LowestBit(mixed);
+				mixed &= mixed - 1;
+
+				float corner[8];
+				for (uint32_t c = 0; c < 8; c++)
+				{
+					corner[c] = m_density[GetPointIndex(baseX + x + (c & 1), baseY + y + ((c >> 1) & 1), baseZ + z + (c >> 2))];
+				}
+
+				Vector3 sum;
+				uint32_t crossings = 0;
+				for (const uint8_t* edge : CellEdges)
+				{
+					float a = corner[edge[0]];
+					float b = corner[edge[1]];
+					if ((a <= 0.0f) != (b <= 0.0f))
+					{
+						float t = a / (a - b);
+						Vector3 pa(static_cast<float>(edge[0] & 1), static_cast<float>((edge[0] >> 1) & 1), static_cast<float>(edge[0] >> 2));
+						Vector3 pb(static_cast<float>(edge[1] & 1), static_cast<float>((edge[1] >> 1) & 1), static_cast<float>(edge[1] >> 2));
+						sum = sum + pa + (pb - pa) * t;
+						crossings++;
+					}
+				}
+
+				Vector3 gradient(
+					(corner[1] + corner[3] + corner[5] + corner[7]) - (corner[0] + corner[2] + corner[4] + corner[6]),
+					(corner[2] + corner[3] + corner[6] + corner[7]) - (corner[0] + corner[1] + corner[4] + corner[5]),
+					(corner[4] + corner[5] + corner[6] + corner[7]) - (corner[0] + corner[1] + corner[2] + corner[3]));
+				float length = Length(gradient);
+				Vector3 normal = (length > 0.0f) ? gradient * (1.0f / length) : Vector3(0.0f, 1.0f, 0.0f);
+
+				Vector3 cellPosition = Vector3(static_cast<float>(baseX + x), static_cast<float>(baseY + y), static_cast<float>(baseZ + z)) + sum * (1.0f / crossings);
+				Vector3 position = m_desc.origin + cellPosition * m_desc.voxelSize;
+				VoxelVertex vertex;
+				vertex.position[0] = position.x;
+				vertex.position[1] = position.y;
+				vertex.position[2] = position.z;
+				ShadeVertex(normal, vertex.color);
+				scratch.cellVertex[(z * stride + y) * stride + x] = static_cast<uint32_t>(mesh.vertices.size());
+				mesh.vertices.push_back(vertex);
+				boundsMin = Min(boundsMin, position);
+				boundsMax = Max(boundsMax, position);
+			}
+		}
+	}
+
+	// Aristas propias que cambian de signo. Las cuatro celdas de una arista que cambia de signo son mixtas,
+	// así que todas tienen vértice. Límites de cada eje: extremo menor de la arista en [0, min(n, celdas))
+	// a lo largo de ella y en [1, min(n, celdas - 1)] en los otros dos.
+	auto cellVertex = [&scratch, stride](uint32_t x, uint32_t y, uint32_t z) { return scratch.cellVertex[(z * stride + y) * stride + x]; };
+	uint32_t alongX = std::min(n, cellsX), alongY = std::min(n, cellsY), alongZ = std::min(n, cellsZ);
+	uint32_t acrossX = std::min(n, cellsX - 1), acrossY = std::min(n, cellsY - 1), acrossZ = std::min(n, cellsZ - 1);
+
+	// Aristas en X: celdas (x, y - sa, z - sb).
+	uint64_t alongXMask = (1ull << alongX) - 1;
+	for (uint32_t z = 1; z <= acrossZ; z++)
+	{
+		for (uint32_t y = 1; y <= acrossY; y++)
+		{
+			uint64_t row = signs(y, z);
+			uint64_t edges = (row ^ (row >> 1)) & alongXMask;
+			while (edges != 0)
+			{
+				uint32_t x = LowestBit(edges);
+				edges &= edges - 1;
+				uint32_t cells[2][2] = { { cellVertex(x, y, z), cellVertex(x, y, z - 1) }, { cellVertex(x, y - 1, z), cellVertex(x, y - 1, z - 1) } };
+				AddQuad(mesh.indices, cells, ((row >> x) & 1) != 0);
+			}
+		}
+	}
+
+	// Aristas en Y: celdas (x - sb, y, z - sa).
+	uint64_t acrossXMask = ((1ull << (acrossX + 1)) - 1) & ~1ull;
+	for (uint32_t z = 1; z <= acrossZ; z++)
+	{
+		for (uint32_t y = 0; y < alongY; y++)
+		{
+			uint64_t row = signs(y, z);
+			uint64_t edges = (row ^ signs(y + 1, z)) & acrossXMask;
+			while (edges != 0)
+			{
+				uint32_t x = LowestBit(edges);
+				edges &= edges - 1;
+				uint32_t cells[2][2] = { { cellVertex(x, y, z), cellVertex(x - 1, y, z) }, { cellVertex(x, y, z - 1), cellVertex(x - 1, y, z - 1) } };
+				AddQuad(mesh.indices, cells, ((row >> x) & 1) != 0);
+			}
+		}
+	}
+
+	// Aristas en Z: celdas (x - sa, y - sb, z).
+	for (uint32_t z = 0; z < alongZ; z++)
+	{
+		for (uint32_t y = 1; y <= acrossY; y++)
+		{
+			uint64_t row = signs(y, z);
+			uint64_t edges = (row ^ signs(y, z + 1)) & acrossXMask;
+			while (edges != 0)
+			{
+				uint32_t x = LowestBit(edges);
+				edges &= edges - 1;
+				uint32_t cells[2][2] = { { cellVertex(x, y, z), cellVertex(x, y - 1, z) }, { cellVertex(x - 1, y, z), cellVertex(x - 1, y - 1, z) } };
+				AddQuad(mesh.indices, cells, ((row >> x) & 1) != 0);
+			}
+		}
+	}
+
+	if (mesh.vertices.empty())
+	{
+		mesh.center = Vector3();
+		mesh.radius = 0.0f;
+	}
+	else
+	{
+		mesh.center = (boundsMin + boundsMax) * 0.5f;
+		mesh.radius = Length(boundsMax - mesh.center);
+	}
+}
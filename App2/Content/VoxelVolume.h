@@ -0,0 +1,154 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Common/JobSystem.h"
+#include "../Common/MemoryTracker.h"
+#include "../Common/VectorMath.h"
+#include "../Common/VertexFormat.h"
+
+namespace App2
+{
+	// Volumen de chunksX x chunksY x chunksZ trozos de chunkCells celdas por lado; cada celda mide voxelSize
+	// y la esquina mínima está en origin.
+	struct VoxelVolumeDesc
+	{
+		uint32_t	chunksX;
+		uint32_t	chunksY;
+		uint32_t	chunksZ;
+		uint32_t	chunkCells;		// Como mucho 62, para que una fila de signos quepa en 64 bits.
+		float		voxelSize;
+		DX::Vector3	origin;
+	};
+
+	// Posición y color, tres flotantes cada uno: el renderizador comprueba que coincide con VertexPositionColor.
+	struct VoxelVertex
+	{
+		float	position[3];
+		float	color[3];
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<App2::VoxelVertex> : VertexLayout<App2::VoxelVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(App2::VoxelVertex, position)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(App2::VoxelVertex, color)>>
+	{
+	};
+}
+
+namespace App2
+{
+
+	// Malla de un trozo: cada vértice lo comparten todos los cuadriláteros de su celda.
+	struct VoxelChunkMesh
+	{
+		DX::TaggedVector<VoxelVertex, DX::MemoryTag::Voxels>	vertices;
+		DX::TaggedVector<uint32_t, DX::MemoryTag::Voxels>		indices;
+		DX::Vector3		center;		// Esfera envolvente; radio 0 si la malla está vacía.
+		float			radius;
+	};
+
+	struct VoxelStats
+	{
+		uint32_t	remeshedChunks;		// En la última llamada a Remesh.
+		uint32_t	vertices;			// De todo el volumen.
+		uint32_t	triangles;
+		uint64_t	totalRemeshedChunks;
+		double		remeshMilliseconds;
+	};
+
+	// Volumen de densidad (distancia con signo: negativa dentro del sólido) con mallas por trozo generadas
+	// por redes de superficie (surface nets): un vértice por celda que corta la superficie, en la media de
+	// los cortes de sus aristas, y un cuadrilátero por arista de la rejilla que cambia de signo. Las
+	// ediciones marcan solo los trozos cuyas muestras han cambiado; Remesh los vuelve a mallar en paralelo.
+	// La capa exterior de muestras es siempre aire, de modo que las superficies quedan cerradas.
+	class VoxelVolume
+	{
+	public:
+		VoxelVolume(DX::JobSystem* jobSystem, const VoxelVolumeDesc& desc);
+
+		// Rellena todas las muestras con density(posición en el mundo) y marca todos los trozos.
+		template<typename TDensity>
+		void Fill(const TDensity& density)
+		{
+			m_jobSystem->ParallelFor(m_pointsZ, 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t z = begin; z < end; z++)
+				{
+					for (uint32_t y = 0; y < m_pointsY; y++)
+					{
+						for (uint32_t x = 0; x < m_pointsX; x++)
+						{
+							m_density[GetPointIndex(x, y, z)] = IsBorder(x, y, z) ? AirDensity : density(GetPointPosition(x, y, z));
+						}
+					}
+				}
+			});
+			MarkAllDirty();
+		}
+
+		// Unión y resta de una esfera (la que se añade o se excava).
+		void AddSphere(const DX::Vector3& center, float radius);
+		void SubtractSphere(const DX::Vector3& center, float radius);
+
+		// Vuelve a mallar los trozos marcados y los anota como cambiados.
+		void Remesh();
+
+		uint32_t GetChunkCount() const								{ return static_cast<uint32_t>(m_meshes.size()); }
+		const VoxelChunkMesh& GetChunkMesh(uint32_t chunk) const	{ return m_meshes[chunk]; }
+		uint32_t GetDirtyChunkCount() const							{ return static_cast<uint32_t>(m_dirtyChunks.size()); }
+		const VoxelVolumeDesc& GetDesc() const						{ return m_desc; }
+		const VoxelStats& GetStats() const							{ return m_stats; }
+
+		float GetDensity(uint32_t x, uint32_t y, uint32_t z) const	{ return m_density[GetPointIndex(x, y, z)]; }
+		DX::Vector3 GetPointPosition(uint32_t x, uint32_t y, uint32_t z) const
+		{
+			return m_desc.origin + DX::Vector3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * m_desc.voxelSize;
+		}
+
+		// Trozos mallados desde la última llamada a ClearChanges, sin repetir.
+		const std::vector<uint32_t>& GetChangedChunks() const		{ return m_changedChunks; }
+		void ClearChanges();
+
+	private:
+		static const float AirDensity;
+
+		// Memoria de cada subproceso para mallar un trozo.
+		struct Scratch
+		{
+			std::vector<uint64_t>	signs;		// Bit x de la fila (y, z): la muestra es sólida.
+			std::vector<uint32_t>	cellVertex;	// Vértice de cada celda que corta la superficie.
+		};
+
+		uint32_t GetPointIndex(uint32_t x, uint32_t y, uint32_t z) const	{ return (z * m_pointsY + y) * m_pointsX + x; }
+		bool IsBorder(uint32_t x, uint32_t y, uint32_t z) const
+		{
+			return x == 0 || y == 0 || z == 0 || x + 1 == m_pointsX || y + 1 == m_pointsY || z + 1 == m_pointsZ;
+		}
+
+		template<typename TCombine>
+		void EditSphere(const DX::Vector3& center, float radius, const TCombine& combine);
+		void MarkDirty(uint32_t minX, uint32_t minY, uint32_t minZ, uint32_t maxX, uint32_t maxY, uint32_t maxZ);
+		void MarkAllDirty();
+		void MeshChunk(uint32_t chunk, Scratch& scratch);
+
+		DX::JobSystem*		m_jobSystem;
+		VoxelVolumeDesc		m_desc;
+		uint32_t			m_pointsX;
+		uint32_t			m_pointsY;
+		uint32_t			m_pointsZ;
+
+		DX::TaggedVector<float, DX::MemoryTag::Voxels>	m_density;
+		std::vector<VoxelChunkMesh>		m_meshes;
+		std::vector<uint8_t>			m_dirty;
+		std::vector<uint32_t>			m_dirtyChunks;
+		std::vector<uint8_t>			m_changed;
+		std::vector<uint32_t>			m_changedChunks;
+		std::vector<Scratch>			m_scratch;
+		VoxelStats						m_stats;
+	};
+}
@@ -0,0 +1,92 @@
+﻿// Referencia de la exportación de animaciones sin ventana: fotogramas por hora según el número de
+// subprocesos (1, 2, 4... hasta todos los núcleos, o solo el número pedido), con la simulación en el
+// subproceso que llama, el trazado por fotogramas en paralelo y la escritura en otro subproceso. El hash de
+// las imágenes debe ser el mismo en todas las filas. Si se da una carpeta, escribe en ella los fotogramas.
+// Uso: AnimationExportBenchmark [subprocesos] [fotogramas] [ancho] [alto] [muestras] [carpeta]
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/AnimationExporter.h"
+
+using namespace App2;
+using namespace DX;
+
+int main(int argc, char** argv)
+{
+	uint32_t threads = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 0;
+	uint32_t frames = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 8;
+	uint32_t width = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 160;
+	uint32_t height = (argc > 4) ? static_cast<uint32_t>(atoi(argv[4])) : 90;
+	uint32_t samples = (argc > 5) ? static_cast<uint32_t>(atoi(argv[5])) : 4;
+	std::string folder = (argc > 6) ? argv[6] : "";
+
+	std::vector<uint32_t> threadCounts;
+	if (threads > 0)
+	{
+		threadCounts.push_back(threads);
+	}
+	else
+	{
+		uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+		for (uint32_t count = 1; count < cores; count *= 2)
+		{
+			threadCounts.push_back(count);
+		}
+		threadCounts.push_back(cores);
+	}
+
+	Benchmarks::BenchmarkReporter reporter("animation_export");
+	uint64_t referenceHash = 0;
+	for (uint32_t count : threadCounts)
+	{
+		JobSystem jobSystem(count);
+		FrameArena frameArena(jobSystem.GetThreadCount(), 256 * 1024);
+		SceneSimulation simulation(&jobSystem);
+		simulation.Create(frameArena);
+
+		AnimationExportDesc desc = AnimationExportDesc::CreateDefault(width, height);
+		desc.frameCount = frames;
+		desc.samplesPerPixel = samples;
+		if (!folder.empty())
+		{
+			desc.pathFormat = folder + "/frame_%04u.bmp";
+		}
+
+		AnimationExporter exporter(&jobSystem, desc);
+		exporter.Run(simulation, frameArena);
+		const AnimationExportStats& stats = exporter.GetStats();
+		if (stats.writer.failures > 0)
+		{
+			fprintf(stderr, "No se pudieron escribir %u fotogramas en %s\n", stats.writer.failures, folder.c_str());
+			return 1;
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "export_%u_threads", count);
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, stats.totalMilliseconds / 1000.0, stats.frames);
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(stats.threads)));
+		result.parameters.push_back(std::make_pair("frames_per_hour", stats.framesPerHour));
+		result.parameters.push_back(std::make_pair("frames_per_hour_per_thread", stats.framesPerHour / stats.threads));
+		result.parameters.push_back(std::make_pair("simulate_ms_per_frame", stats.simulateMilliseconds / stats.frames));
+		result.parameters.push_back(std::make_pair("render_ms", stats.renderMilliseconds));
+		result.parameters.push_back(std::make_pair("rays_per_sec", stats.raysPerSecond));
+		result.parameters.push_back(std::make_pair("files_written", static_cast<double>(stats.writer.filesWritten)));
+		result.parameters.push_back(std::make_pair("write_ms", stats.writer.writeMilliseconds));
+		result.parameters.push_back(std::make_pair("max_pending_files", static_cast<double>(stats.writer.maxPendingFiles)));
+		// Los 32 bits altos del hash: un double no guarda los 64 sin redondear.
+		result.parameters.push_back(std::make_pair("image_hash_high", static_cast<double>(stats.imageHash >> 32)));
+
+		if (count == threadCounts.front())
+		{
+			referenceHash = stats.imageHash;
+		}
+		reporter.Check(result.name, "las imágenes deben ser las mismas con cualquier número de subprocesos", stats.imageHash == referenceHash);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
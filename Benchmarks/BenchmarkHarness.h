@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Benchmarks
+{
+	// Resultado de una medición: coste medio por operación y rendimiento, más parámetros libres.
+	struct BenchmarkResult
+	{
+		std::string									name;
+		std::vector<std::pair<std::string, double>>	parameters;
+		double										nanosecondsPerOp;
+		double										opsPerSecond;
+	};
+
+	// Cronómetro de alta resolución para las mediciones.
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+		void Restart()				{ m_start = std::chrono::steady_clock::now(); }
+		double ElapsedSeconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	// Acumula resultados y los escribe como JSON en la salida estándar. Las comprobaciones de corrección
+	// (Check) hacen que GetExitCode devuelva un error, de modo que las referencias sirven también de pruebas.
+	class BenchmarkReporter
+	{
+	public:
+		explicit BenchmarkReporter(const char* suite) : m_suite(suite), m_failedChecks(0) {}
+
+		BenchmarkResult& Add(const std::string& name, double seconds, uint64_t operations)
+		{
+			BenchmarkResult result;
+			result.name = name;
+			result.nanosecondsPerOp = (operations > 0) ? seconds * 1e9 / static_cast<double>(operations) : 0.0;
+			result.opsPerSecond = (seconds > 0.0) ? static_cast<double>(operations) / seconds : 0.0;
+			m_results.push_back(result);
+			return m_results.back();
+		}
+
+		// Anota una comprobación de la fila name; si falla, la describe en la salida de errores (la estándar
+		// queda para el JSON). Devuelve passed.
+		bool Check(const std::string& name, const char* description, bool passed)
+		{
+			if (!passed)
+			{
+				fprintf(stderr, "%s/%s: falla la comprobación: %s\n", m_suite.c_str(), name.c_str(), description);
+				m_failedChecks++;
+			}
+			return passed;
+		}
+
+		uint32_t GetFailedChecks() const	{ return m_failedChecks; }
+
+		// Valor de salida de main: 1 si alguna comprobación ha fallado.
+		int GetExitCode() const				{ return (m_failedChecks > 0) ? 1 : 0; }
+
+		void Print() const
+		{
+			printf("{\n  \"suite\": \"%s\",\n  \"failed_checks\": %u,\n  \"results\": [\n", m_suite.c_str(), m_failedChecks);
+			for (size_t i = 0; i < m_results.size(); i++)
+			{
+				const BenchmarkResult& result = m_results[i];
+				printf("    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_sec\": %.3f", result.name.c_str(), result.nanosecondsPerOp, result.opsPerSecond);
+				for (const auto& parameter : result.parameters)
+				{
+					printf(", \"%s\": %.6g", parameter.first.c_str(), parameter.second);
+				}
+				printf(" }%s\n", (i + 1 < m_results.size()) ? "," : "");
+			}
+			printf("  ]\n}\n");
+		}
+
+	private:
+		std::string						m_suite;
+		std::vector<BenchmarkResult>	m_results;
+		uint32_t						m_failedChecks;
+	};
+
+	// Evita que el compilador elimine un cálculo cuyo resultado no se usa.
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+		static const void* volatile sink;
+		sink = &value;
+		(void)sink;
+	}
+}
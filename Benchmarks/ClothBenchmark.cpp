@@ -0,0 +1,102 @@
+﻿// Mide las iteraciones del solucionador de ClothSimulation por milisegundo en telas de 10K a 100K partículas.
+// Uso: ClothBenchmark [pasos]
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/ClothSimulation.h"
+
+using namespace App2;
+
+namespace
+{
+	// Posición y normal, como el búfer de vértices de un sombreado iluminado.
+	struct PositionNormalVertex
+	{
+		float	position[3];
+		float	normal[3];
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<PositionNormalVertex> : VertexLayout<PositionNormalVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(PositionNormalVertex, position)>,
+		VertexAttribute<VertexSemantic::Normal, 0, float[3], offsetof(PositionNormalVertex, normal)>>
+	{
+	};
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t stepCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 30;
+	const float deltaSeconds = 1.0f / 60.0f;
+	const uint32_t iterations = 8;
+	const uint32_t particleCounts[] = { 10000, 25000, 50000, 100000 };
+
+	Benchmarks::BenchmarkReporter reporter("cloth");
+
+	uint32_t maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0)
+	{
+		maxThreads = 1;
+	}
+
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (uint32_t particles : particleCounts)
+	{
+		uint32_t side = static_cast<uint32_t>(sqrt(static_cast<double>(particles)));
+		ClothMeshDesc mesh = ClothMeshDesc::CreateGrid(side, side, 1.0f / side, DX::Vector3(-0.5f, 0.5f, 0.0f));
+
+		for (uint32_t threads : threadCounts)
+		{
+			DX::JobSystem jobSystem(threads);
+			ClothSimulation cloth(&jobSystem, mesh);
+			cloth.SetSolverIterations(iterations);
+
+			// Bandera fija por el borde izquierdo que cae sobre una esfera.
+			std::vector<ClothBonePose> poses(1);
+			cloth.SetBonePoses(poses.data(), static_cast<uint32_t>(poses.size()));
+			for (uint32_t y = 0; y < side; y++)
+			{
+				cloth.AttachParticle(y * side, 0);
+			}
+			cloth.AddCollider(ClothCollider::Sphere(0, DX::Vector3(0.3f, 0.0f, 0.1f), 0.2f));
+
+			std::vector<PositionNormalVertex> vertices(cloth.GetParticleCount());
+
+			double solver = 0.0;
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t step = 0; step < stepCount; step++)
+			{
+				cloth.Step(deltaSeconds);
+				solver += cloth.GetStats().solverMilliseconds;
+				cloth.WriteVertices(vertices.data());
+			}
+			double seconds = stopwatch.ElapsedSeconds();
+			Benchmarks::DoNotOptimize(vertices[0].position[0]);
+
+			const ClothStats& stats = cloth.GetStats();
+			Benchmarks::BenchmarkResult& result = reporter.Add("cloth_step", seconds, stepCount);
+			result.parameters.push_back(std::make_pair("particles", static_cast<double>(stats.particles)));
+			result.parameters.push_back(std::make_pair("constraints", static_cast<double>(stats.constraints)));
+			result.parameters.push_back(std::make_pair("colors", static_cast<double>(stats.colors)));
+			result.parameters.push_back(std::make_pair("threads", static_cast<double>(threads)));
+			result.parameters.push_back(std::make_pair("iterations", static_cast<double>(iterations)));
+			result.parameters.push_back(std::make_pair("iterations_per_ms", iterations * stepCount / solver));
+			result.parameters.push_back(std::make_pair("step_ms", seconds * 1000.0 / stepCount));
+		}
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,198 @@
+﻿// Referencia de rendimiento de la grabación paralela de comandos: cada objeto visible se descarta por
+// tronco, calcula sus matrices y graba un paquete en la lista de su tramo; las listas se unen, se
+// ordenan y se reproducen en un backend simulado. Se mide con 1 a N subprocesos y se comprueba que el
+// flujo enviado es idéntico en todos los casos.
+// Uso: CommandRecordingBenchmark [objetos] [subprocesos máximos] [repeticiones]
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/Frustum.h"
+#include "../App2/Common/JobSystem.h"
+#include "../App2/Common/MockRenderBackend.h"
+#include "../App2/Common/ParallelCommandRecorder.h"
+#include "../App2/Content/SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	const uint32_t ShaderCount = 8;
+	const uint32_t MaterialCount = 64;
+	const uint32_t MeshCount = 16;
+
+	// Igual que ModelViewProjectionConstantBuffer del representador.
+	struct ObjectConstants
+	{
+		Matrix4	model;
+		Matrix4	view;
+		Matrix4	projection;
+	};
+
+	struct Scene
+	{
+		std::vector<RigidBody>	bodies;
+		std::vector<uint16_t>	materials;
+		std::vector<uint16_t>	meshes;
+		Matrix4					view;
+		Matrix4					projection;
+		Matrix4					viewProjection;
+		Frustum					frustum;
+
+		explicit Scene(uint32_t count)
+		{
+			uint32_t random = 99;
+			auto next = [&random](float low, float high)
+			{
+				random = random * 1664525u + 1013904223u;
+				return low + (high - low) * ((random >> 8) * (1.0f / 16777216.0f));
+			};
+
+			bodies.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				RigidBody& body = bodies[i];
+				body.position = Vector3(next(-3.0f, 3.0f), next(-2.0f, 2.0f), next(-6.0f, 1.0f));
+				body.orientation = Quaternion::RotationAxis(Vector3(0.0f, 1.0f, 0.0f), next(0.0f, 6.28f));
+				body.halfExtents = Vector3(0.05f, 0.05f, 0.05f);
+				materials.push_back(static_cast<uint16_t>(next(0.0f, static_cast<float>(MaterialCount))));
+				meshes.push_back(static_cast<uint16_t>(next(0.0f, static_cast<float>(MeshCount))));
+			}
+
+			view = ComputeSceneView();
+			projection = ComputeSceneProjection(1920.0f, 1080.0f, Matrix4::Identity());
+			viewProjection = view * projection;
+			frustum = Frustum::FromViewProjection(viewProjection);
+		}
+	};
+
+	// Lo que hace el representador por cuerpo: descarte, matrices, constantes y clave.
+	void RecordBodies(const Scene& scene, RenderCommandBuffer& list, uint32_t begin, uint32_t end)
+	{
+		ObjectConstants constants;
+		constants.view = scene.view.Transposed();
+		constants.projection = scene.projection.Transposed();
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const RigidBody& body = scene.bodies[i];
+			if (!scene.frustum.IntersectsSphere(body.position, Length(body.halfExtents)))
+			{
+				continue;
+			}
+
+			constants.model = ComputeBodyModel(body).Transposed();
+			float clip[4];
+			TransformPoint(body.position, scene.viewProjection, clip);
+
+			DrawPacket packet;
+			packet.material = scene.materials[i];
+			packet.shader = static_cast<uint16_t>(packet.material % ShaderCount);
+			packet.mesh = scene.meshes[i];
+			packet.constantOffset = list.AddConstants(&constants, sizeof(constants));
+			packet.constantSize = sizeof(constants);
+			packet.indexCount = 36;
+			packet.startIndex = 0;
+			packet.baseVertex = 0;
+			list.Add(RenderSortKey::Opaque(0, packet.shader, packet.material, clip[2] / clip[3]), packet);
+		}
+	}
+
+	// Backend que resume en una huella FNV-1a todo lo que recibe, en orden.
+	class FingerprintBackend : public IRenderBackend
+	{
+	public:
+		uint64_t hash;
+
+		FingerprintBackend() : hash(14695981039346656037ull) {}
+
+		virtual void BindShader(uint32_t shader) override							{ Mix(&shader, sizeof(shader)); }
+		virtual void BindMaterial(uint32_t material) override						{ Mix(&material, sizeof(material)); }
+		virtual void BindMesh(uint32_t mesh) override								{ Mix(&mesh, sizeof(mesh)); }
+		virtual void UpdateConstants(const void* data, uint32_t size) override		{ Mix(data, size); }
+		virtual void DrawIndexed(uint32_t indexCount, uint32_t, int32_t) override	{ Mix(&indexCount, sizeof(indexCount)); }
+
+	private:
+		void Mix(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t objects = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	uint32_t maxThreads = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : ((hardwareThreads > 4) ? hardwareThreads : 4);
+	uint32_t repetitions = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 20;
+
+	Benchmarks::BenchmarkReporter reporter("command_recording");
+	Scene scene(objects);
+	uint64_t referenceHash = 0;
+
+	for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		JobSystem jobSystem(threads);
+		ParallelCommandRecorder recorder(1024);
+		RenderCommandBuffer merged(objects, objects * 256);
+		MockRenderBackend backend;
+
+		double recordSeconds = 0.0;
+		double mergeSeconds = 0.0;
+		double sortSeconds = 0.0;
+		double submitSeconds = 0.0;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			Benchmarks::Stopwatch stopwatch;
+			recorder.Record(&jobSystem, objects, [&scene](RenderCommandBuffer& list, uint32_t begin, uint32_t end)
+			{
+				RecordBodies(scene, list, begin, end);
+			});
+			recordSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			merged.Reset();
+			recorder.Merge(&jobSystem, merged);
+			mergeSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			merged.Sort(&jobSystem);
+			sortSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			backend.Reset();
+			merged.Submit(backend);
+			submitSeconds += stopwatch.ElapsedSeconds();
+		}
+
+		// El flujo enviado debe ser el mismo con cualquier número de subprocesos.
+		FingerprintBackend fingerprint;
+		merged.Submit(fingerprint);
+		if (threads == 1)
+		{
+			referenceHash = fingerprint.hash;
+		}
+
+		uint64_t operations = static_cast<uint64_t>(repetitions) * objects;
+		const char* names[4] = { "record", "merge", "sort", "submit" };
+		double seconds[4] = { recordSeconds, mergeSeconds, sortSeconds, submitSeconds };
+		for (int phase = 0; phase < 4; phase++)
+		{
+			Benchmarks::BenchmarkResult& result = reporter.Add(names[phase], seconds[phase], operations);
+			result.parameters.push_back(std::make_pair("threads", static_cast<double>(threads)));
+			result.parameters.push_back(std::make_pair("draws", static_cast<double>(backend.GetStats().draws)));
+			result.parameters.push_back(std::make_pair("lists", static_cast<double>(recorder.GetListCount())));
+			result.parameters.push_back(std::make_pair("deterministic", (fingerprint.hash == referenceHash) ? 1.0 : 0.0));
+		}
+		reporter.Check("submit", "el flujo enviado debe ser el mismo con cualquier número de subprocesos", fingerprint.hash == referenceHash);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
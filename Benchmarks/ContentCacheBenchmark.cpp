@@ -0,0 +1,206 @@
+﻿// Referencia de rendimiento de la caché por hash de contenido: muchos materiales piden sombreadores,
+// diseños de entrada y estados elegidos de un conjunto pequeño, con y sin caché. Sin dispositivo, la
+// creación se simula con lo que hace el controlador como mínimo (copiar y recorrer el código del
+// sombreador), así que el ahorro real en Direct3D es mayor que el medido. También mide el hash.
+// Uso: ContentCacheBenchmark [materiales] [repeticiones]
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/ContentCache.h"
+#include "../App2/Common/ContentHash.h"
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t ShaderVariants = 24;
+	const uint32_t LayoutVariants = 4;
+	const uint32_t StateVariants = 6;
+
+	// Objeto creado a partir de una descripción: copia los datos y los valida recorriéndolos.
+	struct MockObject
+	{
+		std::vector<uint8_t>	data;
+		uint64_t				checksum;
+	};
+
+	std::shared_ptr<MockObject> CreateMockObject(const std::vector<uint8_t>& description)
+	{
+		std::shared_ptr<MockObject> object = std::make_shared<MockObject>();
+		object->data = description;
+		object->checksum = 0;
+		for (int pass = 0; pass < 4; pass++)
+		{
+			for (uint8_t byte : object->data)
+			{
+				object->checksum = object->checksum * 31 + byte + pass;
+			}
+		}
+		return object;
+	}
+
+	std::vector<uint8_t> RandomBytes(uint32_t size, uint32_t seed)
+	{
+		std::vector<uint8_t> bytes(size);
+		uint32_t state = seed * 2654435761u + 1;
+		for (uint8_t& byte : bytes)
+		{
+			state = state * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(state >> 24);
+		}
+		return bytes;
+	}
+
+	// Lo que pide cada material, como índices en los conjuntos de descripciones.
+	struct Material
+	{
+		uint32_t	vertexShader;
+		uint32_t	pixelShader;
+		uint32_t	layout;
+		uint32_t	rasterizer;
+		uint32_t	blend;
+		uint32_t	depth;
+	};
+
+	struct Library
+	{
+		std::vector<std::vector<uint8_t>>	shaders;
+		std::vector<std::vector<uint8_t>>	layouts;
+		std::vector<std::vector<uint8_t>>	states;
+		std::vector<Material>				materials;
+
+		explicit Library(uint32_t materialCount)
+		{
+			// Código de sombreador de 2 a 8 KB, diseños de unos cientos de bytes y estados de unas decenas.
+			for (uint32_t i = 0; i < ShaderVariants * 2; i++)
+			{
+				shaders.push_back(RandomBytes(2048 + (i % 7) * 1024, i));
+			}
+			for (uint32_t i = 0; i < LayoutVariants; i++)
+			{
+				layouts.push_back(RandomBytes(256 + i * 32, 1000 + i));
+			}
+			for (uint32_t i = 0; i < StateVariants * 3; i++)
+			{
+				states.push_back(RandomBytes(44, 2000 + i));
+			}
+
+			uint32_t state = 7;
+			auto next = [&state](uint32_t range)
+			{
+				state = state * 1664525u + 1013904223u;
+				return (state >> 8) % range;
+			};
+			for (uint32_t i = 0; i < materialCount; i++)
+			{
+				Material material;
+				material.vertexShader = next(ShaderVariants);
+				material.pixelShader = ShaderVariants + next(ShaderVariants);
+				material.layout = next(LayoutVariants);
+				material.rasterizer = next(StateVariants);
+				material.blend = StateVariants + next(StateVariants);
+				material.depth = StateVariants * 2 + next(StateVariants);
+				materials.push_back(material);
+			}
+		}
+	};
+
+	typedef std::shared_ptr<MockObject> ObjectPointer;
+
+	struct Caches
+	{
+		ContentCache<ObjectPointer>	shaders;
+		ContentCache<ObjectPointer>	layouts;
+		ContentCache<ObjectPointer>	states;
+	};
+
+	ObjectPointer Get(ContentCache<ObjectPointer>& cache, const std::vector<uint8_t>& description)
+	{
+		return cache.GetOrCreate(description.data(), description.size(), [&]() { return CreateMockObject(description); });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t materialCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 5;
+
+	Benchmarks::BenchmarkReporter reporter("content_cache");
+	Library library(materialCount);
+	const uint64_t objectsPerMaterial = 6;
+
+	// Cada material crea sus propios objetos, como hoy cada representador.
+	{
+		uint64_t checksum = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			for (const Material& material : library.materials)
+			{
+				checksum += CreateMockObject(library.shaders[material.vertexShader])->checksum;
+				checksum += CreateMockObject(library.shaders[material.pixelShader])->checksum;
+				checksum += CreateMockObject(library.layouts[material.layout])->checksum;
+				checksum += CreateMockObject(library.states[material.rasterizer])->checksum;
+				checksum += CreateMockObject(library.states[material.blend])->checksum;
+				checksum += CreateMockObject(library.states[material.depth])->checksum;
+			}
+		}
+		reporter.Add("create_uncached", stopwatch.ElapsedSeconds(), repetitions * materialCount * objectsPerMaterial)
+			.parameters.push_back(std::make_pair("objects_created", static_cast<double>(repetitions * materialCount * objectsPerMaterial)));
+		Benchmarks::DoNotOptimize(checksum);
+	}
+
+	// Con caché: cada repetición empieza vacía, como tras crear o recuperar el dispositivo.
+	{
+		uint64_t checksum = 0;
+		ContentCacheStats shaderStats = {}, layoutStats = {}, stateStats = {};
+		size_t created = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			Caches caches;
+			for (const Material& material : library.materials)
+			{
+				checksum += Get(caches.shaders, library.shaders[material.vertexShader])->checksum;
+				checksum += Get(caches.shaders, library.shaders[material.pixelShader])->checksum;
+				checksum += Get(caches.layouts, library.layouts[material.layout])->checksum;
+				checksum += Get(caches.states, library.states[material.rasterizer])->checksum;
+				checksum += Get(caches.states, library.states[material.blend])->checksum;
+				checksum += Get(caches.states, library.states[material.depth])->checksum;
+			}
+			shaderStats = caches.shaders.GetStats();
+			layoutStats = caches.layouts.GetStats();
+			stateStats = caches.states.GetStats();
+			created = caches.shaders.GetCount() + caches.layouts.GetCount() + caches.states.GetCount();
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add("create_cached", stopwatch.ElapsedSeconds(), repetitions * materialCount * objectsPerMaterial);
+		result.parameters.push_back(std::make_pair("objects_created", static_cast<double>(created * repetitions)));
+		result.parameters.push_back(std::make_pair("shader_hit_rate", shaderStats.GetHitRate()));
+		result.parameters.push_back(std::make_pair("layout_hit_rate", layoutStats.GetHitRate()));
+		result.parameters.push_back(std::make_pair("state_hit_rate", stateStats.GetHitRate()));
+		result.parameters.push_back(std::make_pair("hash_collisions", static_cast<double>(shaderStats.collisions + layoutStats.collisions + stateStats.collisions)));
+		Benchmarks::DoNotOptimize(checksum);
+	}
+
+	// Coste del hash en sí, sobre el código de un sombreador de 8 KB.
+	{
+		std::vector<uint8_t> bytecode = RandomBytes(8192, 42);
+		const uint32_t count = 100000;
+		uint64_t hash = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bytecode[0] = static_cast<uint8_t>(i);
+			hash ^= HashContent(bytecode.data(), bytecode.size());
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+		reporter.Add("hash_8kb", seconds, count)
+			.parameters.push_back(std::make_pair("gb_per_sec", count * 8192.0 / seconds / 1e9));
+		Benchmarks::DoNotOptimize(hash);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,236 @@
+﻿// Referencia de la recuperación tras perder el dispositivo, con un dispositivo simulado: una escena con
+// sombreadores, mallas y búferes de constantes, de la que una parte es visible, se pierde y se recrea de
+// dos formas: volviendo a leer cada recurso de su archivo, en el orden de carga, como hacía
+// CreateDeviceDependentResources, y desde las copias de DX::ResourceRegistry, por prioridad. Mide el
+// tiempo hasta tener de nuevo el conjunto visible y hasta tenerlo todo, y comprueba que lo recreado es
+// igual a lo original. Los archivos quedan en la caché del sistema, así que la lectura medida es la más
+// rápida posible.
+// Uso: DeviceRecoveryBenchmark [recursos] [repeticiones] [directorio temporal]
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/ResourceRegistry.h"
+
+using namespace DX;
+
+namespace
+{
+	// Recurso del dispositivo simulado: la creación copia los datos y los recorre, como mínimo hace el
+	// controlador. generation dice con qué dispositivo se creó.
+	struct MockResource
+	{
+		std::vector<uint8_t>	data;
+		uint64_t				checksum;
+		uint32_t				generation;
+	};
+
+	struct MockDevice
+	{
+		uint32_t	generation;
+		uint64_t	created;
+
+		MockDevice() : generation(1), created(0) {}
+
+		void Create(MockResource& resource, const uint8_t* data, size_t size)
+		{
+			resource.data.assign(data, data + size);
+			resource.checksum = 14695981039346656037ull;
+			for (uint8_t byte : resource.data)
+			{
+				resource.checksum = (resource.checksum ^ byte) * 1099511628211ull;
+			}
+			resource.generation = generation;
+			created++;
+		}
+	};
+
+	struct SceneResource
+	{
+		ShadowKind				kind;
+		ShadowPriority			priority;
+		std::vector<uint8_t>	source;
+		std::string				path;
+	};
+
+	std::vector<uint8_t> RandomBytes(uint32_t size, uint32_t seed)
+	{
+		std::vector<uint8_t> bytes(size);
+		uint32_t state = seed * 2654435761u + 1;
+		for (uint8_t& byte : bytes)
+		{
+			state = state * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(state >> 24);
+		}
+		return bytes;
+	}
+
+	// Uno de cada cuatro recursos es visible; el resto es superposición o fondo. Los tamaños van de los
+	// pocos KB de un sombreador a los cientos de KB de una malla.
+	std::vector<SceneResource> BuildScene(uint32_t count, const std::string& directory)
+	{
+		std::vector<SceneResource> scene(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			SceneResource& resource = scene[i];
+			uint32_t size;
+			switch (i % 3)
+			{
+			case 0:		resource.kind = ShadowKind::Shader;			size = 2048 + (i % 7) * 1024;	break;
+			case 1:		resource.kind = ShadowKind::Mesh;			size = 16384 << (i % 5);		break;
+			default:	resource.kind = ShadowKind::ConstantData;	size = 256;						break;
+			}
+			resource.priority = ((i % 4) == 0) ? ShadowPriority::Visible : (((i % 4) == 1) ? ShadowPriority::Overlay : ShadowPriority::Background);
+			resource.source = RandomBytes(size, i);
+			resource.path = directory + "/DeviceRecovery_" + std::to_string(i) + ".bin";
+
+			FILE* file = fopen(resource.path.c_str(), "wb");
+			if (file != nullptr)
+			{
+				fwrite(resource.source.data(), 1, resource.source.size(), file);
+				fclose(file);
+			}
+		}
+		return scene;
+	}
+
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		data.resize(static_cast<size_t>(size));
+		size_t read = fread(data.data(), 1, data.size(), file);
+		fclose(file);
+		return read == data.size();
+	}
+
+	// Lo recreado debe ser del dispositivo nuevo y tener los mismos datos que el original.
+	bool Verify(const std::vector<SceneResource>& scene, const std::vector<MockResource>& resources, const MockDevice& device)
+	{
+		for (size_t i = 0; i < scene.size(); i++)
+		{
+			if (resources[i].generation != device.generation || resources[i].data != scene[i].source)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void LoseDevice(MockDevice& device, std::vector<MockResource>& resources)
+	{
+		device.generation++;
+		for (MockResource& resource : resources)
+		{
+			resource.data.clear();
+			resource.generation = 0;
+		}
+	}
+
+	void AddRecoveryResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint32_t repetitions, size_t count, double visibleSeconds, uint64_t bytes, bool consistent)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, static_cast<uint64_t>(repetitions) * count);
+		result.parameters.push_back(std::make_pair("visible_ms", visibleSeconds * 1000.0 / repetitions));
+		result.parameters.push_back(std::make_pair("total_ms", seconds * 1000.0 / repetitions));
+		result.parameters.push_back(std::make_pair("mb", bytes / (1024.0 * 1024.0)));
+		result.parameters.push_back(std::make_pair("consistent", consistent ? 1.0 : 0.0));
+		reporter.Check(result.name, "los recursos recreados deben coincidir con los originales", consistent);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 2000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 10;
+	std::string directory = (argc > 3) ? argv[3] : ".";
+
+	Benchmarks::BenchmarkReporter reporter("device_recovery");
+	std::vector<SceneResource> scene = BuildScene(count, directory);
+	std::vector<MockResource> resources(count);
+	MockDevice device;
+	uint64_t bytes = 0;
+	for (const SceneResource& resource : scene)
+	{
+		bytes += resource.source.size();
+	}
+
+	// Como antes: cada recurso se vuelve a leer de su archivo y se crea, en el orden de carga. El conjunto
+	// visible está completo cuando se crea su último recurso.
+	{
+		double visibleSeconds = 0.0;
+		bool consistent = true;
+		size_t lastVisible = 0;
+		for (size_t i = 0; i < scene.size(); i++)
+		{
+			lastVisible = (scene[i].priority == ShadowPriority::Visible) ? i : lastVisible;
+		}
+
+		std::vector<uint8_t> fileData;
+		Benchmarks::Stopwatch total;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			LoseDevice(device, resources);
+			Benchmarks::Stopwatch stopwatch;
+			for (size_t i = 0; i < scene.size(); i++)
+			{
+				consistent = ReadFile(scene[i].path, fileData) && consistent;
+				device.Create(resources[i], fileData.data(), fileData.size());
+				if (i == lastVisible)
+				{
+					visibleSeconds += stopwatch.ElapsedSeconds();
+				}
+			}
+			consistent = consistent && Verify(scene, resources, device);
+		}
+		AddRecoveryResult(reporter, "reload_from_files", total.ElapsedSeconds(), repetitions, scene.size(), visibleSeconds, bytes, consistent);
+	}
+
+	// Con el registro: la carga inicial registra las copias (y crea los recursos), y cada pérdida se
+	// recupera con RecreateAll.
+	{
+		ResourceRegistry registry;
+		LoseDevice(device, resources);
+		for (size_t i = 0; i < scene.size(); i++)
+		{
+			MockResource* target = &resources[i];
+			MockDevice* mockDevice = &device;
+			registry.Register(&scene, scene[i].kind, scene[i].priority, scene[i].source.data(), scene[i].source.size(), [target, mockDevice](const uint8_t* data, size_t size)
+			{
+				mockDevice->Create(*target, data, size);
+			});
+		}
+		bool consistent = Verify(scene, resources, device);
+
+		double visibleSeconds = 0.0;
+		Benchmarks::Stopwatch total;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			LoseDevice(device, resources);
+			ShadowRecoveryStats stats = registry.RecreateAll();
+			visibleSeconds += stats.visibleSeconds;
+			consistent = consistent && Verify(scene, resources, device);
+		}
+		AddRecoveryResult(reporter, "rebuild_from_shadows", total.ElapsedSeconds(), repetitions, scene.size(), visibleSeconds, bytes, consistent);
+
+		Benchmarks::BenchmarkResult& result = reporter.Add("shadow_memory", 0.0, 0);
+		result.parameters.push_back(std::make_pair("shader_mb", registry.GetShadowBytes(ShadowKind::Shader) / (1024.0 * 1024.0)));
+		result.parameters.push_back(std::make_pair("mesh_mb", registry.GetShadowBytes(ShadowKind::Mesh) / (1024.0 * 1024.0)));
+		result.parameters.push_back(std::make_pair("constant_mb", registry.GetShadowBytes(ShadowKind::ConstantData) / (1024.0 * 1024.0)));
+	}
+
+	for (const SceneResource& resource : scene)
+	{
+		remove(resource.path.c_str());
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
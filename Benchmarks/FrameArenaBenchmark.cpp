@@ -0,0 +1,227 @@
+﻿// Compara reservas temporales por fotograma en el montón general frente a la arena de fotograma, y
+// comprueba cuántas reservas del montón hace en régimen estable el bucle de simulación y texto.
+// Uso: FrameArenaBenchmark [fotogramas]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/FrameArena.h"
+#include "../App2/Common/BitmapFont.h"
+#include "../App2/Common/TextBatch.h"
+#include "../App2/Content/ClothSimulation.h"
+#include "../App2/Content/RigidBodyWorld.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_allocations(0);
+}
+
+// Los operadores globales cuentan las reservas; GCC avisa de malloc/free aunque el emparejamiento sea correcto.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+// La versión sin excepciones (la usa std::stable_sort) también debe liberarse con free.
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	g_allocations++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+using namespace DX;
+
+namespace
+{
+	// Trabajo temporal típico de un fotograma: listas de visibles, cadenas de estadísticas, etc.
+	const uint32_t ListsPerFrame = 64;
+	const uint32_t ItemsPerList = 256;
+	const uint32_t StringsPerFrame = 64;
+
+	uint64_t HeapFrame(uint32_t frame)
+	{
+		uint64_t checksum = 0;
+		for (uint32_t l = 0; l < ListsPerFrame; l++)
+		{
+			std::vector<uint32_t> items;
+			for (uint32_t i = 0; i < ItemsPerList; i++)
+			{
+				items.push_back(i ^ frame);
+			}
+			checksum += items[l % ItemsPerList];
+		}
+		for (uint32_t s = 0; s < StringsPerFrame; s++)
+		{
+			std::wstring text = std::to_wstring(frame + s) + L" FPS";
+			checksum += text.size();
+		}
+		return checksum;
+	}
+
+	uint64_t ArenaFrame(FrameArena& arena, uint32_t frame)
+	{
+		uint64_t checksum = 0;
+		ArenaAllocator<uint32_t> allocator(arena.GetArena());
+		for (uint32_t l = 0; l < ListsPerFrame; l++)
+		{
+			ArenaVector<uint32_t> items(allocator);
+			items.reserve(ItemsPerList);
+			for (uint32_t i = 0; i < ItemsPerList; i++)
+			{
+				items.push_back(i ^ frame);
+			}
+			checksum += items[l % ItemsPerList];
+		}
+		for (uint32_t s = 0; s < StringsPerFrame; s++)
+		{
+			wchar_t number[16];
+			swprintf(number, 16, L"%u", frame + s);
+			ArenaWString text(number, ArenaAllocator<wchar_t>(arena.GetArena()));
+			text += L" FPS";
+			checksum += text.size();
+		}
+		return checksum;
+	}
+
+	void AddResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint32_t frames, uint64_t allocations)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, frames);
+		result.parameters.push_back(std::make_pair("us_per_frame", seconds * 1e6 / frames));
+		result.parameters.push_back(std::make_pair("heap_allocations_per_frame", static_cast<double>(allocations) / frames));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frameCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 2000;
+	Benchmarks::BenchmarkReporter reporter("frame_arena");
+
+	{
+		uint64_t before = g_allocations;
+		uint64_t checksum = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			checksum += HeapFrame(frame);
+		}
+		AddResult(reporter, "transient_heap", stopwatch.ElapsedSeconds(), frameCount, g_allocations - before);
+		Benchmarks::DoNotOptimize(checksum);
+	}
+
+	{
+		FrameArena arena(1, 64 * 1024);
+		uint64_t checksum = 0;
+		arena.BeginFrame();
+		ArenaFrame(arena, 0);
+		arena.BeginFrame();
+		ArenaFrame(arena, 0);
+
+		uint64_t before = g_allocations;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			arena.BeginFrame();
+			checksum += ArenaFrame(arena, frame);
+		}
+		AddResult(reporter, "transient_arena", stopwatch.ElapsedSeconds(), frameCount, g_allocations - before);
+		Benchmarks::BenchmarkResult& result = reporter.Add("transient_arena_stats", 0.0, 0);
+		result.parameters.push_back(std::make_pair("arena_allocations_per_frame", static_cast<double>(arena.GetLastFrameStats().allocations)));
+		result.parameters.push_back(std::make_pair("arena_bytes_per_frame", static_cast<double>(arena.GetLastFrameStats().bytes)));
+		result.parameters.push_back(std::make_pair("overflow_allocations", static_cast<double>(arena.GetLastFrameStats().overflowAllocations)));
+		Benchmarks::DoNotOptimize(checksum);
+	}
+
+	// Bucle de la escena: física, tela y texto. Tras unos fotogramas de calentamiento no debe reservar.
+	{
+		JobSystem jobSystem;
+		FrameArena arena(jobSystem.GetThreadCount(), 64 * 1024);
+
+		App2::RigidBodyWorld world(&jobSystem);
+		App2::RigidBodyDesc ground;
+		ground.mass = 0.0f;
+		ground.halfExtents = Vector3(10.0f, 0.5f, 10.0f);
+		ground.position = Vector3(0.0f, -0.5f, 0.0f);
+		world.AddBody(ground);
+		for (uint32_t i = 0; i < 27; i++)
+		{
+			App2::RigidBodyDesc box;
+			box.position = Vector3((i % 3) * 1.05f, 0.5f + (i / 9) * 1.02f, ((i / 3) % 3) * 1.05f);
+			world.AddBody(box);
+		}
+
+		App2::ClothSimulation cloth(&jobSystem, App2::ClothMeshDesc::CreateGrid(32, 32, 0.02f, Vector3()));
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			cloth.AttachParticle(x, 0);
+		}
+		cloth.AddCollider(App2::ClothCollider::Sphere(1, Vector3(), 0.1f));
+		std::vector<App2::ClothVertex> vertices(32 * 32);
+
+		BitmapFontRasterizer rasterizer;
+		GlyphAtlas atlas(&rasterizer, 256, 256);
+		TextLayoutCache layouts(&atlas);
+		TextBatch batch;
+
+		auto runFrame = [&](uint32_t frame)
+		{
+			arena.BeginFrame();
+			world.Step(1.0f / 60.0f);
+
+			ArenaVector<App2::ClothBonePose> poses(2, App2::ClothBonePose(), ArenaAllocator<App2::ClothBonePose>(arena.GetArena()));
+			poses[1].position = Vector3(0.01f * (frame % 50), -0.2f, 0.05f);
+			cloth.SetBonePoses(poses.data(), static_cast<uint32_t>(poses.size()));
+			cloth.Step(1.0f / 60.0f);
+			cloth.WriteVertices(vertices.data());
+
+			char text[64];
+			snprintf(text, sizeof(text), "Contactos: %u", world.GetStats().contactPoints);
+			batch.Clear();
+			batch.AddText(layouts, text, TextFormat(16, 0.0f, TextAlignment::Leading), 8.0f, 8.0f, 0xffffffff);
+			layouts.NextFrame();
+		};
+
+		for (uint32_t frame = 0; frame < 240; frame++)
+		{
+			runFrame(frame);
+		}
+
+		uint64_t before = g_allocations;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			runFrame(frame);
+		}
+		AddResult(reporter, "scene_loop_steady_state", stopwatch.ElapsedSeconds(), frameCount, g_allocations - before);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
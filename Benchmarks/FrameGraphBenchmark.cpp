@@ -0,0 +1,214 @@
+﻿// Referencia del grafo de fotograma: una canalización diferida sintética a 1920x1080 (G-buffer, sombras,
+// oclusión ambiental, iluminación, cadena de resplandor, mapeo de tonos y antialiasing, más un pase de
+// depuración que nadie lee) para comparar la memoria transitoria sin y con alias, y el coste de compilar
+// grafos de tamaño creciente. Incluye un grafo mal formado para comprobar la validación.
+// Uso: FrameGraphBenchmark [pases máximos] [repeticiones]
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/FrameGraph.h"
+
+using namespace DX;
+
+namespace
+{
+	// Valores de DXGI_FORMAT, solo para que las descripciones se parezcan a las reales.
+	const uint32_t FormatRgba8 = 28;
+	const uint32_t FormatRgba16Float = 10;
+	const uint32_t FormatR8 = 61;
+	const uint32_t FormatD32 = 40;
+
+	FrameGraphTextureDesc Desc(uint32_t width, uint32_t height, uint32_t format, uint32_t bytesPerPixel)
+	{
+		FrameGraphTextureDesc desc = { width, height, format, bytesPerPixel };
+		return desc;
+	}
+
+	uint32_t g_executed = 0;
+
+	FrameGraphPass Pass(FrameGraph& graph, const char* name)
+	{
+		return graph.AddPass(name, [](const FrameGraph&) { g_executed++; });
+	}
+
+	void BuildDeferredPipeline(FrameGraph& graph, uint32_t width, uint32_t height)
+	{
+		FrameGraphResource backBuffer = graph.ImportTexture("BackBuffer", Desc(width, height, FormatRgba8, 4));
+
+		FrameGraphResource shadowMap = graph.CreateTexture("ShadowMap", Desc(2048, 2048, FormatD32, 4));
+		FrameGraphPass shadows = Pass(graph, "Shadows");
+		graph.Write(shadows, shadowMap);
+
+		FrameGraphResource albedo = graph.CreateTexture("Albedo", Desc(width, height, FormatRgba8, 4));
+		FrameGraphResource normal = graph.CreateTexture("Normal", Desc(width, height, FormatRgba16Float, 8));
+		FrameGraphResource depth = graph.CreateTexture("Depth", Desc(width, height, FormatD32, 4));
+		FrameGraphPass gbuffer = Pass(graph, "GBuffer");
+		graph.Write(gbuffer, albedo);
+		graph.Write(gbuffer, normal);
+		graph.Write(gbuffer, depth);
+
+		FrameGraphResource ao = graph.CreateTexture("AO", Desc(width, height, FormatR8, 1));
+		FrameGraphPass ssao = Pass(graph, "SSAO");
+		graph.Read(ssao, normal);
+		graph.Read(ssao, depth);
+		graph.Write(ssao, ao);
+
+		FrameGraphResource aoBlurred = graph.CreateTexture("AOBlurred", Desc(width, height, FormatR8, 1));
+		FrameGraphPass ssaoBlur = Pass(graph, "SSAOBlur");
+		graph.Read(ssaoBlur, ao);
+		graph.Write(ssaoBlur, aoBlurred);
+
+		FrameGraphResource hdr = graph.CreateTexture("HDR", Desc(width, height, FormatRgba16Float, 8));
+		FrameGraphPass lighting = Pass(graph, "Lighting");
+		graph.Read(lighting, albedo);
+		graph.Read(lighting, normal);
+		graph.Read(lighting, depth);
+		graph.Read(lighting, aoBlurred);
+		graph.Read(lighting, shadowMap);
+		graph.Write(lighting, hdr);
+
+		// Depuración: escribe una vista de normales que ningún pase lee, así que se descarta.
+		FrameGraphResource debugView = graph.CreateTexture("DebugNormals", Desc(width, height, FormatRgba8, 4));
+		FrameGraphPass debug = Pass(graph, "DebugNormals");
+		graph.Read(debug, normal);
+		graph.Write(debug, debugView);
+
+		// Resplandor: cinco reducciones a la mitad y cinco ampliaciones que suman cada nivel.
+		const uint32_t BloomLevels = 5;
+		FrameGraphResource down[BloomLevels];
+		FrameGraphResource source = hdr;
+		for (uint32_t level = 0; level < BloomLevels; level++)
+		{
+			std::string name = "BloomDown" + std::to_string(level);
+			down[level] = graph.CreateTexture(name.c_str(), Desc(width >> (level + 1), height >> (level + 1), FormatRgba16Float, 8));
+			FrameGraphPass pass = Pass(graph, name.c_str());
+			graph.Read(pass, source);
+			graph.Write(pass, down[level]);
+			source = down[level];
+		}
+		for (uint32_t level = BloomLevels - 1; level-- > 0;)
+		{
+			std::string name = "BloomUp" + std::to_string(level);
+			FrameGraphResource up = graph.CreateTexture(name.c_str(), Desc(width >> (level + 1), height >> (level + 1), FormatRgba16Float, 8));
+			FrameGraphPass pass = Pass(graph, name.c_str());
+			graph.Read(pass, source);
+			graph.Read(pass, down[level]);
+			graph.Write(pass, up);
+			source = up;
+		}
+
+		FrameGraphResource ldr = graph.CreateTexture("LDR", Desc(width, height, FormatRgba8, 4));
+		FrameGraphPass tonemap = Pass(graph, "Tonemap");
+		graph.Read(tonemap, hdr);
+		graph.Read(tonemap, source);
+		graph.Write(tonemap, ldr);
+
+		FrameGraphPass fxaa = Pass(graph, "FXAA");
+		graph.Read(fxaa, ldr);
+		graph.Write(fxaa, backBuffer);
+	}
+
+	// Cadena de count pases con texturas de cuatro tamaños; cada pase lee las dos anteriores y uno de cada
+	// ocho no contribuye a la salida.
+	void BuildChain(FrameGraph& graph, uint32_t count)
+	{
+		FrameGraphResource output = graph.ImportTexture("Output", Desc(1920, 1080, FormatRgba8, 4));
+		FrameGraphResource previous[2] = { FrameGraphInvalid, FrameGraphInvalid };
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t scale = 1 + (i & 3);
+			FrameGraphResource texture = graph.CreateTexture("T", Desc(1920 / scale, 1080 / scale, FormatRgba16Float, 8));
+			FrameGraphPass pass = Pass(graph, "P");
+			for (FrameGraphResource input : previous)
+			{
+				if (input != FrameGraphInvalid)
+				{
+					graph.Read(pass, input);
+				}
+			}
+			graph.Write(pass, texture);
+			if ((i & 7) != 7)
+			{
+				previous[1] = previous[0];
+				previous[0] = texture;
+			}
+		}
+
+		FrameGraphPass present = Pass(graph, "Present");
+		graph.Read(present, previous[0]);
+		graph.Write(present, output);
+	}
+
+	void AddGraphResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t operations, const FrameGraph& graph)
+	{
+		const FrameGraphStats& stats = graph.GetStats();
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, operations);
+		result.parameters.push_back(std::make_pair("passes", static_cast<double>(stats.passes)));
+		result.parameters.push_back(std::make_pair("culled_passes", static_cast<double>(stats.culledPasses)));
+		result.parameters.push_back(std::make_pair("transient_textures", static_cast<double>(stats.transientTextures)));
+		result.parameters.push_back(std::make_pair("physical_textures", static_cast<double>(stats.physicalTextures)));
+		result.parameters.push_back(std::make_pair("unaliased_mb", stats.unaliasedBytes / (1024.0 * 1024.0)));
+		result.parameters.push_back(std::make_pair("aliased_mb", stats.aliasedBytes / (1024.0 * 1024.0)));
+		result.parameters.push_back(std::make_pair("peak_live_mb", stats.peakLiveBytes / (1024.0 * 1024.0)));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t maxPasses = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 100;
+
+	Benchmarks::BenchmarkReporter reporter("frame_graph");
+
+	// Canalización diferida: construcción más compilación, y ejecución de los pases vivos.
+	{
+		FrameGraph graph;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			graph.Reset();
+			BuildDeferredPipeline(graph, 1920, 1080);
+			graph.Compile();
+		}
+		AddGraphResult(reporter, "deferred_build_compile", stopwatch.ElapsedSeconds(), repetitions, graph);
+
+		g_executed = 0;
+		graph.Execute();
+		reporter.Add("deferred_executed_passes", 0.0, 0).parameters.push_back(std::make_pair("executed", static_cast<double>(g_executed)));
+		reporter.Check("deferred_executed_passes", "deben ejecutarse todos los pases no descartados", g_executed == graph.GetStats().passes - graph.GetStats().culledPasses);
+	}
+
+	// Un pase que lee una textura que nadie ha escrito debe rechazarse.
+	{
+		FrameGraph graph;
+		FrameGraphResource output = graph.ImportTexture("Output", Desc(64, 64, FormatRgba8, 4));
+		FrameGraphResource missing = graph.CreateTexture("Missing", Desc(64, 64, FormatRgba8, 4));
+		FrameGraphPass pass = Pass(graph, "Broken");
+		graph.Read(pass, missing);
+		graph.Write(pass, output);
+		graph.Read(pass, 1234);
+		bool compiled = graph.Compile();
+		Benchmarks::BenchmarkResult& result = reporter.Add("validation", 0.0, 0);
+		result.parameters.push_back(std::make_pair("compiled", compiled ? 1.0 : 0.0));
+		result.parameters.push_back(std::make_pair("errors", static_cast<double>(graph.GetErrors().size())));
+		reporter.Check(result.name, "un grafo que lee texturas sin escribir no debe compilar", !compiled && !graph.GetErrors().empty());
+	}
+
+	for (uint32_t passes = 10; passes <= maxPasses; passes *= 10)
+	{
+		FrameGraph graph;
+		BuildChain(graph, passes);
+		uint32_t compileRepetitions = (repetitions * 100) / passes + 1;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < compileRepetitions; r++)
+		{
+			graph.Compile();
+		}
+		AddGraphResult(reporter, "chain_compile", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(compileRepetitions) * passes, graph);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
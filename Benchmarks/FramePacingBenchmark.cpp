@@ -0,0 +1,165 @@
+﻿// Latencia de la entrada a la pantalla con y sin DX::FramePacer, contra un reloj de vsync simulado a
+// 60 Hz. Cada fotograma lee la entrada al empezar y se muestra en el primer vsync tras terminar; el
+// bucle vuelve a empezar cuando se muestra (como Present con un solo fotograma en cola). Sin ritmo, el
+// fotograma empieza justo tras el vsync; con ritmo, FramePacer lo retrasa hasta el vsync menos el coste
+// previsto. El coste de cada fotograma varía un 20% alrededor del nominal, con un 3% de picos del doble
+// y 0,4 ms como mucho de retraso al despertar. Se dan los percentiles de la latencia, la fracción de
+// vsync perdidos y los fotogramas por segundo mostrados.
+// Uso: FramePacingBenchmark [fotogramas]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/FramePacer.h"
+
+using namespace DX;
+
+namespace
+{
+	const double RefreshPeriod = 1.0 / 60.0;
+
+	// Generador congruencial para que las series sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		double Next(double low, double high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * ((state >> 8) * (1.0 / 16777216.0));
+		}
+	};
+
+	struct FrameWorkload
+	{
+		Random	random;
+		double	nominalSeconds;
+
+		FrameWorkload(uint32_t seed, double nominal) : random(seed), nominalSeconds(nominal) {}
+
+		double NextCost()
+		{
+			double cost = nominalSeconds * random.Next(0.8, 1.2);
+			return (random.Next(0.0, 1.0) < 0.03) ? cost * 2.0 : cost;
+		}
+
+		double NextWakeupDelay()		{ return random.Next(0.0, 0.0004); }
+	};
+
+	double GetNextVsync(double time)
+	{
+		return (floor(time / RefreshPeriod + 1e-9) + 1.0) * RefreshPeriod;
+	}
+
+	uint64_t GetRefreshCount(double time)
+	{
+		return static_cast<uint64_t>(floor(time / RefreshPeriod + 1e-9));
+	}
+
+	struct PacingResult
+	{
+		std::vector<double>	latencies;
+		uint32_t			missed;
+		double				seconds;
+	};
+
+	PacingResult RunUnpaced(uint32_t frames, double nominal)
+	{
+		FrameWorkload workload(frames, nominal);
+		PacingResult result = { std::vector<double>(), 0, 0.0 };
+		double now = 0.0;
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			double start = now + workload.NextWakeupDelay();
+			double end = start + workload.NextCost();
+			double displayed = GetNextVsync(end);
+			if (displayed > GetNextVsync(start) + 0.5 * RefreshPeriod)
+			{
+				result.missed++;
+			}
+			result.latencies.push_back(displayed - start);
+			now = displayed;
+		}
+		result.seconds = now;
+		return result;
+	}
+
+	PacingResult RunPaced(uint32_t frames, double nominal, FramePacerStats& stats)
+	{
+		FrameWorkload workload(frames, nominal);
+		FramePacer pacer;
+		PacingResult result = { std::vector<double>(), 0, 0.0 };
+		double now = 0.0;
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			// La espera de la cadena de intercambio vuelve en el vsync que mostró el fotograma anterior.
+			pacer.OnVsync(now, GetRefreshCount(now));
+
+			double start = pacer.GetFrameStart(now);
+			if (start > now)
+			{
+				double woken = start + workload.NextWakeupDelay();
+				pacer.RecordWakeup(start, woken);
+				start = woken;
+			}
+
+			pacer.BeginFrame(start);
+			FramePacingSample sample = pacer.EndFrame(start + workload.NextCost());
+			if (sample.missed)
+			{
+				result.missed++;
+			}
+			result.latencies.push_back(sample.latency);
+			now = sample.displayed;
+		}
+		result.seconds = now;
+		stats = pacer.GetStats();
+		return result;
+	}
+
+	double GetPercentile(std::vector<double> values, double percentile)
+	{
+		size_t index = std::min(static_cast<size_t>(percentile * values.size()), values.size() - 1);
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	Benchmarks::BenchmarkResult& Report(Benchmarks::BenchmarkReporter& reporter, const std::string& name, const PacingResult& run, double nominal)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, run.seconds, run.latencies.size());
+		result.parameters.push_back(std::make_pair("frame_cost_ms", nominal * 1000.0));
+		result.parameters.push_back(std::make_pair("latency_p50_ms", GetPercentile(run.latencies, 0.50) * 1000.0));
+		result.parameters.push_back(std::make_pair("latency_p95_ms", GetPercentile(run.latencies, 0.95) * 1000.0));
+		result.parameters.push_back(std::make_pair("latency_p99_ms", GetPercentile(run.latencies, 0.99) * 1000.0));
+		result.parameters.push_back(std::make_pair("missed_fraction", static_cast<double>(run.missed) / run.latencies.size()));
+		result.parameters.push_back(std::make_pair("displayed_fps", run.latencies.size() / run.seconds));
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+	const double nominalCosts[] = { 0.002, 0.006, 0.012 };
+
+	// Los segundos de las filas son del reloj simulado; ns_per_op es el tiempo medio entre fotogramas mostrados.
+	Benchmarks::BenchmarkReporter reporter("frame_pacing");
+	for (double nominal : nominalCosts)
+	{
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "_%.0fms", nominal * 1000.0);
+
+		Report(reporter, std::string("unpaced") + suffix, RunUnpaced(frames, nominal), nominal);
+
+		FramePacerStats stats;
+		Benchmarks::BenchmarkResult& result = Report(reporter, std::string("paced") + suffix, RunPaced(frames, nominal, stats), nominal);
+		result.parameters.push_back(std::make_pair("predicted_ms", stats.predictedSeconds * 1000.0));
+		result.parameters.push_back(std::make_pair("average_delay_ms", stats.averageDelay * 1000.0));
+	}
+	reporter.Print();
+	return reporter.GetExitCode();
+}
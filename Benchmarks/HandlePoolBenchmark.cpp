@@ -0,0 +1,215 @@
+﻿// Referencia de los conjuntos con identificadores generacionales frente a la propiedad con std::shared_ptr,
+// con un millón de instancias de escena: crear, buscar en orden aleatorio (con detección de caducados:
+// weak_ptr::lock frente a la comprobación de generación), recorrer todas, destruir y volver a crear la
+// mitad, y destruir todo. También comprueba que un identificador caduco se rechaza.
+// Uso: HandlePoolBenchmark [objetos] [búsquedas]
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/HandlePool.h"
+
+using namespace DX;
+
+namespace
+{
+	// Lo que un representador guarda de cada instancia: posición, escala y los recursos que usa.
+	struct Instance
+	{
+		float		position[3];
+		float		scale;
+		uint32_t	mesh;
+		uint32_t	material;
+
+		Instance(uint32_t i) : scale(1.0f), mesh(i & 15), material(i & 63)
+		{
+			position[0] = static_cast<float>(i & 1023);
+			position[1] = static_cast<float>(i >> 10);
+			position[2] = 0.0f;
+		}
+	};
+
+	typedef HandlePool<Instance> InstancePool;
+
+	// Orden aleatorio reproducible de count índices.
+	std::vector<uint32_t> Shuffled(uint32_t count, uint32_t seed)
+	{
+		std::vector<uint32_t> order(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			order[i] = i;
+		}
+		uint32_t state = seed;
+		for (uint32_t i = count; i > 1; i--)
+		{
+			state = state * 1664525u + 1013904223u;
+			std::swap(order[i - 1], order[(state >> 8) % i]);
+		}
+		return order;
+	}
+
+	void AddPerObject(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t operations, const char* model)
+	{
+		reporter.Add(std::string(name) + "_" + model, seconds, operations);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+	uint32_t lookups = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 4000000;
+	count = std::min(count, InstancePool::MaxCount);
+
+	Benchmarks::BenchmarkReporter reporter("handle_pool");
+	std::vector<uint32_t> lookupOrder(lookups);
+	{
+		std::vector<uint32_t> order = Shuffled(count, 11);
+		for (uint32_t i = 0; i < lookups; i++)
+		{
+			lookupOrder[i] = order[i % count];
+		}
+	}
+	std::vector<uint32_t> churnOrder = Shuffled(count, 23);
+
+	// Propiedad compartida: el dueño guarda shared_ptr y los usuarios weak_ptr, para poder detectar objetos
+	// destruidos como con los identificadores.
+	{
+		std::vector<std::shared_ptr<Instance>> owners;
+		std::vector<std::weak_ptr<Instance>> references;
+		owners.reserve(count);
+		references.reserve(count);
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			owners.push_back(std::make_shared<Instance>(i));
+			references.push_back(owners.back());
+		}
+		AddPerObject(reporter, "create", stopwatch.ElapsedSeconds(), count, "shared_ptr");
+
+		float sum = 0.0f;
+		stopwatch.Restart();
+		for (uint32_t i = 0; i < lookups; i++)
+		{
+			std::shared_ptr<Instance> instance = references[lookupOrder[i]].lock();
+			if (instance)
+			{
+				sum += instance->position[0];
+			}
+		}
+		AddPerObject(reporter, "lookup", stopwatch.ElapsedSeconds(), lookups, "shared_ptr");
+
+		stopwatch.Restart();
+		for (const std::shared_ptr<Instance>& instance : owners)
+		{
+			sum += instance->position[1] * instance->scale;
+		}
+		AddPerObject(reporter, "iterate", stopwatch.ElapsedSeconds(), count, "shared_ptr");
+
+		// La mitad se destruye en orden aleatorio y se vuelve a crear.
+		stopwatch.Restart();
+		for (uint32_t i = 0; i < count / 2; i++)
+		{
+			owners[churnOrder[i]].reset();
+		}
+		for (uint32_t i = 0; i < count / 2; i++)
+		{
+			uint32_t index = churnOrder[i];
+			owners[index] = std::make_shared<Instance>(index);
+			references[index] = owners[index];
+		}
+		AddPerObject(reporter, "churn_half", stopwatch.ElapsedSeconds(), count, "shared_ptr");
+
+		stopwatch.Restart();
+		owners.clear();
+		AddPerObject(reporter, "destroy_all", stopwatch.ElapsedSeconds(), count, "shared_ptr");
+
+		uint32_t stale = 0;
+		for (uint32_t i = 0; i < count; i += 997)
+		{
+			stale += references[i].expired() ? 1 : 0;
+		}
+		Benchmarks::DoNotOptimize(sum);
+		Benchmarks::DoNotOptimize(stale);
+	}
+
+	{
+		InstancePool pool;
+		pool.Reserve(count);
+		std::vector<PoolHandle> handles(count);
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			handles[i] = pool.Create(i);
+		}
+		AddPerObject(reporter, "create", stopwatch.ElapsedSeconds(), count, "handle_pool");
+
+		float sum = 0.0f;
+		stopwatch.Restart();
+		for (uint32_t i = 0; i < lookups; i++)
+		{
+			const Instance* instance = pool.Get(handles[lookupOrder[i]]);
+			if (instance != nullptr)
+			{
+				sum += instance->position[0];
+			}
+		}
+		AddPerObject(reporter, "lookup", stopwatch.ElapsedSeconds(), lookups, "handle_pool");
+
+		stopwatch.Restart();
+		const Instance* instances = pool.GetData();
+		for (uint32_t i = 0; i < pool.GetCount(); i++)
+		{
+			sum += instances[i].position[1] * instances[i].scale;
+		}
+		AddPerObject(reporter, "iterate", stopwatch.ElapsedSeconds(), count, "handle_pool");
+
+		std::vector<PoolHandle> destroyed;
+		stopwatch.Restart();
+		for (uint32_t i = 0; i < count / 2; i++)
+		{
+			pool.Destroy(handles[churnOrder[i]]);
+		}
+		for (uint32_t i = 0; i < count / 2; i++)
+		{
+			uint32_t index = churnOrder[i];
+			if (i < 1000)
+			{
+				destroyed.push_back(handles[index]);
+			}
+			handles[index] = pool.Create(index);
+		}
+		AddPerObject(reporter, "churn_half", stopwatch.ElapsedSeconds(), count, "handle_pool");
+
+		// Los identificadores de antes de la renovación apuntan a ranuras reutilizadas y deben rechazarse.
+		uint32_t staleAccepted = 0;
+		for (PoolHandle handle : destroyed)
+		{
+			staleAccepted += (pool.Get(handle) != nullptr) ? 1 : 0;
+		}
+
+		stopwatch.Restart();
+		pool.Clear();
+		AddPerObject(reporter, "destroy_all", stopwatch.ElapsedSeconds(), count, "handle_pool");
+
+		uint32_t validAfterClear = 0;
+		for (PoolHandle handle : handles)
+		{
+			validAfterClear += pool.IsValid(handle) ? 1 : 0;
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add("stale_detection", 0.0, 0);
+		result.parameters.push_back(std::make_pair("stale_checked", static_cast<double>(destroyed.size())));
+		result.parameters.push_back(std::make_pair("stale_accepted", static_cast<double>(staleAccepted)));
+		result.parameters.push_back(std::make_pair("valid_after_clear", static_cast<double>(validAfterClear)));
+		reporter.Check(result.name, "un identificador destruido no debe encontrar objeto", staleAccepted == 0);
+		reporter.Check(result.name, "ningún identificador debe seguir siendo válido tras Clear", validAfterClear == 0);
+		Benchmarks::DoNotOptimize(sum);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
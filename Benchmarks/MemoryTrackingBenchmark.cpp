@@ -0,0 +1,151 @@
+﻿// Referencia de los contadores de memoria por subsistema: coste de una reserva con etiqueta frente a
+// std::allocator, en un subproceso y desde todos los del sistema de tareas a la vez, y la instantánea por
+// fotograma de un bucle que usa los sistemas etiquetados (comandos de dibujo, texto, arena, tela). Para
+// medir el coste con el seguimiento quitado, compilar con -DDX_MEMORY_TRACKING_DISABLED=ON.
+// Uso: MemoryTrackingBenchmark [reservas] [fotogramas]
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/BitmapFont.h"
+#include "../App2/Common/FrameArena.h"
+#include "../App2/Common/JobSystem.h"
+#include "../App2/Common/MemoryTracker.h"
+#include "../App2/Common/RenderCommandBuffer.h"
+#include "../App2/Common/TextBatch.h"
+#include "../App2/Content/ClothSimulation.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+#if defined(DX_MEMORY_TRACKING_DISABLED)
+	const double TrackingEnabled = 0.0;
+#else
+	const double TrackingEnabled = 1.0;
+#endif
+
+	// Reserva y libera count vectores pequeños de tamaño variable, como hacen los contenedores temporales.
+	template<typename TVector>
+	uint64_t Churn(uint32_t count)
+	{
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			TVector values;
+			values.reserve(8 + (i & 63));
+			values.push_back(i);
+			sum += values.capacity();
+		}
+		return sum;
+	}
+
+	void AddChurnResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t count, uint32_t threads)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, count);
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(threads)));
+		result.parameters.push_back(std::make_pair("tracking", TrackingEnabled));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t allocations = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 2000000;
+	uint32_t frames = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 60;
+
+	Benchmarks::BenchmarkReporter reporter("memory_tracking");
+	MemoryTracker& tracker = MemoryTracker::Get();
+
+	{
+		Benchmarks::Stopwatch stopwatch;
+		Benchmarks::DoNotOptimize(Churn<std::vector<uint32_t>>(allocations));
+		AddChurnResult(reporter, "std_allocator", stopwatch.ElapsedSeconds(), allocations, 1);
+
+		stopwatch.Restart();
+		Benchmarks::DoNotOptimize(Churn<TaggedVector<uint32_t, MemoryTag::General>>(allocations));
+		AddChurnResult(reporter, "tagged_allocator", stopwatch.ElapsedSeconds(), allocations, 1);
+	}
+
+	// Todos los subprocesos cargan a la misma etiqueta: el peor caso para la línea de caché compartida.
+	{
+		JobSystem jobSystem;
+		uint32_t threads = jobSystem.GetThreadCount();
+		uint32_t perThread = allocations / threads;
+		Benchmarks::Stopwatch stopwatch;
+		jobSystem.ParallelFor(threads, 1, [perThread](uint32_t, uint32_t)
+		{
+			Benchmarks::DoNotOptimize(Churn<TaggedVector<uint32_t, MemoryTag::General>>(perThread));
+		});
+		AddChurnResult(reporter, "tagged_allocator_parallel", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(perThread) * threads, threads);
+	}
+
+	// Bucle de fotogramas con los sistemas etiquetados. Al final se informa de cada etiqueta.
+	{
+		JobSystem jobSystem;
+		FrameArena frameArena(jobSystem.GetThreadCount(), 64 * 1024);
+		RenderCommandBuffer commands(256);
+		BitmapFontRasterizer rasterizer;
+		GlyphAtlas atlas(&rasterizer, 512, 512);
+		TextLayoutCache layouts(&atlas, 256);
+		TextBatch batch;
+		TextFormat format(16, 0.0f, TextAlignment::Leading);
+		ClothSimulation cloth(&jobSystem, ClothMeshDesc::CreateGrid(32, 32, 0.02f, Vector3(0.0f, 0.0f, 0.0f)));
+		tracker.ResetPeaks();
+		tracker.EndFrame();
+
+		uint64_t frameAllocations = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			frameArena.BeginFrame();
+			commands.Reset();
+			for (uint32_t i = 0; i < 2000 + frame * 100; i++)
+			{
+				DrawPacket packet = {};
+				packet.indexCount = 36;
+				commands.Add(RenderSortKey::Opaque(0, i & 7, i & 63, (i % 100) * 0.01f), packet);
+			}
+			commands.Sort(&jobSystem);
+
+			ArenaVector<uint32_t> scratch(1000 + frame * 50, 0, ArenaAllocator<uint32_t>(frameArena.GetArena()));
+			Benchmarks::DoNotOptimize(scratch.data());
+
+			// Las etiquetas con el número de fotograma cambian, así que la caché maqueta texto nuevo.
+			for (uint32_t i = 0; i < 32; i++)
+			{
+				std::string label = "Etiqueta " + std::to_string(i) + ": " + std::to_string(frame);
+				batch.AddText(layouts, label.c_str(), format, 0.0f, i * 18.0f, 0xffffffff);
+			}
+			batch.Clear();
+			layouts.NextFrame();
+
+			cloth.Step(1.0f / 60.0f);
+			tracker.EndFrame();
+			frameAllocations += tracker.GetLastFrame().GetFrameAllocations();
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		const MemorySnapshot& snapshot = tracker.GetLastFrame();
+		Benchmarks::BenchmarkResult& total = reporter.Add("frame_loop", seconds, frames);
+		total.parameters.push_back(std::make_pair("tracking", TrackingEnabled));
+		total.parameters.push_back(std::make_pair("live_kb", snapshot.GetLiveBytes() / 1024.0));
+		total.parameters.push_back(std::make_pair("allocations_per_frame", static_cast<double>(frameAllocations) / frames));
+
+		static const MemoryTag ReportedTags[] = { MemoryTag::RenderCommands, MemoryTag::Text, MemoryTag::Textures, MemoryTag::FrameArena, MemoryTag::Cloth };
+		for (MemoryTag tag : ReportedTags)
+		{
+			const MemoryTagStats& stats = snapshot.Get(tag);
+			std::string name = std::string("tag_") + GetMemoryTagName(tag);
+			Benchmarks::BenchmarkResult& result = reporter.Add(name, 0.0, 0);
+			result.parameters.push_back(std::make_pair("live_kb", stats.liveBytes / 1024.0));
+			result.parameters.push_back(std::make_pair("peak_kb", stats.peakBytes / 1024.0));
+			result.parameters.push_back(std::make_pair("total_allocations", static_cast<double>(stats.totalAllocations)));
+			result.parameters.push_back(std::make_pair("last_frame_allocations", static_cast<double>(stats.frameAllocations)));
+		}
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,207 @@
+﻿// Referencia del descarte por oclusión en la CPU: los cubos pequeños de SceneBenchmark repartidos entre
+// varias filas de muros, vistos con la cámara de la escena. Tras el tronco, DX::OcclusionCuller descarta
+// los que quedan detrás de los muros; se mide la fracción descartada y el coste de rasterizar, construir
+// la pirámide y probar, en serie y con todos los subprocesos. Cada esfera descartada se comprueba con
+// rayos desde el ojo a su centro y a seis puntos de su superficie (los que caen en pantalla) contra los
+// mismos muros en una DX::TriangleBvh: si alguno llega, el descarte fue incorrecto (wrongly_culled debe
+// ser 0).
+// Uso: OcclusionBenchmark [objetos] [repeticiones]
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/Frustum.h"
+#include "../App2/Common/OcclusionCuller.h"
+#include "../App2/Common/TriangleBvh.h"
+#include "../App2/Content/SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Generador congruencial para que las escenas sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * ((state >> 8) * (1.0f / 16777216.0f));
+		}
+	};
+
+	// Mismo reparto que SyntheticScene en SceneBenchmark.
+	struct SphereSet
+	{
+		std::vector<float>	x, y, z, radius;
+
+		explicit SphereSet(uint32_t count)
+		{
+			Random random(count);
+			float bodyRadius = Length(Vector3(0.05f, 0.05f, 0.05f));
+			for (uint32_t i = 0; i < count; i++)
+			{
+				x.push_back(random.Next(-3.0f, 3.0f));
+				y.push_back(random.Next(-2.0f, 2.0f));
+				z.push_back(random.Next(-6.0f, 1.0f));
+				radius.push_back(bodyRadius);
+			}
+		}
+	};
+
+	// Tres filas de muros, con huecos desplazados de una fila a otra, como triángulos sueltos.
+	void AddBox(std::vector<Vector3>& triangles, const Vector3& minimum, const Vector3& maximum)
+	{
+		static const uint8_t Faces[6][4] =
+		{
+			{ 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 },
+		};
+
+		Vector3 corners[8];
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			corners[i] = Vector3((i & 4) ? maximum.x : minimum.x, (i & 2) ? maximum.y : minimum.y, (i & 1) ? maximum.z : minimum.z);
+		}
+		for (const uint8_t* face : Faces)
+		{
+			triangles.push_back(corners[face[0]]);
+			triangles.push_back(corners[face[1]]);
+			triangles.push_back(corners[face[2]]);
+			triangles.push_back(corners[face[0]]);
+			triangles.push_back(corners[face[2]]);
+			triangles.push_back(corners[face[3]]);
+		}
+	}
+
+	std::vector<Vector3> CreateWalls()
+	{
+		std::vector<Vector3> triangles;
+		const float rowDepths[3] = { -0.5f, -2.0f, -3.5f };
+		for (uint32_t row = 0; row < 3; row++)
+		{
+			for (float left = -3.5f + 0.4f * row; left < 3.0f; left += 1.6f)
+			{
+				AddBox(triangles, Vector3(left, -2.2f, rowDepths[row] - 0.1f), Vector3(left + 1.2f, 0.6f, rowDepths[row] + 0.1f));
+			}
+		}
+		return triangles;
+	}
+
+	// Solo cuentan los puntos dentro de la pantalla: lo que se ve fuera de ella no importa.
+	bool IsPointVisible(const TriangleBvh& bvh, const Matrix4& viewProjection, const Vector3& point)
+	{
+		float clip[4];
+		TransformPoint(point, viewProjection, clip);
+		if (clip[3] <= 0.0f || fabsf(clip[0]) > clip[3] || fabsf(clip[1]) > clip[3])
+		{
+			return false;
+		}
+
+		Vector3 eye = GetSceneEyePosition();
+		Vector3 offset = point - eye;
+		float distance = Length(offset);
+		Ray ray = { eye, offset * (1.0f / distance), distance * 0.999f };
+		return !bvh.IsOccluded(ray);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t objects = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 20;
+
+	SphereSet spheres(objects);
+	std::vector<Vector3> walls = CreateWalls();
+	uint32_t wallTriangles = static_cast<uint32_t>(walls.size() / 3);
+	std::vector<uint32_t> wallIndices(walls.size());
+	for (uint32_t i = 0; i < wallIndices.size(); i++)
+	{
+		wallIndices[i] = i;
+	}
+
+	Matrix4 viewProjection = ComputeSceneView() * ComputeSceneProjection(1920.0f, 1080.0f, Matrix4::Identity());
+	Frustum frustum = Frustum::FromViewProjection(viewProjection);
+	std::vector<uint8_t> frustumVisible(objects);
+	uint32_t inFrustum = frustum.CullSpheres(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), objects, frustumVisible.data());
+
+	JobSystem jobSystem;
+	TriangleBvh bvh;
+	bvh.Build(&jobSystem, walls.data(), wallTriangles);
+
+	Benchmarks::BenchmarkReporter reporter("occlusion");
+	for (int parallel = 0; parallel < 2; parallel++)
+	{
+		JobSystem* jobs = parallel ? &jobSystem : nullptr;
+		OcclusionCuller culler(OcclusionCullerDesc::CreateDefault());
+		std::vector<uint8_t> visible(objects);
+		uint32_t visibleCount = 0;
+		double rasterizeMilliseconds = 0.0;
+		double pyramidMilliseconds = 0.0;
+		double testMilliseconds = 0.0;
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			culler.BeginFrame(viewProjection);
+			culler.AddOccluder(walls.data(), sizeof(Vector3), static_cast<uint32_t>(walls.size()), wallIndices.data(), static_cast<uint32_t>(wallIndices.size()));
+			culler.Rasterize(jobs);
+			visible = frustumVisible;
+			visibleCount = culler.CullSpheres(jobs, spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), objects, visible.data());
+
+			OcclusionStats stats = culler.GetStats();
+			rasterizeMilliseconds += stats.rasterizeMilliseconds;
+			pyramidMilliseconds += stats.pyramidMilliseconds;
+			testMilliseconds += stats.testMilliseconds;
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		uint32_t wronglyCulled = 0;
+		for (uint32_t i = 0; i < objects; i++)
+		{
+			if (!frustumVisible[i] || visible[i])
+			{
+				continue;
+			}
+
+			Vector3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+			float radius = spheres.radius[i];
+			const Vector3 points[7] =
+			{
+				center,
+				center + Vector3(radius, 0.0f, 0.0f), center - Vector3(radius, 0.0f, 0.0f),
+				center + Vector3(0.0f, radius, 0.0f), center - Vector3(0.0f, radius, 0.0f),
+				center + Vector3(0.0f, 0.0f, radius), center - Vector3(0.0f, 0.0f, radius),
+			};
+			for (const Vector3& point : points)
+			{
+				if (IsPointVisible(bvh, viewProjection, point))
+				{
+					wronglyCulled++;
+					break;
+				}
+			}
+		}
+
+		OcclusionStats stats = culler.GetStats();
+		Benchmarks::BenchmarkResult& result = reporter.Add(parallel ? "occlusion_cull_parallel" : "occlusion_cull_serial", seconds, repetitions);
+		result.parameters.push_back(std::make_pair("objects", static_cast<double>(objects)));
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(parallel ? jobSystem.GetThreadCount() : 1)));
+		result.parameters.push_back(std::make_pair("occluder_triangles", static_cast<double>(stats.occluderTriangles)));
+		result.parameters.push_back(std::make_pair("rasterized_triangles", static_cast<double>(stats.rasterizedTriangles)));
+		result.parameters.push_back(std::make_pair("in_frustum", static_cast<double>(inFrustum)));
+		result.parameters.push_back(std::make_pair("visible", static_cast<double>(visibleCount)));
+		result.parameters.push_back(std::make_pair("culled_fraction", (inFrustum > 0) ? 1.0 - static_cast<double>(visibleCount) / inFrustum : 0.0));
+		result.parameters.push_back(std::make_pair("rasterize_ms", rasterizeMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("pyramid_ms", pyramidMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("test_ms", testMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("wrongly_culled", static_cast<double>(wronglyCulled)));
+		reporter.Check(result.name, "no debe descartarse ningún objeto visible", wronglyCulled == 0);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
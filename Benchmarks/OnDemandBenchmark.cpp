@@ -0,0 +1,149 @@
+﻿// Consumo de CPU del bucle de la aplicación con la escena quieta, con y sin dibujo bajo demanda
+// (DX::FrameInvalidation). Cada fotograma simula el coste de Update y Render con una espera activa y el
+// de Present con una espera hasta el siguiente vsync de 60 Hz, como App::Run. Se comparan el bucle
+// continuo, el bajo demanda sin cambios (solo el refresco periódico de 1 FPS) y el bajo demanda con
+// entrada a 10 Hz desde otro subproceso, del que se mide también la latencia desde Invalidate hasta que
+// el bucle empieza el fotograma. cpu_percent es el tiempo de CPU del proceso sobre el tiempo real.
+// Uso: OnDemandBenchmark [segundos por modo] [coste del fotograma en ms]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <thread>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/FrameInvalidation.h"
+
+using namespace DX;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::duration VsyncPeriod = std::chrono::microseconds(16667);
+
+	void SpinFor(Clock::duration duration)
+	{
+		Clock::time_point end = Clock::now() + duration;
+		while (Clock::now() < end)
+		{
+		}
+	}
+
+	struct LoopResult
+	{
+		double		wallSeconds;
+		double		cpuSeconds;
+		uint64_t	frames;
+		uint64_t	inputFrames;
+		double		latencyTotalMilliseconds;
+		double		latencyMaxMilliseconds;
+	};
+
+	// Bucle de App::Run con una ventana siempre visible. inputHertz > 0 marca la entrada desde otro subproceso.
+	LoopResult RunLoop(FrameInvalidation& invalidation, double seconds, Clock::duration frameCost, double inputHertz)
+	{
+		std::atomic<bool> stopping(false);
+		std::atomic<int64_t> inputTicks(0);
+		std::thread input;
+		if (inputHertz > 0.0)
+		{
+			input = std::thread([&]()
+			{
+				Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / inputHertz));
+				while (!stopping)
+				{
+					std::this_thread::sleep_for(interval);
+					inputTicks = Clock::now().time_since_epoch().count();
+					invalidation.Invalidate(FrameInvalidationReason::Input);
+				}
+			});
+		}
+
+		LoopResult result = {};
+		std::clock_t cpuStart = std::clock();
+		Clock::time_point start = Clock::now();
+		Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+		Clock::time_point nextVsync = start + VsyncPeriod;
+		while (Clock::now() < end)
+		{
+			uint32_t reasons = invalidation.BeginFrame();
+			if (reasons == 0)
+			{
+				invalidation.Wait();
+				continue;
+			}
+
+			if (FrameInvalidation::HasReason(reasons, FrameInvalidationReason::Input))
+			{
+				Clock::time_point invalidated = Clock::time_point(Clock::duration(inputTicks.load()));
+				double latency = std::chrono::duration<double, std::milli>(Clock::now() - invalidated).count();
+				result.latencyTotalMilliseconds += latency;
+				result.latencyMaxMilliseconds = std::max(result.latencyMaxMilliseconds, latency);
+				result.inputFrames++;
+			}
+
+			SpinFor(frameCost);
+
+			// Present espera al siguiente vsync; si el fotograma llega tarde, al primero que quede.
+			Clock::time_point now = Clock::now();
+			while (nextVsync <= now)
+			{
+				nextVsync += VsyncPeriod;
+			}
+			std::this_thread::sleep_until(nextVsync);
+			result.frames++;
+		}
+		result.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+		result.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+		stopping = true;
+		if (input.joinable())
+		{
+			input.join();
+		}
+		return result;
+	}
+
+	void Report(Benchmarks::BenchmarkReporter& reporter, const char* name, const LoopResult& loop, const FrameInvalidation& invalidation)
+	{
+		FrameInvalidationStats stats = invalidation.GetStats();
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, loop.wallSeconds, loop.frames);
+		result.parameters.push_back(std::make_pair("frames_per_second", loop.frames / loop.wallSeconds));
+		result.parameters.push_back(std::make_pair("cpu_percent", 100.0 * loop.cpuSeconds / loop.wallSeconds));
+		result.parameters.push_back(std::make_pair("idle_frames", static_cast<double>(stats.idleFrames)));
+		result.parameters.push_back(std::make_pair("waits", static_cast<double>(stats.waits)));
+		if (loop.inputFrames > 0)
+		{
+			result.parameters.push_back(std::make_pair("input_latency_mean_ms", loop.latencyTotalMilliseconds / loop.inputFrames));
+			result.parameters.push_back(std::make_pair("input_latency_max_ms", loop.latencyMaxMilliseconds));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+	double frameMilliseconds = (argc > 2) ? atof(argv[2]) : 4.0;
+	Clock::duration frameCost = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(frameMilliseconds));
+
+	Benchmarks::BenchmarkReporter reporter("on_demand");
+	{
+		FrameInvalidation invalidation;
+		invalidation.SetOnDemand(false);
+		Report(reporter, "continuous", RunLoop(invalidation, seconds, frameCost, 0.0), invalidation);
+	}
+	{
+		FrameInvalidation invalidation;
+		invalidation.SetIdleFramesPerSecond(1.0);
+		Report(reporter, "on_demand_static", RunLoop(invalidation, seconds, frameCost, 0.0), invalidation);
+	}
+	{
+		FrameInvalidation invalidation;
+		invalidation.SetIdleFramesPerSecond(1.0);
+		Report(reporter, "on_demand_input_10hz", RunLoop(invalidation, seconds, frameCost, 10.0), invalidation);
+	}
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,162 @@
+﻿// Referencia del trazador de caminos sobre la escena de la aplicación (pila de cubos, terreno, roca de
+// vóxeles y tela): construcción de la jerarquía en uno y en todos los subprocesos, comprobación de los
+// impactos contra una búsqueda exhaustiva y rayos por segundo (y por subproceso) en pasadas progresivas.
+// Si se da un archivo, escribe en él la imagen acumulada en BMP.
+// Uso: PathTracerBenchmark [subprocesos] [pasadas] [ancho] [alto] [imagen.bmp]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/SceneCamera.h"
+#include "../App2/Content/SceneTracing.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Impacto más cercano probando todos los triángulos (mismo algoritmo que TriangleBvh).
+	bool IntersectAll(const TraceScene& scene, const Ray& ray, float& distance)
+	{
+		distance = ray.maxDistance;
+		bool found = false;
+		for (uint32_t t = 0; t < scene.GetTriangleCount(); t++)
+		{
+			const Vector3* v = &scene.positions[static_cast<size_t>(t) * 3];
+			Vector3 edge1 = v[1] - v[0], edge2 = v[2] - v[0];
+			Vector3 p = Cross(ray.direction, edge2);
+			float determinant = Dot(edge1, p);
+			if (fabsf(determinant) < 1e-12f)
+			{
+				continue;
+			}
+			float inverse = 1.0f / determinant;
+			Vector3 s = ray.origin - v[0];
+			float u = Dot(s, p) * inverse;
+			Vector3 q = Cross(s, edge1);
+			float w = Dot(ray.direction, q) * inverse;
+			float hit = Dot(edge2, q) * inverse;
+			if (u >= 0.0f && u <= 1.0f && w >= 0.0f && u + w <= 1.0f && hit >= 0.0f && hit <= distance)
+			{
+				distance = hit;
+				found = true;
+			}
+		}
+		return found;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t threads = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 0;
+	uint32_t passes = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 8;
+	uint32_t width = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 320;
+	uint32_t height = (argc > 4) ? static_cast<uint32_t>(atoi(argv[4])) : 180;
+	const char* imagePath = (argc > 5) ? argv[5] : nullptr;
+
+	JobSystem jobSystem(threads);
+	JobSystem singleThread(1);
+	Benchmarks::BenchmarkReporter reporter("path_tracer");
+
+	FrameArena frameArena(jobSystem.GetThreadCount(), 256 * 1024);
+	SceneSimulation simulation(&jobSystem);
+	simulation.Create(frameArena);
+	simulation.CompleteStreaming();
+
+	TraceScene scene;
+	AddSceneSimulation(scene, simulation);
+
+	// Jerarquía: la mejor de varias construcciones, en un subproceso y en todos.
+	{
+		const uint32_t builds = 5;
+		JobSystem* systems[2] = { &singleThread, &jobSystem };
+		const char* names[2] = { "bvh_build_1_thread", "bvh_build_parallel" };
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			double best = 1e30;
+			BvhStats stats = {};
+			for (uint32_t b = 0; b < builds; b++)
+			{
+				TriangleBvh bvh;
+				bvh.Build(systems[s], scene.positions.data(), scene.GetTriangleCount());
+				stats = bvh.GetStats();
+				best = std::min(best, stats.buildMilliseconds);
+			}
+			Benchmarks::BenchmarkResult& result = reporter.Add(names[s], best / 1000.0, scene.GetTriangleCount());
+			result.parameters.push_back(std::make_pair("build_ms", best));
+			result.parameters.push_back(std::make_pair("triangles", static_cast<double>(stats.triangleCount)));
+			result.parameters.push_back(std::make_pair("wide_nodes", static_cast<double>(stats.wideNodes)));
+			result.parameters.push_back(std::make_pair("leaves", static_cast<double>(stats.leaves)));
+			result.parameters.push_back(std::make_pair("max_depth", static_cast<double>(stats.maxDepth)));
+			result.parameters.push_back(std::make_pair("threads", static_cast<double>(systems[s]->GetThreadCount())));
+		}
+	}
+
+	PathTracer tracer(&jobSystem, PathTracerDesc::CreateDefault(width, height));
+	tracer.SetScene(scene);
+	SetSceneCamera(tracer);
+
+	// Rayos desde el ojo en direcciones pseudoaleatorias: la jerarquía debe dar la misma distancia que la
+	// búsqueda exhaustiva.
+	{
+		TriangleBvh bvh;
+		bvh.Build(&jobSystem, scene.positions.data(), scene.GetTriangleCount());
+		const uint32_t rays = 2000;
+		uint32_t mismatches = 0;
+		uint32_t hits = 0;
+		uint32_t seed = 7;
+		auto random = [&seed]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+		};
+		for (uint32_t r = 0; r < rays; r++)
+		{
+			Vector3 target(random() * 2.0f, random() * 0.7f - 0.3f, random() * 2.0f - 0.5f);
+			Ray ray = { GetSceneEyePosition(), Normalize(target - GetSceneEyePosition()), 1e30f };
+			RayHit hit;
+			float expected;
+			bool found = bvh.Intersect(ray, hit);
+			bool foundAll = IntersectAll(scene, ray, expected);
+			hits += found ? 1 : 0;
+			if (found != foundAll || (found && fabsf(hit.distance - expected) > 1e-5f))
+			{
+				mismatches++;
+			}
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add("bvh_validation", 0.0, rays);
+		result.parameters.push_back(std::make_pair("hits", static_cast<double>(hits)));
+		result.parameters.push_back(std::make_pair("mismatches", static_cast<double>(mismatches)));
+		reporter.Check(result.name, "la BVH debe dar el mismo impacto que la búsqueda exhaustiva", mismatches == 0);
+	}
+
+	// Pasadas progresivas de una muestra por píxel.
+	{
+		double seconds = 0.0;
+		uint64_t rays = 0;
+		for (uint32_t pass = 0; pass < passes; pass++)
+		{
+			tracer.RenderPass();
+			seconds += tracer.GetStats().passMilliseconds / 1000.0;
+			rays += tracer.GetStats().rays;
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add("render", seconds, rays);
+		result.parameters.push_back(std::make_pair("rays_per_sec", rays / seconds));
+		result.parameters.push_back(std::make_pair("rays_per_sec_per_thread", rays / seconds / jobSystem.GetThreadCount()));
+		result.parameters.push_back(std::make_pair("ms_per_pass", seconds * 1000.0 / passes));
+		result.parameters.push_back(std::make_pair("samples_per_pixel", static_cast<double>(tracer.GetStats().samplesPerPixel)));
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(jobSystem.GetThreadCount())));
+	}
+
+	if (imagePath != nullptr && !tracer.WriteBmp(imagePath))
+	{
+		fprintf(stderr, "No se pudo escribir %s\n", imagePath);
+		return 1;
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,107 @@
+﻿// Mide el tiempo de paso de RigidBodyWorld en escenas de pilas de cajas frente al número de subprocesos.
+// Uso: PhysicsBenchmark [cuerpos] [pasos]
+
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/RigidBodyWorld.h"
+
+using namespace App2;
+
+namespace
+{
+	// Varias pilas de cajas sobre un suelo estático. Cada pila forma una isla independiente
+	// una vez apoyada, que es el caso que reparte el solucionador entre subprocesos.
+	void BuildPileScene(RigidBodyWorld& world, uint32_t bodyCount)
+	{
+		const uint32_t bodiesPerPile = 100;
+		const float size = 1.0f;
+		uint32_t pileCount = (bodyCount + bodiesPerPile - 1) / bodiesPerPile;
+		uint32_t pilesPerRow = static_cast<uint32_t>(ceil(sqrt(static_cast<double>(pileCount))));
+		float spacing = size * 8.0f;
+
+		RigidBodyDesc ground;
+		ground.mass = 0.0f;
+		ground.halfExtents = DX::Vector3(pilesPerRow * spacing, 0.5f, pilesPerRow * spacing);
+		ground.position = DX::Vector3(0.0f, -0.5f, 0.0f);
+		world.AddBody(ground);
+
+		uint32_t created = 0;
+		for (uint32_t pile = 0; pile < pileCount && created < bodyCount; pile++)
+		{
+			float baseX = (pile % pilesPerRow - pilesPerRow * 0.5f) * spacing;
+			float baseZ = (pile / pilesPerRow - pilesPerRow * 0.5f) * spacing;
+			for (uint32_t i = 0; i < bodiesPerPile && created < bodyCount; i++, created++)
+			{
+				// Capas de 3x3 cajas ligeramente desplazadas para que la pila se derrumbe y se asiente.
+				uint32_t layer = i / 9;
+				uint32_t cell = i % 9;
+				RigidBodyDesc box;
+				box.halfExtents = DX::Vector3(size * 0.5f, size * 0.5f, size * 0.5f);
+				box.position = DX::Vector3(
+					baseX + (cell % 3) * size * 1.05f + (layer % 2) * size * 0.3f,
+					size * 0.5f + layer * size * 1.02f,
+					baseZ + (cell / 3) * size * 1.05f);
+				box.orientation = DX::Quaternion::RotationAxis(DX::Vector3(0.0f, 1.0f, 0.0f), 0.1f * layer);
+				world.AddBody(box);
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t bodyCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+	uint32_t stepCount = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 120;
+	const float deltaSeconds = 1.0f / 60.0f;
+
+	Benchmarks::BenchmarkReporter reporter("physics");
+
+	uint32_t maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0)
+	{
+		maxThreads = 1;
+	}
+
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (uint32_t threads : threadCounts)
+	{
+		DX::JobSystem jobSystem(threads);
+		RigidBodyWorld world(&jobSystem);
+		BuildPileScene(world, bodyCount);
+
+		double broadphase = 0.0, narrowphase = 0.0, solver = 0.0;
+		uint64_t contacts = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t step = 0; step < stepCount; step++)
+		{
+			world.Step(deltaSeconds);
+			const RigidBodyWorldStats& stats = world.GetStats();
+			broadphase += stats.broadphaseMilliseconds;
+			narrowphase += stats.narrowphaseMilliseconds;
+			solver += stats.solverMilliseconds;
+			contacts += stats.contactPoints;
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		Benchmarks::BenchmarkResult& result = reporter.Add("pile_step", seconds, stepCount);
+		result.parameters.push_back(std::make_pair("bodies", static_cast<double>(bodyCount)));
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(threads)));
+		result.parameters.push_back(std::make_pair("step_ms", seconds * 1000.0 / stepCount));
+		result.parameters.push_back(std::make_pair("broadphase_ms", broadphase / stepCount));
+		result.parameters.push_back(std::make_pair("narrowphase_ms", narrowphase / stepCount));
+		result.parameters.push_back(std::make_pair("solver_ms", solver / stepCount));
+		result.parameters.push_back(std::make_pair("contacts_per_step", static_cast<double>(contacts) / stepCount));
+		result.parameters.push_back(std::make_pair("awake_bodies_end", static_cast<double>(world.GetStats().awakeBodies)));
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,180 @@
+﻿// Mide el coste de los marcadores del perfilador (planos, anidados y desde varios subprocesos), el de
+// agregar un fotograma en EndFrame y el de exportar una captura como traza de Chrome.
+// Uso: ProfilerBenchmark [marcadores por fotograma] [fotogramas] [traza.json]
+
+#include <cstdio>
+#include <cstdlib>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/JobSystem.h"
+#include "../App2/Common/Profiler.h"
+
+using namespace DX;
+
+namespace
+{
+	uint64_t g_counter = 0;
+
+	// Trabajo mínimo dentro de cada marcador para que el compilador no pueda quitar el bucle.
+	inline void Work()
+	{
+		g_counter++;
+		Benchmarks::DoNotOptimize(g_counter);
+	}
+
+	void NestedMarkers(uint32_t depth)
+	{
+		DX_PROFILE_SCOPE("Anidado");
+		Work();
+		if (depth > 1)
+		{
+			NestedMarkers(depth - 1);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t markersPerFrame = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+	uint32_t frameCount = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 200;
+	const char* tracePath = (argc > 3) ? argv[3] : nullptr;
+
+	Benchmarks::BenchmarkReporter reporter("profiler");
+	Profiler& profiler = Profiler::Get();
+	profiler.EndFrame();
+
+	// Referencia: el mismo bucle sin marcadores.
+	double baselineSeconds = 0.0;
+	{
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			for (uint32_t i = 0; i < markersPerFrame; i++)
+			{
+				Work();
+			}
+		}
+		baselineSeconds = stopwatch.ElapsedSeconds();
+		reporter.Add("baseline_loop", baselineSeconds, static_cast<uint64_t>(frameCount) * markersPerFrame);
+	}
+
+	{
+		uint64_t count = static_cast<uint64_t>(frameCount) * markersPerFrame;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint64_t i = 0; i < count; i++)
+		{
+			Benchmarks::DoNotOptimize(Profiler::Timestamp());
+		}
+		reporter.Add("timestamp", stopwatch.ElapsedSeconds(), count);
+	}
+
+	// Marcadores planos. EndFrame se mide aparte; su coste por evento es el de la agregación.
+	{
+		double markerSeconds = 0.0;
+		double endFrameSeconds = 0.0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t i = 0; i < markersPerFrame; i++)
+			{
+				DX_PROFILE_SCOPE("Plano");
+				Work();
+			}
+			markerSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			profiler.EndFrame();
+			endFrameSeconds += stopwatch.ElapsedSeconds();
+		}
+
+		uint64_t markers = static_cast<uint64_t>(frameCount) * markersPerFrame;
+		Benchmarks::BenchmarkResult& result = reporter.Add("flat_marker", markerSeconds, markers);
+		result.parameters.push_back(std::make_pair("overhead_ns", (markerSeconds - baselineSeconds) * 1e9 / markers));
+		result.parameters.push_back(std::make_pair("dropped_events", static_cast<double>(profiler.GetLastFrame().droppedEvents)));
+		reporter.Add("end_frame_per_event", endFrameSeconds, markers);
+	}
+
+	// Marcadores anidados de ocho niveles.
+	{
+		const uint32_t depth = 8;
+		double markerSeconds = 0.0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t i = 0; i < markersPerFrame / depth; i++)
+			{
+				NestedMarkers(depth);
+			}
+			markerSeconds += stopwatch.ElapsedSeconds();
+			profiler.EndFrame();
+		}
+
+		uint64_t markers = static_cast<uint64_t>(frameCount) * (markersPerFrame / depth) * depth;
+		Benchmarks::BenchmarkResult& result = reporter.Add("nested_marker", markerSeconds, markers);
+		result.parameters.push_back(std::make_pair("depth", static_cast<double>(depth)));
+		result.parameters.push_back(std::make_pair("nodes_per_frame", static_cast<double>(profiler.GetLastFrame().nodes.size())));
+	}
+
+	// Marcadores desde todos los subprocesos del grupo a la vez: cada uno escribe en su propio búfer.
+	{
+		JobSystem jobSystem;
+		double seconds = 0.0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			Benchmarks::Stopwatch stopwatch;
+			jobSystem.ParallelFor(markersPerFrame, 256, [](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					DX_PROFILE_SCOPE("Paralelo");
+					Benchmarks::DoNotOptimize(i);
+				}
+			});
+			seconds += stopwatch.ElapsedSeconds();
+			profiler.EndFrame();
+		}
+
+		Benchmarks::BenchmarkResult& result = reporter.Add("parallel_marker", seconds, static_cast<uint64_t>(frameCount) * markersPerFrame);
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(jobSystem.GetThreadCount())));
+	}
+
+	// Captura y exportación de unos pocos fotogramas con jerarquía.
+	{
+		profiler.BeginCapture();
+		for (uint32_t frame = 0; frame < 4; frame++)
+		{
+			{
+				DX_PROFILE_SCOPE("Fotograma");
+				for (uint32_t i = 0; i < markersPerFrame / 8; i++)
+				{
+					NestedMarkers(4);
+				}
+			}
+			profiler.EndFrame();
+		}
+		profiler.EndCapture();
+
+		Benchmarks::Stopwatch stopwatch;
+		bool written = false;
+		if (tracePath != nullptr)
+		{
+			written = profiler.WriteChromeTrace(tracePath);
+		}
+		else
+		{
+			FILE* file = tmpfile();
+			if (file != nullptr)
+			{
+				profiler.WriteChromeTrace(file);
+				written = ferror(file) == 0;
+				fclose(file);
+			}
+		}
+
+		Benchmarks::BenchmarkResult& result = reporter.Add("chrome_trace_export", stopwatch.ElapsedSeconds(), profiler.GetCapturedEventCount());
+		result.parameters.push_back(std::make_pair("events", static_cast<double>(profiler.GetCapturedEventCount())));
+		result.parameters.push_back(std::make_pair("written", written ? 1.0 : 0.0));
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,172 @@
+﻿// Referencia de rendimiento del búfer de comandos de dibujo: cambios de estado y dibujos que llegan al
+// backend con y sin ordenar por clave, y coste de la ordenación por base (un subproceso y todos) frente a
+// std::sort, sobre fotogramas sintéticos con sombreadores, materiales, mallas y profundidades al azar.
+// Uso: RenderCommandBenchmark [dibujos] [repeticiones]
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/JobSystem.h"
+#include "../App2/Common/MockRenderBackend.h"
+#include "../App2/Common/RenderCommandBuffer.h"
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t ShaderCount = 16;
+	const uint32_t MaterialCount = 256;
+	const uint32_t MeshCount = 64;
+
+	// Generador congruencial para que los fotogramas sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		uint32_t Next(uint32_t range)
+		{
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) % range;
+		}
+		float NextFloat()
+		{
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	// Un fotograma en el orden en que lo emitiría la escena: cada material usa siempre el mismo sombreador,
+	// cada objeto lleva su matriz de modelo y una décima parte es translúcida.
+	void RecordFrame(RenderCommandBuffer& buffer, uint32_t draws, uint32_t seed)
+	{
+		Random random(seed);
+		float model[16] = {};
+		buffer.Reset();
+		for (uint32_t i = 0; i < draws; i++)
+		{
+			uint32_t material = random.Next(MaterialCount);
+			DrawPacket packet;
+			packet.shader = static_cast<uint16_t>(material % ShaderCount);
+			packet.material = static_cast<uint16_t>(material);
+			packet.mesh = static_cast<uint16_t>(random.Next(MeshCount));
+			model[12] = static_cast<float>(i);
+			packet.constantOffset = buffer.AddConstants(model, sizeof(model));
+			packet.constantSize = sizeof(model);
+			packet.indexCount = 36;
+			packet.startIndex = 0;
+			packet.baseVertex = 0;
+
+			float depth = random.NextFloat();
+			bool translucent = random.Next(10) == 0;
+			uint64_t key = translucent ?
+				RenderSortKey::Translucent(1, packet.shader, packet.material, depth) :
+				RenderSortKey::Opaque(0, packet.shader, packet.material, depth);
+			buffer.Add(key, packet);
+		}
+	}
+
+	Benchmarks::BenchmarkResult& AddSubmitResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t operations, const RenderBackendStats& stats)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, operations);
+		result.parameters.push_back(std::make_pair("draws", static_cast<double>(stats.draws)));
+		result.parameters.push_back(std::make_pair("state_changes", static_cast<double>(stats.GetStateChanges())));
+		result.parameters.push_back(std::make_pair("shader_changes", static_cast<double>(stats.shaderChanges)));
+		result.parameters.push_back(std::make_pair("material_changes", static_cast<double>(stats.materialChanges)));
+		result.parameters.push_back(std::make_pair("mesh_changes", static_cast<double>(stats.meshChanges)));
+		return result;
+	}
+
+	bool IsSorted(const RenderCommandBuffer& buffer)
+	{
+		for (uint32_t i = 1; i < buffer.GetCount(); i++)
+		{
+			if (buffer.GetKey(i - 1) > buffer.GetKey(i))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t draws = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 20;
+
+	Benchmarks::BenchmarkReporter reporter("render_commands");
+	JobSystem jobSystem;
+	RenderCommandBuffer buffer(draws, draws * 64);
+
+	// Grabación: paquete, clave y constantes por dibujo.
+	{
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			RecordFrame(buffer, draws, 1234);
+		}
+		reporter.Add("record", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * draws);
+	}
+
+	// Reproducción en el orden de emisión y tras ordenar: el backend cuenta los cambios reales.
+	for (int sorted = 0; sorted < 2; sorted++)
+	{
+		RecordFrame(buffer, draws, 1234);
+		if (sorted)
+		{
+			buffer.Sort(&jobSystem);
+		}
+
+		MockRenderBackend backend;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			backend.Reset();
+			buffer.Submit(backend);
+		}
+		AddSubmitResult(reporter, sorted ? "submit_sorted" : "submit_unsorted", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * draws, backend.GetStats());
+	}
+
+	// Ordenación por base con uno y con todos los subprocesos, frente a std::sort sobre las mismas claves.
+	for (int parallel = 0; parallel < 2; parallel++)
+	{
+		double seconds = 0.0;
+		bool sorted = true;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			RecordFrame(buffer, draws, 1234 + r);
+			Benchmarks::Stopwatch stopwatch;
+			buffer.Sort(parallel ? &jobSystem : nullptr);
+			seconds += stopwatch.ElapsedSeconds();
+			sorted = sorted && IsSorted(buffer);
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add(parallel ? "radix_sort_parallel" : "radix_sort_single", seconds, static_cast<uint64_t>(repetitions) * draws);
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(parallel ? jobSystem.GetThreadCount() : 1)));
+		result.parameters.push_back(std::make_pair("sorted", sorted ? 1.0 : 0.0));
+		reporter.Check(result.name, "los comandos deben quedar ordenados por clave", sorted);
+	}
+
+	{
+		double seconds = 0.0;
+		std::vector<RadixSortItem> items(draws);
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			RecordFrame(buffer, draws, 1234 + r);
+			for (uint32_t i = 0; i < draws; i++)
+			{
+				items[i].key = buffer.GetKey(i);
+				items[i].value = i;
+			}
+			Benchmarks::Stopwatch stopwatch;
+			std::stable_sort(items.begin(), items.end(), [](const RadixSortItem& a, const RadixSortItem& b) { return a.key < b.key; });
+			seconds += stopwatch.ElapsedSeconds();
+		}
+		reporter.Add("std_stable_sort", seconds, static_cast<uint64_t>(repetitions) * draws);
+		Benchmarks::DoNotOptimize(items[0]);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
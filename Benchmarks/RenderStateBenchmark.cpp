@@ -0,0 +1,203 @@
+﻿// Referencia de rendimiento de DX::RenderStateCache sobre un destino que graba las llamadas: cuántas
+// asignaciones de estado llegan al contexto y cuántas se descartan, y cuánto cuesta filtrarlas, tanto
+// con el bucle de Render original (todo el estado en cada dibujo) como reproduciendo paquetes al azar
+// con y sin ordenar. Comprueba además que el estado efectivo en cada dibujo es el pedido.
+// Uso: RenderStateBenchmark [dibujos] [repeticiones]
+
+#include <cstdlib>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/MockRenderBackend.h"
+#include "../App2/Common/RenderCommandBuffer.h"
+#include "../App2/Common/RenderStateCache.h"
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t ShaderCount = 16;
+	const uint32_t MaterialCount = 256;
+	const uint32_t MeshCount = 64;
+	const uint32_t StatesPerDraw = 7;
+
+	// Los objetos del API solo se comparan por dirección, así que bastan direcciones distintas.
+	char FakeObjects[4096];
+
+	const void* Object(uint32_t index)	{ return &FakeObjects[index]; }
+
+	// Todo el estado que fija un dibujo, como lo hacía Sample3DSceneRenderer::Render.
+	struct DrawState
+	{
+		const void*	vertexBuffer;
+		uint32_t	stride;
+		const void*	indexBuffer;
+		uint32_t	indexFormat;
+		uint32_t	topology;
+		const void*	inputLayout;
+		const void*	vertexShader;
+		const void*	constantBuffer;
+		const void*	pixelShader;
+
+		bool operator==(const DrawState& other) const
+		{
+			return vertexBuffer == other.vertexBuffer && stride == other.stride && indexBuffer == other.indexBuffer &&
+				indexFormat == other.indexFormat && topology == other.topology && inputLayout == other.inputLayout &&
+				vertexShader == other.vertexShader && constantBuffer == other.constantBuffer && pixelShader == other.pixelShader;
+		}
+	};
+
+	DrawState StateForPacket(const DrawPacket& packet)
+	{
+		DrawState state;
+		state.vertexBuffer = Object(1000 + packet.mesh);
+		state.stride = 24;
+		state.indexBuffer = Object(2000 + packet.mesh);
+		state.indexFormat = (packet.mesh & 1) ? 42 : 57;
+		state.topology = 4;
+		state.inputLayout = Object(3000 + packet.shader);
+		state.vertexShader = Object(3100 + packet.shader);
+		state.constantBuffer = Object(packet.material);
+		state.pixelShader = Object(3200 + packet.shader);
+		return state;
+	}
+
+	void Apply(IRenderStateSink& sink, const DrawState& state)
+	{
+		sink.SetVertexBuffer(0, state.vertexBuffer, state.stride, 0);
+		sink.SetIndexBuffer(state.indexBuffer, state.indexFormat, 0);
+		sink.SetTopology(state.topology);
+		sink.SetInputLayout(state.inputLayout);
+		sink.SetVertexShader(state.vertexShader);
+		sink.SetVertexConstantBuffer(0, state.constantBuffer);
+		sink.SetPixelShader(state.pixelShader);
+	}
+
+	// Aplica al estado efectivo las llamadas grabadas desde first.
+	void Replay(const std::vector<RecordedStateCall>& calls, size_t first, DrawState& effective)
+	{
+		for (size_t i = first; i < calls.size(); i++)
+		{
+			const RecordedStateCall& call = calls[i];
+			switch (call.slot)
+			{
+			case RenderStateSlot::VertexBuffer:		effective.vertexBuffer = call.object; effective.stride = call.a; break;
+			case RenderStateSlot::IndexBuffer:		effective.indexBuffer = call.object; effective.indexFormat = call.a; break;
+			case RenderStateSlot::Topology:			effective.topology = call.a; break;
+			case RenderStateSlot::InputLayout:		effective.inputLayout = call.object; break;
+			case RenderStateSlot::VertexShader:		effective.vertexShader = call.object; break;
+			case RenderStateSlot::ConstantBuffer:	effective.constantBuffer = call.object; break;
+			case RenderStateSlot::PixelShader:		effective.pixelShader = call.object; break;
+			default:								break;
+			}
+		}
+	}
+
+	// Fotograma al azar en el orden de emisión, como en RenderCommandBenchmark.
+	void RecordFrame(RenderCommandBuffer& buffer, uint32_t draws)
+	{
+		uint32_t random = 1234;
+		buffer.Reset();
+		for (uint32_t i = 0; i < draws; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			uint32_t material = (random >> 8) % MaterialCount;
+			random = random * 1664525u + 1013904223u;
+			DrawPacket packet = {};
+			packet.shader = static_cast<uint16_t>(material % ShaderCount);
+			packet.material = static_cast<uint16_t>(material);
+			packet.mesh = static_cast<uint16_t>((random >> 8) % MeshCount);
+			packet.indexCount = 36;
+			float depth = (random & 0xffff) * (1.0f / 65536.0f);
+			buffer.Add(RenderSortKey::Opaque(0, packet.shader, packet.material, depth), packet);
+		}
+	}
+
+	void AddStateResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t operations, const RenderStateStats& stats, bool consistent)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, operations);
+		result.parameters.push_back(std::make_pair("issued", static_cast<double>(stats.GetIssued())));
+		result.parameters.push_back(std::make_pair("filtered", static_cast<double>(stats.GetFiltered())));
+		result.parameters.push_back(std::make_pair("consistent", consistent ? 1.0 : 0.0));
+		reporter.Check(result.name, "el estado efectivo de cada dibujo debe ser el pedido", consistent);
+	}
+
+	// Pasa los estados de todos los dibujos por la caché (o directamente al destino) repetitions veces y
+	// después una vez más comprobando el estado efectivo en cada dibujo.
+	void Measure(Benchmarks::BenchmarkReporter& reporter, const char* name, const std::vector<DrawState>& draws, uint32_t repetitions, bool cached)
+	{
+		RecordingStateSink sink;
+		RenderStateCache cache(&sink);
+		IRenderStateSink& target = cached ? static_cast<IRenderStateSink&>(cache) : sink;
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			sink.Clear();
+			cache.Invalidate();
+			cache.ResetStats();
+			for (const DrawState& state : draws)
+			{
+				Apply(target, state);
+			}
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+		RenderStateStats stats = cache.GetStats();
+		if (!cached)
+		{
+			// Sin caché todas las llamadas llegan al destino; se anotan juntas.
+			stats.issued[0] = sink.GetCalls().size();
+		}
+
+		sink.Clear();
+		cache.Invalidate();
+		DrawState effective = {};
+		bool consistent = true;
+		for (const DrawState& state : draws)
+		{
+			size_t first = sink.GetCalls().size();
+			Apply(target, state);
+			Replay(sink.GetCalls(), first, effective);
+			consistent = consistent && (effective == state);
+		}
+
+		AddStateResult(reporter, name, seconds, static_cast<uint64_t>(repetitions) * draws.size() * StatesPerDraw, stats, consistent);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t draws = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 20;
+
+	Benchmarks::BenchmarkReporter reporter("render_state");
+
+	// El bucle de Render original: el mismo cubo con el mismo estado, cambiando solo las constantes.
+	{
+		DrawPacket packet = {};
+		std::vector<DrawState> states(draws, StateForPacket(packet));
+		Measure(reporter, "render_loop_direct", states, repetitions, false);
+		Measure(reporter, "render_loop_cached", states, repetitions, true);
+	}
+
+	// Paquetes al azar sin ordenar y ordenados por clave.
+	RenderCommandBuffer buffer(draws);
+	for (int sorted = 0; sorted < 2; sorted++)
+	{
+		RecordFrame(buffer, draws);
+		if (sorted)
+		{
+			buffer.Sort(nullptr);
+		}
+
+		std::vector<DrawState> states;
+		states.reserve(draws);
+		for (uint32_t i = 0; i < buffer.GetCount(); i++)
+		{
+			states.push_back(StateForPacket(buffer.GetPacket(i)));
+		}
+		Measure(reporter, sorted ? "packets_sorted_cached" : "packets_unsorted_cached", states, repetitions, true);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,226 @@
+﻿// Referencia de rendimiento de las rutas de CPU de la escena sin ventana: avance de DX::StepTimer,
+// cálculo de matrices de SceneCamera, transformación de vértices, descarte por tronco y muestreo de
+// animación, sobre escenas sintéticas de tamaño creciente.
+// Uso: SceneBenchmark [objetos máximos] [repeticiones]
+
+#include <cstdlib>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/AnimationTrack.h"
+#include "../App2/Common/Frustum.h"
+#include "../App2/Common/StepTimer.h"
+#include "../App2/Content/SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Vértices del cubo de ejemplo (lado 1 centrado en el origen), como en Sample3DSceneRenderer.
+	const Vector3 CubeVertices[8] =
+	{
+		Vector3(-0.5f, -0.5f, -0.5f), Vector3(-0.5f, -0.5f, 0.5f), Vector3(-0.5f, 0.5f, -0.5f), Vector3(-0.5f, 0.5f, 0.5f),
+		Vector3(0.5f, -0.5f, -0.5f), Vector3(0.5f, -0.5f, 0.5f), Vector3(0.5f, 0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f),
+	};
+
+	// Generador congruencial para que las escenas sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * ((state >> 8) * (1.0f / 16777216.0f));
+		}
+	};
+
+	// Cuerpos repartidos en un volumen mayor que el tronco, de modo que una parte quede fuera de
+	// la pantalla, cada uno con una pista de animación propia.
+	struct SyntheticScene
+	{
+		std::vector<RigidBody>		bodies;
+		std::vector<AnimationTrack>	tracks;
+		std::vector<float>			x, y, z, radius;
+
+		SyntheticScene(uint32_t count, uint32_t keysPerTrack)
+		{
+			Random random(count);
+			bodies.resize(count);
+			tracks.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				RigidBody& body = bodies[i];
+				body.position = Vector3(random.Next(-3.0f, 3.0f), random.Next(-2.0f, 2.0f), random.Next(-6.0f, 1.0f));
+				body.orientation = Quaternion::RotationAxis(Vector3(random.Next(-1.0f, 1.0f), 1.0f, random.Next(-1.0f, 1.0f)), random.Next(0.0f, 6.28f));
+				body.halfExtents = Vector3(0.05f, 0.05f, 0.05f);
+
+				x.push_back(body.position.x);
+				y.push_back(body.position.y);
+				z.push_back(body.position.z);
+				radius.push_back(Length(body.halfExtents));
+
+				for (uint32_t k = 0; k < keysPerTrack; k++)
+				{
+					TransformKey key;
+					key.time = k * (1.0f / 30.0f);
+					key.position = body.position + Vector3(0.0f, 0.1f * sinf(k * 0.2f), 0.0f);
+					key.rotation = Quaternion::RotationAxis(Vector3(0.0f, 1.0f, 0.0f), k * 0.1f);
+					tracks[i].AddKey(key);
+				}
+			}
+		}
+	};
+
+	Matrix4 SceneViewProjection()
+	{
+		return ComputeSceneView() * ComputeSceneProjection(1920.0f, 1080.0f, Matrix4::Identity());
+	}
+
+	Benchmarks::BenchmarkResult& AddSceneResult(Benchmarks::BenchmarkReporter& reporter, const char* name, double seconds, uint64_t operations, uint32_t objects)
+	{
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, operations);
+		result.parameters.push_back(std::make_pair("objects", static_cast<double>(objects)));
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t maxObjects = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 20;
+
+	Benchmarks::BenchmarkReporter reporter("scene");
+
+	// StepTimer: coste de Tick con el bucle vacío, en modo fijo (60 Hz) y variable.
+	for (int fixed = 0; fixed < 2; fixed++)
+	{
+		StepTimer timer;
+		timer.SetFixedTimeStep(fixed != 0);
+		timer.SetTargetElapsedSeconds(1.0 / 60);
+		uint64_t updates = 0;
+		const uint64_t ticks = 1000000;
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint64_t i = 0; i < ticks; i++)
+		{
+			timer.Tick([&]() { updates++; });
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add(fixed ? "step_timer_tick_fixed" : "step_timer_tick_variable", stopwatch.ElapsedSeconds(), ticks);
+		result.parameters.push_back(std::make_pair("updates", static_cast<double>(updates)));
+	}
+
+	// Lo que hacen CreateWindowSizeDependentResources y Rotate en cada llamada.
+	{
+		const uint64_t count = 1000000;
+		Matrix4 orientation = Matrix4::Identity();
+		float checksum = 0.0f;
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint64_t i = 0; i < count; i++)
+		{
+			Matrix4 projection = ComputeSceneProjection(1920.0f + (i & 7), 1080.0f, orientation);
+			Matrix4 view = ComputeSceneView();
+			checksum += projection.Transposed().m[0][0] + view.Transposed().m[3][2];
+		}
+		reporter.Add("window_size_matrices", stopwatch.ElapsedSeconds(), count);
+
+		stopwatch.Restart();
+		for (uint64_t i = 0; i < count; i++)
+		{
+			checksum += ComputeCubeModel(i * 0.001f).Transposed().m[0][2];
+		}
+		reporter.Add("rotate_model", stopwatch.ElapsedSeconds(), count);
+		Benchmarks::DoNotOptimize(checksum);
+	}
+
+	for (uint32_t objects = 1000; objects <= maxObjects; objects *= 10)
+	{
+		SyntheticScene scene(objects, 64);
+		Matrix4 viewProjection = SceneViewProjection();
+		Frustum frustum = Frustum::FromViewProjection(viewProjection);
+		std::vector<Matrix4> mvp(objects);
+
+		// Modelo de cada cuerpo por vista-proyección, traspuesta como en el búfer de constantes.
+		{
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				for (uint32_t i = 0; i < objects; i++)
+				{
+					mvp[i] = (ComputeBodyModel(scene.bodies[i]) * viewProjection).Transposed();
+				}
+			}
+			AddSceneResult(reporter, "mvp_compute", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * objects, objects);
+			Benchmarks::DoNotOptimize(mvp[0]);
+		}
+
+		// Los ocho vértices del cubo de cada cuerpo a espacio de recorte.
+		{
+			std::vector<float> clip(static_cast<size_t>(objects) * 8 * 4);
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				for (uint32_t i = 0; i < objects; i++)
+				{
+					Matrix4 matrix = ComputeBodyModel(scene.bodies[i]) * viewProjection;
+					for (uint32_t v = 0; v < 8; v++)
+					{
+						TransformPoint(CubeVertices[v], matrix, &clip[(static_cast<size_t>(i) * 8 + v) * 4]);
+					}
+				}
+			}
+			AddSceneResult(reporter, "vertex_transform", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * objects * 8, objects);
+			Benchmarks::DoNotOptimize(clip[0]);
+		}
+
+		// Descarte por esfera: una a una y cuatro a la vez sobre la estructura de arrays.
+		{
+			uint32_t visibleCount = 0;
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				visibleCount = 0;
+				for (uint32_t i = 0; i < objects; i++)
+				{
+					visibleCount += frustum.IntersectsSphere(scene.bodies[i].position, scene.radius[i]) ? 1 : 0;
+				}
+			}
+			AddSceneResult(reporter, "cull_spheres_scalar", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * objects, objects)
+				.parameters.push_back(std::make_pair("visible", static_cast<double>(visibleCount)));
+
+			std::vector<uint8_t> visible(objects);
+			stopwatch.Restart();
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				visibleCount = frustum.CullSpheres(scene.x.data(), scene.y.data(), scene.z.data(), scene.radius.data(), objects, visible.data());
+			}
+			AddSceneResult(reporter, "cull_spheres_simd", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * objects, objects)
+				.parameters.push_back(std::make_pair("visible", static_cast<double>(visibleCount)));
+		}
+
+		// Muestreo de una pista por objeto avanzando a 60 Hz, con cursor por pista.
+		{
+			std::vector<uint32_t> cursors(objects, 0);
+			Vector3 positionSum;
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				float time = r * (1.0f / 60.0f);
+				for (uint32_t i = 0; i < objects; i++)
+				{
+					Vector3 position;
+					Quaternion rotation;
+					scene.tracks[i].Sample(time, cursors[i], position, rotation);
+					positionSum += position;
+				}
+			}
+			AddSceneResult(reporter, "animation_sample", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(repetitions) * objects, objects);
+			Benchmarks::DoNotOptimize(positionSum);
+		}
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,172 @@
+﻿// Referencia del arranque con DX::StartupGraph: un grafo con los pasos de inicio de la aplicación
+// (dispositivo, fábricas, lectura y creación de sombreadores, física, tela, fuente) con duraciones
+// simuladas, unas como esperas de E/S o del controlador y otras como cálculo. Se compara la cadena en
+// serie de antes con el grafo en paralelo, en orden de declaración y con el camino crítico primero, y se
+// mide el tiempo hasta el fotograma provisional y hasta el primer fotograma completo. Con el último
+// argumento escribe la línea de tiempo de la versión por camino crítico como traza de Chrome.
+// Uso: StartupBenchmark [repeticiones] [subprocesos] [traza.json]
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/JobSystem.h"
+#include "../App2/Common/StartupGraph.h"
+
+using namespace DX;
+
+namespace
+{
+	// Espera (E/S, controlador) o cálculo durante milliseconds.
+	void Simulate(double milliseconds, bool waits)
+	{
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(milliseconds * 1000.0));
+		if (waits)
+		{
+			std::this_thread::sleep_until(end);
+			return;
+		}
+		volatile uint32_t sink = 0;
+		while (std::chrono::steady_clock::now() < end)
+		{
+			for (uint32_t i = 0; i < 1000; i++)
+			{
+				sink = sink + i;
+			}
+		}
+	}
+
+	struct StartupMilestones
+	{
+		StartupTask	placeholderFrame;
+		StartupTask	firstFrame;
+	};
+
+	StartupTask Step(StartupGraph& graph, const char* name, double milliseconds, bool waits)
+	{
+		return graph.AddTask(name, milliseconds, [milliseconds, waits]() { Simulate(milliseconds, waits); });
+	}
+
+	// Los pasos en el orden en que los hacía App2Main: primero lo barato y lo que no se ve.
+	StartupMilestones BuildStartup(StartupGraph& graph)
+	{
+		StartupTask jobs = Step(graph, "Sistema de tareas", 1.0, false);
+		StartupTask arena = Step(graph, "Arena de fotograma", 0.5, false);
+		StartupTask physics = Step(graph, "Mundo fisico", 4.0, false);
+		StartupTask cloth = Step(graph, "Tela", 6.0, false);
+		StartupTask factories = Step(graph, "Fabricas D2D y DirectWrite", 8.0, true);
+		StartupTask font = Step(graph, "Fuente y atlas", 10.0, false);
+		StartupTask readText = Step(graph, "Leer sombreadores del texto", 20.0, true);
+		StartupTask device = Step(graph, "Dispositivo D3D", 35.0, true);
+		StartupTask readScene = Step(graph, "Leer sombreadores de la escena", 25.0, true);
+		StartupTask createScene = Step(graph, "Crear sombreadores de la escena", 8.0, true);
+		StartupTask cube = Step(graph, "Malla del cubo", 1.0, true);
+		StartupTask clothBuffers = Step(graph, "Buferes de la tela", 2.0, true);
+		StartupTask createText = Step(graph, "Crear recursos del texto", 6.0, true);
+		StartupTask fpsText = Step(graph, "Texto FPS", 4.0, true);
+		StartupTask placeholder = Step(graph, "Fotograma provisional", 1.0, true);
+		StartupTask firstFrame = Step(graph, "Primer fotograma completo", 2.0, true);
+
+		graph.DependsOn(arena, jobs);
+		graph.DependsOn(physics, jobs);
+		graph.DependsOn(cloth, arena);
+		graph.DependsOn(createScene, device);
+		graph.DependsOn(createScene, readScene);
+		graph.DependsOn(cube, device);
+		graph.DependsOn(clothBuffers, device);
+		graph.DependsOn(clothBuffers, cloth);
+		graph.DependsOn(createText, device);
+		graph.DependsOn(createText, readText);
+		graph.DependsOn(createText, font);
+		graph.DependsOn(fpsText, factories);
+		graph.DependsOn(fpsText, device);
+		graph.DependsOn(placeholder, device);
+		graph.DependsOn(firstFrame, createScene);
+		graph.DependsOn(firstFrame, cube);
+		graph.DependsOn(firstFrame, clothBuffers);
+		graph.DependsOn(firstFrame, physics);
+		graph.DependsOn(firstFrame, createText);
+		graph.DependsOn(firstFrame, fpsText);
+		graph.DependsOn(firstFrame, placeholder);
+
+		StartupMilestones milestones = { placeholder, firstFrame };
+		return milestones;
+	}
+
+	void Measure(Benchmarks::BenchmarkReporter& reporter, const char* name, uint32_t threads, bool criticalPathFirst, uint32_t repetitions, const char* tracePath)
+	{
+		JobSystem jobSystem(threads);
+		double placeholderMilliseconds = 0.0;
+		double firstFrameMilliseconds = 0.0;
+		double criticalMilliseconds = 0.0;
+		bool completed = true;
+
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			StartupGraph graph;
+			StartupTimeline timeline;
+			StartupMilestones milestones = BuildStartup(graph);
+			graph.SetCriticalPathFirst(criticalPathFirst);
+			completed = graph.Run(&jobSystem, &timeline) && completed;
+
+			placeholderMilliseconds += graph.GetTaskEndMilliseconds(milestones.placeholderFrame);
+			firstFrameMilliseconds += graph.GetTaskEndMilliseconds(milestones.firstFrame);
+			double critical = 0.0;
+			for (StartupTask task : graph.GetCriticalPath())
+			{
+				critical += graph.GetTaskMilliseconds(task);
+			}
+			criticalMilliseconds += critical;
+
+			if (tracePath != nullptr && r + 1 == repetitions)
+			{
+				FILE* file = fopen(tracePath, "wb");
+				if (file != nullptr)
+				{
+					timeline.WriteChromeTrace(file);
+					fclose(file);
+				}
+				timeline.WriteReport(stderr);
+			}
+		}
+
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, stopwatch.ElapsedSeconds(), repetitions);
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(threads)));
+		result.parameters.push_back(std::make_pair("placeholder_frame_ms", placeholderMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("first_frame_ms", firstFrameMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("critical_path_ms", criticalMilliseconds / repetitions));
+		result.parameters.push_back(std::make_pair("completed", completed ? 1.0 : 0.0));
+		reporter.Check(result.name, "el arranque debe completar todas las tareas", completed);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t repetitions = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 10;
+	uint32_t threads = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 3;
+	const char* tracePath = (argc > 3) ? argv[3] : nullptr;
+
+	Benchmarks::BenchmarkReporter reporter("startup");
+	Measure(reporter, "serial_chain", 1, false, repetitions, nullptr);
+	Measure(reporter, "graph_declaration_order", threads, false, repetitions, nullptr);
+	Measure(reporter, "graph_critical_path_first", threads, true, repetitions, tracePath);
+
+	// Un ciclo debe rechazarse sin ejecutar ninguna tarea.
+	{
+		StartupGraph graph;
+		uint32_t executed = 0;
+		StartupTask a = graph.AddTask("A", 1.0, [&executed]() { executed++; });
+		StartupTask b = graph.AddTask("B", 1.0, [&executed]() { executed++; });
+		graph.DependsOn(a, b);
+		graph.DependsOn(b, a);
+		bool ran = graph.Run(nullptr, nullptr);
+		Benchmarks::BenchmarkResult& result = reporter.Add("cycle_rejected", 0.0, 0);
+		result.parameters.push_back(std::make_pair("ran", ran ? 1.0 : 0.0));
+		result.parameters.push_back(std::make_pair("executed", static_cast<double>(executed)));
+		reporter.Check(result.name, "un grafo con un ciclo no debe ejecutar ninguna tarea", !ran && executed == 0);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,192 @@
+﻿// Referencia de la subdivisión por tablas de plantillas: tiempo de construcción de las tablas (Catmull-Clark
+// sobre cuadriláteros y Loop sobre triángulos) y vértices refinados por segundo al aplicarlas a una malla de
+// control animada, escalar frente a SimdFloat4 y en paralelo. Comprueba que las plantillas suman 1 y que
+// los dos caminos dan el mismo resultado.
+// Uso: SubdivisionBenchmark [subprocesos] [fotogramas] [lado del toro]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/SubdivisionStencils.h"
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t FloatsPerVertex = 8;	// Posición, color y relleno, como los vértices de la escena.
+
+	// Toro de side x side cuadriláteros (cerrado, todos los vértices de valencia 4) o el doble de triángulos.
+	SubdivisionCage CreateTorusCage(uint32_t side, bool triangles)
+	{
+		SubdivisionCage cage;
+		cage.vertexCount = side * side;
+		for (uint32_t j = 0; j < side; j++)
+		{
+			for (uint32_t i = 0; i < side; i++)
+			{
+				uint32_t a = j * side + i;
+				uint32_t b = j * side + (i + 1) % side;
+				uint32_t c = ((j + 1) % side) * side + (i + 1) % side;
+				uint32_t d = ((j + 1) % side) * side + i;
+				if (triangles)
+				{
+					uint32_t face[6] = { a, b, c, a, c, d };
+					cage.faceSizes.insert(cage.faceSizes.end(), 2, 3);
+					cage.faceIndices.insert(cage.faceIndices.end(), face, face + 6);
+				}
+				else
+				{
+					uint32_t face[4] = { a, b, c, d };
+					cage.faceSizes.push_back(4);
+					cage.faceIndices.insert(cage.faceIndices.end(), face, face + 4);
+				}
+			}
+		}
+		return cage;
+	}
+
+	// Vértices del toro desplazados con una onda que avanza con el tiempo.
+	void AnimateTorus(uint32_t side, float time, std::vector<float>& cage)
+	{
+		cage.assign(static_cast<size_t>(side) * side * FloatsPerVertex, 0.0f);
+		for (uint32_t j = 0; j < side; j++)
+		{
+			for (uint32_t i = 0; i < side; i++)
+			{
+				float u = 6.2831853f * i / side;
+				float v = 6.2831853f * j / side;
+				float tube = 0.3f + 0.05f * sinf(3.0f * u + time);
+				float* vertex = &cage[(static_cast<size_t>(j) * side + i) * FloatsPerVertex];
+				vertex[0] = (1.0f + tube * cosf(v)) * cosf(u);
+				vertex[1] = tube * sinf(v);
+				vertex[2] = (1.0f + tube * cosf(v)) * sinf(u);
+				vertex[3] = u / 6.2831853f;
+				vertex[4] = v / 6.2831853f;
+				vertex[5] = 0.5f;
+			}
+		}
+	}
+
+	void ApplyScalar(const SubdivisionStencils& stencils, uint32_t level, const float* cage, float* out)
+	{
+		const TaggedVector<uint32_t, MemoryTag::Meshes>& offsets = stencils.GetOffsets(level);
+		const TaggedVector<uint32_t, MemoryTag::Meshes>& sources = stencils.GetSources(level);
+		const TaggedVector<float, MemoryTag::Meshes>& weights = stencils.GetWeights(level);
+		for (uint32_t v = 0; v < stencils.GetVertexCount(level); v++)
+		{
+			float* target = out + static_cast<size_t>(v) * FloatsPerVertex;
+			for (uint32_t k = 0; k < FloatsPerVertex; k++)
+			{
+				target[k] = 0.0f;
+			}
+			for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+			{
+				const float* source = cage + static_cast<size_t>(sources[i]) * FloatsPerVertex;
+				for (uint32_t k = 0; k < FloatsPerVertex; k++)
+				{
+					target[k] += weights[i] * source[k];
+				}
+			}
+		}
+	}
+
+	// Mayor desviación de 1 en la suma de pesos de una plantilla (una superficie afín debe sumar 1).
+	float GetMaxWeightError(const SubdivisionStencils& stencils, uint32_t level)
+	{
+		float maxError = 0.0f;
+		for (uint32_t v = 0; v < stencils.GetVertexCount(level); v++)
+		{
+			float sum = 0.0f;
+			for (uint32_t i = stencils.GetOffsets(level)[v]; i < stencils.GetOffsets(level)[v + 1]; i++)
+			{
+				sum += stencils.GetWeights(level)[i];
+			}
+			maxError = std::max(maxError, fabsf(sum - 1.0f));
+		}
+		return maxError;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t threads = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 0;
+	uint32_t frames = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 60;
+	uint32_t side = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 32;
+	const uint32_t maxLevel = 3;
+
+	JobSystem jobSystem(threads);
+	JobSystem singleThread(1);
+	Benchmarks::BenchmarkReporter reporter("subdivision");
+
+	const SubdivisionScheme schemes[] = { SubdivisionScheme::CatmullClark, SubdivisionScheme::Loop };
+	for (SubdivisionScheme scheme : schemes)
+	{
+		std::string prefix = (scheme == SubdivisionScheme::CatmullClark) ? "catmull_clark" : "loop";
+		SubdivisionCage cage = CreateTorusCage(side, scheme == SubdivisionScheme::Loop);
+
+		// Construcción de las tablas: la mejor de varias repeticiones.
+		const uint32_t builds = 5;
+		double bestBuild = 1e30;
+		for (uint32_t b = 0; b < builds; b++)
+		{
+			SubdivisionStencils stencils(scheme, cage, maxLevel);
+			bestBuild = std::min(bestBuild, stencils.GetBuildMilliseconds());
+		}
+		SubdivisionStencils stencils(scheme, cage, maxLevel);
+		uint32_t refined = stencils.GetVertexCount(maxLevel);
+		Benchmarks::BenchmarkResult& build = reporter.Add(prefix + "_build", bestBuild / 1000.0, 1);
+		build.parameters.push_back(std::make_pair("build_ms", bestBuild));
+		build.parameters.push_back(std::make_pair("cage_vertices", static_cast<double>(cage.vertexCount)));
+		build.parameters.push_back(std::make_pair("refined_vertices", static_cast<double>(refined)));
+		build.parameters.push_back(std::make_pair("stencil_entries", static_cast<double>(stencils.GetSources(maxLevel).size())));
+		float weightError = GetMaxWeightError(stencils, maxLevel);
+		build.parameters.push_back(std::make_pair("max_weight_error", static_cast<double>(weightError)));
+		reporter.Check(build.name, "los pesos de cada plantilla deben sumar 1", weightError < 1e-4f);
+
+		// Un fotograma: animar la malla de control y refinar al nivel máximo.
+		std::vector<float> animated;
+		std::vector<float> scalar(static_cast<size_t>(refined) * FloatsPerVertex);
+		std::vector<float> simd(scalar.size());
+		double scalarSeconds = 0.0, simdSeconds = 0.0, parallelSeconds = 0.0;
+		float maxDifference = 0.0f;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			AnimateTorus(side, frame / 60.0f, animated);
+
+			Benchmarks::Stopwatch stopwatch;
+			ApplyScalar(stencils, maxLevel, animated.data(), scalar.data());
+			scalarSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			stencils.Apply(&singleThread, maxLevel, animated.data(), FloatsPerVertex, simd.data());
+			simdSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			stencils.Apply(&jobSystem, maxLevel, animated.data(), FloatsPerVertex, simd.data());
+			parallelSeconds += stopwatch.ElapsedSeconds();
+			Benchmarks::DoNotOptimize(simd.data());
+
+			for (size_t i = 0; i < simd.size(); i++)
+			{
+				maxDifference = std::max(maxDifference, fabsf(simd[i] - scalar[i]));
+			}
+		}
+
+		uint64_t vertices = static_cast<uint64_t>(refined) * frames;
+		reporter.Add(prefix + "_apply_scalar", scalarSeconds, vertices)
+			.parameters.push_back(std::make_pair("vertices_per_sec", vertices / scalarSeconds));
+		reporter.Add(prefix + "_apply_simd", simdSeconds, vertices)
+			.parameters.push_back(std::make_pair("vertices_per_sec", vertices / simdSeconds));
+		Benchmarks::BenchmarkResult& parallel = reporter.Add(prefix + "_apply_parallel", parallelSeconds, vertices);
+		parallel.parameters.push_back(std::make_pair("vertices_per_sec", vertices / parallelSeconds));
+		parallel.parameters.push_back(std::make_pair("threads", static_cast<double>(jobSystem.GetThreadCount())));
+		parallel.parameters.push_back(std::make_pair("max_difference", static_cast<double>(maxDifference)));
+		reporter.Check(parallel.name, "el refinado SIMD y paralelo debe coincidir con el escalar", maxDifference < 1e-4f);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
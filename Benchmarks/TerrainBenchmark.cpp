@@ -0,0 +1,190 @@
+﻿// Referencia del terreno por trozos: ruido fractal escalar frente a filas SIMD, trozos generados por
+// segundo al cargar de golpe todo el radio de visión, y coste por fotograma con el ojo en movimiento a 60
+// FPS, sin tope y con varios topes de trozos por fotograma. Comprueba también que los bordes de trozos
+// vecinos (del mismo nivel y de niveles distintos) tienen exactamente la misma altura.
+// Uso: TerrainBenchmark [subprocesos] [fotogramas]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/TerrainStreamer.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Vértice (i, j) de la rejilla de un trozo, sin contar el faldón.
+	const TerrainVertex& GetGridVertex(const TerrainChunk& chunk, uint32_t res, uint32_t i, uint32_t j)
+	{
+		return chunk.vertices[j * (res + 1) + i];
+	}
+
+	// Mayor diferencia de altura en los puntos que comparten los bordes de trozos vecinos en X. Si los
+	// niveles difieren, se comparan los vértices del grueso con los del fino en la misma posición.
+	float GetMaxSeamError(const TerrainStreamer& terrain)
+	{
+		const TerrainDesc& desc = terrain.GetDesc();
+		std::vector<const TerrainChunk*> chunks;
+		for (uint32_t i = 0; i < terrain.GetChunkCount(); i++)
+		{
+			chunks.push_back(&terrain.GetChunk(i));
+		}
+
+		float maxError = 0.0f;
+		for (const TerrainChunk* left : chunks)
+		{
+			for (const TerrainChunk* right : chunks)
+			{
+				if (right->x != left->x + 1 || right->z != left->z)
+				{
+					continue;
+				}
+
+				uint32_t leftRes = desc.chunkQuads >> left->lod;
+				uint32_t rightRes = desc.chunkQuads >> right->lod;
+				uint32_t coarse = std::min(leftRes, rightRes);
+				for (uint32_t j = 0; j <= coarse; j++)
+				{
+					const TerrainVertex& a = GetGridVertex(*left, leftRes, leftRes, j * (leftRes / coarse));
+					const TerrainVertex& b = GetGridVertex(*right, rightRes, 0, j * (rightRes / coarse));
+					maxError = std::max(maxError, fabsf(a.position[1] - b.position[1]));
+				}
+			}
+		}
+		return maxError;
+	}
+
+	struct FrameSummary
+	{
+		double		meanMilliseconds;
+		double		maxMilliseconds;
+		double		p99Milliseconds;
+		uint32_t	maxPending;
+		uint64_t	generated;
+		double		seconds;
+	};
+
+	// El ojo avanza speed unidades por segundo en diagonal, un paso de 1/60 s por fotograma.
+	FrameSummary RunFrames(JobSystem& jobSystem, const TerrainDesc& desc, uint32_t frames, float speed)
+	{
+		TerrainStreamer terrain(&jobSystem, desc);
+		std::vector<double> times;
+		times.reserve(frames);
+		FrameSummary summary = {};
+
+		Benchmarks::Stopwatch total;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			float distance = speed * frame / 60.0f;
+			Vector3 eye(distance * 0.8f, 0.7f, distance * 0.6f);
+			Benchmarks::Stopwatch stopwatch;
+			terrain.Update(eye);
+			terrain.ClearChanges();
+			times.push_back(stopwatch.ElapsedSeconds() * 1000.0);
+			summary.maxPending = std::max(summary.maxPending, terrain.GetStats().pendingChunks);
+		}
+		summary.seconds = total.ElapsedSeconds();
+		summary.generated = terrain.GetStats().totalGeneratedChunks;
+
+		double sum = 0.0;
+		for (double time : times)
+		{
+			sum += time;
+		}
+		summary.meanMilliseconds = sum / frames;
+		std::sort(times.begin(), times.end());
+		summary.maxMilliseconds = times.back();
+		summary.p99Milliseconds = times[std::min(frames - 1, frames * 99 / 100)];
+		return summary;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t threads = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 0;
+	uint32_t frames = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 600;
+
+	JobSystem jobSystem(threads);
+	Benchmarks::BenchmarkReporter reporter("terrain");
+	TerrainDesc desc = TerrainDesc::CreateDefault();
+
+	// Ruido fractal de cinco octavas: punto a punto frente a filas de cuatro en cuatro.
+	{
+		GradientNoise noise(desc.seed);
+		const uint32_t width = 1024;
+		const uint32_t rows = 256;
+		std::vector<float> scalar(width), simd(width);
+		float maxDifference = 0.0f;
+		double scalarSeconds = 0.0, simdSeconds = 0.0;
+		for (uint32_t row = 0; row < rows; row++)
+		{
+			float y = row * 0.0625f;
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t i = 0; i < width; i++)
+			{
+				scalar[i] = noise.Fractal(static_cast<float>(static_cast<int32_t>(i) - 512) * 0.0625f, y, desc.noise);
+			}
+			scalarSeconds += stopwatch.ElapsedSeconds();
+
+			stopwatch.Restart();
+			noise.FractalRow(-512, 0.0625f, y, width, desc.noise, simd.data());
+			simdSeconds += stopwatch.ElapsedSeconds();
+
+			for (uint32_t i = 0; i < width; i++)
+			{
+				maxDifference = std::max(maxDifference, fabsf(scalar[i] - simd[i]));
+			}
+		}
+		reporter.Add("fractal_noise_scalar", scalarSeconds, static_cast<uint64_t>(width) * rows);
+		reporter.Add("fractal_noise_simd", simdSeconds, static_cast<uint64_t>(width) * rows)
+			.parameters.push_back(std::make_pair("max_difference", static_cast<double>(maxDifference)));
+		reporter.Check("fractal_noise_simd", "el ruido por filas debe coincidir con el escalar", maxDifference < 1e-4f);
+	}
+
+	// Carga completa del radio de visión en una sola llamada, sin tope.
+	{
+		TerrainDesc unlimited = desc;
+		unlimited.maxChunksPerUpdate = 100000;
+		const uint32_t repetitions = 5;
+		uint64_t generated = 0;
+		float seamError = 0.0f;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			TerrainStreamer terrain(&jobSystem, unlimited);
+			terrain.Update(Vector3(3.0f, 0.7f, -5.0f));
+			generated += terrain.GetStats().generatedChunks;
+			seamError = std::max(seamError, GetMaxSeamError(terrain));
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+		Benchmarks::BenchmarkResult& result = reporter.Add("full_load", seconds, generated);
+		result.parameters.push_back(std::make_pair("chunks_per_sec", generated / seconds));
+		result.parameters.push_back(std::make_pair("chunks", static_cast<double>(generated / repetitions)));
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(jobSystem.GetThreadCount())));
+		result.parameters.push_back(std::make_pair("max_seam_error", static_cast<double>(seamError)));
+		reporter.Check(result.name, "los bordes de trozos vecinos deben coincidir", seamError < 1e-4f);
+	}
+
+	// En movimiento a 8 unidades por segundo (cuatro trozos por segundo): coste por fotograma del terreno.
+	const uint32_t caps[] = { 100000, 8, 4, 2 };
+	for (uint32_t cap : caps)
+	{
+		TerrainDesc capped = desc;
+		capped.maxChunksPerUpdate = cap;
+		FrameSummary summary = RunFrames(jobSystem, capped, frames, 8.0f);
+		std::string name = (cap >= 100000) ? "moving_uncapped" : "moving_cap_" + std::to_string(cap);
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, summary.seconds, frames);
+		result.parameters.push_back(std::make_pair("mean_ms", summary.meanMilliseconds));
+		result.parameters.push_back(std::make_pair("p99_ms", summary.p99Milliseconds));
+		result.parameters.push_back(std::make_pair("max_ms", summary.maxMilliseconds));
+		result.parameters.push_back(std::make_pair("max_pending", static_cast<double>(summary.maxPending)));
+		result.parameters.push_back(std::make_pair("chunks_per_sec", summary.generated / summary.seconds));
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
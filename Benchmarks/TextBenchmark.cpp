@@ -0,0 +1,168 @@
+﻿// Mide el coste por fotograma del texto superpuesto (atlas de glifos, caché de maquetación y lote de
+// cuadrados) con cientos de etiquetas, y cuenta las reservas de memoria por fotograma.
+// Uso: TextBenchmark [etiquetas] [fotogramas]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/BitmapFont.h"
+#include "../App2/Common/TextBatch.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_allocations(0);
+}
+
+// Los operadores globales cuentan las reservas; GCC avisa de malloc/free aunque el emparejamiento sea correcto.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+// La versión sin excepciones (la usa std::stable_sort) también debe liberarse con free.
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	g_allocations++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+using namespace DX;
+
+namespace
+{
+	const uint32_t White = 0xffffffff;
+
+	// Etiquetas que no cambian entre fotogramas (nombres de objetos).
+	void DrawStaticLabels(TextBatch& batch, TextLayoutCache& cache, uint32_t labelCount, uint32_t)
+	{
+		char text[64];
+		TextFormat format(16, 0.0f, TextAlignment::Center);
+		for (uint32_t i = 0; i < labelCount; i++)
+		{
+			snprintf(text, sizeof(text), "Objeto %u", i);
+			batch.AddText(cache, text, format, (i % 40) * 48.0f, (i / 40) * 20.0f, White);
+		}
+	}
+
+	// Etiquetas cuyo texto cambia en cada fotograma (distancias), el peor caso para la caché.
+	void DrawDynamicLabels(TextBatch& batch, TextLayoutCache& cache, uint32_t labelCount, uint32_t frame)
+	{
+		char text[64];
+		TextFormat format(16, 0.0f, TextAlignment::Leading);
+		for (uint32_t i = 0; i < labelCount; i++)
+		{
+			snprintf(text, sizeof(text), "%u: %.2f m", i, (i * 7 + frame) * 0.01f);
+			batch.AddText(cache, text, format, (i % 40) * 48.0f, (i / 40) * 20.0f, White);
+		}
+	}
+
+	template<typename TDraw>
+	void Measure(Benchmarks::BenchmarkReporter& reporter, const char* name, uint32_t labelCount, uint32_t frameCount, bool freshCache, TDraw draw)
+	{
+		BitmapFontRasterizer rasterizer;
+		GlyphAtlas atlas(&rasterizer, 512, 512);
+		TextLayoutCache cache(&atlas, labelCount * 2);
+		TextBatch batch;
+
+		// Fotograma de calentamiento: rasteriza los glifos y reserva la memoria de los búferes.
+		batch.Clear();
+		draw(batch, cache, labelCount, 0);
+		cache.NextFrame();
+
+		uint64_t allocationsBefore = g_allocations;
+		uint64_t quads = 0;
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 1; frame <= frameCount; frame++)
+		{
+			batch.Clear();
+			if (freshCache)
+			{
+				// Referencia: sin caché, cada fotograma vuelve a maquetar todo el texto.
+				TextLayoutCache frameCache(&atlas, labelCount * 2);
+				draw(batch, frameCache, labelCount, frame);
+			}
+			else
+			{
+				draw(batch, cache, labelCount, frame);
+				cache.NextFrame();
+			}
+			quads += batch.GetQuadCount();
+			Benchmarks::DoNotOptimize(batch.GetVertices()[0]);
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+		uint64_t allocations = g_allocations - allocationsBefore;
+
+		Benchmarks::BenchmarkResult& result = reporter.Add(name, seconds, frameCount);
+		result.parameters.push_back(std::make_pair("labels", static_cast<double>(labelCount)));
+		result.parameters.push_back(std::make_pair("us_per_frame", seconds * 1e6 / frameCount));
+		result.parameters.push_back(std::make_pair("ns_per_label", seconds * 1e9 / (static_cast<double>(frameCount) * labelCount)));
+		result.parameters.push_back(std::make_pair("quads_per_frame", static_cast<double>(quads) / frameCount));
+		result.parameters.push_back(std::make_pair("allocations_per_frame", static_cast<double>(allocations) / frameCount));
+		result.parameters.push_back(std::make_pair("layout_hit_rate", (cache.GetHitCount() + cache.GetMissCount() > 0) ? static_cast<double>(cache.GetHitCount()) / (cache.GetHitCount() + cache.GetMissCount()) : 0.0));
+	}
+
+	// Glifos mayores que el atlas entero: deben quedar vacíos (sin píxeles) en lugar de escribirse fuera
+	// del atlas, y sin vaciarlo.
+	void MeasureOversizedGlyphs(Benchmarks::BenchmarkReporter& reporter, uint32_t frameCount)
+	{
+		BitmapFontRasterizer rasterizer;
+		GlyphAtlas atlas(&rasterizer, 64, 64);
+		float area = 0.0f;
+		uint32_t generation = atlas.GetGeneration();
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			const AtlasGlyph& glyph = atlas.GetGlyph('A' + frame % 26, 128 + frame % 4);
+			area += glyph.width * glyph.height;
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		Benchmarks::BenchmarkResult& result = reporter.Add("oversized_glyphs", seconds, frameCount);
+		result.parameters.push_back(std::make_pair("atlas_pixels", 64.0 * 64.0));
+		result.parameters.push_back(std::make_pair("glyph_area", static_cast<double>(area)));
+		result.parameters.push_back(std::make_pair("atlas_clears", static_cast<double>(atlas.GetGeneration() - generation)));
+		reporter.Check(result.name, "los glifos mayores que el atlas no deben ocupar espacio", area == 0.0f);
+		reporter.Check(result.name, "los glifos mayores que el atlas no deben vaciarlo", atlas.GetGeneration() == generation);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t labelCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 500;
+	uint32_t frameCount = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 1000;
+
+	Benchmarks::BenchmarkReporter reporter("text");
+	Measure(reporter, "static_labels_cached", labelCount, frameCount, false, DrawStaticLabels);
+	Measure(reporter, "static_labels_uncached", labelCount, frameCount, true, DrawStaticLabels);
+	Measure(reporter, "dynamic_labels_cached", labelCount, frameCount, false, DrawDynamicLabels);
+	MeasureOversizedGlyphs(reporter, frameCount);
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,144 @@
+﻿// Referencia de los núcleos por lotes de DX::VectorMath frente al código escalar equivalente: seno y coseno
+// (sinf/cosf contra SinCos de cuatro en cuatro, con el error máximo) y transformación de puntos (TransformPoint
+// sobre Vector3 contra TransformPoints sobre estructura de arrays, que debe dar exactamente lo mismo). Los
+// nombres de las filas por lotes llevan la implementación SIMD con la que se compiló.
+// Uso: VectorMathBenchmark [elementos] [repeticiones]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/VectorMath.h"
+#include "../App2/Content/SceneCamera.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Generador congruencial para que los datos sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * ((state >> 8) * (1.0f / 16777216.0f));
+		}
+	};
+
+	const char* GetSimdName()
+	{
+#if defined(DX_SIMD_SSE4)
+		return "sse4";
+#elif defined(DX_SIMD_SSE)
+		return "sse2";
+#elif defined(DX_SIMD_NEON)
+		return "neon";
+#else
+		return "scalar";
+#endif
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 10;
+
+	Random random(count);
+	std::vector<float> angles(count);
+	for (float& angle : angles)
+	{
+		angle = random.Next(-100.0f, 100.0f);
+	}
+
+	Benchmarks::BenchmarkReporter reporter("vector_math");
+
+	// Seno y coseno.
+	std::vector<float> scalarSines(count), scalarCosines(count), sines(count), cosines(count);
+	{
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				scalarSines[i] = sinf(angles[i]);
+				scalarCosines[i] = cosf(angles[i]);
+			}
+		}
+		reporter.Add("sincos_scalar", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(count) * repetitions);
+	}
+	{
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			SinCos(angles.data(), count, sines.data(), cosines.data());
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		double maxError = 0.0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			maxError = std::max(maxError, fabs(static_cast<double>(sines[i]) - sin(static_cast<double>(angles[i]))));
+			maxError = std::max(maxError, fabs(static_cast<double>(cosines[i]) - cos(static_cast<double>(angles[i]))));
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add(std::string("sincos_batch_") + GetSimdName(), seconds, static_cast<uint64_t>(count) * repetitions);
+		result.parameters.push_back(std::make_pair("max_error", maxError));
+		reporter.Check(result.name, "el error de SinCos debe quedar por debajo de 1e-6", maxError < 1e-6);
+	}
+
+	// Transformación por la vista-proyección de la escena.
+	Matrix4 viewProjection = ComputeSceneView() * ComputeSceneProjection(1920.0f, 1080.0f, Matrix4::Identity());
+	std::vector<Vector3> points(count);
+	std::vector<float> x(count), y(count), z(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		points[i] = Vector3(random.Next(-3.0f, 3.0f), random.Next(-2.0f, 2.0f), random.Next(-6.0f, 1.0f));
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+		z[i] = points[i].z;
+	}
+
+	std::vector<float> scalarClip(static_cast<size_t>(count) * 4);
+	{
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				TransformPoint(points[i], viewProjection, &scalarClip[static_cast<size_t>(i) * 4]);
+			}
+		}
+		reporter.Add("transform_scalar", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(count) * repetitions);
+	}
+	{
+		std::vector<float> clipX(count), clipY(count), clipZ(count), clipW(count);
+		Benchmarks::Stopwatch stopwatch;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			TransformPoints(viewProjection, x.data(), y.data(), z.data(), count, clipX.data(), clipY.data(), clipZ.data(), clipW.data());
+		}
+		double seconds = stopwatch.ElapsedSeconds();
+
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const float* expected = &scalarClip[static_cast<size_t>(i) * 4];
+			if (clipX[i] != expected[0] || clipY[i] != expected[1] || clipZ[i] != expected[2] || clipW[i] != expected[3])
+			{
+				mismatches++;
+			}
+		}
+		Benchmarks::BenchmarkResult& result = reporter.Add(std::string("transform_soa_") + GetSimdName(), seconds, static_cast<uint64_t>(count) * repetitions);
+		result.parameters.push_back(std::make_pair("mismatches", static_cast<double>(mismatches)));
+		reporter.Check(result.name, "la transformación por lotes debe coincidir con la escalar", mismatches == 0);
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}
@@ -0,0 +1,205 @@
+﻿// Referencia de las conversiones de DX::VertexFormat: el vértice completo de la tela (posición, normal y
+// color) a posición y color en flotantes y a posición con color RGBA8. Se compara un conversor genérico que
+// recorre en cada vértice los elementos de los dos formatos y elige la conversión según el formato (como
+// el flujo de vértices con desplazamientos de antes) con DX::ConvertVertices, resuelto al compilar. Las
+// dos salidas deben coincidir byte a byte (mismatches debe ser 0).
+// Uso: VertexFormatBenchmark [vértices] [repeticiones]
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Common/VertexFormat.h"
+#include "../App2/Content/ClothSimulation.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	struct PositionColorVertex
+	{
+		float	position[3];
+		float	color[3];
+	};
+
+	struct PackedColorVertex
+	{
+		float		position[3];
+		uint32_t	color;
+	};
+}
+
+namespace DX
+{
+	template<>
+	struct VertexLayoutOf<PositionColorVertex> : VertexLayout<PositionColorVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(PositionColorVertex, position)>,
+		VertexAttribute<VertexSemantic::Color, 0, float[3], offsetof(PositionColorVertex, color)>>
+	{
+	};
+
+	template<>
+	struct VertexLayoutOf<PackedColorVertex> : VertexLayout<PackedColorVertex,
+		VertexAttribute<VertexSemantic::Position, 0, float[3], offsetof(PackedColorVertex, position)>,
+		VertexAttribute<VertexSemantic::Color, 0, uint32_t, offsetof(PackedColorVertex, color)>>
+	{
+	};
+}
+
+namespace
+{
+	// Generador congruencial para que los datos sean reproducibles.
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * ((state >> 8) * (1.0f / 16777216.0f));
+		}
+	};
+
+	uint32_t GetComponentCount(VertexElementFormat format)
+	{
+		switch (format)
+		{
+		case VertexElementFormat::Float1:	return 1;
+		case VertexElementFormat::Float2:	return 2;
+		case VertexElementFormat::Float3:	return 3;
+		default:							return 4;
+		}
+	}
+
+	float ReadComponent(const uint8_t* source, VertexElementFormat format, uint32_t component)
+	{
+		if (format == VertexElementFormat::UNorm8x4)
+		{
+			return source[component] * (1.0f / 255.0f);
+		}
+		float value;
+		memcpy(&value, source + component * sizeof(float), sizeof(value));
+		return value;
+	}
+
+	void WriteComponent(uint8_t* target, VertexElementFormat format, uint32_t component, float value)
+	{
+		if (format == VertexElementFormat::UNorm8x4)
+		{
+			value = (value < 0.0f) ? 0.0f : value;
+			value = (value > 1.0f) ? 1.0f : value;
+			target[component] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+			return;
+		}
+		memcpy(target + component * sizeof(float), &value, sizeof(value));
+	}
+
+	// Conversor guiado por las descripciones: busca cada elemento del destino en el origen y convierte
+	// componente a componente según los dos formatos.
+	void ConvertWithDescriptors(const VertexElement* sourceElements, uint32_t sourceCount, uint32_t sourceStride, const void* source,
+		const VertexElement* targetElements, uint32_t targetCount, uint32_t targetStride, void* target, uint32_t vertexCount)
+	{
+		const uint8_t* sourceVertex = static_cast<const uint8_t*>(source);
+		uint8_t* targetVertex = static_cast<uint8_t*>(target);
+		for (uint32_t v = 0; v < vertexCount; v++, sourceVertex += sourceStride, targetVertex += targetStride)
+		{
+			for (uint32_t t = 0; t < targetCount; t++)
+			{
+				const VertexElement& targetElement = targetElements[t];
+				const VertexElement* sourceElement = nullptr;
+				for (uint32_t s = 0; s < sourceCount; s++)
+				{
+					if (sourceElements[s].semantic == targetElement.semantic && sourceElements[s].semanticIndex == targetElement.semanticIndex)
+					{
+						sourceElement = &sourceElements[s];
+						break;
+					}
+				}
+
+				uint32_t components = GetComponentCount(targetElement.format);
+				uint32_t available = (sourceElement != nullptr) ? GetComponentCount(sourceElement->format) : 0;
+				for (uint32_t c = 0; c < components; c++)
+				{
+					float value = (c == 3) ? 1.0f : 0.0f;
+					if (c < available)
+					{
+						value = ReadComponent(sourceVertex + sourceElement->offset, sourceElement->format, c);
+					}
+					WriteComponent(targetVertex + targetElement.offset, targetElement.format, c, value);
+				}
+			}
+		}
+	}
+
+	template<typename TTarget>
+	void Measure(Benchmarks::BenchmarkReporter& reporter, const char* name, const std::vector<ClothVertex>& source, uint32_t repetitions)
+	{
+		typedef VertexLayoutOf<ClothVertex> SourceLayout;
+		typedef VertexLayoutOf<TTarget> TargetLayout;
+		uint32_t count = static_cast<uint32_t>(source.size());
+		std::vector<TTarget> runtime(count), compiled(count);
+		memset(runtime.data(), 0, runtime.size() * sizeof(TTarget));
+		memset(compiled.data(), 0, compiled.size() * sizeof(TTarget));
+
+		{
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				ConvertWithDescriptors(SourceLayout::GetElements(), SourceLayout::ElementCount, SourceLayout::Stride, source.data(),
+					TargetLayout::GetElements(), TargetLayout::ElementCount, TargetLayout::Stride, runtime.data(), count);
+				Benchmarks::DoNotOptimize(runtime[0]);
+			}
+			reporter.Add(std::string(name) + "_descriptors", stopwatch.ElapsedSeconds(), static_cast<uint64_t>(count) * repetitions);
+		}
+		{
+			Benchmarks::Stopwatch stopwatch;
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				ConvertVertices(source.data(), count, compiled.data());
+				Benchmarks::DoNotOptimize(compiled[0]);
+			}
+			double seconds = stopwatch.ElapsedSeconds();
+
+			uint32_t mismatches = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (memcmp(&runtime[i], &compiled[i], sizeof(TTarget)) != 0)
+				{
+					mismatches++;
+				}
+			}
+			Benchmarks::BenchmarkResult& result = reporter.Add(std::string(name) + "_compiled", seconds, static_cast<uint64_t>(count) * repetitions);
+			result.parameters.push_back(std::make_pair("stride", static_cast<double>(TargetLayout::Stride)));
+			result.parameters.push_back(std::make_pair("mismatches", static_cast<double>(mismatches)));
+			reporter.Check(result.name, "la conversión compilada debe coincidir con la de tiempo de ejecución", mismatches == 0);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+	uint32_t repetitions = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 10;
+
+	Random random(count);
+	std::vector<ClothVertex> source(count);
+	for (ClothVertex& vertex : source)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			vertex.position[c] = random.Next(-2.0f, 2.0f);
+			vertex.normal[c] = random.Next(-1.0f, 1.0f);
+			vertex.color[c] = vertex.normal[c] * 0.5f + 0.5f;
+		}
+	}
+
+	Benchmarks::BenchmarkReporter reporter("vertex_format");
+	Measure<PositionColorVertex>(reporter, "position_color", source, repetitions);
+	Measure<PackedColorVertex>(reporter, "packed_color", source, repetitions);
+	reporter.Print();
+	return reporter.GetExitCode();
+}
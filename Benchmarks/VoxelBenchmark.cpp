@@ -0,0 +1,184 @@
+﻿// Referencia del volumen de vóxeles: trozos mallados por segundo al reconstruir todo el volumen y latencia
+// de volver a mallar tras una sola edición (una esfera excavada), con los trozos que toca cada una.
+// Comprueba también que todos los triángulos miran hacia fuera del sólido y que la superficie es cerrada
+// (cada arista la comparten exactamente dos triángulos, también entre trozos).
+// Uso: VoxelBenchmark [subprocesos] [ediciones] [trozos por eje]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+#include "BenchmarkHarness.h"
+#include "../App2/Content/VoxelVolume.h"
+
+using namespace App2;
+using namespace DX;
+
+namespace
+{
+	// Esfera deformada con ondulaciones: distancia con signo aproximada.
+	float BlobDensity(const Vector3& p, const Vector3& center, float radius)
+	{
+		Vector3 d = p - center;
+		float ripple = 0.08f * radius * sinf(d.x * 9.0f / radius) * sinf(d.y * 7.0f / radius) * sinf(d.z * 8.0f / radius);
+		return Length(d) - radius + ripple;
+	}
+
+	struct MeshCheck
+	{
+		uint32_t	wrongWinding;
+		uint32_t	openEdges;
+	};
+
+	// Orientación respecto al gradiente de la densidad y aristas sin pareja, identificando los vértices por
+	// su posición: los de las celdas de solape se calculan igual en los dos trozos.
+	MeshCheck CheckMesh(const VoxelVolume& volume, const Vector3& center, float radius)
+	{
+		typedef std::pair<float, std::pair<float, float>> Key;
+		auto makeKey = [](const VoxelVertex& v) { return Key(v.position[0], std::make_pair(v.position[1], v.position[2])); };
+		std::map<std::pair<Key, Key>, int> edges;
+		MeshCheck check = {};
+		float h = volume.GetDesc().voxelSize * 0.5f;
+
+		for (uint32_t chunk = 0; chunk < volume.GetChunkCount(); chunk++)
+		{
+			const VoxelChunkMesh& mesh = volume.GetChunkMesh(chunk);
+			for (size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				const VoxelVertex* v[3] = { &mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]], &mesh.vertices[mesh.indices[i + 2]] };
+				Vector3 p[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = Vector3(v[k]->position[0], v[k]->position[1], v[k]->position[2]);
+				}
+
+				// En Direct3D la cara delantera va en el sentido de las agujas del reloj: su producto
+				// vectorial apunta hacia dentro del sólido, contra el gradiente.
+				Vector3 c = (p[0] + p[1] + p[2]) * (1.0f / 3.0f);
+				Vector3 gradient(
+					BlobDensity(c + Vector3(h, 0.0f, 0.0f), center, radius) - BlobDensity(c - Vector3(h, 0.0f, 0.0f), center, radius),
+					BlobDensity(c + Vector3(0.0f, h, 0.0f), center, radius) - BlobDensity(c - Vector3(0.0f, h, 0.0f), center, radius),
+					BlobDensity(c + Vector3(0.0f, 0.0f, h), center, radius) - BlobDensity(c - Vector3(0.0f, 0.0f, h), center, radius));
+				if (Dot(Cross(p[1] - p[0], p[2] - p[0]), gradient) >= 0.0f)
+				{
+					check.wrongWinding++;
+				}
+
+				for (int k = 0; k < 3; k++)
+				{
+					Key a = makeKey(*v[k]);
+					Key b = makeKey(*v[(k + 1) % 3]);
+					edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+				}
+			}
+		}
+
+		for (const auto& edge : edges)
+		{
+			if (edge.second != 2)
+			{
+				check.openEdges++;
+			}
+		}
+		return check;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t threads = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 0;
+	uint32_t edits = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 200;
+	uint32_t chunksPerAxis = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 4;
+
+	JobSystem jobSystem(threads);
+	Benchmarks::BenchmarkReporter reporter("voxels");
+
+	VoxelVolumeDesc desc;
+	desc.chunksX = chunksPerAxis;
+	desc.chunksY = chunksPerAxis;
+	desc.chunksZ = chunksPerAxis;
+	desc.chunkCells = 32;
+	desc.voxelSize = 1.0f;
+	desc.origin = Vector3();
+	float extent = static_cast<float>(chunksPerAxis * desc.chunkCells);
+	Vector3 center(extent * 0.5f, extent * 0.5f, extent * 0.5f);
+	float radius = extent * 0.38f;
+	auto blob = [center, radius](const Vector3& p) { return BlobDensity(p, center, radius); };
+
+	VoxelVolume volume(&jobSystem, desc);
+
+	// Reconstrucción completa: todos los trozos marcados y mallados de una vez.
+	{
+		const uint32_t repetitions = 5;
+		double seconds = 0.0;
+		uint64_t chunks = 0;
+		for (uint32_t r = 0; r < repetitions; r++)
+		{
+			volume.Fill(blob);
+			Benchmarks::Stopwatch stopwatch;
+			volume.Remesh();
+			seconds += stopwatch.ElapsedSeconds();
+			chunks += volume.GetStats().remeshedChunks;
+			volume.ClearChanges();
+		}
+
+		MeshCheck check = CheckMesh(volume, center, radius);
+		Benchmarks::BenchmarkResult& result = reporter.Add("full_rebuild", seconds, chunks);
+		result.parameters.push_back(std::make_pair("chunks_per_sec", chunks / seconds));
+		result.parameters.push_back(std::make_pair("ms_per_rebuild", seconds * 1000.0 / repetitions));
+		result.parameters.push_back(std::make_pair("triangles", static_cast<double>(volume.GetStats().triangles)));
+		result.parameters.push_back(std::make_pair("threads", static_cast<double>(jobSystem.GetThreadCount())));
+		result.parameters.push_back(std::make_pair("wrong_winding", static_cast<double>(check.wrongWinding)));
+		result.parameters.push_back(std::make_pair("open_edges", static_cast<double>(check.openEdges)));
+		reporter.Check(result.name, "todos los triángulos deben mirar hacia fuera", check.wrongWinding == 0);
+		reporter.Check(result.name, "la malla debe ser cerrada", check.openEdges == 0);
+	}
+
+	// Ediciones sueltas: una esfera de tres vóxeles de radio excavada en la superficie y mallado inmediato.
+	{
+		std::vector<double> times;
+		times.reserve(edits);
+		uint64_t chunks = 0;
+		uint32_t seed = 12345;
+		auto random = [&seed]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / 16777216.0f;
+		};
+
+		Benchmarks::Stopwatch total;
+		for (uint32_t e = 0; e < edits; e++)
+		{
+			float theta = random() * 6.2831853f;
+			float y = random() * 2.0f - 1.0f;
+			float ring = sqrtf(1.0f - y * y);
+			Vector3 point = center + Vector3(ring * cosf(theta), y, ring * sinf(theta)) * radius;
+
+			Benchmarks::Stopwatch stopwatch;
+			volume.SubtractSphere(point, 3.0f);
+			volume.Remesh();
+			times.push_back(stopwatch.ElapsedSeconds() * 1000.0);
+			chunks += volume.GetStats().remeshedChunks;
+			volume.ClearChanges();
+		}
+		double seconds = total.ElapsedSeconds();
+
+		double sum = 0.0;
+		for (double time : times)
+		{
+			sum += time;
+		}
+		std::sort(times.begin(), times.end());
+		Benchmarks::BenchmarkResult& result = reporter.Add("single_edit", seconds, edits);
+		result.parameters.push_back(std::make_pair("mean_ms", sum / edits));
+		result.parameters.push_back(std::make_pair("p99_ms", times[std::min(edits - 1, edits * 99 / 100)]));
+		result.parameters.push_back(std::make_pair("max_ms", times.back()));
+		result.parameters.push_back(std::make_pair("chunks_per_edit", static_cast<double>(chunks) / edits));
+	}
+
+	reporter.Print();
+	return reporter.GetExitCode();
+}